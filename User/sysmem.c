@@ -22,30 +22,53 @@
 
 /* Includes */
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include "sysmem.h"
 
 /**
  * Pointer to the current high watermark of the heap usage
  */
 static uint8_t *__sbrk_heap_end = NULL;
 
+/**
+ * Set by sysmem_heap_lock(), and the caller of the last refused request
+ */
+static volatile bool __sbrk_locked = false;
+static void *volatile __sbrk_violation = NULL;
+
+void sysmem_heap_lock(void)
+{
+  __sbrk_locked = true;
+}
+
+uint32_t sysmem_heap_used(void)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+  return (NULL == __sbrk_heap_end) ? 0 : (uint32_t)(__sbrk_heap_end - &_end);
+}
+
+void *sysmem_heap_violation(void)
+{
+  return __sbrk_violation;
+}
+
 /**
  * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
  *        and others from the C library
  *
  * @verbatim
  * ############################################################################
- * #  .data  #  .bss  #       newlib heap       #          MSP stack          #
- * #         #        #                         # Reserved by _Min_Stack_Size #
+ * #  .data  #  .bss  #                  newlib heap                          #
  * ############################################################################
- * ^-- RAM start      ^-- _end                             _estack, RAM end --^
+ * ^-- RAM start      ^-- _end                              _eheap, RAM end --^
  * @endverbatim
  *
  * This implementation starts allocating at the '_end' linker symbol
- * The '_Min_Stack_Size' linker symbol reserves a memory for the MSP stack
- * The implementation considers '_estack' linker symbol to be RAM end
- * NOTE: If the MSP stack, at any point during execution, grows larger than the
- * reserved size, please increase the '_Min_Stack_Size'.
+ * The implementation considers '_eheap' linker symbol to be RAM end
+ * NOTE: The MSP stack is at the top of SRAM2 (see the linker script), so the
+ * heap and the stack can not collide.
  *
  * @param incr Memory size
  * @return Pointer to allocated memory
@@ -53,19 +76,28 @@ static uint8_t *__sbrk_heap_end = NULL;
 void *_sbrk(ptrdiff_t incr)
 {
   extern uint8_t _end; /* Symbol defined in the linker script */
-  extern uint8_t _estack; /* Symbol defined in the linker script */
-  extern uint32_t _Min_Stack_Size; /* Symbol defined in the linker script */
-  const uint32_t stack_limit = (uint32_t)&_estack - (uint32_t)&_Min_Stack_Size;
-  const uint8_t *max_heap = (uint8_t *)stack_limit;
+  extern uint8_t _eheap; /* Symbol defined in the linker script */
+  const uint8_t *max_heap = &_eheap;
   uint8_t *prev_heap_end;
 
+  /* No heap growth after init: a hidden allocation must not go unnoticed */
+  if (__sbrk_locked)
+  {
+    __sbrk_violation = __builtin_return_address(0);
+#if SYSMEM_HEAP_LOCK_TRAP
+    __asm volatile ("bkpt #0");
+#endif
+    errno = ENOMEM;
+    return (void *)-1;
+  }
+
   /* Initialize heap end at first call */
   if (NULL == __sbrk_heap_end)
   {
     __sbrk_heap_end = &_end;
   }
 
-  /* Protect heap from growing into the reserved MSP stack */
+  /* Protect heap from growing past the end of RAM */
   if (__sbrk_heap_end + incr > max_heap)
   {
     errno = ENOMEM;
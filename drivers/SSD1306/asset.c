@@ -0,0 +1,104 @@
+#include "asset.h"
+#include "gfx.h"
+
+#define ASSET_RLE_REPEAT    0x80U
+#define ASSET_RLE_MIN_RUN   3U
+
+// Decoder state, kept across page strips because runs may span them
+typedef struct {
+    const uint8_t *src;
+    uint8_t left;           // Bytes left in the current run
+    bool repeat;            // Current run repeats value instead of copying literals
+    uint8_t value;
+} asset_rle_t;
+
+static void asset_rle_unpack(asset_rle_t *rle, uint8_t *dst, uint8_t count) {
+    while (count > 0) {
+        if (rle->left == 0) {
+            uint8_t ctrl = *rle->src++;
+            rle->repeat = (ctrl & ASSET_RLE_REPEAT) != 0;
+            if (rle->repeat) {
+                rle->left = (uint8_t)((ctrl & 0x7FU) + ASSET_RLE_MIN_RUN);
+                rle->value = *rle->src++;
+            } else {
+                rle->left = (uint8_t)(ctrl + 1U);
+            }
+        }
+
+        uint8_t n = (rle->left < count) ? rle->left : count;
+        rle->left -= n;
+        count -= n;
+        if (rle->repeat) {
+            while (n--) *dst++ = rle->value;
+        } else {
+            while (n--) *dst++ = *rle->src++;
+        }
+    }
+}
+
+/**
+ * @brief Draws page-layout data, unpacking RLE one page strip at a time.
+ */
+static void asset_draw(int16_t x, int16_t y, const uint8_t *data, bool compressed,
+                       uint8_t w, uint8_t h, ssd1306_color_t color) {
+    if (w == 0 || h == 0 || w > ASSET_MAX_WIDTH) return;
+
+    if (!compressed) {
+        gfx_draw_bitmap(x, y, data, w, h, color);
+        return;
+    }
+
+    uint8_t strip[ASSET_MAX_WIDTH];
+    asset_rle_t rle = { .src = data, .left = 0 };
+
+    for (uint16_t row = 0; row < h; row += 8) {
+        asset_rle_unpack(&rle, strip, w);
+        uint8_t rows = (uint8_t)((h - row < 8) ? h - row : 8);
+        gfx_draw_bitmap(x, (int16_t)(y + row), strip, w, rows, color);
+    }
+}
+
+void asset_draw_bitmap(int16_t x, int16_t y, const asset_bitmap_t *bitmap, ssd1306_color_t color) {
+    if (bitmap == NULL) return;
+    asset_draw(x, y, bitmap->data, bitmap->rle != 0, bitmap->width, bitmap->height, color);
+}
+
+static const asset_glyph_t *asset_glyph(const asset_font_t *font, char ch) {
+    uint8_t index = (uint8_t)((uint8_t)ch - font->first);
+    return (index < font->count) ? &font->glyphs[index] : NULL;
+}
+
+uint8_t asset_draw_char(int16_t x, int16_t y, const asset_font_t *font, char ch, ssd1306_color_t color) {
+    if (font == NULL) return 0;
+
+    const asset_glyph_t *glyph = asset_glyph(font, ch);
+    if (glyph == NULL) return font->height / 2;
+
+    // Glyphs fully left or right of the screen only advance the cursor
+    if (x < SSD1306_WIDTH && x + glyph->width > 0) {
+        asset_draw(x, y, &font->data[glyph->offset & ~ASSET_GLYPH_RLE],
+                   (glyph->offset & ASSET_GLYPH_RLE) != 0, glyph->width, font->height, color);
+    }
+    return glyph->advance;
+}
+
+int16_t asset_draw_text(int16_t x, int16_t y, const asset_font_t *font, const char *str, ssd1306_color_t color) {
+    if (str == NULL) return x;
+
+    while (*str && x < SSD1306_WIDTH) {
+        x = (int16_t)(x + asset_draw_char(x, y, font, *str, color));
+        str++;
+    }
+    return x;
+}
+
+uint16_t asset_text_width(const asset_font_t *font, const char *str) {
+    uint16_t width = 0;
+    if (font == NULL || str == NULL) return 0;
+
+    while (*str) {
+        const asset_glyph_t *glyph = asset_glyph(font, *str++);
+        width += glyph ? glyph->advance : font->height / 2;
+    }
+    return width;
+}
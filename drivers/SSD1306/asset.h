@@ -0,0 +1,81 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+/*
+ * Fonts and bitmaps generated at build time by tools/assetgen.py from the
+ * BDF/PBM/PNG files in assets/ (see the generated "assets.h").
+ *
+ * Pixel data uses the gfx_draw_bitmap() layout: ceil(height / 8) pages of
+ * width bytes, one byte per column of 8 rows, bit 0 on top. Each glyph or
+ * bitmap may be RLE compressed:
+ *   ctrl 0x00-0x7F: ctrl + 1 literal bytes follow
+ *   ctrl 0x80-0xFF: the next byte is repeated (ctrl & 0x7F) + 3 times
+ * Compressed data is unpacked one page strip at a time on the stack and
+ * drawn straight into the screen buffer, so no RAM copy of the asset exists.
+ */
+
+#define ASSET_GLYPH_RLE     0x8000U     // Set in asset_glyph_t.offset when the glyph is compressed
+#define ASSET_MAX_WIDTH     SSD1306_WIDTH
+
+typedef struct {
+    uint16_t offset;        // Into asset_font_t.data, ORed with ASSET_GLYPH_RLE
+    uint8_t width;          // Stored columns, 0 for blank glyphs
+    uint8_t advance;        // Cursor step in pixels
+} asset_glyph_t;
+
+typedef struct {
+    uint8_t first;          // Character of glyphs[0]
+    uint8_t count;
+    uint8_t height;
+    const asset_glyph_t *glyphs;
+    const uint8_t *data;
+} asset_font_t;
+
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    uint8_t rle;            // 1 if data is RLE compressed
+    const uint8_t *data;
+} asset_bitmap_t;
+
+/**
+ * @brief Draws a generated bitmap. Set bits are drawn with color, clear bits are transparent.
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row, any alignment.
+ * @param[in] bitmap Bitmap generated by assetgen.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void asset_draw_bitmap(int16_t x, int16_t y, const asset_bitmap_t *bitmap, ssd1306_color_t color);
+
+/**
+ * @brief Draws one character of a generated font.
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row, any alignment.
+ * @param[in] font Font generated by assetgen.
+ * @param[in] ch Character to draw; characters outside the font only advance.
+ * @param[in] color BLACK, WHITE or INVERT.
+ * @return Advance in pixels.
+ */
+uint8_t asset_draw_char(int16_t x, int16_t y, const asset_font_t *font, char ch, ssd1306_color_t color);
+
+/**
+ * @brief Draws a string of a generated font on one line.
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row, any alignment.
+ * @param[in] font Font generated by assetgen.
+ * @param[in] str Null-terminated string.
+ * @param[in] color BLACK, WHITE or INVERT.
+ * @return Column after the last character drawn.
+ */
+int16_t asset_draw_text(int16_t x, int16_t y, const asset_font_t *font, const char *str, ssd1306_color_t color);
+
+/**
+ * @brief Width of a string in pixels, for alignment.
+ */
+uint16_t asset_text_width(const asset_font_t *font, const char *str);
+
+#endif // ASSET_H
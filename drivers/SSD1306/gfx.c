@@ -0,0 +1,233 @@
+#include "gfx.h"
+
+#define GFX_PAGES (SSD1306_HEIGHT / 8)
+
+// Outcodes for Cohen-Sutherland line clipping
+#define GFX_CLIP_LEFT   (1U << 0)
+#define GFX_CLIP_RIGHT  (1U << 1)
+#define GFX_CLIP_TOP    (1U << 2)
+#define GFX_CLIP_BOTTOM (1U << 3)
+
+/*
+ * Every color is applied as dst = (dst & ~(bits & and_sel)) ^ (bits & xor_sel):
+ *   WHITE:  and_sel = 0xFF, xor_sel = 0xFF -> set
+ *   BLACK:  and_sel = 0xFF, xor_sel = 0x00 -> clear
+ *   INVERT: and_sel = 0x00, xor_sel = 0xFF -> toggle
+ * so the inner loops never branch on the color.
+ */
+typedef struct {
+    uint32_t and_sel;
+    uint32_t xor_sel;
+} gfx_op_t;
+
+static gfx_op_t gfx_op(ssd1306_color_t color) {
+    gfx_op_t op;
+    op.and_sel = (color == SSD1306_COLOR_INVERT) ? 0U : 0xFFFFFFFFU;
+    op.xor_sel = (color == SSD1306_COLOR_BLACK) ? 0U : 0xFFFFFFFFU;
+    return op;
+}
+
+static inline uint8_t gfx_apply_byte(uint8_t dst, uint8_t bits, gfx_op_t op) {
+    return (uint8_t)((dst & ~(bits & op.and_sel)) ^ (bits & op.xor_sel));
+}
+
+/**
+ * @brief Applies the same row mask to count consecutive columns of one page.
+ *
+ * Unaligned head and tail columns are done byte by byte, the rest four
+ * columns per 32-bit load/store with the mask replicated in every byte.
+ */
+static void gfx_apply_columns(uint8_t *dst, uint16_t count, uint8_t mask, gfx_op_t op) {
+    while (count > 0 && ((uintptr_t)dst & 3U)) {
+        *dst = gfx_apply_byte(*dst, mask, op);
+        dst++;
+        count--;
+    }
+
+    uint32_t wide = mask * 0x01010101U;
+    uint32_t and_mask = ~(wide & op.and_sel);
+    uint32_t xor_mask = wide & op.xor_sel;
+    ssd1306_word_t *word = (ssd1306_word_t *)dst;
+    for (; count >= 4; count -= 4) {
+        *word = (*word & and_mask) ^ xor_mask;
+        word++;
+    }
+
+    dst = (uint8_t *)word;
+    while (count > 0) {
+        *dst = gfx_apply_byte(*dst, mask, op);
+        dst++;
+        count--;
+    }
+}
+
+void gfx_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, ssd1306_color_t color) {
+    // Clip once against the screen
+    int32_t x0 = x, y0 = y, x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > SSD1306_WIDTH) x1 = SSD1306_WIDTH;
+    if (y1 > SSD1306_HEIGHT) y1 = SSD1306_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    gfx_op_t op = gfx_op(color);
+    uint8_t *buffer = ssd1306_get_buffer();
+    uint8_t first_page = (uint8_t)(y0 >> 3);
+    uint8_t last_page = (uint8_t)((y1 - 1) >> 3);
+
+    // Each page gets one mask covering the rows of the rectangle inside it
+    for (uint8_t page = first_page; page <= last_page; page++) {
+        uint8_t mask = 0xFF;
+        if (page == first_page) mask &= (uint8_t)(0xFF << (y0 & 7));
+        if (page == last_page) mask &= (uint8_t)(0xFF >> (7 - ((y1 - 1) & 7)));
+        gfx_apply_columns(&buffer[page * SSD1306_WIDTH + x0], (uint16_t)(x1 - x0), mask, op);
+    }
+}
+
+void gfx_draw_hline(int16_t x, int16_t y, int16_t w, ssd1306_color_t color) {
+    gfx_fill_rect(x, y, w, 1, color);
+}
+
+void gfx_draw_vline(int16_t x, int16_t y, int16_t h, ssd1306_color_t color) {
+    gfx_fill_rect(x, y, 1, h, color);
+}
+
+void gfx_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, ssd1306_color_t color) {
+    if (w <= 0 || h <= 0) return;
+
+    gfx_draw_hline(x, y, w, color);
+    if (h > 1)
+        gfx_draw_hline(x, y + h - 1, w, color);
+    // The side lines skip the corners so INVERT does not toggle them twice
+    if (h > 2) {
+        gfx_draw_vline(x, y + 1, h - 2, color);
+        if (w > 1)
+            gfx_draw_vline(x + w - 1, y + 1, h - 2, color);
+    }
+}
+
+static uint8_t gfx_outcode(int32_t x, int32_t y) {
+    uint8_t code = 0;
+    if (x < 0) code |= GFX_CLIP_LEFT;
+    else if (x >= SSD1306_WIDTH) code |= GFX_CLIP_RIGHT;
+    if (y < 0) code |= GFX_CLIP_TOP;
+    else if (y >= SSD1306_HEIGHT) code |= GFX_CLIP_BOTTOM;
+    return code;
+}
+
+/**
+ * @brief Cohen-Sutherland clipping of a line to the screen.
+ * @return false if the line is completely outside.
+ */
+static bool gfx_clip_line(int32_t *x0, int32_t *y0, int32_t *x1, int32_t *y1) {
+    uint8_t code0 = gfx_outcode(*x0, *y0);
+    uint8_t code1 = gfx_outcode(*x1, *y1);
+
+    while (code0 | code1) {
+        if (code0 & code1) return false;
+
+        uint8_t code = code0 ? code0 : code1;
+        int32_t x, y;
+        int32_t dx = *x1 - *x0, dy = *y1 - *y0;
+
+        if (code & GFX_CLIP_BOTTOM) {
+            y = SSD1306_HEIGHT - 1;
+            x = *x0 + dx * (y - *y0) / dy;
+        } else if (code & GFX_CLIP_TOP) {
+            y = 0;
+            x = *x0 + dx * (y - *y0) / dy;
+        } else if (code & GFX_CLIP_RIGHT) {
+            x = SSD1306_WIDTH - 1;
+            y = *y0 + dy * (x - *x0) / dx;
+        } else {
+            x = 0;
+            y = *y0 + dy * (x - *x0) / dx;
+        }
+
+        if (code == code0) {
+            *x0 = x; *y0 = y;
+            code0 = gfx_outcode(x, y);
+        } else {
+            *x1 = x; *y1 = y;
+            code1 = gfx_outcode(x, y);
+        }
+    }
+    return true;
+}
+
+void gfx_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, ssd1306_color_t color) {
+    // Axis aligned lines are spans
+    if (y0 == y1) {
+        int16_t left = (x0 < x1) ? x0 : x1;
+        gfx_draw_hline(left, y0, (int16_t)((x0 < x1 ? x1 - x0 : x0 - x1) + 1), color);
+        return;
+    }
+    if (x0 == x1) {
+        int16_t top = (y0 < y1) ? y0 : y1;
+        gfx_draw_vline(x0, top, (int16_t)((y0 < y1 ? y1 - y0 : y0 - y1) + 1), color);
+        return;
+    }
+
+    int32_t ax = x0, ay = y0, bx = x1, by = y1;
+    if (!gfx_clip_line(&ax, &ay, &bx, &by)) return;
+
+    // Both ends are on screen now, the loop needs no bounds checks
+    gfx_op_t op = gfx_op(color);
+    uint8_t *buffer = ssd1306_get_buffer();
+    int32_t dx = (bx > ax) ? bx - ax : ax - bx;
+    int32_t dy = (by > ay) ? ay - by : by - ay;  // Negative
+    int32_t sx = (ax < bx) ? 1 : -1;
+    int32_t sy = (ay < by) ? 1 : -1;
+    int32_t err = dx + dy;
+
+    while (1) {
+        uint8_t *dst = &buffer[(ay >> 3) * SSD1306_WIDTH + ax];
+        *dst = gfx_apply_byte(*dst, (uint8_t)(1U << (ay & 7)), op);
+        if (ax == bx && ay == by) break;
+
+        int32_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; ax += sx; }
+        if (e2 <= dx) { err += dx; ay += sy; }
+    }
+}
+
+void gfx_draw_bitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, ssd1306_color_t color) {
+    if (bitmap == NULL || w == 0 || h == 0) return;
+
+    // Horizontal clipping, shared by every source page
+    int32_t col_start = (x < 0) ? -x : 0;
+    int32_t col_end = (x + w > SSD1306_WIDTH) ? SSD1306_WIDTH - x : w;
+    if (col_start >= col_end) return;
+
+    gfx_op_t op = gfx_op(color);
+    uint8_t *buffer = ssd1306_get_buffer();
+    uint8_t src_pages = (uint8_t)((h + 7) / 8);
+
+    for (uint8_t src_page = 0; src_page < src_pages; src_page++) {
+        // Rows of this source byte that belong to the bitmap
+        uint8_t valid = 0xFF;
+        if (src_page == src_pages - 1 && (h & 7))
+            valid = (uint8_t)(0xFF >> (8 - (h & 7)));
+
+        // The byte lands across two screen pages, shifted down by shift rows
+        int32_t top = (int32_t)y + src_page * 8;
+        if (top >= SSD1306_HEIGHT || top + 8 <= 0) continue;
+        int32_t page = (top >= 0) ? top >> 3 : -((7 - top) >> 3);
+        uint8_t shift = (uint8_t)(top - page * 8);
+        bool upper = (page >= 0);
+        bool lower = (shift != 0 && page + 1 < GFX_PAGES);
+
+        const uint8_t *src = &bitmap[src_page * w];
+        int32_t upper_base = page * SSD1306_WIDTH + x;
+        int32_t lower_base = upper_base + SSD1306_WIDTH;
+
+        for (int32_t col = col_start; col < col_end; col++) {
+            uint8_t bits = src[col] & valid;
+            if (bits == 0) continue;
+            if (upper)
+                buffer[upper_base + col] = gfx_apply_byte(buffer[upper_base + col], (uint8_t)(bits << shift), op);
+            if (lower)
+                buffer[lower_base + col] = gfx_apply_byte(buffer[lower_base + col], (uint8_t)(bits >> (8 - shift)), op);
+        }
+    }
+}
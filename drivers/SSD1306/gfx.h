@@ -0,0 +1,79 @@
+#ifndef GFX_H
+#define GFX_H
+
+#include <stdint.h>
+#include "ssd1306.h"
+
+/*
+ * Drawing primitives working directly on the SSD1306 screen buffer.
+ *
+ * Coordinates are signed so shapes may be partially off screen; clipping is
+ * done once per call, never per pixel. Spans and rectangles touch whole
+ * bytes (one byte holds 8 rows of a column) and use 32-bit stores across
+ * columns. Every function accepts SSD1306_COLOR_INVERT for XOR drawing.
+ */
+
+/**
+ * @brief Draws a horizontal line.
+ * @param[in] x Leftmost column.
+ * @param[in] y Row.
+ * @param[in] w Length in pixels.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_draw_hline(int16_t x, int16_t y, int16_t w, ssd1306_color_t color);
+
+/**
+ * @brief Draws a vertical line.
+ * @param[in] x Column.
+ * @param[in] y Top row.
+ * @param[in] h Length in pixels.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_draw_vline(int16_t x, int16_t y, int16_t h, ssd1306_color_t color);
+
+/**
+ * @brief Fills a rectangle.
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row.
+ * @param[in] w Width in pixels.
+ * @param[in] h Height in pixels.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, ssd1306_color_t color);
+
+/**
+ * @brief Draws the one pixel wide outline of a rectangle.
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row.
+ * @param[in] w Width in pixels.
+ * @param[in] h Height in pixels.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, ssd1306_color_t color);
+
+/**
+ * @brief Draws a line between two points (Bresenham), both ends included.
+ * @param[in] x0 Start column.
+ * @param[in] y0 Start row.
+ * @param[in] x1 End column.
+ * @param[in] y1 End row.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, ssd1306_color_t color);
+
+/**
+ * @brief Draws a 1-bpp bitmap. Set bits are drawn with color, clear bits are transparent.
+ *
+ * The bitmap uses the screen buffer layout: ceil(h / 8) pages of w bytes,
+ * each byte a column of 8 rows with bit 0 at the top (same as the font).
+ *
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row, any alignment.
+ * @param[in] bitmap Pointer to the bitmap data.
+ * @param[in] w Width in pixels.
+ * @param[in] h Height in pixels.
+ * @param[in] color BLACK, WHITE or INVERT.
+ */
+void gfx_draw_bitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, ssd1306_color_t color);
+
+#endif // GFX_H
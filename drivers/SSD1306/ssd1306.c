@@ -1,110 +1,300 @@
 #include "ssd1306.h"
+#include "placement.h"
 
 // --- Private Module Variables ---
 
 // Screen buffer in RAM. Each byte represents a vertical column of 8 pixels.
-static uint8_t g_ssd1306_buffer[SSD1306_BUFFER_SIZE];
+// Word aligned so it can be filled 32 bits at a time, and kept in SRAM1
+// (DMA_BUFFER) so a DMA channel can stream it to the display.
+static uint8_t g_ssd1306_buffer[SSD1306_BUFFER_SIZE] DMA_BUFFER;
 
 // I2C port used for communication
 static i2c_t* i2c_port = NULL;
 
+// Dirty column range of every page, empty when start > end
+static uint8_t g_dirty_start[SSD1306_PAGES];
+static uint8_t g_dirty_end[SSD1306_PAGES];
+
+// Initialization state machine
+static volatile ssd1306_state_t g_state = SSD1306_STATE_IDLE;
+static uint16_t g_init_step = 0;
+static uint32_t g_init_start_tick = 0;
+
+#define SSD1306_POWER_UP_MS  (100U)   // Time for VDD/VCC to settle before the first command
+
+// --- Control bytes ---
+#define SSD1306_CTRL_COMMANDS (0x00)  // Co = 0, D/C# = 0: every following byte is a command
+#define SSD1306_CTRL_COMMAND  (0x80)  // Co = 1, D/C# = 0: one command, another control byte follows
+#define SSD1306_CTRL_DATA     (0x40)  // Co = 0, D/C# = 1: every following byte is display data
+
+// Initialization sequence for a 128x32 SSD1306, sent as a single command stream
+static const uint8_t g_init_commands[] = {
+    0xAE,       // Display OFF
+    0x20, 0x00, // Set Memory Addressing Mode: 00,Horizontal; 01,Vertical; 10,Page Addressing Mode (RESET); 11,Invalid
+    0xC8,       // Set COM Output Scan Direction
+    0x40,       // --set start line address
+    0x81, 0xFF, // --set contrast control register
+    0xA1,       // --set segment re-map 0 to 127
+    0xA6,       // --set normal display
+    0xA8, SSD1306_HEIGHT - 1, // --set multiplex ratio(1 to 64)
+    0xA4,       // 0xa4,Output follows RAM content; 0xa5,Output ignores RAM content
+    0xD3, 0x00, // -set display offset: not offset
+    0xD5, 0xF0, // --set display clock divide ratio/oscillator frequency
+    0xD9, 0x22, // --set pre-charge period
+    0xDA, (SSD1306_HEIGHT == 64) ? 0x12 : 0x02, // --set com pins hardware configuration
+    0xDB, 0x20, // --set vcomh: 0x20,0.77xVcc
+    0x8D, 0x14, // --set DC-DC enable
+    0xAF        // --turn on SSD1306 panel
+};
+
 // --- Private Helper Functions ---
 
 /**
- * @brief Sends a single command byte to the SSD1306.
- * @param[in] cmd The command byte to send.
+ * @brief Sends a sequence of commands in one I2C transaction.
+ * @param[in] cmds Pointer to the command bytes.
+ * @param[in] count Number of command bytes.
+ * @return 0 on success, non-zero on I2C error.
+ */
+static int ssd1306_write_commands(const uint8_t *cmds, uint16_t count) {
+    if (i2c_port == NULL) return -1;
+    // The command stream is [Control Byte (0x00), Command Bytes...]
+    static const uint8_t control = SSD1306_CTRL_COMMANDS;
+    return i2c_master_write_prefixed(i2c_port, SSD1306_I2C_ADDR, &control, 1, cmds, count);
+}
+
+/**
+ * @brief Sends a window of the screen buffer, addressing included, in one transaction.
+ *
+ * The column/page window commands travel as Co = 1 command pairs in front of
+ * the 0x40 data control byte, so no separate command transaction is needed.
+ * The window must be contiguous in the buffer: a single page or full width.
+ *
+ * @param[in] first_page The first page to send.
+ * @param[in] last_page The last page to send (inclusive).
+ * @param[in] col_start The first column to send.
+ * @param[in] col_end The last column to send (inclusive).
+ */
+static int ssd1306_send_window(uint8_t first_page, uint8_t last_page, uint8_t col_start, uint8_t col_end) {
+    if (i2c_port == NULL) return -1;
+    const uint8_t header[] = {
+        SSD1306_CTRL_COMMAND, 0x21,                     // Set Column Address
+        SSD1306_CTRL_COMMAND, col_start,                // Column start
+        SSD1306_CTRL_COMMAND, col_end,                  // Column end
+        SSD1306_CTRL_COMMAND, 0x22,                     // Set Page Address
+        SSD1306_CTRL_COMMAND, first_page,               // Page start
+        SSD1306_CTRL_COMMAND, last_page,                // Page end
+        SSD1306_CTRL_DATA
+    };
+    return i2c_master_write_prefixed(i2c_port, SSD1306_I2C_ADDR, header, sizeof(header),
+                                     &g_ssd1306_buffer[first_page * SSD1306_WIDTH + col_start],
+                                     (uint32_t)(last_page - first_page) * SSD1306_WIDTH + (col_end - col_start + 1));
+}
+
+/**
+ * @brief Forgets every pending dirty region.
  */
-static void ssd1306_write_command(uint8_t cmd) {
-    if (i2c_port == NULL) return;
-    // The command sequence is [Control Byte (0x00), Command Byte]
-    uint8_t buffer[2] = {0x00, cmd};
-    i2c_master_write(i2c_port, SSD1306_I2C_ADDR, buffer, 2);
+static void ssd1306_clear_dirty(void) {
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        g_dirty_start[page] = SSD1306_WIDTH - 1;
+        g_dirty_end[page] = 0;
+    }
 }
 
 // --- Public API Implementation ---
 
 /**
- * @brief Initializes the SSD1306 display.
+ * @brief Starts the non-blocking initialization.
  */
-bool ssd1306_init(i2c_t *I2Cx) {
+bool ssd1306_init_start(i2c_t *I2Cx) {
     if (I2Cx == NULL) return false;
     i2c_port = I2Cx;
 
-    // A short delay is good practice before starting initialization
-    systick_delay_ms(100);
-
-    // Standard initialization sequence for a 128x64 SSD1306
-    ssd1306_write_command(0xAE); // Display OFF
-    ssd1306_write_command(0x20); // Set Memory Addressing Mode
-    ssd1306_write_command(0x10); // 00,Horizontal Addressing Mode; 01,Vertical Addressing Mode; 10,Page Addressing Mode (RESET); 11,Invalid
-    ssd1306_write_command(0xB0); // Set Page Start Address for Page Addressing Mode, 0-7
-    ssd1306_write_command(0xC8); // Set COM Output Scan Direction
-    ssd1306_write_command(0x00); // ---set low column address
-    ssd1306_write_command(0x10); // ---set high column address
-    ssd1306_write_command(0x40); // --set start line address
-    ssd1306_write_command(0x81); // --set contrast control register
-    ssd1306_write_command(0xFF);
-    ssd1306_write_command(0xA1); // --set segment re-map 0 to 127
-    ssd1306_write_command(0xA6); // --set normal display
-    ssd1306_write_command(0xA8); // --set multiplex ratio(1 to 64)
-    ssd1306_write_command(0x3F); //
-    ssd1306_write_command(0xA4); // 0xa4,Output follows RAM content; 0xa5,Output ignores RAM content
-    ssd1306_write_command(0xD3); // -set display offset
-    ssd1306_write_command(0x00); // -not offset
-    ssd1306_write_command(0xD5); // --set display clock divide ratio/oscillator frequency
-    ssd1306_write_command(0xF0); // --set divide ratio
-    ssd1306_write_command(0xD9); // --set pre-charge period
-    ssd1306_write_command(0x22); //
-    ssd1306_write_command(0xDA); // --set com pins hardware configuration
-    ssd1306_write_command(0x12);
-    ssd1306_write_command(0xDB); // --set vcomh
-    ssd1306_write_command(0x20); // 0x20,0.77xVcc
-    ssd1306_write_command(0x8D); // --set DC-DC enable
-    ssd1306_write_command(0x14); //
-    ssd1306_write_command(0xAF); // --turn on SSD1306 panel
-
-    // Clear the screen buffer and update the display
-    ssd1306_fill(SSD1306_COLOR_BLACK);
-    ssd1306_update_screen();
-
+    g_init_step = 0;
+    g_init_start_tick = systick_getTick();
+    g_state = SSD1306_STATE_POWER_UP;
     return true;
 }
 
+/**
+ * @brief Advances the initialization by one short step.
+ */
+ssd1306_state_t ssd1306_init_poll(void) {
+    switch (g_state) {
+        case SSD1306_STATE_POWER_UP:
+            // Non-blocking replacement for the power-up delay
+            if (systick_elapsed(g_init_start_tick, SSD1306_POWER_UP_MS))
+                g_state = SSD1306_STATE_COMMANDS;
+            break;
+
+        case SSD1306_STATE_COMMANDS:
+            // The whole table goes out in one transaction (under 1 ms at 400 kHz)
+            if (ssd1306_write_commands(g_init_commands, sizeof(g_init_commands)) != 0) {
+                g_state = SSD1306_STATE_ERROR;
+                break;
+            }
+            ssd1306_fill(SSD1306_COLOR_BLACK);
+            g_init_step = 0;
+            g_state = SSD1306_STATE_CLEAR;
+            break;
+
+        case SSD1306_STATE_CLEAR:
+            // One page of the blank frame per call
+            if (ssd1306_send_window(g_init_step, g_init_step, 0, SSD1306_WIDTH - 1) != 0) {
+                g_state = SSD1306_STATE_ERROR;
+                break;
+            }
+            if (++g_init_step >= SSD1306_PAGES) {
+                ssd1306_clear_dirty();
+                g_state = SSD1306_STATE_READY;
+            }
+            break;
+
+        default:
+            break;
+    }
+    return g_state;
+}
+
+/**
+ * @brief Returns true once the display is initialized.
+ */
+bool ssd1306_is_ready(void) {
+    return g_state == SSD1306_STATE_READY;
+}
+
+/**
+ * @brief Initializes the SSD1306 display.
+ */
+bool ssd1306_init(i2c_t *I2Cx) {
+    if (!ssd1306_init_start(I2Cx)) return false;
+
+    ssd1306_state_t state;
+    do {
+        state = ssd1306_init_poll();
+    } while (state != SSD1306_STATE_READY && state != SSD1306_STATE_ERROR);
+
+    return state == SSD1306_STATE_READY;
+}
+
 /**
  * @brief Fills the entire screen buffer with a specified color.
  */
 void ssd1306_fill(ssd1306_color_t color) {
-    uint8_t fill_val = (color == SSD1306_COLOR_BLACK) ? 0x00 : 0xFF;
+    ssd1306_word_t *words = (ssd1306_word_t *)g_ssd1306_buffer;
+
+    if (color == SSD1306_COLOR_INVERT) {
+        for (uint16_t i = 0; i < SSD1306_BUFFER_SIZE / 4; i++) {
+            words[i] = ~words[i];
+        }
+        return;
+    }
+
+    uint32_t fill_val = (color == SSD1306_COLOR_BLACK) ? 0x00000000U : 0xFFFFFFFFU;
+    for (uint16_t i = 0; i < SSD1306_BUFFER_SIZE / 4; i++) {
+        words[i] = fill_val;
+    }
+}
+
+/**
+ * @brief Returns the screen buffer for direct drawing.
+ */
+uint8_t *ssd1306_get_buffer(void) {
+    return g_ssd1306_buffer;
+}
+
+/**
+ * @brief Reads back a pixel from the screen buffer.
+ */
+bool ssd1306_get_pixel(uint8_t x, uint8_t y) {
+    if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) {
+        return false;
+    }
+    return (g_ssd1306_buffer[x + (y / 8) * SSD1306_WIDTH] >> (y % 8)) & 1;
+}
+
+/**
+ * @brief Copies the screen buffer.
+ */
+void ssd1306_snapshot(uint8_t *dst) {
+    if (dst == NULL) return;
     for (uint16_t i = 0; i < SSD1306_BUFFER_SIZE; i++) {
-        g_ssd1306_buffer[i] = fill_val;
+        dst[i] = g_ssd1306_buffer[i];
+    }
+}
+
+/**
+ * @brief Converts the screen buffer into a binary PBM (P4) image.
+ */
+uint32_t ssd1306_export_pbm(uint8_t *dst, uint32_t size) {
+    static const char header[] = "P4\n128 32\n";
+    _Static_assert(SSD1306_WIDTH == 128 && SSD1306_HEIGHT == 32, "update the PBM header");
+
+    if (dst == NULL || size < SSD1306_PBM_SIZE) return 0;
+
+    uint32_t n = 0;
+    for (; header[n]; n++) {
+        dst[n] = (uint8_t)header[n];
     }
+
+    // Transpose: every output byte holds 8 horizontal pixels of one row
+    for (uint8_t y = 0; y < SSD1306_HEIGHT; y++) {
+        const uint8_t *page = &g_ssd1306_buffer[(y / 8) * SSD1306_WIDTH];
+        uint8_t bit = y % 8;
+        for (uint8_t x = 0; x < SSD1306_WIDTH; x += 8) {
+            uint8_t packed = 0;
+            for (uint8_t i = 0; i < 8; i++) {
+                packed = (uint8_t)((packed << 1) | ((page[x + i] >> bit) & 1));
+            }
+            dst[n++] = packed;
+        }
+    }
+    return n;
 }
 
 /**
  * @brief Updates the physical screen with the contents of the screen buffer.
  */
 void ssd1306_update_screen(void) {
-    if (i2c_port == NULL) return;
-
-    // Set the display cursor to the top-left corner
-    ssd1306_write_command(0x21); // Set Column Address
-    ssd1306_write_command(0);    // Column start
-    ssd1306_write_command(127);  // Column end
-    ssd1306_write_command(0x22); // Set Page Address
-    ssd1306_write_command(0);    // Page start
-    ssd1306_write_command(3);    // Page end (8 pages for 64 rows)
-
-    // The data transfer needs a control byte (0x40) followed by the data.
-    // We create a temporary buffer to hold the control byte and a chunk of data.
-    uint8_t data_chunk[17]; // 1 control byte + 16 data bytes
-    data_chunk[0] = 0x40;   // Data control byte
-
-    for (uint16_t i = 0; i < SSD1306_BUFFER_SIZE; i += 16) {
-        for (uint8_t j = 0; j < 16; j++) {
-            data_chunk[j + 1] = g_ssd1306_buffer[i + j];
-        }
-        i2c_master_write(i2c_port, SSD1306_I2C_ADDR, data_chunk, sizeof(data_chunk));
+    if (g_state != SSD1306_STATE_READY) return;
+
+    // Window and frame data in a single transaction
+    if (ssd1306_send_window(0, SSD1306_PAGES - 1, 0, SSD1306_WIDTH - 1) == 0)
+        ssd1306_clear_dirty();
+}
+
+/**
+ * @brief Marks a region of the screen buffer as modified.
+ */
+void ssd1306_mark_dirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    int32_t x0 = x, y0 = y, x1 = (int32_t)x + w - 1, y1 = (int32_t)y + h - 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= SSD1306_WIDTH) x1 = SSD1306_WIDTH - 1;
+    if (y1 >= SSD1306_HEIGHT) y1 = SSD1306_HEIGHT - 1;
+    if (x0 > x1 || y0 > y1) return;
+
+    for (uint8_t page = (uint8_t)(y0 >> 3); page <= (uint8_t)(y1 >> 3); page++) {
+        if (x0 < g_dirty_start[page]) g_dirty_start[page] = (uint8_t)x0;
+        if (x1 > g_dirty_end[page]) g_dirty_end[page] = (uint8_t)x1;
+    }
+}
+
+/**
+ * @brief Sends only the dirty part of every page.
+ */
+bool ssd1306_update_dirty(void) {
+    if (g_state != SSD1306_STATE_READY) return false;
+
+    bool sent = false;
+    for (uint8_t page = 0; page < SSD1306_PAGES; page++) {
+        if (g_dirty_start[page] > g_dirty_end[page]) continue;
+
+        if (ssd1306_send_window(page, page, g_dirty_start[page], g_dirty_end[page]) != 0) return sent;
+        g_dirty_start[page] = SSD1306_WIDTH - 1;
+        g_dirty_end[page] = 0;
+        sent = true;
     }
+    return sent;
 }
 
 /**
@@ -122,6 +312,8 @@ void ssd1306_draw_pixel(uint8_t x, uint8_t y, ssd1306_color_t color) {
 
     if (color == SSD1306_COLOR_WHITE) {
         g_ssd1306_buffer[buffer_index] |= (1 << bit_pos);
+    } else if (color == SSD1306_COLOR_INVERT) {
+        g_ssd1306_buffer[buffer_index] ^= (1 << bit_pos);
     } else {
         g_ssd1306_buffer[buffer_index] &= ~(1 << bit_pos);
     }
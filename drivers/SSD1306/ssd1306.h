@@ -10,41 +10,138 @@
 #define SSD1306_I2C_ADDR   (0x3C) // Default I2C address for many 128x64 displays
 #define SSD1306_WIDTH      (128)
 #define SSD1306_HEIGHT     (32)
+#define SSD1306_PAGES      (SSD1306_HEIGHT / 8)
 #define SSD1306_BUFFER_SIZE (SSD1306_WIDTH * SSD1306_HEIGHT / 8)
 
+// 32-bit view of the screen buffer, allowed to alias its bytes
+typedef uint32_t __attribute__((may_alias)) ssd1306_word_t;
+
 // --- Color Enum ---
 // Monochrome display: only two "colors"
 typedef enum {
     SSD1306_COLOR_BLACK = 0, // Pixel is off
-    SSD1306_COLOR_WHITE = 1  // Pixel is on
+    SSD1306_COLOR_WHITE = 1, // Pixel is on
+    SSD1306_COLOR_INVERT = 2 // Pixel is toggled (XOR)
 } ssd1306_color_t;
 
 
+// --- Initialization State ---
+typedef enum {
+    SSD1306_STATE_IDLE,     // ssd1306_init_start() not called yet
+    SSD1306_STATE_POWER_UP, // Waiting for the panel supply to settle
+    SSD1306_STATE_COMMANDS, // Sending the configuration commands
+    SSD1306_STATE_CLEAR,    // Sending a blank frame
+    SSD1306_STATE_READY,
+    SSD1306_STATE_ERROR     // The display did not acknowledge
+} ssd1306_state_t;
+
+
 // --- Public API Functions ---
 
 /**
- * @brief Initializes the SSD1306 display.
+ * @brief Initializes the SSD1306 display, blocking until it is done (~110 ms).
  * @param[in] i2c_port Pointer to the initialized I2C peripheral to use.
  * @return true on success, false on failure.
  */
 bool ssd1306_init(i2c_t *i2c_port);
 
+/**
+ * @brief Starts a non-blocking initialization of the display.
+ *
+ * The power-up wait, the configuration commands and the blank frame are
+ * spread over calls to ssd1306_init_poll(), each taking a few milliseconds at most.
+ *
+ * @param[in] i2c_port Pointer to the initialized I2C peripheral to use.
+ * @return true on success, false on invalid arguments.
+ */
+bool ssd1306_init_start(i2c_t *i2c_port);
+
+/**
+ * @brief Runs the next initialization step. Call from the main loop.
+ * @return The current state; SSD1306_STATE_READY or SSD1306_STATE_ERROR when done.
+ */
+ssd1306_state_t ssd1306_init_poll(void);
+
+/**
+ * @brief Returns true once the display is initialized and can be updated.
+ */
+bool ssd1306_is_ready(void);
+
 /**
  * @brief Fills the entire screen buffer with a specified color.
  * @param[in] color The color to fill the screen with (BLACK or WHITE).
  */
 void ssd1306_fill(ssd1306_color_t color);
 
+/**
+ * @brief Returns the screen buffer for direct drawing (e.g., by gfx.h).
+ *
+ * Byte x + page * SSD1306_WIDTH holds column x of rows page*8 to page*8+7,
+ * bit 0 being the top row. The buffer is 32-bit aligned.
+ */
+uint8_t *ssd1306_get_buffer(void);
+
+/**
+ * @brief Reads back a pixel from the screen buffer.
+ * @param[in] x The x-coordinate.
+ * @param[in] y The y-coordinate.
+ * @return true if the pixel is on, false if off or out of bounds.
+ */
+bool ssd1306_get_pixel(uint8_t x, uint8_t y);
+
+/**
+ * @brief Copies the screen buffer (SSD1306_BUFFER_SIZE bytes, page organised).
+ * @param[out] dst Destination buffer.
+ */
+void ssd1306_snapshot(uint8_t *dst);
+
+/**
+ * @brief Size of the image written by ssd1306_export_pbm().
+ */
+#define SSD1306_PBM_SIZE (sizeof("P4\n128 32\n") - 1 + SSD1306_BUFFER_SIZE)
+
+/**
+ * @brief Converts the screen buffer into a binary PBM (P4) image.
+ *
+ * The PBM is row-major, MSB first, with lit pixels as 1 (drawn black on
+ * white by image viewers). tools/fb2pbm.py converts raw page-organised
+ * dumps the same way on the host.
+ *
+ * @param[out] dst Destination buffer.
+ * @param[in] size Size of dst, at least SSD1306_PBM_SIZE.
+ * @return Number of bytes written, or 0 if dst is too small.
+ */
+uint32_t ssd1306_export_pbm(uint8_t *dst, uint32_t size);
+
 /**
  * @brief Updates the physical screen with the contents of the screen buffer.
  */
 void ssd1306_update_screen(void);
 
+/**
+ * @brief Marks a region of the screen buffer as modified.
+ *
+ * Regions are accumulated as one column range per page until the next
+ * ssd1306_update_dirty() or ssd1306_update_screen().
+ *
+ * @param[in] x Leftmost column.
+ * @param[in] y Top row.
+ * @param[in] w Width in pixels.
+ * @param[in] h Height in pixels.
+ */
+void ssd1306_mark_dirty(int16_t x, int16_t y, int16_t w, int16_t h);
+
+/**
+ * @brief Sends only the dirty regions to the display, one transaction per dirty page.
+ * @return true if anything was sent.
+ */
+bool ssd1306_update_dirty(void);
+
 /**
  * @brief Draws a single pixel in the screen buffer.
  * @param[in] x The x-coordinate (0-127).
  * @param[in] y The y-coordinate (0-63).
- * @param[in] color The color of the pixel (BLACK or WHITE).
+ * @param[in] color The color of the pixel (BLACK, WHITE or INVERT).
  */
 void ssd1306_draw_pixel(uint8_t x, uint8_t y, ssd1306_color_t color);
 
@@ -0,0 +1,110 @@
+#include "widget.h"
+
+#define WIDGET_CHAR_WIDTH (6)   // 5 pixel glyph + 1 pixel spacing
+
+/**
+ * @brief Draws text clipped to the widget box, without wrapping.
+ */
+static void widget_draw_text(const widget_t *widget, int16_t x, const char *str) {
+    int16_t right = widget->x + widget->w;
+    while (str != NULL && *str && x + WIDGET_CHAR_WIDTH - 1 <= right) {
+        x = ssd1306_draw_char((uint8_t)x, (uint8_t)widget->y, *str++, SSD1306_COLOR_WHITE);
+    }
+}
+
+/**
+ * @brief Formats a signed integer into buf (at least 12 bytes).
+ */
+static const char *widget_format_int(int32_t value, char *buf, uint8_t size) {
+    char *p = &buf[size - 1];
+    uint32_t magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+
+    *p = '\0';
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        *--p = '-';
+    return p;
+}
+
+/**
+ * @brief Returns the cache key of the widget's current state.
+ *
+ * For bars the key is the filled width in pixels, so value changes that do
+ * not move the bar do not trigger a redraw.
+ */
+static uintptr_t widget_key(const widget_t *widget) {
+    switch (widget->type) {
+        case WIDGET_TYPE_LABEL:
+            return (uintptr_t)*widget->bind.label.text;
+        case WIDGET_TYPE_NUMBER:
+            return (uintptr_t)(uint32_t)*widget->bind.number.value;
+        case WIDGET_TYPE_ICON:
+            return *widget->bind.icon.index;
+        case WIDGET_TYPE_BAR: {
+            int32_t value = *widget->bind.bar.value;
+            int32_t max = widget->bind.bar.max;
+            int32_t inner = widget->w - 2;
+            if (max <= 0 || value <= 0 || inner <= 0) return 0;
+            if (value >= max) return (uintptr_t)inner;
+            return (uintptr_t)((value * inner) / max);
+        }
+    }
+    return 0;
+}
+
+static void widget_draw(const widget_t *widget, uintptr_t key) {
+    switch (widget->type) {
+        case WIDGET_TYPE_LABEL:
+            widget_draw_text(widget, widget->x, (const char *)key);
+            break;
+
+        case WIDGET_TYPE_NUMBER: {
+            char digits[12];
+            int16_t x = widget->x;
+            const char *text = widget_format_int((int32_t)(uint32_t)key, digits, sizeof(digits));
+            for (const char *c = text; *c; c++)
+                x += WIDGET_CHAR_WIDTH;
+            widget_draw_text(widget, widget->x, text);
+            widget_draw_text(widget, x, widget->bind.number.suffix);
+            break;
+        }
+
+        case WIDGET_TYPE_ICON:
+            if (key < widget->bind.icon.count)
+                gfx_draw_bitmap(widget->x, widget->y, widget->bind.icon.bitmaps[key], widget->w, widget->h, SSD1306_COLOR_WHITE);
+            break;
+
+        case WIDGET_TYPE_BAR:
+            gfx_draw_rect(widget->x, widget->y, widget->w, widget->h, SSD1306_COLOR_WHITE);
+            gfx_fill_rect(widget->x + 1, widget->y + 1, (int16_t)key, widget->h - 2, SSD1306_COLOR_WHITE);
+            break;
+    }
+}
+
+bool widget_render(widget_t *widgets, uint8_t count) {
+    bool changed = false;
+
+    for (uint8_t i = 0; i < count; i++) {
+        widget_t *widget = &widgets[i];
+        uintptr_t key = widget_key(widget);
+        if (widget->valid && widget->cache == key) continue;
+
+        gfx_fill_rect(widget->x, widget->y, widget->w, widget->h, SSD1306_COLOR_BLACK);
+        widget_draw(widget, key);
+        ssd1306_mark_dirty(widget->x, widget->y, widget->w, widget->h);
+
+        widget->cache = key;
+        widget->valid = true;
+        changed = true;
+    }
+    return changed;
+}
+
+void widget_invalidate(widget_t *widgets, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        widgets[i].valid = false;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+#include "gfx.h"
+
+/*
+ * Retained-mode widgets for the SSD1306.
+ *
+ * Each widget is bound to a variable of the application and remembers what
+ * it last drew. widget_render() compares the bound values with that cache
+ * and only redraws, and marks dirty, the widgets whose output would change.
+ * When nothing changed a refresh costs one comparison per widget and no I2C
+ * traffic. Widgets are declared statically with the WIDGET_* macros.
+ */
+
+typedef enum {
+    WIDGET_TYPE_LABEL,      // Text from a bound string pointer
+    WIDGET_TYPE_NUMBER,     // Signed integer with an optional suffix
+    WIDGET_TYPE_ICON,       // Bitmap chosen by a bound index
+    WIDGET_TYPE_BAR         // Horizontal progress bar
+} widget_type_t;
+
+typedef struct {
+    widget_type_t type;
+    int16_t x, y;           // Bounding box, cleared before every redraw
+    uint8_t w, h;
+    union {
+        struct {
+            const char *const volatile *text;   // Points to the application's string pointer
+        } label;
+        struct {
+            const volatile int32_t *value;
+            const char *suffix;                 // e.g. " RPM", may be NULL
+        } number;
+        struct {
+            const volatile uint8_t *index;
+            const uint8_t *const *bitmaps;      // Same layout as gfx_draw_bitmap(), w x h each
+            uint8_t count;
+        } icon;
+        struct {
+            const volatile int32_t *value;
+            int32_t max;                        // Value of a full bar
+        } bar;
+    } bind;
+    uintptr_t cache;        // What was last drawn (string pointer, value, index or bar pixels)
+    bool valid;             // false forces the next redraw
+} widget_t;
+
+#define WIDGET_LABEL(x_, y_, w_, text_ptr) \
+    { .type = WIDGET_TYPE_LABEL, .x = (x_), .y = (y_), .w = (w_), .h = 8, .bind.label = { (text_ptr) } }
+#define WIDGET_NUMBER(x_, y_, w_, value_ptr, suffix_) \
+    { .type = WIDGET_TYPE_NUMBER, .x = (x_), .y = (y_), .w = (w_), .h = 8, .bind.number = { (value_ptr), (suffix_) } }
+#define WIDGET_ICON(x_, y_, w_, h_, index_ptr, bitmaps_, count_) \
+    { .type = WIDGET_TYPE_ICON, .x = (x_), .y = (y_), .w = (w_), .h = (h_), .bind.icon = { (index_ptr), (bitmaps_), (count_) } }
+#define WIDGET_BAR(x_, y_, w_, h_, value_ptr, max_) \
+    { .type = WIDGET_TYPE_BAR, .x = (x_), .y = (y_), .w = (w_), .h = (h_), .bind.bar = { (value_ptr), (max_) } }
+
+/**
+ * @brief Redraws the widgets whose bound value changed and marks them dirty.
+ *
+ * Follow with ssd1306_update_dirty() to send the changed regions.
+ *
+ * @param[in,out] widgets Array of widgets.
+ * @param[in] count Number of widgets.
+ * @return true if at least one widget was redrawn.
+ */
+bool widget_render(widget_t *widgets, uint8_t count);
+
+/**
+ * @brief Forces every widget to redraw on the next widget_render() (e.g., after a screen clear).
+ * @param[in,out] widgets Array of widgets.
+ * @param[in] count Number of widgets.
+ */
+void widget_invalidate(widget_t *widgets, uint8_t count);
+
+#endif // WIDGET_H
@@ -1,4 +1,6 @@
 #include "keyPad/keypad.h"
+#include "trace.h"
+#include "event.h"
 
 void keypad_init(const keypad_config_t *config)
 {
@@ -26,13 +28,13 @@ void keypad_init(const keypad_config_t *config)
         );
     }
 
-    ring_buffer_init(&keypad_rb, keypad_buffer_data, KEYPAD_BUFFER_SIZE);
     keypad_initialized = true;
 }
 
-void keypad_irq_handler(void)
+RAMFUNC void keypad_irq_handler(void)
 {
     if(!keypad_initialized) return;
+    TRACE_BEGIN_EVENT(TRACE_EV_KEYPAD_ISR, 0);
 
     // 1. Disable all column interrupts to prevent bouncing and re-entry.
     // We only need to disable the shared IRQ lines, not individual pins.
@@ -66,9 +68,9 @@ void keypad_irq_handler(void)
         }
     }
 
-    // 4. If a valid key was found, write it to the buffer.
+    // 4. If a valid key was found, hand it to the application.
     if(pressed_key != '\0') {
-        ring_buffer_write(&keypad_rb, (uint8_t)pressed_key);
+        event_post(EVENT_KEY_PRESSED, EVENT_PRIO_NORMAL, (uint8_t)pressed_key);
     }
     
     // 5. CRITICAL: Clear all potential pending EXTI flags for the columns.
@@ -79,10 +81,5 @@ void keypad_irq_handler(void)
         IRQn_t irq = get_irqn_for_exti_line(keypad_config.col_pin[c]);
         nvic_irq_enable(irq);
     }
-}
-
-bool keypad_read_key(char *key)
-{
-    if(key == NULL) return false;
-    return ring_buffer_read(&keypad_rb, (uint8_t *)key);
+    TRACE_END_EVENT(TRACE_EV_KEYPAD_ISR, (uint8_t)pressed_key);
 }
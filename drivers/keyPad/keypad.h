@@ -1,15 +1,14 @@
 #ifndef KEYPAD_H
 #define KEYPAD_H
 
-#include "ringBuffer/ringBuffer.h"
 #include "systick.h"
 #include "gpio.h"
 #include "exti.h"
 #include "nvic.h"
+#include "placement.h"
 
 #define NUM_ROWS 4
 #define NUM_COLS 4
-#define KEYPAD_BUFFER_SIZE (NUM_ROWS * NUM_COLS)
 
 static const char keypad_map[NUM_ROWS][NUM_COLS] = {
     {'1', '2', '3', 'A'},
@@ -18,9 +17,6 @@ static const char keypad_map[NUM_ROWS][NUM_COLS] = {
     {'*', '0', '#', 'D'}
 };
 
-static ring_buffer_t keypad_rb;
-static uint8_t keypad_buffer_data[KEYPAD_BUFFER_SIZE];
-
 typedef struct {
     gpio_t *row_port[NUM_ROWS];
     uint8_t row_pin[NUM_ROWS];
@@ -54,14 +50,9 @@ void keypad_init(const keypad_config_t *config);
  *
  * This function should be called from ALL column pin EXTI Handlers.
  * It disables interrupts, debounces, scans, and re-enables interrupts.
+ * A key found is posted as an EVENT_KEY_PRESSED event (event.h).
+ * Runs from SRAM2 (RAMFUNC).
  */
-void keypad_irq_handler(void);
-
-/**
- * @brief Reads a single character from the keypad buffer.
- * @param[out] key Pointer to a variable to store the read key.
- * @return true if a key was read, false if the buffer is empty.
- */
-bool keypad_read_key(char *key);
+RAMFUNC void keypad_irq_handler(void);
 
 #endif
@@ -0,0 +1,500 @@
+#include "kvStore.h"
+#include <string.h>
+
+#define KV_PAGE_MAGIC       0x3153564BUL    // "KVS1"
+#define KV_RECORD_VALUE     0xA5
+#define KV_RECORD_DELETE    0x5A
+#define KV_ALIGN8(n)        (((n) + 7U) & ~7U)
+
+// Reserved flash area, defined in the linker script
+extern uint8_t _skvstore[];
+extern uint8_t _ekvstore[];
+
+// First double-word of a page. Written last, when the page content is complete.
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+} kv_page_header_t;
+
+// Record header, one double-word followed by the value padded to 8 bytes
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint8_t type;
+    uint16_t crc;
+    uint16_t reserved;
+} kv_record_header_t;
+
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint32_t addr;      // Flash address of the value
+} kv_index_entry_t;
+
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint8_t type;
+    uint8_t data[KV_MAX_VALUE_LEN];
+} kv_pending_t;
+
+// Outcome of one flash step of kv_commit()
+typedef enum {
+    KV_STEP_DONE,       // The record is written
+    KV_STEP_AGAIN,      // A compaction step was done, the record is still to write
+    KV_STEP_FAILED
+} kv_step_t;
+
+_Static_assert(sizeof(kv_page_header_t) == 8, "page header must be one double-word");
+_Static_assert(sizeof(kv_record_header_t) == 8, "record header must be one double-word");
+_Static_assert(sizeof(kv_page_header_t) + (KV_MAX_KEYS + 1) * (sizeof(kv_record_header_t) + KV_ALIGN8(KV_MAX_VALUE_LEN)) <= FLASH_PAGE_SIZE,
+               "live records and one more must fit in a single page");
+
+static kv_index_entry_t g_index[KV_MAX_KEYS];
+static uint8_t g_index_count = 0;
+
+static kv_pending_t g_pending[KV_PENDING_MAX];
+static uint8_t g_pending_count = 0;
+
+static uint32_t g_page_addr = 0;    // Active page
+static uint32_t g_write_addr = 0;   // Next free double-word in the active page
+static uint32_t g_sequence = 0;
+static bool g_mounted = false;
+
+// Compaction in progress: next page, erased, being filled with the live records
+static uint32_t g_compact_addr = 0;     // 0 when no compaction runs
+static uint32_t g_compact_write;        // Next free double-word in that page
+static uint8_t g_compact_copied;        // Index entries already copied
+static uint32_t g_compact_value_addr[KV_MAX_KEYS];
+
+static uint32_t kv_page_count(void)
+{
+    return (uint32_t)(_ekvstore - _skvstore) / FLASH_PAGE_SIZE;
+}
+
+static uint32_t kv_page_address(uint32_t page)
+{
+    return (uint32_t)_skvstore + page * FLASH_PAGE_SIZE;
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE, bitwise to keep the code small.
+ */
+static uint16_t kv_crc16(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+    while(len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for(uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static uint16_t kv_record_crc(uint16_t key, uint8_t len, uint8_t type, const uint8_t *data)
+{
+    uint8_t head[4] = { (uint8_t)key, (uint8_t)(key >> 8), len, type };
+    return kv_crc16(kv_crc16(0xFFFFU, head, sizeof(head)), data, len);
+}
+
+static bool kv_is_erased(uint32_t addr, uint32_t end)
+{
+    for(; addr < end; addr += 4) {
+        if(*(const uint32_t *)addr != 0xFFFFFFFFUL)
+            return false;
+    }
+    return true;
+}
+
+static kv_index_entry_t *kv_index_find(uint16_t key)
+{
+    for(uint8_t i = 0; i < g_index_count; i++) {
+        if(g_index[i].key == key)
+            return &g_index[i];
+    }
+    return NULL;
+}
+
+static bool kv_index_put(uint16_t key, uint8_t len, uint32_t addr)
+{
+    kv_index_entry_t *entry = kv_index_find(key);
+    if(entry == NULL) {
+        if(g_index_count >= KV_MAX_KEYS)
+            return false;
+        entry = &g_index[g_index_count++];
+        entry->key = key;
+    }
+    entry->len = len;
+    entry->addr = addr;
+    return true;
+}
+
+static void kv_index_remove(uint16_t key)
+{
+    kv_index_entry_t *entry = kv_index_find(key);
+    if(entry != NULL)
+        *entry = g_index[--g_index_count];
+}
+
+static kv_pending_t *kv_pending_find(uint16_t key)
+{
+    // Newest first, a key is queued at most once anyway
+    for(uint8_t i = g_pending_count; i > 0; i--) {
+        if(g_pending[i - 1].key == key)
+            return &g_pending[i - 1];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Keys in flash plus the new keys waiting in the queue.
+ *
+ * Queued deletes are not subtracted: the slot they free only exists once
+ * they are committed, which may be after a new key queued before them.
+ */
+static uint8_t kv_keys_in_use(void)
+{
+    uint8_t count = g_index_count;
+    for(uint8_t i = 0; i < g_pending_count; i++) {
+        if(g_pending[i].type == KV_RECORD_VALUE && kv_index_find(g_pending[i].key) == NULL)
+            count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Rebuilds the RAM index from the records of the active page.
+ */
+static void kv_scan_page(void)
+{
+    uint32_t end = g_page_addr + FLASH_PAGE_SIZE;
+    uint32_t addr = g_page_addr + sizeof(kv_page_header_t);
+
+    g_index_count = 0;
+    while(addr + sizeof(kv_record_header_t) <= end) {
+        const kv_record_header_t *hdr = (const kv_record_header_t *)addr;
+        const uint8_t *data = (const uint8_t *)(addr + sizeof(kv_record_header_t));
+
+        if(kv_is_erased(addr, addr + sizeof(kv_record_header_t))) {
+            // End of the log. Leftovers of an interrupted write make the rest unusable.
+            g_write_addr = kv_is_erased(addr, end) ? addr : end;
+            return;
+        }
+
+        uint32_t size = sizeof(kv_record_header_t) + KV_ALIGN8(hdr->len);
+        bool valid = (hdr->type == KV_RECORD_VALUE || hdr->type == KV_RECORD_DELETE) &&
+                     hdr->len <= KV_MAX_VALUE_LEN && addr + size <= end &&
+                     hdr->crc == kv_record_crc(hdr->key, hdr->len, hdr->type, data);
+        if(!valid) {
+            // Torn record: keep what was read so far and compact on the next write
+            g_write_addr = end;
+            return;
+        }
+
+        if(hdr->type == KV_RECORD_VALUE)
+            kv_index_put(hdr->key, hdr->len, (uint32_t)data);
+        else
+            kv_index_remove(hdr->key);
+        addr += size;
+    }
+    g_write_addr = end;
+}
+
+/**
+ * @brief Programs one record at addr: the value first, the header last.
+ */
+static bool kv_program_record(uint32_t addr, uint16_t key, uint8_t type, const uint8_t *data, uint8_t len)
+{
+    uint32_t value_addr = addr + sizeof(kv_record_header_t);
+    for(uint8_t offset = 0; offset < len; offset += 8) {
+        uint8_t chunk[8];
+        uint8_t n = (len - offset < 8) ? (uint8_t)(len - offset) : 8;
+        memset(chunk, 0xFF, sizeof(chunk));
+        memcpy(chunk, &data[offset], n);
+
+        uint64_t dword;
+        memcpy(&dword, chunk, sizeof(dword));
+        if(flash_program_double_word(value_addr + offset, dword) != 0)
+            return false;
+    }
+
+    kv_record_header_t hdr = {
+        .key = key,
+        .len = len,
+        .type = type,
+        .crc = kv_record_crc(key, len, type, data),
+        .reserved = 0
+    };
+    uint64_t dword;
+    memcpy(&dword, &hdr, sizeof(dword));
+    return flash_program_double_word(addr, dword) == 0;
+}
+
+/**
+ * @brief Erases a page and marks it as the newest one. Used for an empty store.
+ */
+static bool kv_format_page(uint32_t page_addr, uint32_t sequence)
+{
+    if(flash_erase_page(page_addr) != 0)
+        return false;
+
+    kv_page_header_t page_hdr = { KV_PAGE_MAGIC, sequence };
+    uint64_t dword;
+    memcpy(&dword, &page_hdr, sizeof(dword));
+    return flash_program_double_word(page_addr, dword) == 0;
+}
+
+/**
+ * @brief Does one step of copying the live records into the next page.
+ *
+ * The first step erases the page (~22 ms), each later one copies a single
+ * record, so the main loop is never held for more than one erase. The page
+ * header is programmed last, so a power loss during compaction leaves the
+ * current page as the newest valid one. The RAM index does not change while
+ * a compaction runs: only kv_commit() modifies it.
+ *
+ * @return true if the step succeeded. A failure abandons the compaction,
+ *         the next step starts over with the erase.
+ */
+static bool kv_compact_step(void)
+{
+    if(g_compact_addr == 0) {
+        uint32_t page = (g_page_addr - (uint32_t)_skvstore) / FLASH_PAGE_SIZE;
+        uint32_t next_addr = kv_page_address((page + 1) % kv_page_count());
+        if(flash_erase_page(next_addr) != 0)
+            return false;
+        g_compact_addr = next_addr;
+        g_compact_write = next_addr + sizeof(kv_page_header_t);
+        g_compact_copied = 0;
+        return true;
+    }
+
+    if(g_compact_copied < g_index_count) {
+        const kv_index_entry_t *entry = &g_index[g_compact_copied];
+        if(!kv_program_record(g_compact_write, entry->key, KV_RECORD_VALUE, (const uint8_t *)entry->addr, entry->len)) {
+            g_compact_addr = 0;
+            return false;
+        }
+        g_compact_value_addr[g_compact_copied++] = g_compact_write + sizeof(kv_record_header_t);
+        g_compact_write += sizeof(kv_record_header_t) + KV_ALIGN8(entry->len);
+        return true;
+    }
+
+    kv_page_header_t page_hdr = { KV_PAGE_MAGIC, g_sequence + 1 };
+    uint64_t dword;
+    memcpy(&dword, &page_hdr, sizeof(dword));
+    uint32_t next_addr = g_compact_addr;
+    g_compact_addr = 0;
+    if(flash_program_double_word(next_addr, dword) != 0)
+        return false;
+
+    // The new page is committed, switch the index over
+    for(uint8_t i = 0; i < g_index_count; i++)
+        g_index[i].addr = g_compact_value_addr[i];
+    g_page_addr = next_addr;
+    g_write_addr = g_compact_write;
+    g_sequence++;
+    return true;
+}
+
+/**
+ * @brief Does one flash step towards writing a buffered record: the record
+ *        itself, or a compaction step while the active page has no room.
+ */
+static kv_step_t kv_commit(const kv_pending_t *pending)
+{
+    uint32_t size = sizeof(kv_record_header_t) + KV_ALIGN8(pending->len);
+    kv_step_t step;
+
+    flash_unlock();
+    if(g_compact_addr != 0 || g_write_addr + size > g_page_addr + FLASH_PAGE_SIZE) {
+        // Compaction always makes room, see the static assertion above
+        step = kv_compact_step() ? KV_STEP_AGAIN : KV_STEP_FAILED;
+    }
+    else if(pending->type == KV_RECORD_VALUE && kv_index_find(pending->key) == NULL
+            && g_index_count >= KV_MAX_KEYS) {
+        // No index slot: a record written now would be lost at the next kv_init()
+        step = KV_STEP_FAILED;
+    }
+    else {
+        bool ok = kv_program_record(g_write_addr, pending->key, pending->type, pending->data, pending->len);
+        if(ok) {
+            if(pending->type == KV_RECORD_VALUE)
+                ok = kv_index_put(pending->key, pending->len, g_write_addr + sizeof(kv_record_header_t));
+            else
+                kv_index_remove(pending->key);
+        }
+        // A failed record is torn, never program over it again
+        g_write_addr = ok ? g_write_addr + size : g_page_addr + FLASH_PAGE_SIZE;
+        step = ok ? KV_STEP_DONE : KV_STEP_FAILED;
+    }
+    flash_lock();
+
+    return step;
+}
+
+/**
+ * @brief Drops the oldest buffered write, once it is in flash.
+ */
+static void kv_pending_pop(void)
+{
+    g_pending_count--;
+    memmove(&g_pending[0], &g_pending[1], g_pending_count * sizeof(kv_pending_t));
+}
+
+/**
+ * @brief Writes the oldest buffered record, compacting first if needed.
+ * @return true on success, false if a flash operation failed (the write stays queued).
+ */
+static bool kv_commit_oldest(void)
+{
+    kv_step_t step;
+    do {
+        step = kv_commit(&g_pending[0]);
+    } while(step == KV_STEP_AGAIN);
+
+    if(step != KV_STEP_DONE)
+        return false;
+    kv_pending_pop();
+    return true;
+}
+
+bool kv_init(void)
+{
+    uint32_t pages = kv_page_count();
+    bool found = false;
+
+    g_mounted = false;
+    g_pending_count = 0;
+    g_compact_addr = 0;
+    if(pages < 2)
+        return false;
+
+    // The active page is the valid one with the highest sequence number
+    for(uint32_t page = 0; page < pages; page++) {
+        const kv_page_header_t *hdr = (const kv_page_header_t *)kv_page_address(page);
+        if(hdr->magic != KV_PAGE_MAGIC || hdr->sequence == 0xFFFFFFFFUL)
+            continue;
+        if(!found || hdr->sequence > g_sequence) {
+            g_sequence = hdr->sequence;
+            g_page_addr = kv_page_address(page);
+            found = true;
+        }
+    }
+
+    if(!found) {
+        g_page_addr = kv_page_address(0);
+        g_sequence = 1;
+        flash_unlock();
+        bool ok = kv_format_page(g_page_addr, g_sequence);
+        flash_lock();
+        if(!ok)
+            return false;
+    }
+
+    kv_scan_page();
+    g_mounted = true;
+    return true;
+}
+
+static bool kv_queue(uint16_t key, uint8_t type, const void *value, uint8_t len)
+{
+    kv_pending_t *pending = kv_pending_find(key);
+    if(pending == NULL) {
+        if(g_pending_count >= KV_PENDING_MAX && !kv_commit_oldest())
+            return false;
+        pending = &g_pending[g_pending_count++];
+        pending->key = key;
+    }
+
+    pending->type = type;
+    pending->len = len;
+    if(len > 0)
+        memcpy(pending->data, value, len);
+    return true;
+}
+
+bool kv_set(uint16_t key, const void *value, uint8_t len)
+{
+    if(!g_mounted || key == KV_KEY_INVALID || len > KV_MAX_VALUE_LEN || (value == NULL && len > 0))
+        return false;
+
+    const kv_index_entry_t *entry = kv_index_find(key);
+    kv_pending_t *pending = kv_pending_find(key);
+
+    // Writing the value already in flash would only wear it out
+    if(pending == NULL && entry != NULL && entry->len == len && memcmp((const void *)entry->addr, value, len) == 0)
+        return true;
+    if(entry == NULL && pending == NULL && kv_keys_in_use() >= KV_MAX_KEYS)
+        return false;
+
+    return kv_queue(key, KV_RECORD_VALUE, value, len);
+}
+
+int kv_get(uint16_t key, void *value, uint8_t max_len)
+{
+    if(!g_mounted || value == NULL)
+        return -1;
+
+    const uint8_t *src;
+    uint8_t len;
+
+    const kv_pending_t *pending = kv_pending_find(key);
+    if(pending != NULL) {
+        if(pending->type == KV_RECORD_DELETE)
+            return -1;
+        src = pending->data;
+        len = pending->len;
+    }
+    else {
+        const kv_index_entry_t *entry = kv_index_find(key);
+        if(entry == NULL)
+            return -1;
+        src = (const uint8_t *)entry->addr;
+        len = entry->len;
+    }
+
+    memcpy(value, src, (len < max_len) ? len : max_len);
+    return len;
+}
+
+bool kv_delete(uint16_t key)
+{
+    if(!g_mounted)
+        return false;
+
+    if(kv_index_find(key) == NULL) {
+        // Not in flash: at most drop a queued write
+        kv_pending_t *pending = kv_pending_find(key);
+        if(pending != NULL)
+            *pending = g_pending[--g_pending_count];
+        return true;
+    }
+
+    return kv_queue(key, KV_RECORD_DELETE, NULL, 0);
+}
+
+bool kv_process(void)
+{
+    if(!g_mounted || g_pending_count == 0)
+        return false;
+
+    // A failed write stays queued so kv_flush() can report it
+    if(kv_commit(&g_pending[0]) == KV_STEP_DONE)
+        kv_pending_pop();
+
+    return g_pending_count > 0;
+}
+
+bool kv_flush(void)
+{
+    while(g_mounted && g_pending_count > 0) {
+        if(!kv_commit_oldest())
+            return false;
+    }
+    return g_mounted;
+}
+
+uint8_t kv_pending_count(void)
+{
+    return g_pending_count;
+}
@@ -0,0 +1,88 @@
+#ifndef KVSTORE_H
+#define KVSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash.h"
+
+#define KV_MAX_KEYS         16      // Distinct keys kept in the RAM index
+#define KV_MAX_VALUE_LEN    32      // Largest value in bytes
+#define KV_PENDING_MAX      4       // Writes buffered in RAM before they must be committed
+#define KV_KEY_INVALID      0xFFFF  // Reserved, matches erased flash
+
+/**
+ * Log-structured key-value store in the flash pages reserved by the linker
+ * script (_skvstore.._ekvstore).
+ *
+ * Every kv_set() appends a CRC-protected record to the active page, so a
+ * value is never rewritten in place. When the active page is full the live
+ * records are compacted into the next page, which rotates the erases over
+ * all the reserved pages. A RAM index holds the flash address of every
+ * value, so reads never scan flash.
+ *
+ * Writes are buffered in RAM and committed by kv_process() (one flash step
+ * per call) or kv_flush(), keeping flash programming out of the caller's
+ * path. A compaction is spread over several kv_process() calls: the erase
+ * of the next page, then one call per live record.
+ */
+
+/**
+ * @brief Mounts the store: finds the newest page and rebuilds the RAM index.
+ *
+ * Records that fail their CRC (e.g., interrupted by a power loss) end the
+ * log; the next write compacts the valid records into a fresh page.
+ *
+ * @return true on success, false if the reserved pages cannot be erased/programmed.
+ */
+bool kv_init(void);
+
+/**
+ * @brief Queues a value for writing. Reads see the new value immediately.
+ * @param[in] key The key (any value but KV_KEY_INVALID).
+ * @param[in] value Pointer to the data.
+ * @param[in] len Data length, at most KV_MAX_VALUE_LEN.
+ * @return true on success, false on invalid arguments or if KV_MAX_KEYS keys, in
+ *         flash or queued, are already used.
+ * @note If the write queue is full, the oldest write is committed first.
+ */
+bool kv_set(uint16_t key, const void *value, uint8_t len);
+
+/**
+ * @brief Reads a value.
+ * @param[in] key The key.
+ * @param[out] value Pointer to the destination buffer.
+ * @param[in] max_len Size of the destination buffer.
+ * @return The stored length (the copy is truncated to max_len), or -1 if the key does not exist.
+ */
+int kv_get(uint16_t key, void *value, uint8_t max_len);
+
+/**
+ * @brief Queues the removal of a key.
+ * @param[in] key The key.
+ * @return true on success, false if the store is not mounted.
+ */
+bool kv_delete(uint16_t key);
+
+/**
+ * @brief Does at most one flash step of the buffered writes. Call from the main loop.
+ *
+ * A step is the write of one record, or while the active page is being
+ * compacted, the erase of the next page or the copy of one live record.
+ * A page erase (~22 ms) is the longest a call takes.
+ *
+ * @return true while writes remain pending.
+ */
+bool kv_process(void);
+
+/**
+ * @brief Commits every buffered write.
+ * @return true on success, false if a flash operation failed.
+ */
+bool kv_flush(void);
+
+/**
+ * @brief Returns the number of buffered writes not yet committed.
+ */
+uint8_t kv_pending_count(void);
+
+#endif
@@ -0,0 +1,118 @@
+#include "memPool.h"
+#include "irq.h"
+
+static void mem_stats_add(mem_stats_t *stats, uint32_t amount) {
+    stats->used += amount;
+    if (stats->used > stats->peak)
+        stats->peak = stats->used;
+}
+
+void mem_pool_init(mem_pool_t *pool, const char *name, void *storage, uint16_t block_size, uint16_t count) {
+    if (pool == NULL) return;
+
+    pool->name = name;
+    pool->storage = (uint8_t *)storage;
+    pool->block_size = (uint16_t)MEM_ALIGN_UP(block_size);
+    pool->count = count;
+    pool->fresh = 0;
+    pool->free_list = NULL;
+    pool->stats = (mem_stats_t){ .capacity = count };
+}
+
+void *mem_pool_alloc(mem_pool_t *pool) {
+    if (pool == NULL || pool->storage == NULL) return NULL;
+
+    uint32_t primask = irq_lock();
+    mem_block_t *block = pool->free_list;
+    if (block != NULL) {
+        pool->free_list = block->next;
+    } else if (pool->fresh < pool->count) {
+        // Untouched blocks are carved out in order, no init loop needed
+        block = (mem_block_t *)&pool->storage[(uint32_t)pool->fresh * pool->block_size];
+        pool->fresh++;
+    }
+
+    if (block != NULL)
+        mem_stats_add(&pool->stats, 1);
+    else
+        pool->stats.failures++;
+    irq_unlock(primask);
+
+    return block;
+}
+
+bool mem_pool_free(mem_pool_t *pool, void *block) {
+    if (block == NULL) return true;
+    if (pool == NULL) return false;
+
+    // Reject pointers that are not the start of one of this pool's blocks
+    uintptr_t offset = (uintptr_t)block - (uintptr_t)pool->storage;
+    if ((uintptr_t)block < (uintptr_t)pool->storage ||
+        offset >= (uintptr_t)pool->fresh * pool->block_size ||
+        offset % pool->block_size != 0)
+        return false;
+
+    uint32_t primask = irq_lock();
+    mem_block_t *node = (mem_block_t *)block;
+    node->next = pool->free_list;
+    pool->free_list = node;
+    pool->stats.used--;
+    irq_unlock(primask);
+
+    return true;
+}
+
+void mem_pool_get_stats(const mem_pool_t *pool, mem_stats_t *stats) {
+    if (pool == NULL || stats == NULL) return;
+
+    uint32_t primask = irq_lock();
+    *stats = pool->stats;
+    irq_unlock(primask);
+}
+
+void *mem_arena_alloc(mem_arena_t *arena, uint32_t size) {
+    if (arena == NULL || arena->base == NULL || size == 0) return NULL;
+
+    void *ptr = NULL;
+    uint32_t aligned = MEM_ALIGN_UP(size);
+
+    uint32_t primask = irq_lock();
+    // aligned < size catches the wrap of huge requests
+    if (aligned >= size && aligned <= arena->size - arena->offset) {
+        ptr = &arena->base[arena->offset];
+        arena->offset += aligned;
+        mem_stats_add(&arena->stats, aligned);
+    } else {
+        arena->stats.failures++;
+    }
+    irq_unlock(primask);
+
+    return ptr;
+}
+
+uint32_t mem_arena_mark(const mem_arena_t *arena) {
+    return (arena != NULL) ? arena->offset : 0;
+}
+
+void mem_arena_release(mem_arena_t *arena, uint32_t mark) {
+    if (arena == NULL) return;
+
+    uint32_t primask = irq_lock();
+    if (mark < arena->offset) {
+        arena->offset = mark;
+        arena->stats.used = mark;
+    }
+    irq_unlock(primask);
+}
+
+void mem_arena_reset(mem_arena_t *arena) {
+    mem_arena_release(arena, 0);
+}
+
+void mem_arena_get_stats(const mem_arena_t *arena, mem_stats_t *stats) {
+    if (arena == NULL || stats == NULL) return;
+
+    uint32_t primask = irq_lock();
+    *stats = arena->stats;
+    irq_unlock(primask);
+}
@@ -0,0 +1,142 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Deterministic allocation without the newlib heap.
+ *
+ * Fixed-block pools: every block of a pool has the same size, so allocating
+ * and freeing are O(1) (pop/push on an intrusive free list) and a pool can
+ * never fragment. Blocks that were never used are handed out from a bump
+ * index, so a pool needs no initialization loop and works from .bss.
+ *
+ * Bump arena: variable sized allocations that are released all at once
+ * (mem_arena_reset) or back to a saved mark, e.g. scratch memory for one
+ * main loop iteration.
+ *
+ * Pools and arenas are sized at compile time with MEM_POOL_DEFINE and
+ * MEM_ARENA_DEFINE. All functions may be called from interrupts.
+ */
+
+#define MEM_ALIGN                   8U      // Alignment of every block and arena allocation
+
+#define MEM_ALIGN_UP(size)          (((size) + MEM_ALIGN - 1U) & ~(MEM_ALIGN - 1U))
+
+typedef struct {
+    uint32_t capacity;      // Blocks (pool) or bytes (arena)
+    uint32_t used;          // Currently allocated, same unit
+    uint32_t peak;          // Highest value of used since boot
+    uint32_t failures;      // Allocations refused because the pool/arena was full
+} mem_stats_t;
+
+typedef struct mem_block {
+    struct mem_block *next;
+} mem_block_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *storage;
+    uint16_t block_size;    // Already rounded to MEM_ALIGN
+    uint16_t count;
+    uint16_t fresh;         // Blocks never handed out start here
+    mem_block_t *free_list; // Blocks returned by mem_pool_free()
+    mem_stats_t stats;
+} mem_pool_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *base;
+    uint32_t size;
+    uint32_t offset;
+    mem_stats_t stats;
+} mem_arena_t;
+
+/**
+ * @brief Defines a pool of count blocks of at least block_size bytes with static storage.
+ */
+#define MEM_POOL_DEFINE(name_, block_size_, count_) \
+    static uint64_t name_##_storage[(MEM_ALIGN_UP(block_size_) * (count_)) / sizeof(uint64_t)]; \
+    mem_pool_t name_ = { \
+        .name = #name_, \
+        .storage = (uint8_t *)name_##_storage, \
+        .block_size = MEM_ALIGN_UP(block_size_), \
+        .count = (count_), \
+        .stats = { .capacity = (count_) } \
+    }
+
+/**
+ * @brief Defines an arena of size bytes with static storage.
+ */
+#define MEM_ARENA_DEFINE(name_, size_) \
+    static uint64_t name_##_storage[MEM_ALIGN_UP(size_) / sizeof(uint64_t)]; \
+    mem_arena_t name_ = { \
+        .name = #name_, \
+        .base = (uint8_t *)name_##_storage, \
+        .size = MEM_ALIGN_UP(size_), \
+        .stats = { .capacity = MEM_ALIGN_UP(size_) } \
+    }
+
+/**
+ * @brief Sets up a pool on caller provided storage (MEM_POOL_DEFINE does this statically).
+ * @param[out] pool The pool.
+ * @param[in] name Name shown in statistics.
+ * @param[in] storage At least MEM_ALIGN_UP(block_size) * count bytes, MEM_ALIGN aligned.
+ * @param[in] block_size Size of one block in bytes.
+ * @param[in] count Number of blocks.
+ */
+void mem_pool_init(mem_pool_t *pool, const char *name, void *storage, uint16_t block_size, uint16_t count);
+
+/**
+ * @brief Takes a block from the pool in constant time.
+ * @param[in] pool The pool.
+ * @return The block, or NULL if the pool is exhausted.
+ */
+void *mem_pool_alloc(mem_pool_t *pool);
+
+/**
+ * @brief Returns a block to its pool in constant time.
+ * @param[in] pool The pool the block was taken from.
+ * @param[in] block The block, NULL is ignored.
+ * @return false if block does not belong to the pool.
+ */
+bool mem_pool_free(mem_pool_t *pool, void *block);
+
+/**
+ * @brief Copies the statistics of a pool (capacity and usage in blocks).
+ */
+void mem_pool_get_stats(const mem_pool_t *pool, mem_stats_t *stats);
+
+/**
+ * @brief Allocates from the arena in constant time.
+ * @param[in] arena The arena.
+ * @param[in] size Size in bytes, rounded up to MEM_ALIGN.
+ * @return The memory, or NULL if the arena is full.
+ */
+void *mem_arena_alloc(mem_arena_t *arena, uint32_t size);
+
+/**
+ * @brief Returns the current fill level, to be passed to mem_arena_release().
+ */
+uint32_t mem_arena_mark(const mem_arena_t *arena);
+
+/**
+ * @brief Frees everything allocated after mark was taken.
+ * @param[in] arena The arena.
+ * @param[in] mark Value from mem_arena_mark().
+ */
+void mem_arena_release(mem_arena_t *arena, uint32_t mark);
+
+/**
+ * @brief Frees every allocation of the arena.
+ */
+void mem_arena_reset(mem_arena_t *arena);
+
+/**
+ * @brief Copies the statistics of an arena (capacity and usage in bytes).
+ */
+void mem_arena_get_stats(const mem_arena_t *arena, mem_stats_t *stats);
+
+#endif // MEMPOOL_H
@@ -0,0 +1,149 @@
+#include "tachometer/tachometer.h"
+
+static tach_config_t tach_config;
+static bool tach_initialized = false;
+static uint32_t tach_counter_mask;
+
+// --- ISR private state ---
+static uint32_t last_capture;
+static bool have_last_capture = false;
+static uint32_t window[TACH_AVG_WINDOW];
+static uint32_t window_sum;
+static uint8_t window_index;
+static uint8_t window_fill;
+
+// --- Published by the ISR, read by the main loop ---
+// Each value is a single aligned 32-bit word, so reads and writes are atomic
+// on the Cortex-M4 and no lock is needed.
+static volatile uint32_t published_period = 0;
+static volatile uint32_t last_edge_ms = 0;
+
+// --- Main loop private state ---
+static bool stall_reported = false;
+
+bool tach_init(const tach_config_t *config)
+{
+    if(config == NULL || config->tick_hz == 0 || config->pulses_per_rev == 0)
+        return false;
+    // The resolution comes from the counter prescaler, which is 16 bits wide
+    uint32_t prescaler = config->timer_clock_hz / config->tick_hz;
+    if(prescaler == 0 || prescaler > TIM_PRESCALER_MAX)
+        return false;
+
+    tach_config = *config;
+
+    timer_ic_config_t ic_config = {
+        .channel   = config->channel,
+        .edge      = TIM_IC_RISING,
+        .filter    = 4,     // Reject short glitches on the open-collector line
+        .prescaler = prescaler,
+        .period    = 0,     // Free running over the full counter range
+        .interrupt = true
+    };
+    if(timer_input_capture_init(config->timer, &ic_config) != 0)
+        return false;
+
+    // 16-bit timers ignore the upper half of ARR, so this is the counter range
+    tach_counter_mask = config->timer->ARR;
+
+    have_last_capture = false;
+    window_sum = 0;
+    window_index = 0;
+    window_fill = 0;
+    published_period = 0;
+    last_edge_ms = systick_getTick();
+    stall_reported = false;
+    tach_initialized = true;
+    return true;
+}
+
+void tach_irq_handler(void)
+{
+    if(!tach_initialized) return;
+
+    GeneralPurpose_Timer_t *TIMx = tach_config.timer;
+    uint32_t ccif = (1U << (tach_config.channel + 1));
+    uint32_t ccof = (1U << (tach_config.channel + 9));
+
+    if(!(TIMx->SR & ccif))
+        return;
+
+    // Reading CCRx clears CCxIF
+    uint32_t capture = timer_capture_read(TIMx, tach_config.channel);
+    uint32_t now_ms = systick_getTick();
+
+    // An over-capture means an edge was lost, the next period is not valid
+    bool lost_edge = (TIMx->SR & ccof) != 0;
+    if(lost_edge)
+        TIMx->SR = ~ccof;
+
+    // After a stall the first edge only restarts the measurement
+    if(!have_last_capture || lost_edge || (now_ms - last_edge_ms) > tach_config.stall_timeout_ms) {
+        have_last_capture = true;
+        for(int i = 0; i < TACH_AVG_WINDOW; i++)
+            window[i] = 0;
+        window_sum = 0;
+        window_index = 0;
+        window_fill = 0;
+        published_period = 0;
+    } else {
+        uint32_t period = (capture - last_capture) & tach_counter_mask;
+
+        window_sum -= window[window_index];
+        window[window_index] = period;
+        window_sum += period;
+        window_index = (window_index + 1) & (TACH_AVG_WINDOW - 1);
+        if(window_fill < TACH_AVG_WINDOW)
+            window_fill++;
+
+        published_period = window_sum / window_fill;
+    }
+
+    last_capture = capture;
+    last_edge_ms = now_ms;
+}
+
+uint32_t tach_get_period_ticks(void)
+{
+    if(!tach_initialized || stall_reported)
+        return 0;
+    return published_period;
+}
+
+uint32_t tach_get_frequency_mhz(void)
+{
+    uint32_t period = tach_get_period_ticks();
+    if(period == 0)
+        return 0;
+    return (uint32_t)(((uint64_t)tach_config.tick_hz * 1000U) / period);
+}
+
+uint32_t tach_get_rpm(void)
+{
+    uint32_t period = tach_get_period_ticks();
+    if(period == 0)
+        return 0;
+    return (uint32_t)(((uint64_t)tach_config.tick_hz * 60U) / ((uint64_t)period * tach_config.pulses_per_rev));
+}
+
+bool tach_poll_event(tach_event_t *event)
+{
+    if(event == NULL || !tach_initialized)
+        return false;
+
+    bool stalled = (systick_getTick() - last_edge_ms) > tach_config.stall_timeout_ms;
+
+    if(stalled && !stall_reported) {
+        stall_reported = true;
+        *event = TACH_EVENT_STALL;
+        return true;
+    }
+    if(!stalled && stall_reported && published_period != 0) {
+        stall_reported = false;
+        *event = TACH_EVENT_RUNNING;
+        return true;
+    }
+
+    *event = TACH_EVENT_NONE;
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef TACHOMETER_H
+#define TACHOMETER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "systick.h"
+#include "tim.h"
+
+#define TACH_AVG_WINDOW 8 // Moving average length, must be a power of two
+
+typedef struct {
+    GeneralPurpose_Timer_t *timer;  // Capture timer; TIM2/TIM5 have a 32-bit counter
+    timer_channel_t channel;        // Capture channel wired to the tach output
+    uint32_t timer_clock_hz;        // Kernel clock of the timer
+    uint32_t tick_hz;               // Capture resolution, e.g. 1000000 for 1 us; at least
+                                    // timer_clock_hz / TIM_PRESCALER_MAX
+    uint8_t pulses_per_rev;         // Tach pulses per revolution (2 for most PC fans)
+    uint32_t stall_timeout_ms;      // No edge for this long means the fan stalled
+} tach_config_t;
+
+typedef enum {
+    TACH_EVENT_NONE,
+    TACH_EVENT_STALL,       // Edges stopped for longer than stall_timeout_ms
+    TACH_EVENT_RUNNING      // Edges resumed after a stall
+} tach_event_t;
+
+/**
+ * @brief Configures the input capture channel and starts measuring.
+ * @param[in] config Pointer to the tach_config_t struct.
+ * @return true on success, false on invalid configuration, including a
+ *         tick_hz the 16-bit prescaler cannot reach.
+ */
+bool tach_init(const tach_config_t *config);
+
+/**
+ * @brief Capture interrupt handler.
+ *
+ * Must be called from the IRQ handler of the configured timer
+ * (e.g., TIM5_IRQHandler). It timestamps the edge, updates the moving
+ * average and publishes the result.
+ */
+void tach_irq_handler(void);
+
+/**
+ * @brief Returns the averaged tach period in timer ticks.
+ * @return The period, or 0 while stalled or before two edges were seen.
+ */
+uint32_t tach_get_period_ticks(void);
+
+/**
+ * @brief Returns the averaged tach signal frequency in millihertz.
+ */
+uint32_t tach_get_frequency_mhz(void);
+
+/**
+ * @brief Returns the fan speed in revolutions per minute.
+ */
+uint32_t tach_get_rpm(void);
+
+/**
+ * @brief Checks for stall / recovery transitions. Call from the main loop.
+ * @param[out] event Pointer to store the event.
+ * @return true if an event was reported, false otherwise.
+ */
+bool tach_poll_event(tach_event_t *event);
+
+#endif
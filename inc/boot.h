@@ -0,0 +1,54 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dwt.h"
+#include "rcc.h"
+#include "uart.h"
+
+#define BOOT_MAX_MARKS  16  // Entries in the boot timeline
+#define BOOT_MAX_TASKS  4   // Deferred initialization tasks
+
+/**
+ * @brief A deferred initialization step, polled from the main loop.
+ * @return true once the step has finished (successfully or not).
+ */
+typedef bool (*boot_task_t)(void);
+
+/**
+ * @brief Records the end of a boot stage in the timeline.
+ *
+ * Timestamps come from the DWT cycle counter, so dwt_init() must run first.
+ * Each interval is converted with the HCLK frequency at the time of the mark;
+ * the interval containing a clock switch is therefore approximate.
+ *
+ * @param[in] stage Name of the stage. Must point to a string that outlives the boot (a literal).
+ */
+void boot_mark(const char *stage);
+
+/**
+ * @brief Registers a slow initialization step to run in the background.
+ * @param[in] stage Name recorded in the timeline when the task finishes.
+ * @param[in] task The polling function.
+ * @return true on success, false if the task table is full.
+ */
+bool boot_defer(const char *stage, boot_task_t task);
+
+/**
+ * @brief Polls every pending deferred task once. Call from the main loop.
+ */
+void boot_process(void);
+
+/**
+ * @brief Returns true when every deferred task has finished.
+ */
+bool boot_is_complete(void);
+
+/**
+ * @brief Prints the timeline as "stage: +delta us (total us)" lines.
+ * @param[in] usart_port Pointer to the USART used as console.
+ */
+void boot_print_timeline(usart_t *usart_port);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "rcc.h"
+
+/* Base address for both DMA controllers */
+#define DMA1 ((dma_t *)0x40020000UL)
+#define DMA2 ((dma_t *)0x40020400UL)
+
+// --- DMA Channel Configuration Register Bits ---
+#define DMA_CCR_EN_Pos      (0U)
+#define DMA_CCR_EN          (1U << DMA_CCR_EN_Pos)      // Channel enable
+#define DMA_CCR_TCIE_Pos    (1U)
+#define DMA_CCR_TCIE        (1U << DMA_CCR_TCIE_Pos)    // Transfer complete interrupt enable
+#define DMA_CCR_HTIE_Pos    (2U)
+#define DMA_CCR_HTIE        (1U << DMA_CCR_HTIE_Pos)    // Half transfer interrupt enable
+#define DMA_CCR_TEIE_Pos    (3U)
+#define DMA_CCR_TEIE        (1U << DMA_CCR_TEIE_Pos)    // Transfer error interrupt enable
+#define DMA_CCR_DIR_Pos     (4U)
+#define DMA_CCR_DIR         (1U << DMA_CCR_DIR_Pos)     // 1: Read from memory
+#define DMA_CCR_CIRC_Pos    (5U)
+#define DMA_CCR_CIRC        (1U << DMA_CCR_CIRC_Pos)    // Circular mode
+#define DMA_CCR_PINC_Pos    (6U)
+#define DMA_CCR_PINC        (1U << DMA_CCR_PINC_Pos)    // Peripheral increment mode
+#define DMA_CCR_MINC_Pos    (7U)
+#define DMA_CCR_MINC        (1U << DMA_CCR_MINC_Pos)    // Memory increment mode
+#define DMA_CCR_PSIZE_Pos   (8U)
+#define DMA_CCR_MSIZE_Pos   (10U)
+#define DMA_CCR_PL_Pos      (12U)
+
+// Register map for a single DMA channel
+typedef struct {
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+    volatile uint32_t RESERVED;
+} dma_channel_t;
+
+// Register map for a DMA controller
+typedef struct {
+    volatile uint32_t ISR;
+    volatile uint32_t IFCR;
+    dma_channel_t CH[7];
+    volatile uint32_t RESERVED0[5];
+    volatile uint32_t CSELR;
+} dma_t;
+
+typedef enum {
+    DMA_DIR_PERIPH_TO_MEM,
+    DMA_DIR_MEM_TO_PERIPH
+} dma_dir_t;
+
+typedef enum {
+    DMA_WIDTH_8BIT  = 0U,
+    DMA_WIDTH_16BIT = 1U,
+    DMA_WIDTH_32BIT = 2U
+} dma_width_t;
+
+typedef enum {
+    DMA_PRIORITY_LOW,
+    DMA_PRIORITY_MEDIUM,
+    DMA_PRIORITY_HIGH,
+    DMA_PRIORITY_VERY_HIGH
+} dma_priority_t;
+
+/**
+ * @brief Configuration structure for a DMA channel.
+ */
+typedef struct {
+    dma_t *dma;                 // DMA1 or DMA2
+    uint8_t channel;            // Channel number (1-7)
+    uint8_t request;            // Request mapping written to CSELR (0-7)
+    volatile void *periph_addr; // Peripheral register address
+    const void *mem_addr;       // Memory buffer address
+    uint16_t count;             // Number of data items to transfer
+    dma_dir_t direction;
+    dma_width_t periph_width;
+    dma_width_t mem_width;
+    dma_priority_t priority;
+    bool circular;              // Restart automatically when count reaches zero
+} dma_config_t;
+
+/**
+ * @brief Configures a DMA channel. The channel is left disabled.
+ * @param[in] config Pointer to the dma_config_t struct.
+ * @return 0 on success, -1 on invalid configuration.
+ */
+int dma_init(const dma_config_t *config);
+
+/**
+ * @brief Enables a previously configured DMA channel.
+ * @param[in] DMAx Pointer to the DMA controller.
+ * @param[in] channel The channel number (1-7).
+ */
+void dma_enable(dma_t *DMAx, uint8_t channel);
+
+/**
+ * @brief Disables a DMA channel and clears its interrupt flags.
+ * @param[in] DMAx Pointer to the DMA controller.
+ * @param[in] channel The channel number (1-7).
+ */
+void dma_disable(dma_t *DMAx, uint8_t channel);
+
+/**
+ * @brief Returns the number of data items left in the current transfer.
+ * @param[in] DMAx Pointer to the DMA controller.
+ * @param[in] channel The channel number (1-7).
+ */
+uint16_t dma_get_remaining(dma_t *DMAx, uint8_t channel);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef DWT_H
+#define DWT_H
+
+#include <stdint.h>
+
+#define DWT ((DataWatchpointTrace_t *)0xE0001000UL)
+#define DEMCR (*(volatile uint32_t *)0xE000EDFCUL)     // Debug Exception and Monitor Control Register
+
+// --- DEMCR Bits ---
+#define DEMCR_TRCENA_Pos        (24U)
+#define DEMCR_TRCENA            (1U << DEMCR_TRCENA_Pos)    // Enables the DWT and ITM units
+
+// --- DWT Control Register Bits ---
+#define DWT_CTRL_CYCCNTENA_Pos  (0U)
+#define DWT_CTRL_CYCCNTENA      (1U << DWT_CTRL_CYCCNTENA_Pos) // Cycle counter enable
+
+/**
+ * @brief Register map for the start of the Data Watchpoint and Trace unit.
+ */
+typedef struct {
+    volatile uint32_t CTRL;     // Control register
+    volatile uint32_t CYCCNT;   // Cycle count register
+    volatile uint32_t CPICNT;   // CPI count register
+    volatile uint32_t EXCCNT;   // Exception overhead count register
+    volatile uint32_t SLEEPCNT; // Sleep count register
+    volatile uint32_t LSUCNT;   // LSU count register
+    volatile uint32_t FOLDCNT;  // Folded-instruction count register
+    volatile uint32_t PCSR;     // Program counter sample register
+} DataWatchpointTrace_t;
+
+/**
+ * @brief Enables the trace unit and starts the CPU cycle counter from zero.
+ */
+void dwt_init(void);
+
+/**
+ * @brief Returns the number of CPU cycles since dwt_init(). Wraps every 2^32 cycles
+ * (53 s at 80 MHz), so compute differences with unsigned subtraction.
+ */
+static inline uint32_t dwt_get_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+#endif
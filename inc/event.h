@@ -0,0 +1,83 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define EVENT_QUEUE_SIZE        16U     // Per priority, power of two
+#define EVENT_MAX_SUBSCRIBERS   4U      // Per event type
+
+/*
+ * Event queue between drivers and application logic.
+ *
+ * Producers (interrupt handlers or the main loop) post small typed events
+ * with event_post(): a few instructions with interrupts masked, no loops,
+ * so the cost in an ISR is bounded. There is one FIFO per priority.
+ * The main loop calls event_dispatch(), which takes the oldest event of the
+ * highest non-empty priority and hands it to every subscriber of its type.
+ * When event_pending() is false the main loop can sleep until the next
+ * interrupt (power_idle()).
+ */
+
+typedef enum {
+    EVENT_KEY_PRESSED = 0,  // data: key character
+    EVENT_BUTTON,           // data: unused
+    EVENT_UART_LINE,        // data: line length
+    EVENT_TEMPERATURE,      // data: temperature in 0.01 degC, signed
+    EVENT_TIMER,            // data: timer id
+    EVENT_TYPE_COUNT
+} event_type_t;
+
+typedef enum {
+    EVENT_PRIO_HIGH = 0,
+    EVENT_PRIO_NORMAL,
+    EVENT_PRIO_LOW,
+    EVENT_PRIO_COUNT
+} event_priority_t;
+
+typedef struct {
+    uint8_t type;           // event_type_t
+    uint8_t priority;       // event_priority_t
+    uint32_t data;
+} event_t;
+
+/**
+ * @brief Called by event_dispatch() for every event of a subscribed type.
+ */
+typedef void (*event_handler_t)(const event_t *event);
+
+/**
+ * @brief Adds a subscriber to an event type. Subscribers run in subscription order.
+ * @param[in] type The event type.
+ * @param[in] handler The callback, run from the main loop.
+ * @return 0 on success, -1 if the type is invalid or has no free slot.
+ */
+int event_subscribe(event_type_t type, event_handler_t handler);
+
+/**
+ * @brief Queues an event. Safe from interrupt handlers.
+ * @param[in] type The event type.
+ * @param[in] priority Queue to use; higher priorities are dispatched first.
+ * @param[in] data Event payload, see event_type_t.
+ * @return true on success, false if that priority's queue is full (the event is counted as dropped).
+ */
+bool event_post(event_type_t type, event_priority_t priority, uint32_t data);
+
+/**
+ * @brief Delivers the next event to its subscribers. Call from the main loop only.
+ * @return true if an event was delivered, false if the queue was empty.
+ */
+bool event_dispatch(void);
+
+/**
+ * @brief Whether any event is queued. Check it with interrupts masked before sleeping.
+ */
+bool event_pending(void);
+
+/**
+ * @brief Number of events dropped because their queue was full.
+ */
+uint32_t event_get_dropped(void);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FAULT_H
+#define FAULT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart.h"
+
+#define FAULT_BACKTRACE_DEPTH   8U              // Return addresses kept from the faulting stack
+#define FAULT_RECORD_MAGIC      0xFA17DEADUL    // Marks a valid record in .noinit
+
+// Why the record was written: the exception number (3 = HardFault ...) or one of these
+#define FAULT_REASON_PANIC          0x100U      // fault_panic() from software
+#define FAULT_REASON_UNHANDLED_IRQ  0x101U      // A default IRQ handler ran
+
+/*
+ * Crash dumps that survive the reset.
+ *
+ * HardFault, MemManage, BusFault, UsageFault and every unhandled interrupt
+ * (startup Default_Handler) enter a naked stub that switches to a private
+ * stack and captures the stacked registers, the fault status registers and
+ * a heuristic backtrace (stack words that look like Thumb return addresses
+ * into code) into a record in the .noinit section, then reset the MCU.
+ * After the reset fault_report() prints the record once over UART;
+ * tools/fault_decode.py symbolizes it with the linker .map file.
+ */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t reason;            // Exception number or FAULT_REASON_*
+    uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;     // Stacked by the exception entry
+    uint32_t sp;                // Stack pointer before the exception
+    uint32_t exc_return;
+    uint32_t cfsr, hfsr, mmfar, bfar;
+    uint32_t tick;              // systick_getTick() at the fault
+    uint32_t depth;             // Valid entries in backtrace
+    uint32_t backtrace[FAULT_BACKTRACE_DEPTH];
+    uint32_t check;             // ~(sum of the fields above), detects a half-written record
+} fault_record_t;
+
+/**
+ * @brief Enables the MemManage, BusFault and UsageFault handlers and the divide by zero trap.
+ */
+void fault_init(void);
+
+/**
+ * @brief Reads the record left by the previous run.
+ * @param[out] record Copy of the record.
+ * @return true if the previous run ended with a fault.
+ */
+bool fault_get_record(fault_record_t *record);
+
+/**
+ * @brief Prints the record of the previous run, if any, and clears it.
+ *
+ * The "key=0x..." lines are what tools/fault_decode.py expects.
+ *
+ * @param[in] usart_port The USART to print to.
+ * @return true if a record was printed.
+ */
+bool fault_report(usart_t *usart_port);
+
+/**
+ * @brief Records a software detected fatal error with the caller as pc, then resets.
+ * @param[in] reason FAULT_REASON_* code stored in the record.
+ */
+void fault_panic(uint32_t reason) __attribute__((noreturn));
+
+#endif
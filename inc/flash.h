@@ -2,10 +2,20 @@
 #define FLASH_H
 
 #include <stdint.h>
+#include "placement.h"
 
 // Dirección base del periférico FLASH para STM32L476RG
 #define FLASH ((Flash_t *)0x40022000UL)
 
+// --- Organización de la memoria (2 bancos de 512 KB, páginas de 2 KB) ---
+#define FLASH_BASE_ADDR     (0x08000000UL)
+#define FLASH_BANK_SIZE     (0x80000UL)
+#define FLASH_PAGE_SIZE     (0x800UL)
+
+// Llaves para desbloquear el registro CR
+#define FLASH_KEY1          (0x45670123UL)
+#define FLASH_KEY2          (0xCDEF89ABUL)
+
 // --- Macros para el Registro de Control de Acceso (ACR) ---
 
 // Máscara para limpiar los bits de latencia (bits 0-2)
@@ -17,6 +27,33 @@
 #define FLASH_ACR_PRFTEN (0x1 << 8)  // Habilitar prefetch buffer
 #define FLASH_ACR_ICEN   (0x1 << 9)  // Habilitar instruction cache
 #define FLASH_ACR_DCEN   (0x1 << 10) // Habilitar data cache
+#define FLASH_ACR_DCRST  (0x1 << 12) // Reset de la data cache
+
+// --- Macros para el Registro de Estado (SR) ---
+#define FLASH_SR_EOP     (0x1 << 0)  // Fin de operación
+#define FLASH_SR_OPERR   (0x1 << 1)  // Error de operación
+#define FLASH_SR_PROGERR (0x1 << 3)  // Error de programación (destino no borrado)
+#define FLASH_SR_WRPERR  (0x1 << 4)  // Error de protección de escritura
+#define FLASH_SR_PGAERR  (0x1 << 5)  // Error de alineación
+#define FLASH_SR_SIZERR  (0x1 << 6)  // Error de tamaño
+#define FLASH_SR_PGSERR  (0x1 << 7)  // Error de secuencia
+#define FLASH_SR_MISERR  (0x1 << 8)  // Error de datos faltantes
+#define FLASH_SR_FASTERR (0x1 << 9)  // Error de programación rápida
+#define FLASH_SR_RDERR   (0x1 << 14) // Error de lectura PCROP
+#define FLASH_SR_OPTVERR (0x1 << 15) // Error de validez de opciones
+#define FLASH_SR_BSY     (0x1 << 16) // Operación en curso
+#define FLASH_SR_ERRORS  (FLASH_SR_OPERR | FLASH_SR_PROGERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | \
+                          FLASH_SR_SIZERR | FLASH_SR_PGSERR | FLASH_SR_MISERR | FLASH_SR_FASTERR | \
+                          FLASH_SR_RDERR | FLASH_SR_OPTVERR)
+
+// --- Macros para el Registro de Control (CR) ---
+#define FLASH_CR_PG      (0x1 << 0)  // Programación
+#define FLASH_CR_PER     (0x1 << 1)  // Borrado de página
+#define FLASH_CR_PNB_Pos (3U)        // Número de página (bits 3-10)
+#define FLASH_CR_PNB     (0xFF << FLASH_CR_PNB_Pos)
+#define FLASH_CR_BKER    (0x1 << 11) // Selección de banco para el borrado
+#define FLASH_CR_STRT    (0x1 << 16) // Inicio del borrado
+#define FLASH_CR_LOCK    (0x1UL << 31) // Registro CR bloqueado
 
 /**
  * @brief Estructura que mapea los registros del periférico FLASH
@@ -51,5 +88,53 @@ typedef struct {
  */
 void flash_configure_for_high_speed(void);
 
+/**
+ * @brief Establece el número de Wait States de la memoria FLASH.
+ *
+ * Al subir la frecuencia se debe llamar ANTES del cambio de reloj, y al
+ * bajarla DESPUÉS. La función espera hasta que la nueva latencia sea efectiva.
+ *
+ * @param[in] wait_states Número de Wait States (0-4).
+ */
+void flash_set_latency(uint8_t wait_states);
+
+/**
+ * @brief Devuelve el número de Wait States configurado actualmente.
+ */
+uint8_t flash_get_latency(void);
+
+/**
+ * @brief Desbloquea el registro de control para poder borrar y programar.
+ */
+void flash_unlock(void);
+
+/**
+ * @brief Vuelve a bloquear el registro de control.
+ */
+void flash_lock(void);
+
+/**
+ * @brief Borra la página de 2 KB que contiene la dirección indicada.
+ *
+ * Se ejecuta desde RAM. Mientras dura el borrado (~22 ms) el banco afectado
+ * no se puede leer, por lo que solo debe usarse sobre páginas del banco que
+ * no contiene el programa.
+ *
+ * @param[in] address Cualquier dirección dentro de la página.
+ * @return 0 si tuvo éxito, -1 si hubo un error (el registro SR se limpia).
+ */
+RAMFUNC int flash_erase_page(uint32_t address);
+
+/**
+ * @brief Programa una doble palabra (64 bits), la unidad mínima del STM32L4.
+ *
+ * Se ejecuta desde RAM. El destino debe estar borrado y alineado a 8 bytes.
+ *
+ * @param[in] address Dirección destino, alineada a 8 bytes.
+ * @param[in] data Valor a escribir.
+ * @return 0 si tuvo éxito, -1 si hubo un error.
+ */
+RAMFUNC int flash_program_double_word(uint32_t address, uint64_t data);
+
 
 #endif // FLASH_H
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "gpio.h"
 #include "rcc.h"
+#include "syscfg.h"
 
 /* Base address for all I2C ports */
 #define I2C1 ((i2c_t *)0x40005400UL)
@@ -19,7 +20,24 @@
 #define I2C_CR2_STOP_Pos    (14U) // Stop generation
 #define I2C_CR2_NACK_Pos    (15U) // NACK generation
 #define I2C_CR2_NBYTES_Pos  (16U) // Number of bytes to transfer
+#define I2C_CR2_NBYTES      (0xFFU << I2C_CR2_NBYTES_Pos)
+#define I2C_CR2_RELOAD_Pos  (24U) // NBYTES reload mode, for transfers over 255 bytes
+#define I2C_CR2_RELOAD      (1U << I2C_CR2_RELOAD_Pos)
 #define I2C_CR2_AUTOEND_Pos (25U) // Automatic END condition
+#define I2C_CR2_AUTOEND     (1U << I2C_CR2_AUTOEND_Pos)
+#define I2C_NBYTES_MAX      (255U)
+
+// --- I2C Timing Register Fields ---
+#define I2C_TIMINGR_SCLL_Pos    (0U)
+#define I2C_TIMINGR_SCLH_Pos    (8U)
+#define I2C_TIMINGR_SDADEL_Pos  (16U)
+#define I2C_TIMINGR_SCLDEL_Pos  (20U)
+#define I2C_TIMINGR_PRESC_Pos   (28U)
+
+// --- Standard bus speeds ---
+#define I2C_SPEED_STANDARD      (100000U)   // Standard-mode
+#define I2C_SPEED_FAST          (400000U)   // Fast-mode
+#define I2C_SPEED_FAST_PLUS     (1000000U)  // Fast-mode Plus
 
 // --- I2C Interrupt and Status Register Bits ---
 #define I2C_ISR_TXE_Pos     (0U)
@@ -30,11 +48,19 @@
 #define I2C_ISR_RXNE        (1U << I2C_ISR_RXNE_Pos) // Receive buffer not empty
 #define I2C_ISR_NACKF_Pos   (4U)
 #define I2C_ISR_NACKF       (1U << I2C_ISR_NACKF_Pos) // Not Acknowledge received flag
+#define I2C_ISR_STOPF_Pos   (5U)
+#define I2C_ISR_STOPF       (1U << I2C_ISR_STOPF_Pos) // Stop detection flag
 #define I2C_ISR_TC_Pos      (6U)
 #define I2C_ISR_TC          (1U << I2C_ISR_TC_Pos)  // Transfer Complete flag
+#define I2C_ISR_TCR_Pos     (7U)
+#define I2C_ISR_TCR         (1U << I2C_ISR_TCR_Pos) // Transfer Complete Reload flag
 #define I2C_ISR_BUSY_Pos    (15U)
 #define I2C_ISR_BUSY        (1U << I2C_ISR_BUSY_Pos) // Bus busy flag
 
+// --- I2C Interrupt Clear Register Bits ---
+#define I2C_ICR_NACKCF      (1U << 4) // NACK flag clear
+#define I2C_ICR_STOPCF      (1U << 5) // STOP flag clear
+
 // Register map for an I2C peripheral
 typedef struct {
     volatile uint32_t CR1;
@@ -52,10 +78,40 @@ typedef struct {
 
 /**
  * @brief Initializes an I2C peripheral in master mode.
- * @param[in] config Pointer to the i2c_config_t struct.
+ * @param[in] I2Cx Pointer to the I2C peripheral.
+ * @param[in] timing Raw value for the TIMINGR register.
  */
 void i2c_init(i2c_t *I2Cx, uint32_t timing);
 
+/**
+ * @brief Initializes an I2C peripheral in master mode for a given bus speed.
+ *
+ * The TIMINGR value is computed from the current PCLK1 frequency (the default
+ * I2C kernel clock) and recomputed automatically whenever the clock tree is
+ * reconfigured with rcc_clock_config(). Speeds above 400 kHz also enable the
+ * Fast-mode Plus drive on the port pins.
+ *
+ * @param[in] I2Cx Pointer to the I2C peripheral.
+ * @param[in] bus_hz Desired SCL frequency (at most I2C_SPEED_FAST_PLUS).
+ * @return 0 on success, -1 if no valid timing exists for the current clock.
+ */
+int i2c_init_speed(i2c_t *I2Cx, uint32_t bus_hz);
+
+/**
+ * @brief Computes a TIMINGR value from the I2C-bus specification limits.
+ *
+ * The mode (Standard, Fast or Fast-mode Plus) is picked from bus_hz. The
+ * smallest prescaler that satisfies the SCL low/high, data setup and data
+ * hold limits is used, and the resulting SCL frequency never exceeds bus_hz.
+ *
+ * @param[in] i2c_clk_hz Frequency of the I2C kernel clock.
+ * @param[in] bus_hz Desired SCL frequency.
+ * @param[in] rise_ns SCL/SDA rise time of the bus, in nanoseconds.
+ * @param[in] fall_ns SCL/SDA fall time of the bus, in nanoseconds.
+ * @return The TIMINGR value, or 0 if the constraints cannot be met.
+ */
+uint32_t i2c_compute_timing(uint32_t i2c_clk_hz, uint32_t bus_hz, uint32_t rise_ns, uint32_t fall_ns);
+
 /**
  * @brief Writes a block of data to an I2C slave device.
  * @param[in] i2c_port Pointer to the I2C peripheral.
@@ -66,6 +122,23 @@ void i2c_init(i2c_t *I2Cx, uint32_t timing);
  */
 int i2c_master_write(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *data, uint32_t size);
 
+/**
+ * @brief Writes a header followed by a data block in a single I2C transaction.
+ *
+ * Avoids copying the payload just to put a register address or control byte
+ * in front of it. Transfers longer than 255 bytes use NBYTES reload.
+ *
+ * @param[in] i2c_port Pointer to the I2C peripheral.
+ * @param[in] slave_addr The 7-bit address of the slave device.
+ * @param[in] header Bytes sent first (may be NULL if header_len is 0).
+ * @param[in] header_len Number of header bytes.
+ * @param[in] data Pointer to the data buffer to write.
+ * @param[in] size The number of data bytes.
+ * @return 0 on success, -1 on timeout, -2 if the slave sent a NACK.
+ */
+int i2c_master_write_prefixed(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *header, uint32_t header_len,
+                              const uint8_t *data, uint32_t size);
+
 /**
  * @brief Reads a block of data from an I2C slave device.
  * @param[in] i2c_port Pointer to the I2C peripheral.
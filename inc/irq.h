@@ -0,0 +1,42 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+/*
+ * Core interrupt mask and wait instructions. Kept apart from nvic.h so the
+ * host tests can replace them (tests/host/irq.h) and build the modules that
+ * use them unmodified.
+ */
+
+/**
+ * @brief Masks all configurable interrupts (PRIMASK) for a short critical section.
+ * @return Previous PRIMASK, to be passed to irq_unlock() so sections can nest.
+ */
+static inline uint32_t irq_lock(void)
+{
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+/**
+ * @brief Restores the interrupt mask saved by irq_lock().
+ * @param[in] primask Value returned by the matching irq_lock().
+ */
+static inline void irq_unlock(uint32_t primask)
+{
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/**
+ * @brief Waits for an interrupt (WFI), in Sleep or Stop depending on SCR.SLEEPDEEP.
+ *
+ * A pending interrupt wakes the core even while masked by irq_lock().
+ */
+static inline void irq_wait(void)
+{
+    __asm volatile ("dsb\n\twfi\n\tisb" ::: "memory");
+}
+
+#endif
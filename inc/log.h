@@ -0,0 +1,75 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart.h"
+
+/*
+ * Deferred logging: nothing is formatted on the target.
+ *
+ * LOG_INFO("fan %u rpm", rpm) places the format string in the .logstr
+ * section, which the linker script marks INFO: it is kept in the ELF but
+ * never loaded into flash, and a string's address in it is its ID.
+ * The call only copies {level, ID, count, tick, args} into a RAM ring
+ * (tens of cycles). log_process() encodes queued records as "#L" hex lines
+ * and sends them without blocking; tools/logdecode.py rebuilds the text
+ * from the same ELF.
+ *
+ * Arguments are 32-bit integers: %d %i %u %x %X %c (and %p with a cast).
+ * Floats are not formatted, log scaled integers instead.
+ */
+
+#define LOG_RING_WORDS      256U        // Power of two
+#define LOG_MAX_ARGS        6U
+
+typedef enum {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO  = 1,
+    LOG_LEVEL_WARN  = 2,
+    LOG_LEVEL_ERROR = 3
+} log_level_t;
+
+#define LOG_ARGS(...)       ((const uint32_t[]){ 0, ##__VA_ARGS__ })
+#define LOG_NARGS(...)      (sizeof(LOG_ARGS(__VA_ARGS__)) / sizeof(uint32_t) - 1U)
+
+#define LOG(level, fmt, ...) \
+    do { \
+        static const char log_fmt_[] __attribute__((section(".logstr"), used)) = fmt; \
+        _Static_assert(LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS, "too many log arguments"); \
+        log_write((level), (uint32_t)(uintptr_t)log_fmt_, LOG_ARGS(__VA_ARGS__) + 1, LOG_NARGS(__VA_ARGS__)); \
+    } while(0)
+
+#define LOG_DEBUG(fmt, ...)     LOG(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)      LOG(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)      LOG(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...)     LOG(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Queues one record. Use the LOG_* macros instead of calling it directly.
+ * @param[in] level log_level_t of the record.
+ * @param[in] id Address of the format string in .logstr.
+ * @param[in] args Argument values.
+ * @param[in] count Number of arguments, at most LOG_MAX_ARGS.
+ * @note Safe from interrupts. When the ring is full the record is dropped and counted.
+ */
+void log_write(log_level_t level, uint32_t id, const uint32_t *args, uint32_t count);
+
+/**
+ * @brief Sends queued records without blocking. Call from the main loop.
+ *
+ * Only as many characters as the transmitter accepts right now are written,
+ * the rest follows on the next calls.
+ *
+ * @param[in] usart_port The USART to send to.
+ * @return true while records are still pending.
+ */
+bool log_process(usart_t *usart_port);
+
+/**
+ * @brief Sends every queued record, blocking. For use before a reset.
+ * @param[in] usart_port The USART to send to.
+ */
+void log_flush(usart_t *usart_port);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef LPTIM_H
+#define LPTIM_H
+
+#include <stdint.h>
+
+#define LPTIM1 ((LowPowerTimer_t *)0x40007C00UL)
+#define LPTIM2 ((LowPowerTimer_t *)0x40009400UL)
+
+// --- LPTIM_ISR / LPTIM_ICR / LPTIM_IER Register Bits ---
+#define LPTIM_ISR_ARRM_Pos      (1U)
+#define LPTIM_ISR_ARRM          (1U << LPTIM_ISR_ARRM_Pos)      // Counter reached ARR
+#define LPTIM_ISR_ARROK_Pos     (4U)
+#define LPTIM_ISR_ARROK         (1U << LPTIM_ISR_ARROK_Pos)     // ARR write completed
+#define LPTIM_IER_ARRMIE        LPTIM_ISR_ARRM
+#define LPTIM_ICR_ARRMCF        LPTIM_ISR_ARRM
+#define LPTIM_ICR_ARROKCF       LPTIM_ISR_ARROK
+
+// --- LPTIM_CFGR Register Bits ---
+#define LPTIM_CFGR_PRESC_Pos    (9U)
+#define LPTIM_CFGR_PRESC_Msk    (0x7U << LPTIM_CFGR_PRESC_Pos)  // Kernel clock / 2^PRESC
+
+// --- LPTIM_CR Register Bits ---
+#define LPTIM_CR_ENABLE_Pos     (0U)
+#define LPTIM_CR_ENABLE         (1U << LPTIM_CR_ENABLE_Pos)
+#define LPTIM_CR_SNGSTRT_Pos    (1U)
+#define LPTIM_CR_SNGSTRT        (1U << LPTIM_CR_SNGSTRT_Pos)    // Start in one-shot mode
+
+typedef struct {
+    volatile uint32_t ISR;
+    volatile uint32_t ICR;
+    volatile uint32_t IER;
+    volatile uint32_t CFGR;
+    volatile uint32_t CR;
+    volatile uint32_t CMP;
+    volatile uint32_t ARR;
+    volatile uint32_t CNT;
+    volatile uint32_t OR;
+} LowPowerTimer_t;
+
+#endif
@@ -4,11 +4,28 @@
 #include <stdint.h>
 #include "drivers/ringBuffer/ringBuffer.h"
 #include "drivers/SSD1306/ssd1306.h"
+#include "drivers/SSD1306/widget.h"
+#include "assets.h"
 #include "drivers/keyPad/keypad.h"
 #include "systick.h"
 #include "uart.h"
 #include "gpio.h"
 #include "rcc.h"
 #include "i2c.h"
+#include "tim.h"
+#include "boot.h"
+#include "dwt.h"
+#include "sysmem.h"
+#include "stack.h"
+#include "fault.h"
+#include "trace.h"
+#include "log.h"
+#include "power.h"
+#include "irq.h"
+#include "event.h"
+#include "room_control.h"
+#include "swtimer.h"
+#include "drivers/kvStore/kvStore.h"
+#include "password.h"
 
 #endif
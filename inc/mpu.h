@@ -0,0 +1,74 @@
+#ifndef MPU_H
+#define MPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MPU ((MemoryProtectionUnit_t *)0xE000ED90UL)
+
+#define MPU_REGION_COUNT        8U
+#define MPU_REGION_MIN_SIZE     32U     // Smallest region, in bytes
+
+// --- CTRL Bits ---
+#define MPU_CTRL_ENABLE         (1U << 0)
+#define MPU_CTRL_HFNMIENA       (1U << 1)   // Keep the MPU on in HardFault and NMI
+#define MPU_CTRL_PRIVDEFENA     (1U << 2)   // Default memory map for privileged code outside the regions
+
+// --- RASR Fields ---
+#define MPU_RASR_ENABLE         (1U << 0)
+#define MPU_RASR_SIZE_Pos       (1U)        // Region size is 2^(SIZE + 1) bytes
+#define MPU_RASR_SRD_Pos        (8U)        // Subregion disable bits
+#define MPU_RASR_B              (1U << 16)
+#define MPU_RASR_C              (1U << 17)
+#define MPU_RASR_S              (1U << 18)
+#define MPU_RASR_TEX_Pos        (19U)
+#define MPU_RASR_AP_Pos         (24U)
+#define MPU_RASR_XN             (1U << 28)  // Execute never
+
+// --- Access permissions (RASR.AP) ---
+#define MPU_AP_NO_ACCESS        (0U << MPU_RASR_AP_Pos)
+#define MPU_AP_PRIV_RW          (1U << MPU_RASR_AP_Pos)
+#define MPU_AP_FULL_ACCESS      (3U << MPU_RASR_AP_Pos)
+#define MPU_AP_PRIV_RO          (5U << MPU_RASR_AP_Pos)
+#define MPU_AP_READ_ONLY        (6U << MPU_RASR_AP_Pos)
+
+/**
+ * @brief Register map of the Memory Protection Unit.
+ */
+typedef struct {
+    volatile uint32_t TYPE;     // MPU Type Register
+    volatile uint32_t CTRL;     // MPU Control Register
+    volatile uint32_t RNR;      // Region Number Register
+    volatile uint32_t RBAR;     // Region Base Address Register
+    volatile uint32_t RASR;     // Region Attribute and Size Register
+} MemoryProtectionUnit_t;
+
+/**
+ * @brief Configures one MPU region.
+ * @param[in] region Region number (0-7), higher numbers take precedence on overlap.
+ * @param[in] base Base address, aligned to size.
+ * @param[in] size Size in bytes, a power of two of at least MPU_REGION_MIN_SIZE.
+ * @param[in] attributes MPU_AP_* access permission ORed with MPU_RASR_XN/C/B/S.
+ * @return 0 on success, -1 on an invalid region, size or alignment.
+ */
+int mpu_region_config(uint8_t region, uint32_t base, uint32_t size, uint32_t attributes);
+
+/**
+ * @brief Disables one MPU region.
+ * @param[in] region Region number (0-7).
+ */
+void mpu_region_disable(uint8_t region);
+
+/**
+ * @brief Turns the MPU on, with the default memory map as background for privileged code.
+ *
+ * The MPU stays off in HardFault and NMI, so those handlers can always run.
+ */
+void mpu_enable(void);
+
+/**
+ * @brief Turns the MPU off.
+ */
+void mpu_disable(void);
+
+#endif
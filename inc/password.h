@@ -0,0 +1,72 @@
+#ifndef PASSWORD_H
+#define PASSWORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PASSWORD_KV_KEY         0x0100U     // Record in the key-value store
+#define PASSWORD_DEFAULT        "1234"      // Stored on first boot
+#define PASSWORD_MAX_LEN        16U
+#define PASSWORD_ITERATIONS     256U        // KDF rounds, one SHA-256 block each
+#define PASSWORD_SALT_LEN       8U
+#define PASSWORD_HASH_LEN       20U         // Truncated SHA-256: salt and hash fit one KV value
+#define PASSWORD_FREE_ATTEMPTS  3U          // Wrong passwords before the lockout starts
+#define PASSWORD_BACKOFF_MS     1000U       // First lockout, doubled by every further failure
+#define PASSWORD_BACKOFF_MAX_MS 300000U
+
+/*
+ * Keypad password, stored as a salted, iterated SHA-256 hash:
+ *   u = SHA-256(salt | pin), then PASSWORD_ITERATIONS - 1 times u = SHA-256(u | pin)
+ * Verification always runs every round and compares every byte, so its
+ * time does not depend on how much of the password was right.
+ *
+ * After PASSWORD_FREE_ATTEMPTS consecutive failures each further failure
+ * locks verification out for an exponentially growing time. While locked,
+ * password_verify() returns at once without hashing, so a brute-force loop
+ * on the keypad cannot keep the CPU busy. The failure count is kept in
+ * NOINIT RAM: a reset does not clear the backoff.
+ */
+
+typedef enum {
+    PASSWORD_OK = 0,
+    PASSWORD_WRONG,
+    PASSWORD_LOCKED         // Not checked, still in the backoff period
+} password_result_t;
+
+/**
+ * @brief Loads the stored password, storing PASSWORD_DEFAULT if there is none.
+ * @param[in] now_ms Current time, to restart a lockout that was active before a reset.
+ * @return true on success, false if the default could not be queued in the store
+ *         (it is still used until the next reset).
+ * @note Call after kv_init().
+ */
+bool password_init(uint32_t now_ms);
+
+/**
+ * @brief Replaces the password with a new salt. The write is committed by kv_process().
+ * @param[in] pin The new password, not null-terminated.
+ * @param[in] length Its length, 1 to PASSWORD_MAX_LEN.
+ * @return true on success, false on an invalid length or a store error.
+ */
+bool password_set(const char *pin, uint8_t length);
+
+/**
+ * @brief Checks a password in constant time and updates the backoff.
+ * @param[in] pin The password entered, not null-terminated.
+ * @param[in] length Its length.
+ * @param[in] now_ms Current time.
+ * @return PASSWORD_OK, PASSWORD_WRONG or PASSWORD_LOCKED.
+ */
+password_result_t password_verify(const char *pin, uint8_t length, uint32_t now_ms);
+
+/**
+ * @brief Time left in the current lockout, 0 if none.
+ */
+uint32_t password_lockout_remaining(uint32_t now_ms);
+
+/**
+ * @brief CPU cycles taken by the last password_verify() that ran the KDF.
+ */
+uint32_t password_get_verify_cycles(void);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+/*
+ * Placement of code and data in the memory regions of STM32L476RGTX_FLASH.ld.
+ *
+ *   RAM (SRAM1, 96K)  .data/.bss, heap and every DMA buffer
+ *   SRAM2 (32K)       RAMFUNC code, SRAM2_DATA/SRAM2_BSS and the MSP stack
+ *
+ * Use them on definitions, e.g.
+ *   static uint8_t rx_data[64] SRAM2_BSS;
+ *   RAMFUNC void SysTick_Handler(void) { ... }
+ */
+
+// Code copied to SRAM2 at startup: no flash wait states (4 at 80 MHz), no prefetch misses
+#define RAMFUNC         __attribute__((section(".ramfunc"), noinline, long_call))
+
+// Initialized data in SRAM2, copied from flash at startup
+#define SRAM2_DATA      __attribute__((section(".sram2")))
+
+// Zero-initialized data in SRAM2, cleared at startup. Not reachable by DMA at this address
+#define SRAM2_BSS       __attribute__((section(".sram2_bss")))
+
+// Not initialized at startup, keeps its content across a reset (crash dumps)
+#define NOINIT          __attribute__((section(".noinit")))
+
+// Zero-initialized DMA source/destination, kept in SRAM1 and word aligned
+#define DMA_BUFFER      __attribute__((section(".bss.dma_buffer"), aligned(4)))
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rcc.h"
+#include "uart.h"
+
+#define POWER_STOP_MIN_MS   5U              // Shorter idle periods use Sleep: Stop costs a PLL relock
+#define POWER_STOP_MAX_MS   60000U          // Longest Stop, bounded by the 16-bit wakeup timer
+#define POWER_IDLE_FOREVER  UINT32_MAX      // No deadline pending
+
+/*
+ * Idle power manager. When the main loop has nothing to do it calls
+ * power_idle() with the time left until its next deadline:
+ *   - Sleep: core clock gated, peripherals and SysTick keep running. Any
+ *     interrupt wakes the core, so it never lasts more than one tick.
+ *   - Stop 1/2: every high-speed clock stops. Wakeup sources are the GPIO
+ *     EXTI lines (button, keypad columns), the console USART receiving a
+ *     start bit (Stop 1 only, the USARTs are powered down in Stop 2) and
+ *     LPTIM1, clocked from LSI, armed for the deadline. The MCU wakes up on
+ *     HSI16, the run clock tree is restored with rcc_clock_config() and the
+ *     time measured by LPTIM1 is added to the SysTick count.
+ */
+
+/**
+ * @brief Power modes, from the lightest to the deepest.
+ */
+typedef enum {
+    POWER_MODE_RUN,
+    POWER_MODE_SLEEP,
+    POWER_MODE_STOP1,
+    POWER_MODE_STOP2,
+    POWER_MODE_COUNT
+} power_mode_t;
+
+typedef struct {
+    const rcc_clock_config_t *run_clock;    // Clock tree restored after Stop
+    usart_t *console;                       // Wakes the MCU on RX and drains TX before Stop, NULL for none
+    power_mode_t deepest;                   // Deepest mode allowed
+} power_config_t;
+
+typedef struct {
+    uint32_t entries[POWER_MODE_COUNT];     // RUN counts the idle calls that did not sleep
+    uint64_t time_us[POWER_MODE_COUNT];     // RUN is the rest of the time since power_init()
+} power_stats_t;
+
+/**
+ * @brief Sets up LPTIM1 as the Stop wakeup timer and the console USART wakeup.
+ * @param[in] config Pointer to the configuration, must stay valid.
+ * @return 0 on success, -1 if the console cannot wake the MCU (its kernel
+ *         clock must be HSI16, see rcc_usart_clock_source()). Sleep and Stop
+ *         still work, the console then limits the deepest mode to Sleep.
+ */
+int power_init(const power_config_t *config);
+
+/**
+ * @brief Chooses the power mode for an idle period.
+ *
+ * Pure function, no register access.
+ *
+ * @param[in] idle_ms Time until the next deadline, 0 if work is pending,
+ *                    POWER_IDLE_FOREVER if there is none.
+ * @param[in] stop_allowed False while a peripheral still needs its bus clock.
+ * @param[in] deepest Deepest mode allowed.
+ * @return The mode to enter.
+ */
+power_mode_t power_select_mode(uint32_t idle_ms, bool stop_allowed, power_mode_t deepest);
+
+/**
+ * @brief Sleeps until the next interrupt or deadline in the deepest suitable mode.
+ *
+ * Call with interrupts masked (irq_lock()) after checking that no work is
+ * pending, otherwise an interrupt arriving between the check and the sleep
+ * is only served at the next wakeup. A pending interrupt still wakes the
+ * core; its handler runs after irq_unlock().
+ *
+ * @param[in] idle_ms Time until the next deadline, POWER_IDLE_FOREVER if none.
+ * @return The mode that was used.
+ */
+power_mode_t power_idle(uint32_t idle_ms);
+
+/**
+ * @brief Keeps the MCU out of Stop while a peripheral needs its bus clock
+ *        (e.g. a PWM output). Calls nest; each needs a power_stop_unlock().
+ */
+void power_stop_lock(void);
+
+/**
+ * @brief Releases one power_stop_lock().
+ */
+void power_stop_unlock(void);
+
+/**
+ * @brief Clears the USART wakeup flag. Call from the console USART interrupt handler.
+ * @param[in] usart_port The console USART.
+ */
+void power_usart_wakeup_irq(usart_t *usart_port);
+
+/**
+ * @brief Copies the time spent in each mode since power_init().
+ * @param[out] stats Pointer to the statistics.
+ */
+void power_get_stats(power_stats_t *stats);
+
+/**
+ * @brief Prints the time and duty cycle of each power mode.
+ * @param[in] usart_port The USART to print to.
+ */
+void power_print_stats(usart_t *usart_port);
+
+#endif
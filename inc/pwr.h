@@ -0,0 +1,71 @@
+#ifndef PWR_H
+#define PWR_H
+
+#include <stdint.h>
+#include "rcc.h"
+
+#define PWR ((PowerControl_t *)0x40007000UL)
+
+// --- PWR_CR1 Register Bits ---
+#define PWR_CR1_LPMS_Pos    (0U)
+#define PWR_CR1_LPMS_Msk    (0x7U << PWR_CR1_LPMS_Pos)  // Low-power mode selection
+#define PWR_CR1_LPMS_STOP1  (1U << PWR_CR1_LPMS_Pos)
+#define PWR_CR1_LPMS_STOP2  (2U << PWR_CR1_LPMS_Pos)
+#define PWR_CR1_DBP_Pos     (8U)
+#define PWR_CR1_DBP         (1U << PWR_CR1_DBP_Pos)     // Backup domain write protection disable
+#define PWR_CR1_VOS_Pos     (9U)
+#define PWR_CR1_VOS_Msk     (0x3U << PWR_CR1_VOS_Pos)   // Voltage scaling range selection
+
+// --- PWR_SR2 Register Bits ---
+#define PWR_SR2_VOSF_Pos    (10U)
+#define PWR_SR2_VOSF        (1U << PWR_SR2_VOSF_Pos)    // Voltage scaling in progress
+
+typedef struct {
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t CR3;
+    volatile uint32_t CR4;
+    volatile uint32_t SR1;
+    volatile uint32_t SR2;
+    volatile uint32_t SCR;
+    volatile uint32_t RESERVED;
+    volatile uint32_t PUCRA;
+    volatile uint32_t PDCRA;
+    volatile uint32_t PUCRB;
+    volatile uint32_t PDCRB;
+    volatile uint32_t PUCRC;
+    volatile uint32_t PDCRC;
+    volatile uint32_t PUCRD;
+    volatile uint32_t PDCRD;
+    volatile uint32_t PUCRE;
+    volatile uint32_t PDCRE;
+    volatile uint32_t PUCRF;
+    volatile uint32_t PDCRF;
+    volatile uint32_t PUCRG;
+    volatile uint32_t PDCRG;
+    volatile uint32_t PUCRH;
+    volatile uint32_t PDCRH;
+} PowerControl_t;
+
+/**
+ * @brief Core regulator voltage ranges.
+ */
+typedef enum {
+    PWR_VOS_RANGE1 = 1U,    // High performance, SYSCLK up to 80 MHz
+    PWR_VOS_RANGE2 = 2U     // Low power, SYSCLK up to 26 MHz
+} pwr_vos_t;
+
+/**
+ * @brief Selects the core regulator voltage range and waits until it is stable.
+ * @param[in] range The voltage range.
+ * @note Raise the range before increasing SYSCLK and lower it only after
+ *       SYSCLK has been reduced.
+ */
+void pwr_set_voltage_scaling(pwr_vos_t range);
+
+/**
+ * @brief Returns the current core regulator voltage range.
+ */
+pwr_vos_t pwr_get_voltage_scaling(void);
+
+#endif
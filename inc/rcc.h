@@ -2,6 +2,7 @@
 #define RCC_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "flash.h"
 
 // --- Peripheral base Address ---
@@ -12,6 +13,10 @@
 #define RCC_CR_MSION          (1U << RCC_CR_MSION_Pos)
 #define RCC_CR_MSIRDY_Pos     (1U)
 #define RCC_CR_MSIRDY         (1U << RCC_CR_MSIRDY_Pos)
+#define RCC_CR_MSIRGSEL_Pos   (3U)
+#define RCC_CR_MSIRGSEL       (1U << RCC_CR_MSIRGSEL_Pos)
+#define RCC_CR_MSIRANGE_Pos   (4U)
+#define RCC_CR_MSIRANGE_Msk   (0xFU << RCC_CR_MSIRANGE_Pos)
 #define RCC_CR_HSION_Pos      (8U)
 #define RCC_CR_HSION          (1U << RCC_CR_HSION_Pos)
 #define RCC_CR_HSIRDY_Pos     (10U)
@@ -30,6 +35,47 @@
 #define RCC_CFGR_SW_Msk       (0x3U << RCC_CFGR_SW_Pos)
 #define RCC_CFGR_SWS_Pos      (2U)
 #define RCC_CFGR_SWS_Msk      (0x3U << RCC_CFGR_SWS_Pos)
+#define RCC_CFGR_HPRE_Pos     (4U)
+#define RCC_CFGR_HPRE_Msk     (0xFU << RCC_CFGR_HPRE_Pos)
+#define RCC_CFGR_PPRE1_Pos    (8U)
+#define RCC_CFGR_PPRE1_Msk    (0x7U << RCC_CFGR_PPRE1_Pos)
+#define RCC_CFGR_PPRE2_Pos    (11U)
+#define RCC_CFGR_PPRE2_Msk    (0x7U << RCC_CFGR_PPRE2_Pos)
+#define RCC_CFGR_STOPWUCK_Pos (15U)
+#define RCC_CFGR_STOPWUCK     (1U << RCC_CFGR_STOPWUCK_Pos) // Wake up from Stop on HSI16 instead of MSI
+
+// --- RCC_PLLCFGR Register Bits ---
+#define RCC_PLLCFGR_PLLSRC_Pos (0U)
+#define RCC_PLLCFGR_PLLSRC_Msk (0x3U << RCC_PLLCFGR_PLLSRC_Pos)
+#define RCC_PLLCFGR_PLLM_Pos   (4U)
+#define RCC_PLLCFGR_PLLM_Msk   (0x7U << RCC_PLLCFGR_PLLM_Pos)
+#define RCC_PLLCFGR_PLLN_Pos   (8U)
+#define RCC_PLLCFGR_PLLN_Msk   (0x7FU << RCC_PLLCFGR_PLLN_Pos)
+#define RCC_PLLCFGR_PLLREN_Pos (24U)
+#define RCC_PLLCFGR_PLLREN     (1U << RCC_PLLCFGR_PLLREN_Pos)
+#define RCC_PLLCFGR_PLLR_Pos   (25U)
+#define RCC_PLLCFGR_PLLR_Msk   (0x3U << RCC_PLLCFGR_PLLR_Pos)
+
+// --- RCC_CCIPR Register Bits ---
+#define RCC_CCIPR_LPTIM1SEL_Pos (18U)
+#define RCC_CCIPR_LPTIM1SEL_Msk (0x3U << RCC_CCIPR_LPTIM1SEL_Pos)
+#define RCC_CCIPR_LPTIM2SEL_Pos (20U)
+#define RCC_CCIPR_LPTIM2SEL_Msk (0x3U << RCC_CCIPR_LPTIM2SEL_Pos)
+
+// --- RCC_CSR Register Bits ---
+#define RCC_CSR_LSION_Pos     (0U)
+#define RCC_CSR_LSION         (1U << RCC_CSR_LSION_Pos)
+#define RCC_CSR_LSIRDY_Pos    (1U)
+#define RCC_CSR_LSIRDY        (1U << RCC_CSR_LSIRDY_Pos)
+#define RCC_CSR_MSISRANGE_Pos (8U)
+#define RCC_CSR_MSISRANGE_Msk (0xFU << RCC_CSR_MSISRANGE_Pos)
+
+// --- Oscillator frequencies ---
+#define RCC_HSI_HZ            (16000000U)
+#define RCC_HSE_HZ            (8000000U)  // ST-LINK MCO on the Nucleo board
+#define RCC_LSI_HZ            (32000U)
+#define RCC_SYSCLK_MAX_HZ     (80000000U)
+#define RCC_CLOCK_HOOKS_MAX   (8U)
 
 // --- RCC_APB2ENR Register Bits ---
 #define RCC_APB2ENR_SYSCFGEN_Pos (0U)
@@ -89,6 +135,43 @@ typedef enum {
     SYSCLK_SRC_PLL  // Phase-Locked Loop
 } rcc_clksrc_t;
 
+/**
+ * @brief Kernel clock of a USART, RCC_CCIPR USARTxSEL encoding.
+ */
+typedef enum {
+    RCC_USART_CLK_PCLK   = 0U,  // Follows the clock tree
+    RCC_USART_CLK_SYSCLK = 1U,
+    RCC_USART_CLK_HSI16  = 2U,  // Keeps running in Stop, needed to wake up on RX
+    RCC_USART_CLK_LSE    = 3U
+} rcc_usart_clk_t;
+
+/**
+ * @brief Bus clock frequencies derived from the current clock tree.
+ */
+typedef struct {
+    uint32_t sysclk_hz;
+    uint32_t hclk_hz;       // AHB: core, SysTick, DMA, memories
+    uint32_t pclk1_hz;      // APB1: USART2-5, I2C1-3, TIM2-7
+    uint32_t pclk2_hz;      // APB2: USART1, TIM1/8/15-17, SYSCFG
+    uint32_t timclk1_hz;    // APB1 timer kernel clock (x2 when PCLK1 is divided)
+    uint32_t timclk2_hz;    // APB2 timer kernel clock (x2 when PCLK2 is divided)
+} rcc_clocks_t;
+
+/**
+ * @brief Requested clock tree. Everything else is computed.
+ */
+typedef struct {
+    uint32_t sysclk_hz;     // SYSCLK = HCLK. 16 MHz selects HSI, MSI frequencies up to
+                            // 24 MHz select MSI, anything else is built with the PLL.
+    uint32_t pclk1_max_hz;  // Upper limit for PCLK1, 0 for no limit
+    uint32_t pclk2_max_hz;  // Upper limit for PCLK2, 0 for no limit
+} rcc_clock_config_t;
+
+/**
+ * @brief Callback run after every clock tree change.
+ */
+typedef void (*rcc_clock_hook_t)(const rcc_clocks_t *clocks);
+
 /**
  * @brief Enables the clock for SYSCFG and the Power Interface.
  * @note Power interface clock is required to change voltage scaling.
@@ -101,6 +184,32 @@ void rcc_sys_power_clock_enable(void);
  */
 void rcc_set_system_clock(rcc_clksrc_t clock_source);
 
+/**
+ * @brief Configures the clock tree for the requested SYSCLK.
+ *
+ * Computes the source, PLL M/N/R, voltage range, flash wait states and APB
+ * prescalers, applies them in a safe order and runs the registered hooks.
+ * It can be called at run time to switch between 80 MHz and low-power
+ * frequencies.
+ *
+ * @param[in] config Pointer to the requested configuration.
+ * @return 0 on success, -1 if the frequency cannot be generated exactly.
+ */
+int rcc_clock_config(const rcc_clock_config_t *config);
+
+/**
+ * @brief Returns the bus clocks of the current clock tree.
+ */
+const rcc_clocks_t *rcc_get_clocks(void);
+
+/**
+ * @brief Registers a callback to run after every clock tree change, used to
+ *        re-derive baud rates, SysTick reload, I2C timings, etc.
+ * @param[in] hook The callback.
+ * @return 0 on success, -1 if the hook table is full.
+ */
+int rcc_clock_hook_register(rcc_clock_hook_t hook);
+
 /**
  * @brief Enables the clock for a specific GPIO port.
  * @param[in] port_index Integer for the port (0 for GPIOA, 1 for GPIOB, etc.).
@@ -110,10 +219,24 @@ void rcc_gpio_clock_enable(uint8_t port_index);
 /**
  * @brief Enables the clock for a specific USART peripheral.
  * @param[in] usart_number The number for the USART (1, 2, 3, etc.).
- * @note usart_number 4 and 5 activates the clock for UART com.
+ * @note usart_number 4 and 5 activates the clock for UART com, 6 for LPUART1.
  */
 void rcc_usart_clock_enable(uint8_t usart_number);
 
+/**
+ * @brief Selects the kernel clock of a USART. Call before setting its baud rate.
+ * @param[in] usart_number The number for the USART (1, 2, 3, 4, 5, 6 for LPUART1).
+ * @param[in] source The kernel clock.
+ */
+void rcc_usart_clock_source(uint8_t usart_number, rcc_usart_clk_t source);
+
+/**
+ * @brief Returns the kernel clock frequency of a USART, used to compute its baud rate.
+ * @param[in] usart_number The number for the USART (1, 2, 3, 4, 5, 6 for LPUART1).
+ * @return Frequency in Hz, 0 if the source is not running or unknown.
+ */
+uint32_t rcc_usart_kernel_hz(uint8_t usart_number);
+
 /**
  * @brief Enables the clock for a specific I2C peripheral.
  * @param[in] i2c_number The number for the I2C (1, 2, 3).
@@ -126,6 +249,19 @@ void rcc_i2c_clock_enable(uint8_t i2c_number);
  */
 void rcc_tim_clock_enable(uint8_t timer_number);
 
+/**
+ * @brief Enables a low-power timer clocked from LSI (32 kHz), so it keeps
+ *        counting in Stop 2. LSI is started if needed.
+ * @param[in] lptim_number The number of the low-power timer (1 or 2).
+ */
+void rcc_lptim_clock_enable(uint8_t lptim_number);
+
+/**
+ * @brief Enables the clock for a DMA controller.
+ * @param[in] dma_number The number of the DMA controller (1 or 2).
+ */
+void rcc_dma_clock_enable(uint8_t dma_number);
+
 /**
  * @brief Enables the clock for ADC peripheral.
  */
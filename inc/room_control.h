@@ -0,0 +1,135 @@
+#ifndef ROOM_CONTROL_H
+#define ROOM_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RC_UNLOCK_TEMP_MS   5000U       // Temporary unlock before the door relocks
+#define RC_DENIED_MS        3000U       // Keypad lockout after a wrong password
+#define RC_PIN_MAX          8U          // Longest password accepted from the keypad
+#define RC_MAX_DEPTH        3U          // Deepest state nesting, bounds every dispatch
+
+/*
+ * Room control core: door, keypad access and fan, without any hardware access.
+ *
+ * Hierarchical state machine. Nesting:
+ *   NORMAL          fan level, emergency entry
+ *     LOCKED        door locked; button or remote open -> temporary unlock
+ *       LOCKED_IDLE keypad password entry
+ *       DENIED      keypad ignored for RC_DENIED_MS after a wrong password
+ *     UNLOCKED      door unlocked; lock command or button -> LOCKED_IDLE
+ *       UNLOCKED_TEMP relocks after RC_UNLOCK_TEMP_MS
+ *       UNLOCKED_PERM
+ *   EMERGENCY       door locked, fan at maximum, only EMERGENCY_OFF accepted
+ *
+ * Transitions are a [state][event] table. An event is looked up for the
+ * active leaf state, then for each parent until one handles it, so dispatch
+ * takes at most RC_MAX_DEPTH lookups. A state may have a timeout: it is
+ * armed on entry, cancelled on exit, and room_control_tick() turns it into
+ * RC_EV_TIMEOUT. Time is passed in by the caller (milliseconds, wrapping),
+ * so the same code runs on the target and on a host.
+ */
+
+typedef enum {
+    RC_STATE_NONE = 0,
+    RC_STATE_NORMAL,
+    RC_STATE_LOCKED,
+    RC_STATE_LOCKED_IDLE,
+    RC_STATE_DENIED,
+    RC_STATE_UNLOCKED,
+    RC_STATE_UNLOCKED_TEMP,
+    RC_STATE_UNLOCKED_PERM,
+    RC_STATE_EMERGENCY,
+    RC_STATE_COUNT
+} rc_state_t;
+
+typedef enum {
+    RC_EV_KEY = 0,          // arg: key character. Digits, '*' clears, '#' submits.
+    RC_EV_BUTTON,
+    RC_EV_REMOTE_OPEN,      // Temporary unlock
+    RC_EV_LOCK,
+    RC_EV_UNLOCK,           // Permanent unlock
+    RC_EV_EMERGENCY_ON,
+    RC_EV_EMERGENCY_OFF,
+    RC_EV_FAN_SET,          // arg: rc_fan_t
+    RC_EV_TIMEOUT,          // Generated by room_control_tick()
+    RC_EV_COUNT
+} rc_event_t;
+
+typedef enum {
+    RC_FAN_OFF = 0,
+    RC_FAN_LOW,
+    RC_FAN_MED,
+    RC_FAN_HIGH,
+    RC_FAN_LEVELS
+} rc_fan_t;
+
+/**
+ * @brief Outputs of the state machine. Any callback may be NULL.
+ */
+typedef struct {
+    void (*door)(bool locked);                              // Called when the lock changes
+    void (*fan)(rc_fan_t level);                            // Called when the fan level changes
+    void (*state_changed)(rc_state_t state);                // After every transition
+    bool (*check_password)(const char *pin, uint8_t length); // NULL rejects every password
+} room_control_io_t;
+
+typedef struct {
+    const room_control_io_t *io;
+    rc_state_t state;           // Active leaf state
+    bool door_locked;
+    rc_fan_t fan;               // Current output
+    rc_fan_t fan_user;          // Level requested, restored when the emergency ends
+    bool timer_armed;
+    uint32_t deadline;          // When RC_EV_TIMEOUT is due
+    uint32_t now;               // Time of the event being handled
+    char pin[RC_PIN_MAX];
+    uint8_t pin_length;         // Keys entered, may exceed RC_PIN_MAX
+} room_control_t;
+
+/**
+ * @brief Enters LOCKED_IDLE with the fan off and drives all outputs once.
+ * @param[out] rc The instance.
+ * @param[in] io Output callbacks, must stay valid.
+ * @param[in] now_ms Current time.
+ */
+void room_control_init(room_control_t *rc, const room_control_io_t *io, uint32_t now_ms);
+
+/**
+ * @brief Handles one event. Unhandled events are ignored.
+ * @param[in,out] rc The instance.
+ * @param[in] event The event.
+ * @param[in] arg Event argument, see rc_event_t.
+ * @param[in] now_ms Current time, used to arm state timeouts.
+ */
+void room_control_dispatch(room_control_t *rc, rc_event_t event, uint32_t arg, uint32_t now_ms);
+
+/**
+ * @brief Delivers RC_EV_TIMEOUT when the active state's timeout expired.
+ * @param[in,out] rc The instance.
+ * @param[in] now_ms Current time.
+ */
+void room_control_tick(room_control_t *rc, uint32_t now_ms);
+
+/**
+ * @brief Time left until the next timeout, to size idle periods.
+ * @return Milliseconds, 0 if already due, UINT32_MAX if no timeout is armed.
+ */
+uint32_t room_control_time_to_deadline(const room_control_t *rc, uint32_t now_ms);
+
+/**
+ * @brief Whether a state is the given state or one of its substates.
+ */
+bool room_control_in_state(const room_control_t *rc, rc_state_t state);
+
+/**
+ * @brief Short display name of a state, e.g. "LOCKED".
+ */
+const char *room_control_state_name(rc_state_t state);
+
+/**
+ * @brief PWM duty cycle of a fan level: 0, 25, 60 or 100 %.
+ */
+uint8_t room_control_fan_percent(rc_fan_t level);
+
+#endif
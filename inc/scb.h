@@ -0,0 +1,93 @@
+#ifndef SCB_H
+#define SCB_H
+
+#include <stdint.h>
+
+#define SCB ((SystemControlBlock_t *)0xE000ED00UL)
+#define DHCSR (*(volatile uint32_t *)0xE000EDF0UL)     // Debug Halting Control and Status Register
+
+// --- ICSR Bits ---
+#define SCB_ICSR_VECTACTIVE_Msk     (0x1FFU)                        // Active exception number
+#define SCB_ICSR_PENDSTSET_Pos      (26U)
+#define SCB_ICSR_PENDSTSET          (1U << SCB_ICSR_PENDSTSET_Pos)  // SysTick exception pending
+
+// --- AIRCR Bits ---
+#define SCB_AIRCR_SYSRESETREQ_Pos   (2U)
+#define SCB_AIRCR_SYSRESETREQ       (1U << SCB_AIRCR_SYSRESETREQ_Pos)
+#define SCB_AIRCR_PRIGROUP_Msk      (7U << 8)
+#define SCB_AIRCR_VECTKEY           (0x05FAUL << 16)                // Required for every write
+
+// --- SCR Bits ---
+#define SCB_SCR_SLEEPONEXIT_Pos     (1U)
+#define SCB_SCR_SLEEPONEXIT         (1U << SCB_SCR_SLEEPONEXIT_Pos)
+#define SCB_SCR_SLEEPDEEP_Pos       (2U)
+#define SCB_SCR_SLEEPDEEP           (1U << SCB_SCR_SLEEPDEEP_Pos)
+
+// --- CCR Bits ---
+#define SCB_CCR_DIV_0_TRP           (1U << 4)                       // Trap on divide by zero
+#define SCB_CCR_STKALIGN            (1U << 9)
+
+// --- SHCSR Bits ---
+#define SCB_SHCSR_MEMFAULTENA       (1U << 16)
+#define SCB_SHCSR_BUSFAULTENA       (1U << 17)
+#define SCB_SHCSR_USGFAULTENA       (1U << 18)
+
+// --- CFSR Bits (MemManage, BusFault and UsageFault status) ---
+#define SCB_CFSR_IACCVIOL           (1U << 0)       // Instruction access violation
+#define SCB_CFSR_DACCVIOL           (1U << 1)       // Data access violation
+#define SCB_CFSR_MUNSTKERR          (1U << 3)       // MemManage fault on unstacking
+#define SCB_CFSR_MSTKERR            (1U << 4)       // MemManage fault on stacking
+#define SCB_CFSR_MMARVALID          (1U << 7)       // MMFAR holds the faulting address
+#define SCB_CFSR_IBUSERR            (1U << 8)
+#define SCB_CFSR_PRECISERR          (1U << 9)
+#define SCB_CFSR_IMPRECISERR        (1U << 10)
+#define SCB_CFSR_UNSTKERR           (1U << 11)
+#define SCB_CFSR_STKERR             (1U << 12)
+#define SCB_CFSR_BFARVALID          (1U << 15)      // BFAR holds the faulting address
+#define SCB_CFSR_UNDEFINSTR         (1U << 16)
+#define SCB_CFSR_INVSTATE           (1U << 17)
+#define SCB_CFSR_INVPC              (1U << 18)
+#define SCB_CFSR_NOCP               (1U << 19)
+#define SCB_CFSR_UNALIGNED          (1U << 24)
+#define SCB_CFSR_DIVBYZERO          (1U << 25)
+
+// --- HFSR Bits ---
+#define SCB_HFSR_VECTTBL            (1U << 1)       // Vector table read fault
+#define SCB_HFSR_FORCED             (1U << 30)      // Escalated from a configurable fault
+
+// --- DHCSR Bits ---
+#define DHCSR_C_DEBUGEN             (1U << 0)       // A debugger is attached
+
+/**
+ * @brief Register map of the System Control Block.
+ */
+typedef struct {
+    volatile uint32_t CPUID;    // CPUID Base Register
+    volatile uint32_t ICSR;     // Interrupt Control and State Register
+    volatile uint32_t VTOR;     // Vector Table Offset Register
+    volatile uint32_t AIRCR;    // Application Interrupt and Reset Control Register
+    volatile uint32_t SCR;      // System Control Register
+    volatile uint32_t CCR;      // Configuration Control Register
+    volatile uint8_t  SHP[12];  // System Handlers Priority Registers (4-7, 8-11, 12-15)
+    volatile uint32_t SHCSR;    // System Handler Control and State Register
+    volatile uint32_t CFSR;     // Configurable Fault Status Register
+    volatile uint32_t HFSR;     // HardFault Status Register
+    volatile uint32_t DFSR;     // Debug Fault Status Register
+    volatile uint32_t MMFAR;    // MemManage Fault Address Register
+    volatile uint32_t BFAR;     // BusFault Address Register
+    volatile uint32_t AFSR;     // Auxiliary Fault Status Register
+} SystemControlBlock_t;
+
+/**
+ * @brief Requests a system reset and waits for it.
+ */
+static inline __attribute__((noreturn)) void scb_system_reset(void)
+{
+    __asm volatile ("dsb" ::: "memory");
+    SCB->AIRCR = SCB_AIRCR_VECTKEY | (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) | SCB_AIRCR_SYSRESETREQ;
+    __asm volatile ("dsb" ::: "memory");
+    while(1)
+        ;
+}
+
+#endif
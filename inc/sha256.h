@@ -0,0 +1,38 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_BLOCK_SIZE   64U
+#define SHA256_DIGEST_SIZE  32U
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;                    // Bytes hashed so far
+    uint8_t block[SHA256_BLOCK_SIZE];
+    uint8_t used;                       // Bytes waiting in block
+} sha256_t;
+
+/**
+ * @brief Starts a new hash.
+ * @param[out] ctx The hash context.
+ */
+void sha256_init(sha256_t *ctx);
+
+/**
+ * @brief Hashes more data.
+ * @param[in,out] ctx The hash context.
+ * @param[in] data Pointer to the data.
+ * @param[in] len Data length in bytes.
+ */
+void sha256_update(sha256_t *ctx, const void *data, size_t len);
+
+/**
+ * @brief Finishes the hash and wipes the context.
+ * @param[in,out] ctx The hash context.
+ * @param[out] digest SHA256_DIGEST_SIZE bytes.
+ */
+void sha256_final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif
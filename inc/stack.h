@@ -0,0 +1,44 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdint.h>
+#include "uart.h"
+
+#define STACK_PAINT_PATTERN     0xDEADBEEFUL    // Written over the free stack by Reset_Handler
+#define STACK_GUARD_REGION      0U              // MPU region used for the guard
+
+/*
+ * The MSP stack spans _sstack.._estack at the top of SRAM2 (see the linker
+ * script). Reset_Handler paints it before main(), so the deepest point it
+ * ever reached is the lowest word that no longer holds the pattern.
+ */
+
+/**
+ * @brief Arms the 32 byte no-access MPU region below the stack.
+ *
+ * From then on an overflow raises a MemManage fault at the first access
+ * past _sstack, instead of silently corrupting SRAM2 data. The fault
+ * handler (fault.h) records it on its own stack and resets the MCU.
+ */
+void stack_guard_init(void);
+
+/**
+ * @brief Size of the stack region in bytes.
+ */
+uint32_t stack_get_size(void);
+
+/**
+ * @brief Deepest stack usage since reset, in bytes.
+ *
+ * Scans the painted area from the bottom, so the cost grows with the free
+ * space left; call it from the main loop, not from an interrupt.
+ */
+uint32_t stack_get_high_water(void);
+
+/**
+ * @brief Prints "used/size" of the stack and the guard state.
+ * @param[in] usart_port The USART to print to.
+ */
+void stack_print_usage(usart_t *usart_port);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SWTIMER_LEVELS          4U
+#define SWTIMER_SLOT_BITS       6U
+#define SWTIMER_SLOTS           (1U << SWTIMER_SLOT_BITS)
+#define SWTIMER_MAX_DELAY_MS    0x7FFFFFFFUL    // Wrap-safe limit of the tick arithmetic
+#define SWTIMER_NONE            UINT32_MAX      // No timer pending
+
+/*
+ * Software timers on a hierarchical timing wheel: 4 levels of 64 slots with
+ * a resolution of 1, 64, 4096 and 262144 ms. A timer goes into the level
+ * whose range covers its delay and drops one level each time the lower
+ * level wraps, so start and stop are O(1) and expiry is amortized O(1)
+ * whatever the number of timers. Delays beyond the top level (about 4.6 h)
+ * are parked in it and re-filed when its slot comes round.
+ *
+ * Timers are owned by the caller (no allocation) and callbacks run from
+ * swtimer_process() in the main loop, never from an interrupt. Interrupt
+ * handlers that need a timer post an event instead. None of the functions
+ * are reentrant from interrupt context.
+ */
+
+typedef struct swtimer swtimer_t;
+
+typedef void (*swtimer_callback_t)(swtimer_t *timer);
+
+struct swtimer {
+    swtimer_t *next;
+    swtimer_t **pprev;              // Link that points to this timer, NULL when stopped
+    uint32_t expires;               // Tick of the next expiry
+    uint32_t period_ms;             // 0 for a one-shot timer
+    swtimer_callback_t callback;
+    void *context;                  // For the callback, not used by the wheel
+};
+
+/**
+ * @brief Resets the wheel.
+ * @param[in] now_ms Current tick (systick_getTick()).
+ */
+void swtimer_init(uint32_t now_ms);
+
+/**
+ * @brief Prepares a stopped timer.
+ * @param[out] timer The timer.
+ * @param[in] callback Called from swtimer_process() at each expiry.
+ * @param[in] context Stored in timer->context for the callback.
+ */
+void swtimer_setup(swtimer_t *timer, swtimer_callback_t callback, void *context);
+
+/**
+ * @brief Starts or restarts a timer.
+ * @param[in,out] timer The timer, prepared with swtimer_setup().
+ * @param[in] delay_ms Time to the first expiry, at most SWTIMER_MAX_DELAY_MS.
+ *                     0 expires at the next tick processed.
+ * @param[in] period_ms Time between later expiries, 0 for a one-shot timer.
+ * @note May be called from a timer callback, including for the timer itself.
+ */
+void swtimer_start(swtimer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Stops a timer. Does nothing if it is not running.
+ */
+void swtimer_stop(swtimer_t *timer);
+
+/**
+ * @brief Checks whether a timer is running.
+ */
+static inline bool swtimer_is_active(const swtimer_t *timer)
+{
+    return timer->pprev != NULL;
+}
+
+/**
+ * @brief Runs the callbacks of every timer that expired up to now. Call from the main loop.
+ *
+ * Ticks with nothing to do are skipped, so catching up after a long Stop
+ * costs one step per 64 ms rather than one per millisecond.
+ *
+ * @param[in] now_ms Current tick.
+ * @return The number of callbacks run.
+ */
+uint32_t swtimer_process(uint32_t now_ms);
+
+/**
+ * @brief Time until swtimer_process() next has work, for the power manager.
+ *
+ * Exact for timers less than 64 ms away. Farther timers report the time to
+ * the move of their slot to a lower level, which is never later than the
+ * expiry.
+ *
+ * @param[in] now_ms Current tick.
+ * @return Milliseconds, 0 if work is pending, SWTIMER_NONE if no timer runs.
+ */
+uint32_t swtimer_time_to_next(uint32_t now_ms);
+
+#endif
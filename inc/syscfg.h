@@ -2,10 +2,14 @@
 #define SYSCFG_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "rcc.h"
 
 #define SYSCFG ((SystemConfiguration_t *)0x40010000UL)
 
+// --- SYSCFG Configuration Register 1 Bits ---
+#define SYSCFG_CFGR1_I2C1_FMP_Pos   (20U)   // I2C1..I2C3 Fast-mode Plus drive (bits 20-22)
+
 /**
  * @brief Register map for the core SYSCFG peripheral.
  */
@@ -32,4 +36,11 @@ typedef struct {
  */
 void syscfg_exti_map(uint8_t GPIO_port, uint8_t pin);
 
+/**
+ * @brief Enables or disables the Fast-mode Plus (20 mA) drive on the pins of an I2C port.
+ * @param[in] i2c_number The I2C port number (1-3).
+ * @param[in] enable true to enable the Fast-mode Plus drive.
+ */
+void syscfg_i2c_fast_mode_plus(uint8_t i2c_number, bool enable);
+
 #endif
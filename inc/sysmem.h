@@ -0,0 +1,34 @@
+#ifndef SYSMEM_H
+#define SYSMEM_H
+
+#include <stdint.h>
+
+/*
+ * With SYSMEM_HEAP_LOCK_TRAP set (default), an _sbrk() call after
+ * sysmem_heap_lock() executes a breakpoint: the debugger stops on the hidden
+ * allocation, or without a debugger the core escalates it to a HardFault.
+ * Set it to 0 to only fail the allocation with ENOMEM and record the caller.
+ */
+#ifndef SYSMEM_HEAP_LOCK_TRAP
+#define SYSMEM_HEAP_LOCK_TRAP   1
+#endif
+
+/**
+ * @brief Forbids any further growth of the newlib heap (malloc, printf buffers, ...).
+ *
+ * Call once initialization is done; from then on memory comes from the
+ * static pools and arenas of drivers/memPool only.
+ */
+void sysmem_heap_lock(void);
+
+/**
+ * @brief Bytes handed out to the newlib heap so far.
+ */
+uint32_t sysmem_heap_used(void);
+
+/**
+ * @brief Return address of the last _sbrk() call refused by the lock, NULL if none.
+ */
+void *sysmem_heap_violation(void);
+
+#endif
@@ -2,6 +2,7 @@
 #define SYSTICK_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct {
     volatile uint32_t CTRL;     // SysTick Control and Status Register
@@ -53,11 +54,76 @@ void systick_delay_ms(uint32_t ms);
 uint32_t systick_getTick(void);
 
 /**
- * @brief Pone en cero el contador de interrupciones.
+ * @brief Adds time that passed while SysTick was not counting.
  *
- * Esta función restablece el contador de interrupciones
- * (contador de tiempo) del sistema.
+ * SysTick stops with the core clock in Stop modes; the power manager measures
+ * the time spent there with a low-power timer and adds it back here.
+ *
+ * @param[in] ms Milliseconds to add to the tick count.
+ * @note Call with interrupts masked.
+ */
+void systick_advance(uint32_t ms);
+
+/**
+ * @brief Gets the milliseconds since the SysTick timer started, without wrap.
+ *
+ * Lock-free: the handler updates the low word before the high word, and the
+ * high word is read before and after the low word until both reads agree.
+ * Consistent from thread mode and from handlers SysTick can preempt; a
+ * handler of higher priority than SysTick should use systick_getTick().
+ *
+ * @return The 64-bit tick count.
+ */
+uint64_t systick_get_ms64(void);
+
+/**
+ * @brief Gets the microseconds since the SysTick timer started.
+ *
+ * Adds the fraction of the current millisecond read from VAL. A reload whose
+ * interrupt is still pending (interrupts masked) is counted.
+ *
+ * @return The time in microseconds.
+ */
+uint64_t systick_get_us(void);
+
+/*
+ * Wrap-safe deadlines on the 32-bit tick: differences are taken modulo 2^32,
+ * so they stay right across the wrap as long as the two times are less than
+ * 2^31 ms (24 days) apart.
+ */
+
+/**
+ * @brief Checks whether a timeout has elapsed since a start tick.
+ * @param[in] start Tick when the timeout started.
+ * @param[in] timeout_ms The timeout.
+ * @return true once timeout_ms or more have passed.
+ */
+static inline bool systick_elapsed(uint32_t start, uint32_t timeout_ms)
+{
+    return systick_getTick() - start >= timeout_ms;
+}
+
+/**
+ * @brief Checks whether a deadline has been reached.
+ * @param[in] deadline Tick of the deadline.
+ * @param[in] now The current tick.
+ * @return true if now is at or after the deadline.
+ */
+static inline bool systick_deadline_reached(uint32_t deadline, uint32_t now)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+/**
+ * @brief Time left until a deadline.
+ * @param[in] deadline Tick of the deadline.
+ * @param[in] now The current tick.
+ * @return Milliseconds left, 0 if the deadline has been reached.
  */
-void systick_reset(void);
+static inline uint32_t systick_time_left(uint32_t deadline, uint32_t now)
+{
+    int32_t left = (int32_t)(deadline - now);
+    return (left > 0) ? (uint32_t)left : 0;
+}
 
 #endif
@@ -2,28 +2,78 @@
 #define TIM_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "gpio.h"
 #include "rcc.h"
+#include "dma.h"
+#include "nvic.h"
 
 //--- Timer Peripheral Base Addresses ---//
+#define TIM1_BASE   (0x40012C00UL)
+#define TIM2_BASE   (0x40000000UL)
+#define TIM3_BASE   (0x40000400UL)
+#define TIM4_BASE   (0x40000800UL)
+#define TIM5_BASE   (0x40000C00UL)
+#define TIM6_BASE   (0x40001000UL)
+#define TIM7_BASE   (0x40001400UL)
+#define TIM8_BASE   (0x40013400UL)
+#define TIM15_BASE  (0x40014000UL)
+#define TIM16_BASE  (0x40014400UL)
+#define TIM17_BASE  (0x40014800UL)
+
 // Base address for advanced control TIMs
-#define TIM1 ((Advanced_Timer_t *)0x40012C00UL)
-#define TIM8 ((Advanced_Timer_t *)0x40013400UL)
+#define TIM1 ((Advanced_Timer_t *)TIM1_BASE)
+#define TIM8 ((Advanced_Timer_t *)TIM8_BASE)
 
 // Base address for general purpose TIMs
-#define TIM2 ((GeneralPurpose_Timer_t *)0x40000000UL)
-#define TIM3 ((GeneralPurpose_Timer_t *)0x40000400UL)
-#define TIM4 ((GeneralPurpose_Timer_t *)0x40000800UL)
-#define TIM5 ((GeneralPurpose_Timer_t *)0x40000C00UL)
+#define TIM2 ((GeneralPurpose_Timer_t *)TIM2_BASE)
+#define TIM3 ((GeneralPurpose_Timer_t *)TIM3_BASE)
+#define TIM4 ((GeneralPurpose_Timer_t *)TIM4_BASE)
+#define TIM5 ((GeneralPurpose_Timer_t *)TIM5_BASE)
 
 // Base address for basic TIMs
-#define TIM6 ((Basic_Timer_t *)0x40001000UL)
-#define TIM7 ((Basic_Timer_t *)0x40001400UL)
+#define TIM6 ((Basic_Timer_t *)TIM6_BASE)
+#define TIM7 ((Basic_Timer_t *)TIM7_BASE)
 
 // Base address for general purpose TIMs 15, 16 and 17
-#define TIM15 ((GeneralPurpose_Timer_15_t *)0x40014000UL)
-#define TIM16 ((GeneralPurpose_Timer_16_17_t *)0x40014400UL)
-#define TIM17 ((GeneralPurpose_Timer_16_17_t *)0x40014800UL)
+#define TIM15 ((GeneralPurpose_Timer_15_t *)TIM15_BASE)
+#define TIM16 ((GeneralPurpose_Timer_16_17_t *)TIM16_BASE)
+#define TIM17 ((GeneralPurpose_Timer_16_17_t *)TIM17_BASE)
+
+// --- Timer Control and Status Register Bits ---
+#define TIM_CR1_CEN_Pos     (0U)
+#define TIM_CR1_CEN         (1U << TIM_CR1_CEN_Pos)     // Counter enable
+#define TIM_CR1_ARPE_Pos    (7U)
+#define TIM_CR1_ARPE        (1U << TIM_CR1_ARPE_Pos)    // Auto-reload preload enable
+#define TIM_DIER_UIE_Pos    (0U)
+#define TIM_DIER_UIE        (1U << TIM_DIER_UIE_Pos)    // Update interrupt enable
+#define TIM_SR_UIF_Pos      (0U)
+#define TIM_SR_UIF          (1U << TIM_SR_UIF_Pos)      // Update interrupt flag
+#define TIM_SR_BIF_Pos      (7U)
+#define TIM_SR_BIF          (1U << TIM_SR_BIF_Pos)      // Break interrupt flag
+#define TIM_EGR_UG_Pos      (0U)
+#define TIM_EGR_UG          (1U << TIM_EGR_UG_Pos)      // Update generation
+
+// --- Break and Dead-Time Register Bits (TIM1/TIM8/TIM15-17) ---
+#define TIM_BDTR_DTG_Pos    (0U)                        // Dead-time generator setup
+#define TIM_BDTR_OSSI_Pos   (10U)
+#define TIM_BDTR_OSSI       (1U << TIM_BDTR_OSSI_Pos)   // Off-state selection for idle mode
+#define TIM_BDTR_OSSR_Pos   (11U)
+#define TIM_BDTR_OSSR       (1U << TIM_BDTR_OSSR_Pos)   // Off-state selection for run mode
+#define TIM_BDTR_BKE_Pos    (12U)
+#define TIM_BDTR_BKE        (1U << TIM_BDTR_BKE_Pos)    // Break enable
+#define TIM_BDTR_BKP_Pos    (13U)
+#define TIM_BDTR_BKP        (1U << TIM_BDTR_BKP_Pos)    // Break polarity (1: active high)
+#define TIM_BDTR_MOE_Pos    (15U)
+#define TIM_BDTR_MOE        (1U << TIM_BDTR_MOE_Pos)    // Main output enable
+
+// --- Timer DMA Registers Bits ---
+#define TIM_DIER_UDE_Pos    (8U)
+#define TIM_DIER_UDE        (1U << TIM_DIER_UDE_Pos)    // Update DMA request enable
+#define TIM_DCR_DBA_Pos     (0U)                        // DMA base address (register index)
+#define TIM_DCR_DBL_Pos     (8U)                        // DMA burst length minus one
+#define TIM_DCR_DBA_CCR1    (13U)                       // CCR1 offset (0x34) in 32-bit words
+#define TIM_PRESCALER_MAX   (65536U)                    // PSC is 16 bits, the clock is divided by PSC + 1
 
 //--- Timer Register Structures ---//
 
@@ -169,6 +219,22 @@ typedef struct {
     int period;
 } pwm_config_t;
 
+/**
+ * @brief Configuration structure for DMA driven multi-channel waveforms.
+ *
+ * The table holds raw compare values (0 to period), interleaved per frame:
+ * {CCR1, CCR2, ..., CCRn} for frame 0, then frame 1, and so on. One frame is
+ * written to CCR1..CCRn on every update event, the table then wraps around.
+ */
+typedef struct {
+    GeneralPurpose_Timer_t *pwmTimer;
+    uint8_t channels;           // Number of channels driven, CH1..CHn (1-4)
+    const uint16_t *table;      // frames * channels compare values
+    uint16_t frames;
+    int prescaler;
+    int period;
+} pwm_waveform_config_t;
+
 /**
  * @brief Maps a timer and channel to a default GPIO configuration for PWM output.
  *
@@ -177,20 +243,40 @@ typedef struct {
  * common, default pin for the mapping. Other possible pin mappings are listed
  * in the comments for reference.
  *
- * @param[in] timer Pointer to the timer peripheral (e.g., TIM2).
+ * @param[in] TIMx Any timer (e.g., TIM2); anything else is a compile error.
  * @param[in] channel The timer channel (e.g., TIM_CHANNEL1).
  *
  * @return A gpio_config_t structure with all necessary settings for PWM.
  *         If no mapping is found for the given timer/channel, the returned
  *         struct will have its .port member set to NULL.
  */
-gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel);
+#define timer_get_pin_config(TIMx, channel) \
+    timer_base_pin_config(timer_number(TIMER_BASE(TIMx)), (channel))
+
+/**
+ * @brief Maps a TIM1/TIM8 channel to the GPIO of its complementary output (CHxN).
+ * @return A gpio_config_t structure; .port is NULL if there is no mapping.
+ */
+#define timer_get_complementary_pin_config(TIMx, channel) \
+    timer_base_complementary_pin_config(timer_number(TIMER_BASE(TIMx)), (channel))
+
+/**
+ * @brief Maps a TIM1/TIM8 timer to the GPIO of its break input (BKIN).
+ * @return A gpio_config_t structure; .port is NULL if there is no mapping.
+ */
+#define timer_get_break_pin_config(TIMx) \
+    timer_base_break_pin_config(timer_number(TIMER_BASE(TIMx)))
 
 /**
  * @brief Enables the clock for a specific timer peripheral.
- * @param Timer Pointer to the timer peripheral.
+ * @param TIMx Any timer (e.g., TIM2); anything else is a compile error.
  */
-void timer_clocl_enable(void *Timer);
+#define timer_clock_enable(TIMx) rcc_tim_clock_enable(timer_number(TIMER_BASE(TIMx)))
+
+// Back ends of the macros above, by timer number (1-17)
+gpio_config_t timer_base_pin_config(uint8_t number, timer_channel_t channel);
+gpio_config_t timer_base_complementary_pin_config(uint8_t number, timer_channel_t channel);
+gpio_config_t timer_base_break_pin_config(uint8_t number);
 
 /**
  * @brief Initializes a timer channel for PWM output.
@@ -206,4 +292,181 @@ void pwm_init(pwm_config_t *configStructure);
  */
 void pwm_set_dutyCycle(GeneralPurpose_Timer_t *TIMx, timer_channel_t channel, int dutyCycle);
 
+/**
+ * @brief Starts a DMA burst waveform on channels CH1..CHn of a timer.
+ *
+ * Each update event streams the next frame of the table into CCR1..CCRn
+ * through the DCR/DMAR burst interface, with no CPU involvement. Supported
+ * timers are TIM2-TIM5.
+ *
+ * @param config Pointer to a pwm_waveform_config_t structure.
+ * @return 0 on success, -1 on invalid configuration or unsupported timer.
+ * @note The table must stay valid while the waveform runs.
+ */
+int pwm_waveform_start(const pwm_waveform_config_t *config);
+
+/**
+ * @brief Stops a DMA burst waveform. Outputs hold the last written values.
+ * @param TIMx Pointer to the timer peripheral.
+ */
+void pwm_waveform_stop(GeneralPurpose_Timer_t *TIMx);
+
+//--- Generic Timer API ---//
+
+/**
+ * @brief Returns the timer number (1-17) for a timer peripheral pointer.
+ *
+ * Inlined so that, when TIMx is one of the TIMn constants, the lookup folds
+ * away at compile time.
+ *
+ * @return The timer number, or 0 if the pointer is not a timer.
+ */
+static inline uint8_t timer_number(const volatile void *TIMx)
+{
+    switch((uint32_t)TIMx) {
+        case TIM1_BASE:  return 1;
+        case TIM2_BASE:  return 2;
+        case TIM3_BASE:  return 3;
+        case TIM4_BASE:  return 4;
+        case TIM5_BASE:  return 5;
+        case TIM6_BASE:  return 6;
+        case TIM7_BASE:  return 7;
+        case TIM8_BASE:  return 8;
+        case TIM15_BASE: return 15;
+        case TIM16_BASE: return 16;
+        case TIM17_BASE: return 17;
+        default:         return 0;
+    }
+}
+
+/**
+ * @brief Common register view of any timer.
+ *
+ * CR1, CR2, DIER, SR, EGR, CNT, PSC and ARR sit at the same offsets in every
+ * timer class, which is exactly the basic timer layout. Passing anything that
+ * is not a timer register map is a compile error.
+ */
+#define TIMER_BASE(TIMx) _Generic((TIMx), \
+    Advanced_Timer_t *:             (Basic_Timer_t *)(TIMx), \
+    GeneralPurpose_Timer_t *:       (Basic_Timer_t *)(TIMx), \
+    GeneralPurpose_Timer_15_t *:    (Basic_Timer_t *)(TIMx), \
+    GeneralPurpose_Timer_16_17_t *: (Basic_Timer_t *)(TIMx), \
+    Basic_Timer_t *:                (Basic_Timer_t *)(TIMx))
+
+/**
+ * @brief Configures any timer to generate a periodic update interrupt.
+ *
+ * Update frequency = f_TIMCLK / (prescaler * period). The matching NVIC line
+ * is enabled; the counter is left stopped until timer_start() is called.
+ * The ISR must call timer_update_pending() to acknowledge the interrupt.
+ *
+ * @param TIMx Any timer (e.g., TIM6, TIM7).
+ * @param prescaler Clock prescaler (1-65536).
+ * @param period Number of prescaled ticks per update event.
+ */
+#define timer_periodic_init(TIMx, prescaler, period) \
+    timer_base_periodic_init(TIMER_BASE(TIMx), timer_number(TIMx), (prescaler), (period))
+
+/**
+ * @brief Starts / stops the counter of any timer.
+ */
+#define timer_start(TIMx)   (TIMER_BASE(TIMx)->CR1 |= TIM_CR1_CEN)
+#define timer_stop(TIMx)    (TIMER_BASE(TIMx)->CR1 &= ~TIM_CR1_CEN)
+
+/**
+ * @brief Reads the counter of any timer.
+ */
+#define timer_get_counter(TIMx) (TIMER_BASE(TIMx)->CNT)
+
+/**
+ * @brief Checks and clears the update flag of any timer.
+ * @return true if an update event was pending.
+ */
+#define timer_update_pending(TIMx) timer_base_update_pending(TIMER_BASE(TIMx))
+
+void timer_base_periodic_init(Basic_Timer_t *TIMx, uint8_t number, uint32_t prescaler, uint32_t period);
+bool timer_base_update_pending(Basic_Timer_t *TIMx);
+
+/**
+ * @brief Configuration structure for PWM with dead-time and break on TIM1/TIM8.
+ */
+typedef struct {
+    Advanced_Timer_t *pwmTimer;
+    timer_channel_t pwmChannel;
+    int prescaler;
+    int period;
+    bool complementary;         // Also drive the CHxN output (channels 1-3)
+    uint32_t dead_time_ns;      // Delay inserted between CHx and CHxN edges
+    uint32_t timer_clock_hz;    // Timer kernel clock, used to convert dead_time_ns
+    bool break_enable;          // Force outputs to their idle state on BKIN
+    bool break_active_high;     // BKIN polarity
+} adv_pwm_config_t;
+
+/**
+ * @brief Initializes a TIM1/TIM8 channel for PWM with optional complementary
+ *        output, dead-time insertion and break input.
+ * @param config Pointer to an adv_pwm_config_t structure.
+ * @return 0 on success, -1 on invalid configuration.
+ */
+int adv_pwm_init(const adv_pwm_config_t *config);
+
+/**
+ * @brief Sets the duty cycle for a TIM1/TIM8 PWM channel.
+ * @param TIMx Pointer to the timer peripheral (TIM1 or TIM8).
+ * @param channel The timer channel to modify.
+ * @param dutyCycle The desired duty cycle in percent (0 to 100).
+ */
+void adv_pwm_set_dutyCycle(Advanced_Timer_t *TIMx, timer_channel_t channel, int dutyCycle);
+
+/**
+ * @brief Re-enables the outputs after a break event has been handled.
+ * @param TIMx Pointer to the timer peripheral (TIM1 or TIM8).
+ */
+void adv_pwm_break_clear(Advanced_Timer_t *TIMx);
+
+/**
+ * @brief Edge selection for input capture.
+ */
+typedef enum {
+    TIM_IC_RISING,
+    TIM_IC_FALLING,
+    TIM_IC_BOTH_EDGES
+} timer_ic_edge_t;
+
+/**
+ * @brief Configuration structure for input capture.
+ */
+typedef struct {
+    timer_channel_t channel;
+    timer_ic_edge_t edge;
+    uint8_t filter;             // Digital input filter (ICxF, 0-15)
+    uint32_t prescaler;         // Counter prescaler (1-TIM_PRESCALER_MAX)
+    uint32_t period;            // Counter period; 0 selects the full counter range
+    bool interrupt;             // Enable the capture interrupt in the timer and NVIC
+} timer_ic_config_t;
+
+/**
+ * @brief Configures a channel for input capture and starts the counter.
+ *
+ * Supported timers are TIM2-TIM5 (channels 1-4) and TIM15 (channels 1-2).
+ * The pin is taken from timer_get_pin_config().
+ *
+ * @param TIMx Pointer to the timer peripheral.
+ * @param config Pointer to a timer_ic_config_t structure.
+ * @return 0 on success, -1 on invalid configuration.
+ */
+#define timer_input_capture_init(TIMx, config) _Generic((TIMx), \
+    GeneralPurpose_Timer_t *:    gp_timer_input_capture_init, \
+    GeneralPurpose_Timer_15_t *: tim15_input_capture_init)((TIMx), (config))
+
+/**
+ * @brief Reads the last captured value of a channel.
+ */
+#define timer_capture_read(TIMx, channel) _Generic((TIMx), \
+    GeneralPurpose_Timer_t *:    (&(TIMx)->CCR1)[(channel)], \
+    GeneralPurpose_Timer_15_t *: (&(TIMx)->CCR1)[(channel)])
+
+int gp_timer_input_capture_init(GeneralPurpose_Timer_t *TIMx, const timer_ic_config_t *config);
+int tim15_input_capture_init(GeneralPurpose_Timer_15_t *TIMx, const timer_ic_config_t *config);
+
 #endif
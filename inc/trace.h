@@ -0,0 +1,111 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dwt.h"
+#include "uart.h"
+
+/*
+ * Binary event trace for ISR and main loop timelines.
+ *
+ * Every event is 8 bytes {DWT cycle count, id, 16-bit argument} in a RAM
+ * ring that always holds the newest TRACE_SIZE events. A slot is claimed
+ * with one atomic increment (LDREX/STREX), so trace_event() is lock-free,
+ * may be called from any interrupt and costs a few cycles. trace_dump()
+ * prints the ring as hex lines; tools/trace2json.py turns them into a
+ * Chrome trace / Perfetto JSON file, taking the event names from this
+ * header.
+ *
+ * Build with TRACE_ENABLED=0 to compile every TRACE_* call out.
+ */
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED       1
+#endif
+
+#ifndef TRACE_SYSTICK
+#define TRACE_SYSTICK       0   // One event per millisecond, fills the ring in TRACE_SIZE ms
+#endif
+
+#define TRACE_SIZE          512U        // Events, power of two
+
+// Kind of event, in the top bits of the id
+#define TRACE_INSTANT       0x0000U
+#define TRACE_BEGIN         0x4000U     // Start of a duration, matched by the next TRACE_END of the same event
+#define TRACE_END           0x8000U
+#define TRACE_KIND_Msk      0xC000U
+
+// Events. tools/trace2json.py parses this enum, keep one "TRACE_EV_<NAME> = <n>," per line.
+// Names ending in _ISR are drawn on the interrupt track.
+typedef enum {
+    TRACE_EV_SYSTICK_ISR    = 1,    // arg: tick, low 16 bits
+    TRACE_EV_EXTI_ISR       = 2,    // arg: pending EXTI lines
+    TRACE_EV_KEYPAD_ISR     = 3,    // arg: key found, 0 if none
+    TRACE_EV_USART_TX       = 4,    // arg: characters sent (end)
+    TRACE_EV_I2C_WRITE      = 5,    // arg: slave address (begin), 0 or 0xFFFF on error (end)
+    TRACE_EV_BOOT_TASK      = 6,    // arg: deferred task index
+    TRACE_EV_LOOP_BUTTON    = 7,    // main loop: button task
+    TRACE_EV_LOOP_BOOT      = 8,    // main loop: deferred boot tasks
+    TRACE_EV_IDLE           = 9,    // arg: power mode entered (begin)
+    TRACE_EV_USER           = 64    // First id free for the application
+} trace_event_id_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint16_t id;
+    uint16_t arg;
+} trace_entry_t;
+
+extern trace_entry_t g_trace_buffer[TRACE_SIZE];
+extern uint32_t g_trace_head;
+extern volatile bool g_trace_enabled;
+
+/**
+ * @brief Records one event.
+ * @param[in] id trace_event_id_t ORed with TRACE_BEGIN, TRACE_END or TRACE_INSTANT.
+ * @param[in] arg Event specific argument.
+ */
+static inline void trace_event(uint16_t id, uint16_t arg)
+{
+    if(!g_trace_enabled)
+        return;
+
+    uint32_t slot = __atomic_fetch_add(&g_trace_head, 1U, __ATOMIC_RELAXED) & (TRACE_SIZE - 1U);
+    trace_entry_t *entry = &g_trace_buffer[slot];
+    entry->cycles = dwt_get_cycles();
+    entry->id = id;
+    entry->arg = arg;
+}
+
+#if TRACE_ENABLED
+#define TRACE_INSTANT_EVENT(ev, arg)    trace_event((uint16_t)(TRACE_INSTANT | (ev)), (uint16_t)(arg))
+#define TRACE_BEGIN_EVENT(ev, arg)      trace_event((uint16_t)(TRACE_BEGIN | (ev)), (uint16_t)(arg))
+#define TRACE_END_EVENT(ev, arg)        trace_event((uint16_t)(TRACE_END | (ev)), (uint16_t)(arg))
+#else
+#define TRACE_INSTANT_EVENT(ev, arg)    ((void)0)
+#define TRACE_BEGIN_EVENT(ev, arg)      ((void)0)
+#define TRACE_END_EVENT(ev, arg)        ((void)0)
+#endif
+
+/**
+ * @brief Clears the ring and starts recording. Needs dwt_init() first.
+ */
+void trace_start(void);
+
+/**
+ * @brief Stops recording, the ring keeps its content.
+ */
+void trace_stop(void);
+
+/**
+ * @brief Prints the ring, oldest event first, then resumes recording if it was on.
+ *
+ * Format: "TRACE <cpu_hz> <count>", one "<cycles> <id> <arg>" hex line per
+ * event, "TRACE END". Events recorded by interrupts during the dump are lost.
+ *
+ * @param[in] usart_port The USART to print to.
+ */
+void trace_dump(usart_t *usart_port);
+
+#endif
@@ -2,6 +2,7 @@
 #define UART_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "nvic.h"
 #include "gpio.h"
 #include "rcc.h"
@@ -11,6 +12,7 @@
 #define USART3 ((usart_t *)0x40004800UL)
 #define UART_4 ((usart_t *)0x40004C00UL)
 #define UART_5 ((usart_t *)0x40005000UL)
+#define LPUART1 ((usart_t *)0x40008000UL)
 
 // --- USART Control Register Bits ---
 #define USART_CR1_UE_Pos     (0U)
@@ -25,16 +27,33 @@
 #define USART_CR1_PCE        (1U << USART_CR1_PCE_Pos)  // Parity Control Enable
 #define USART_CR1_PS_Pos     (9U)
 #define USART_CR1_PS         (1U << USART_CR1_PS_Pos)   // Parity Selection
+#define USART_CR1_OVER8_Pos  (15U)
+#define USART_CR1_OVER8      (1U << USART_CR1_OVER8_Pos) // Oversampling by 8
 #define USART_CR1_M0_Pos     (12U)
 #define USART_CR1_M0         (1U << USART_CR1_M0_Pos)   // Word Length Bit 0
 #define USART_CR1_M1_Pos     (28U)
 #define USART_CR1_M1         (1U << USART_CR1_M1_Pos)   // Word Length Bit 1
+#define USART_CR1_UESM_Pos   (1U)
+#define USART_CR1_UESM       (1U << USART_CR1_UESM_Pos) // USART Enable in Stop mode
+
+// --- USART_CR3 Register Bits ---
+#define USART_CR3_WUS_Pos    (20U)
+#define USART_CR3_WUS_Msk    (0x3U << USART_CR3_WUS_Pos) // Wakeup from Stop event: 2 = start bit
+#define USART_CR3_WUFIE_Pos  (22U)
+#define USART_CR3_WUFIE      (1U << USART_CR3_WUFIE_Pos) // Wakeup from Stop Interrupt Enable
 
 // --- USART Status Register Bits ---
 #define USART_ISR_TXE_Pos    (7U)
 #define USART_ISR_TXE        (1U << USART_ISR_TXE_Pos) // Transmit Data Register Empty
 #define USART_ISR_RXNE_Pos   (5U)
 #define USART_ISR_RXNE       (1U << USART_ISR_RXNE_Pos) // Read Data Register Not Empty
+#define USART_ISR_TC_Pos     (6U)
+#define USART_ISR_TC         (1U << USART_ISR_TC_Pos)   // Transmission Complete
+#define USART_ISR_WUF_Pos    (20U)
+#define USART_ISR_WUF        (1U << USART_ISR_WUF_Pos)  // Wakeup from Stop
+#define USART_ICR_WUCF       USART_ISR_WUF
+
+#define USART_BAUD_INVALID   (INT32_MIN)
 
 typedef struct {
     volatile uint32_t CR1;
@@ -69,6 +88,16 @@ typedef enum {
     NO_PARITY
 }parity_t;
 
+/**
+ * @brief Result of a baud rate computation.
+ */
+typedef struct {
+    uint32_t brr;           // Value for the BRR register
+    bool over8;             // OVER8 must be set (never for LPUART1)
+    uint32_t actual_baud;   // Baud rate really generated by brr
+    int32_t error_ppm;      // (actual - requested) / requested, in parts per million
+}usart_brr_t;
+
 typedef struct {
     usart_t *usart_port;
     uint32_t baudrate;
@@ -84,6 +113,31 @@ typedef struct {
  */
 void usart_init(const usart_config_t *config, uint32_t pclk_freq);
 
+/**
+ * @brief Reprograms the baud rate of an initialized USART, e.g. after a clock change.
+ * @param[in] usart_port Pointer to the USART peripheral.
+ * @param[in] pclk_freq The new frequency of the peripheral clock feeding the USART.
+ * @param[in] baudrate The desired baud rate.
+ * @return The baud rate error in ppm, or USART_BAUD_INVALID if BRR was left untouched.
+ * @note Waits for the frame in progress to complete before touching BRR.
+ */
+int32_t usart_set_baudrate(usart_t *usart_port, uint32_t pclk_freq, uint32_t baudrate);
+
+/**
+ * @brief Computes the rounded BRR value for a baud rate.
+ *
+ * Oversampling by 16 is preferred for its better noise tolerance, OVER8 is
+ * selected only when pclk_freq / baudrate drops below 16, which allows up to
+ * pclk_freq / 8 baud (10 Mbaud at 80 MHz). LPUART1 uses its own 256x divider.
+ *
+ * @param[in] usart_port Pointer to the USART peripheral (selects the divider type).
+ * @param[in] pclk_freq The frequency of the clock feeding the USART.
+ * @param[in] baudrate The desired baud rate.
+ * @param[out] result Pointer to store the BRR value, mode and error.
+ * @return 0 on success, -1 if the baud rate is out of range for this clock.
+ */
+int usart_compute_brr(usart_t *usart_port, uint32_t pclk_freq, uint32_t baudrate, usart_brr_t *result);
+
 /**
  * @brief Enables the USART receive interrupt (RXNE).
  * @param[in] usart_port Pointer to the USART peripheral.
@@ -97,6 +151,14 @@ void usart_rx_interrupt_enable(usart_t *usart_port);
  */
 void usart_send_char(usart_t *usart_port, char c);
 
+/**
+ * @brief Sends a character only if the transmitter can take it now.
+ * @param[in] usart_port Pointer to the USART peripheral.
+ * @param[in] c The character to send.
+ * @return true if the character was written, false if the transmit register is still full.
+ */
+bool usart_try_send_char(usart_t *usart_port, char c);
+
 /**
  * @brief Sends a null-terminated string over USART.
  * @param[in] usart_port Pointer to the USART peripheral.
@@ -104,6 +166,20 @@ void usart_send_char(usart_t *usart_port, char c);
  */
 void usart_send_string(usart_t *usart_port, const char *str);
 
+/**
+ * @brief Sends an unsigned integer in decimal, without pulling in printf.
+ * @param[in] usart_port Pointer to the USART peripheral.
+ * @param[in] value The number to send.
+ */
+void usart_send_uint(usart_t *usart_port, uint32_t value);
+
+/**
+ * @brief Sends a 32-bit value as "0x" followed by 8 hexadecimal digits.
+ * @param[in] usart_port Pointer to the USART peripheral.
+ * @param[in] value The number to send.
+ */
+void usart_send_hex(usart_t *usart_port, uint32_t value);
+
 /**
  * @brief Receives a single character from USART.
  * @note This is a blocking function. It will wait until a character is received.
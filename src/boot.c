@@ -0,0 +1,87 @@
+#include "boot.h"
+#include "trace.h"
+
+typedef struct {
+    const char *stage;
+    uint32_t time_us;       // Time since dwt_init()
+} boot_mark_t;
+
+typedef struct {
+    const char *stage;
+    boot_task_t task;
+} boot_deferred_t;
+
+static boot_mark_t g_marks[BOOT_MAX_MARKS];
+static uint8_t g_mark_count = 0;
+
+static boot_deferred_t g_tasks[BOOT_MAX_TASKS];
+static uint8_t g_task_count = 0;
+
+static uint32_t g_last_cycles = 0;
+static uint32_t g_elapsed_us = 0;
+
+void boot_mark(const char *stage)
+{
+    uint32_t now = dwt_get_cycles();
+    uint32_t cycles_per_us = rcc_get_clocks()->hclk_hz / 1000000U;
+
+    g_elapsed_us += (now - g_last_cycles) / (cycles_per_us ? cycles_per_us : 1);
+    g_last_cycles = now;
+
+    if(g_mark_count < BOOT_MAX_MARKS) {
+        g_marks[g_mark_count].stage = stage;
+        g_marks[g_mark_count].time_us = g_elapsed_us;
+        g_mark_count++;
+    }
+}
+
+bool boot_defer(const char *stage, boot_task_t task)
+{
+    if(task == NULL || g_task_count >= BOOT_MAX_TASKS)
+        return false;
+
+    g_tasks[g_task_count].stage = stage;
+    g_tasks[g_task_count].task = task;
+    g_task_count++;
+    return true;
+}
+
+void boot_process(void)
+{
+    for(uint8_t i = 0; i < g_task_count; ) {
+        TRACE_BEGIN_EVENT(TRACE_EV_BOOT_TASK, i);
+        bool done = g_tasks[i].task();
+        TRACE_END_EVENT(TRACE_EV_BOOT_TASK, i);
+
+        if(done) {
+            boot_mark(g_tasks[i].stage);
+            // Finished tasks are dropped, the order of the others does not matter
+            g_tasks[i] = g_tasks[--g_task_count];
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+bool boot_is_complete(void)
+{
+    return g_task_count == 0;
+}
+
+void boot_print_timeline(usart_t *usart_port)
+{
+    uint32_t previous_us = 0;
+
+    usart_send_string(usart_port, "Boot timeline:\r\n");
+    for(uint8_t i = 0; i < g_mark_count; i++) {
+        usart_send_string(usart_port, "  ");
+        usart_send_string(usart_port, g_marks[i].stage);
+        usart_send_string(usart_port, ": +");
+        usart_send_uint(usart_port, g_marks[i].time_us - previous_us);
+        usart_send_string(usart_port, " us (");
+        usart_send_uint(usart_port, g_marks[i].time_us);
+        usart_send_string(usart_port, " us)\r\n");
+        previous_us = g_marks[i].time_us;
+    }
+}
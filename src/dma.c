@@ -0,0 +1,71 @@
+#include "dma.h"
+
+static uint8_t dma_number(dma_t *DMAx)
+{
+    if(DMAx == DMA1) return 1;
+    if(DMAx == DMA2) return 2;
+    return 0;
+}
+
+int dma_init(const dma_config_t *config)
+{
+    if(config == NULL || config->channel < 1 || config->channel > 7)
+        return -1;
+
+    dma_t *DMAx = config->dma;
+    uint8_t number = dma_number(DMAx);
+    if(number == 0)
+        return -1;
+
+    // 1. Enable the DMA controller clock
+    rcc_dma_clock_enable(number);
+
+    // 2. The channel must be disabled before it can be reconfigured
+    dma_channel_t *ch = &DMAx->CH[config->channel - 1];
+    ch->CCR &= ~DMA_CCR_EN;
+    DMAx->IFCR = (0xFU << (4 * (config->channel - 1)));
+
+    // 3. Route the requested peripheral to this channel
+    uint8_t shift = 4 * (config->channel - 1);
+    DMAx->CSELR = (DMAx->CSELR & ~(0xFU << shift)) | ((config->request & 0xFU) << shift);
+
+    // 4. Addresses and transfer length
+    ch->CPAR  = (uint32_t)config->periph_addr;
+    ch->CMAR  = (uint32_t)config->mem_addr;
+    ch->CNDTR = config->count;
+
+    // 5. Channel configuration. The peripheral address never increments.
+    uint32_t ccr = DMA_CCR_MINC;
+    ccr |= (config->periph_width << DMA_CCR_PSIZE_Pos);
+    ccr |= (config->mem_width << DMA_CCR_MSIZE_Pos);
+    ccr |= (config->priority << DMA_CCR_PL_Pos);
+    if(config->direction == DMA_DIR_MEM_TO_PERIPH)
+        ccr |= DMA_CCR_DIR;
+    if(config->circular)
+        ccr |= DMA_CCR_CIRC;
+    ch->CCR = ccr;
+
+    return 0;
+}
+
+void dma_enable(dma_t *DMAx, uint8_t channel)
+{
+    if(channel < 1 || channel > 7)
+        return;
+    DMAx->CH[channel - 1].CCR |= DMA_CCR_EN;
+}
+
+void dma_disable(dma_t *DMAx, uint8_t channel)
+{
+    if(channel < 1 || channel > 7)
+        return;
+    DMAx->CH[channel - 1].CCR &= ~DMA_CCR_EN;
+    DMAx->IFCR = (0xFU << (4 * (channel - 1)));
+}
+
+uint16_t dma_get_remaining(dma_t *DMAx, uint8_t channel)
+{
+    if(channel < 1 || channel > 7)
+        return 0;
+    return (uint16_t)DMAx->CH[channel - 1].CNDTR;
+}
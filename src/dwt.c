@@ -0,0 +1,11 @@
+#include "dwt.h"
+
+void dwt_init(void)
+{
+    // 1. The DWT registers are only accessible once trace is enabled
+    DEMCR |= DEMCR_TRCENA;
+
+    // 2. Restart and enable the cycle counter
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+}
@@ -0,0 +1,94 @@
+#include "event.h"
+#include "irq.h"
+
+#define EVENT_QUEUE_MASK    (EVENT_QUEUE_SIZE - 1U)
+
+_Static_assert((EVENT_QUEUE_SIZE & EVENT_QUEUE_MASK) == 0, "EVENT_QUEUE_SIZE must be a power of two");
+
+// One FIFO per priority. head and tail run freely; head - tail is the count.
+typedef struct {
+    event_t events[EVENT_QUEUE_SIZE];
+    volatile uint8_t head;      // Written by event_post()
+    volatile uint8_t tail;      // Written by event_dispatch()
+} event_queue_t;
+
+static event_queue_t g_queues[EVENT_PRIO_COUNT];
+static event_handler_t g_subscribers[EVENT_TYPE_COUNT][EVENT_MAX_SUBSCRIBERS];
+static volatile uint32_t g_dropped = 0;
+
+int event_subscribe(event_type_t type, event_handler_t handler)
+{
+    if(type >= EVENT_TYPE_COUNT || handler == NULL)
+        return -1;
+
+    for(uint32_t i = 0; i < EVENT_MAX_SUBSCRIBERS; i++) {
+        if(g_subscribers[type][i] == NULL) {
+            g_subscribers[type][i] = handler;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+bool event_post(event_type_t type, event_priority_t priority, uint32_t data)
+{
+    if(type >= EVENT_TYPE_COUNT || priority >= EVENT_PRIO_COUNT)
+        return false;
+
+    event_queue_t *queue = &g_queues[priority];
+    bool posted = false;
+
+    // Masked so that nested interrupts posting to the same queue cannot
+    // claim the same slot
+    uint32_t primask = irq_lock();
+    uint8_t head = queue->head;
+    if((uint8_t)(head - queue->tail) < EVENT_QUEUE_SIZE) {
+        event_t *event = &queue->events[head & EVENT_QUEUE_MASK];
+        event->type = (uint8_t)type;
+        event->priority = (uint8_t)priority;
+        event->data = data;
+        queue->head = (uint8_t)(head + 1U);
+        posted = true;
+    } else {
+        g_dropped++;
+    }
+    irq_unlock(primask);
+    return posted;
+}
+
+bool event_dispatch(void)
+{
+    for(uint32_t prio = 0; prio < EVENT_PRIO_COUNT; prio++) {
+        event_queue_t *queue = &g_queues[prio];
+        uint8_t tail = queue->tail;
+        if(queue->head == tail)
+            continue;
+
+        // Copied out so the slot can be reused while the subscribers run
+        event_t event = queue->events[tail & EVENT_QUEUE_MASK];
+        queue->tail = (uint8_t)(tail + 1U);
+
+        for(uint32_t i = 0; i < EVENT_MAX_SUBSCRIBERS; i++) {
+            event_handler_t handler = g_subscribers[event.type][i];
+            if(handler == NULL)
+                break;
+            handler(&event);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool event_pending(void)
+{
+    for(uint32_t prio = 0; prio < EVENT_PRIO_COUNT; prio++) {
+        if(g_queues[prio].head != g_queues[prio].tail)
+            return true;
+    }
+    return false;
+}
+
+uint32_t event_get_dropped(void)
+{
+    return g_dropped;
+}
@@ -1,4 +1,5 @@
 #include "exti.h"
+#include "fault.h"
 
 IRQn_t get_irqn_for_exti_line(uint8_t pin)
 {
@@ -73,16 +74,16 @@ void usart_interrupt_enable(uint8_t USART)
     }
 }
 
-// This default handler clears the interrupt flag to prevent a crash,
-// then enters an infinite loop. This helps a developer immediately see
-// that an unhandled interrupt has occurred during debugging.
+// This default handler clears the interrupt flag, then reports the
+// unhandled interrupt through fault_panic(): the crash record is printed
+// on the next boot (and a debugger stops on it).
 
 #define DEFAULT_IRQ_HANDLER(line_bit) \
     do { \
         if (EXTI->PR1 & (line_bit)) { \
             EXTI->PR1 = (line_bit); \
         } \
-        while(1); \
+        fault_panic(FAULT_REASON_UNHANDLED_IRQ); \
     } while(0)
 
 __attribute__((weak)) void EXTI0_IRQHandler(void)   { DEFAULT_IRQ_HANDLER(1U << 0); }
@@ -96,11 +97,11 @@ __attribute__((weak)) void EXTI9_5_IRQHandler(void) {
     // This default implementation just clears all possible flags and spins.
     uint32_t pending_flags = EXTI->PR1 & (0x1F << 5); // Check lines 5 through 9
     EXTI->PR1 = pending_flags; // Clear all pending flags found
-    while(1);
+    fault_panic(FAULT_REASON_UNHANDLED_IRQ);
 }
 
 __attribute__((weak)) void EXTI15_10_IRQHandler(void) {
     uint32_t pending_flags = EXTI->PR1 & (0x3F << 10); // Check lines 10 through 15
     EXTI->PR1 = pending_flags; // Clear all pending flags found
-    while(1);
+    fault_panic(FAULT_REASON_UNHANDLED_IRQ);
 }
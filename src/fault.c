@@ -0,0 +1,251 @@
+#include <stddef.h>
+#include "fault.h"
+#include "placement.h"
+#include "systick.h"
+#include "mpu.h"
+#include "scb.h"
+
+#define FAULT_STACK_SIZE        256     // Bytes, the handler runs on its own stack
+#define FAULT_STR(x)            #x
+#define FAULT_XSTR(x)           FAULT_STR(x)
+
+#define FAULT_FLASH_START       0x08000000UL
+
+// --- EXC_RETURN and stacked xPSR Bits ---
+#define EXC_RETURN_BASIC_FRAME  (1U << 4)   // Clear when the frame includes the FPU registers
+#define XPSR_FRAME_PADDED       (1U << 9)   // One padding word was added for 8 byte alignment
+#define XPSR_EXCEPTION_Msk      (0x1FFU)
+
+#define FRAME_WORDS_BASIC       8U
+#define FRAME_WORDS_EXTENDED    26U
+
+extern uint32_t _etext;         // Symbols defined in the linker script
+extern uint32_t _ssram2;
+extern uint32_t _esram2;
+extern uint32_t _sstack_guard;
+extern uint32_t _estack;
+
+// Survives the reset: not zeroed by the startup code
+static fault_record_t g_fault_record NOINIT;
+
+static uint32_t g_fault_stack[FAULT_STACK_SIZE / 4] __attribute__((used, aligned(8)));
+
+static bool fault_is_code(uint32_t addr)
+{
+    // Thumb return addresses are odd
+    if(!(addr & 1U))
+        return false;
+
+    addr &= ~1U;
+    return (addr >= FAULT_FLASH_START && addr < (uint32_t)&_etext) ||
+           (addr >= (uint32_t)&_ssram2 && addr < (uint32_t)&_esram2);
+}
+
+static uint32_t fault_checksum(const fault_record_t *record)
+{
+    const uint32_t *word = (const uint32_t *)record;
+    uint32_t sum = 0;
+
+    for(uint32_t i = 0; i < offsetof(fault_record_t, check) / sizeof(uint32_t); i++)
+        sum += word[i];
+    return ~sum;
+}
+
+/**
+ * @brief Fills the fields common to every kind of fault, seals the record and resets.
+ * @param[in] stack First stack word of the interrupted code, scanned for return addresses.
+ */
+static void __attribute__((noreturn)) fault_commit(fault_record_t *record, const uint32_t *stack)
+{
+    record->cfsr = SCB->CFSR;
+    record->hfsr = SCB->HFSR;
+    record->mmfar = SCB->MMFAR;
+    record->bfar = SCB->BFAR;
+    record->tick = systick_getTick();
+
+    // Heuristic backtrace: without frame pointers, every stack word that
+    // points just after a call into code is reported, stale ones included
+    record->depth = 0;
+    if(stack >= &_sstack_guard && stack < &_estack) {
+        for(; stack < &_estack && record->depth < FAULT_BACKTRACE_DEPTH; stack++) {
+            if(fault_is_code(*stack))
+                record->backtrace[record->depth++] = *stack;
+        }
+    }
+
+    record->magic = FAULT_RECORD_MAGIC;
+    record->check = fault_checksum(record);
+
+    // Stop here when debugging, the fault registers are still intact
+    if(DHCSR & DHCSR_C_DEBUGEN)
+        __asm volatile ("bkpt #0");
+
+    scb_system_reset();
+}
+
+/**
+ * @brief C part of fault_entry, running on g_fault_stack.
+ * @param[in] frame Exception frame stacked by the hardware.
+ * @param[in] exc_return LR value on exception entry.
+ */
+static void __attribute__((used, noreturn)) fault_capture(const uint32_t *frame, uint32_t exc_return)
+{
+    fault_record_t *record = &g_fault_record;
+    uint32_t ipsr;
+
+    // After a stack overflow the frame lies in the MPU guard region
+    mpu_disable();
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+
+    record->reason = ipsr & XPSR_EXCEPTION_Msk;
+    record->exc_return = exc_return;
+
+    // A frame outside the stack can not be read safely from here
+    if(frame < &_sstack_guard || frame + FRAME_WORDS_BASIC > &_estack) {
+        record->r0 = record->r1 = record->r2 = record->r3 = 0;
+        record->r12 = record->lr = record->pc = record->xpsr = 0;
+        record->sp = (uint32_t)frame;
+        fault_commit(record, NULL);
+    }
+
+    record->r0 = frame[0];
+    record->r1 = frame[1];
+    record->r2 = frame[2];
+    record->r3 = frame[3];
+    record->r12 = frame[4];
+    record->lr = frame[5];
+    record->pc = frame[6];
+    record->xpsr = frame[7];
+
+    const uint32_t *caller_stack = frame + ((exc_return & EXC_RETURN_BASIC_FRAME) ? FRAME_WORDS_BASIC : FRAME_WORDS_EXTENDED);
+    if(record->xpsr & XPSR_FRAME_PADDED)
+        caller_stack++;
+    record->sp = (uint32_t)caller_stack;
+
+    fault_commit(record, caller_stack);
+}
+
+/*
+ * Entry of every fault and of the startup Default_Handler. The faulting
+ * stack may be exhausted (stack overflow) or corrupt, so nothing is pushed
+ * on it: the frame address and EXC_RETURN are passed in r0/r1 and the C part
+ * runs on g_fault_stack.
+ */
+void __attribute__((naked)) fault_entry(void)
+{
+    __asm volatile (
+        "tst   lr, #4                   \n"
+        "ite   eq                       \n"
+        "mrseq r0, msp                  \n"
+        "mrsne r0, psp                  \n"
+        "mov   r1, lr                   \n"
+        "ldr   r2, =g_fault_stack + " FAULT_XSTR(FAULT_STACK_SIZE) "\n"
+        "msr   msp, r2                  \n"
+        "b     fault_capture            \n"
+    );
+}
+
+void HardFault_Handler(void) __attribute__((alias("fault_entry")));
+void MemManage_Handler(void) __attribute__((alias("fault_entry")));
+void BusFault_Handler(void) __attribute__((alias("fault_entry")));
+void UsageFault_Handler(void) __attribute__((alias("fault_entry")));
+
+void fault_init(void)
+{
+    // Separate handlers instead of everything escalating to HardFault
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA | SCB_SHCSR_BUSFAULTENA | SCB_SHCSR_USGFAULTENA;
+    SCB->CCR |= SCB_CCR_DIV_0_TRP;
+}
+
+void fault_panic(uint32_t reason)
+{
+    fault_record_t *record = &g_fault_record;
+    uint32_t sp, xpsr;
+
+    __asm volatile ("cpsid i" ::: "memory");
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+    __asm volatile ("mrs %0, xpsr" : "=r" (xpsr));
+
+    record->reason = reason;
+    record->r0 = record->r1 = record->r2 = record->r3 = record->r12 = 0;
+    record->pc = (uint32_t)__builtin_return_address(0);
+    record->lr = 0;
+    record->xpsr = xpsr;
+    record->sp = sp;
+    record->exc_return = 0;
+
+    fault_commit(record, (const uint32_t *)sp);
+}
+
+bool fault_get_record(fault_record_t *record)
+{
+    if(g_fault_record.magic != FAULT_RECORD_MAGIC || g_fault_record.check != fault_checksum(&g_fault_record))
+        return false;
+
+    if(record != NULL)
+        *record = g_fault_record;
+    return true;
+}
+
+static const char *fault_name(uint32_t reason)
+{
+    switch(reason) {
+        case 2:  return "NMI";
+        case 3:  return "HardFault";
+        case 4:  return "MemManage";
+        case 5:  return "BusFault";
+        case 6:  return "UsageFault";
+        case FAULT_REASON_PANIC:         return "Panic";
+        case FAULT_REASON_UNHANDLED_IRQ: return "Unhandled IRQ";
+        default: return (reason >= 16 && reason < 0x100) ? "Unhandled IRQ" : "Exception";
+    }
+}
+
+static void fault_send_field(usart_t *usart_port, const char *name, uint32_t value)
+{
+    usart_send_string(usart_port, name);
+    usart_send_char(usart_port, '=');
+    usart_send_hex(usart_port, value);
+    usart_send_char(usart_port, ' ');
+}
+
+bool fault_report(usart_t *usart_port)
+{
+    fault_record_t record;
+
+    if(!fault_get_record(&record))
+        return false;
+    // Report it once
+    g_fault_record.magic = 0;
+
+    usart_send_string(usart_port, "*** FAULT in previous run: ");
+    usart_send_string(usart_port, fault_name(record.reason));
+    usart_send_string(usart_port, " at tick ");
+    usart_send_uint(usart_port, record.tick);
+    usart_send_string(usart_port, "\r\n");
+
+    fault_send_field(usart_port, "reason", record.reason);
+    fault_send_field(usart_port, "pc", record.pc);
+    fault_send_field(usart_port, "lr", record.lr);
+    fault_send_field(usart_port, "sp", record.sp);
+    fault_send_field(usart_port, "xpsr", record.xpsr);
+    usart_send_string(usart_port, "\r\n");
+    fault_send_field(usart_port, "r0", record.r0);
+    fault_send_field(usart_port, "r1", record.r1);
+    fault_send_field(usart_port, "r2", record.r2);
+    fault_send_field(usart_port, "r3", record.r3);
+    fault_send_field(usart_port, "r12", record.r12);
+    usart_send_string(usart_port, "\r\n");
+    fault_send_field(usart_port, "cfsr", record.cfsr);
+    fault_send_field(usart_port, "hfsr", record.hfsr);
+    fault_send_field(usart_port, "mmfar", record.mmfar);
+    fault_send_field(usart_port, "bfar", record.bfar);
+    fault_send_field(usart_port, "exc_return", record.exc_return);
+    usart_send_string(usart_port, "\r\nbt=");
+    for(uint32_t i = 0; i < record.depth && i < FAULT_BACKTRACE_DEPTH; i++) {
+        usart_send_hex(usart_port, record.backtrace[i]);
+        usart_send_char(usart_port, ' ');
+    }
+    usart_send_string(usart_port, "\r\n");
+    return true;
+}
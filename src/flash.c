@@ -15,3 +15,109 @@ void flash_configure_for_high_speed(void)
 	// de que el CPU espere a la memoria FLASH.
 	FLASH->ACR |= FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
 }
+
+void flash_set_latency(uint8_t wait_states)
+{
+	if(wait_states > 4)
+		wait_states = 4;
+
+	FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY_MASK) | wait_states;
+
+	// La nueva latencia solo es efectiva cuando se puede leer de vuelta.
+	while((FLASH->ACR & FLASH_ACR_LATENCY_MASK) != wait_states);
+
+	FLASH->ACR |= FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+}
+
+uint8_t flash_get_latency(void)
+{
+	return (uint8_t)(FLASH->ACR & FLASH_ACR_LATENCY_MASK);
+}
+
+void flash_unlock(void)
+{
+	if(FLASH->CR & FLASH_CR_LOCK) {
+		FLASH->KEYR = FLASH_KEY1;
+		FLASH->KEYR = FLASH_KEY2;
+	}
+}
+
+void flash_lock(void)
+{
+	FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/**
+ * @brief Espera a que la FLASH quede libre y limpia las banderas pendientes.
+ *
+ * Una bandera que quedó de antes (p. ej. OPTVERR tras el reset, o el error
+ * de otra operación) no debe atribuirse a la operación que va a empezar, y
+ * PGSERR impediría incluso arrancarla.
+ */
+static RAMFUNC void flash_begin(void)
+{
+	while(FLASH->SR & FLASH_SR_BSY);
+	FLASH->SR = FLASH_SR_ERRORS | FLASH_SR_EOP;	// Las banderas se limpian escribiendo 1
+}
+
+/**
+ * @brief Espera el fin de la operación y limpia las banderas de estado.
+ * @return 0 si la operación no levantó errores, -1 en caso contrario.
+ */
+static RAMFUNC int flash_wait_done(void)
+{
+	while(FLASH->SR & FLASH_SR_BSY);
+
+	uint32_t errors = FLASH->SR & FLASH_SR_ERRORS;
+	FLASH->SR = errors | FLASH_SR_EOP;	// Las banderas se limpian escribiendo 1
+	return errors ? -1 : 0;
+}
+
+RAMFUNC int flash_erase_page(uint32_t address)
+{
+	if(address < FLASH_BASE_ADDR || address >= FLASH_BASE_ADDR + 2 * FLASH_BANK_SIZE)
+		return -1;
+
+	uint32_t offset = address - FLASH_BASE_ADDR;
+	uint32_t page = (offset % FLASH_BANK_SIZE) / FLASH_PAGE_SIZE;
+
+	flash_begin();
+
+	// PASO 1: Seleccionar banco y página, y arrancar el borrado.
+	uint32_t cr = FLASH->CR & ~(FLASH_CR_PNB | FLASH_CR_BKER);
+	cr |= FLASH_CR_PER | (page << FLASH_CR_PNB_Pos);
+	if(offset >= FLASH_BANK_SIZE)
+		cr |= FLASH_CR_BKER;
+	FLASH->CR = cr;
+	FLASH->CR |= FLASH_CR_STRT;
+
+	int result = flash_wait_done();
+	FLASH->CR &= ~(FLASH_CR_PER | FLASH_CR_PNB | FLASH_CR_BKER);
+
+	// PASO 2: La data cache puede contener el contenido anterior de la página.
+	if(FLASH->ACR & FLASH_ACR_DCEN) {
+		FLASH->ACR &= ~FLASH_ACR_DCEN;
+		FLASH->ACR |= FLASH_ACR_DCRST;
+		FLASH->ACR &= ~FLASH_ACR_DCRST;
+		FLASH->ACR |= FLASH_ACR_DCEN;
+	}
+
+	return result;
+}
+
+RAMFUNC int flash_program_double_word(uint32_t address, uint64_t data)
+{
+	if(address & 0x7U)
+		return -1;
+
+	flash_begin();
+
+	// Las dos palabras deben escribirse seguidas, la de menor dirección primero.
+	FLASH->CR |= FLASH_CR_PG;
+	*(volatile uint32_t *)address = (uint32_t)data;
+	*(volatile uint32_t *)(address + 4) = (uint32_t)(data >> 32);
+
+	int result = flash_wait_done();
+	FLASH->CR &= ~FLASH_CR_PG;
+	return result;
+}
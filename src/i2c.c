@@ -1,4 +1,47 @@
 #include "i2c.h"
+#include "trace.h"
+
+#define I2C_PS_PER_NS       (1000U)
+#define I2C_AF_MIN_PS       (50000U)    // Analog filter delay, minimum
+#define I2C_AF_MAX_PS       (260000U)   // Analog filter delay, maximum
+
+/**
+ * @brief I2C-bus specification limits for one speed mode, in nanoseconds.
+ * The default rise/fall times are the ones assumed by i2c_init_speed().
+ */
+typedef struct {
+    uint32_t max_hz;
+    uint16_t low_min;       // tLOW
+    uint16_t high_min;      // tHIGH
+    uint16_t su_dat_min;    // tSU;DAT
+    uint16_t vd_dat_max;    // tVD;DAT
+    uint16_t rise_default;
+    uint16_t fall_default;
+} i2c_mode_spec_t;
+
+static const i2c_mode_spec_t i2c_modes[] = {
+    { I2C_SPEED_STANDARD,   4700, 4000, 250, 3450, 1000, 300 },
+    { I2C_SPEED_FAST,       1300,  600, 100,  900,  300, 300 },
+    { I2C_SPEED_FAST_PLUS,   500,  260,  50,  450,  100,  50 },  // Needs strong pull-ups
+};
+
+// Requested bus speed of each port, 0 while the port is unused
+static uint32_t g_i2c_bus_hz[3];
+static bool g_i2c_hook_registered = false;
+
+static const i2c_mode_spec_t *i2c_mode_lookup(uint32_t bus_hz)
+{
+    for(uint8_t i = 0; i < sizeof(i2c_modes) / sizeof(i2c_modes[0]); i++) {
+        if(bus_hz <= i2c_modes[i].max_hz)
+            return &i2c_modes[i];
+    }
+    return NULL;
+}
+
+static uint32_t div_ceil(uint32_t num, uint32_t den)
+{
+    return (num + den - 1) / den;
+}
 
 uint8_t i2c_number(i2c_t *I2Cx)
 {
@@ -49,6 +92,16 @@ static int get_i2c_pin_configs(i2c_t *I2Cx, gpio_config_t *scl_conf, gpio_config
     return 0; // No mapping found
 }
 
+/**
+ * @brief Writes a new TIMINGR value. The peripheral must be disabled while doing so.
+ */
+static void i2c_apply_timing(i2c_t *I2Cx, uint32_t timing)
+{
+    I2Cx->CR1 &= ~I2C_CR1_PE;
+    I2Cx->TIMINGR = timing;
+    I2Cx->CR1 |= I2C_CR1_PE;
+}
+
 void i2c_init(i2c_t *I2Cx, uint32_t timing)
 {
     // 1. Enable peripheral clock for the I2C port
@@ -63,17 +116,134 @@ void i2c_init(i2c_t *I2Cx, uint32_t timing)
     gpio_init(&sda_pin_config);
 
     // 3. Configure the I2C peripheral
-    // Ensure the peripheral is disabled to allow configuration
-    I2Cx->CR1 &= ~I2C_CR1_PE;
+    // The analog filter stays enabled, i2c_compute_timing() accounts for its delay.
+    // Set the timing register for the desired I2C speed and enable the peripheral.
+    i2c_apply_timing(I2Cx, timing);
+}
 
-    // Set the timing register for the desired I2C speed (e.g., 100kHz or 400kHz)
-    I2Cx->TIMINGR = timing;
-    
-    // Disable analog filter (optional, can improve robustness)
-    // I2Cx->CR1 |= (1 << 12); // ANFOFF
+uint32_t i2c_compute_timing(uint32_t i2c_clk_hz, uint32_t bus_hz, uint32_t rise_ns, uint32_t fall_ns)
+{
+    const i2c_mode_spec_t *mode = i2c_mode_lookup(bus_hz);
+    if(mode == NULL || bus_hz < 1000U || i2c_clk_hz < 1000U)
+        return 0;
 
-    // Enable the peripheral
-    I2Cx->CR1 |= I2C_CR1_PE;
+    // All the arithmetic is done in picoseconds to keep the I2CCLK period exact enough
+    uint32_t t_clk  = 1000000000U / (i2c_clk_hz / 1000U);
+    uint32_t t_r    = rise_ns * I2C_PS_PER_NS;
+    uint32_t t_f    = fall_ns * I2C_PS_PER_NS;
+    uint32_t t_scl  = 1000000000U / (bus_hz / 1000U);
+    uint32_t t_low  = mode->low_min * I2C_PS_PER_NS;
+    uint32_t t_high = mode->high_min * I2C_PS_PER_NS;
+    uint32_t t_su   = mode->su_dat_min * I2C_PS_PER_NS;
+    uint32_t t_vd   = mode->vd_dat_max * I2C_PS_PER_NS;
+
+    // I2CCLK limits of RM0351: tI2CCLK < (tLOW - tfilters) / 4 and tI2CCLK < tHIGH
+    if(4 * t_clk >= t_low - I2C_AF_MIN_PS || t_clk >= t_high)
+        return 0;
+
+    // SCL is only counted once the master sees its own edge: the low phase
+    // lasts tSYNC1 = tf + tAF + 2 * tI2CCLK more than SCLL, the high phase
+    // tSYNC2 = tr + tAF + 2 * tI2CCLK more than SCLH. The minimum delays are
+    // used, so the real periods can only be longer and the rate lower.
+    uint32_t t_sync_low  = t_f + I2C_AF_MIN_PS + 2 * t_clk;
+    uint32_t t_sync_high = t_r + I2C_AF_MIN_PS + 2 * t_clk;
+    uint32_t t_sync = t_sync_low + t_sync_high;
+    if(t_sync >= t_scl)
+        return 0;
+
+    // The smallest prescaler gives the finest resolution on SCLL/SCLH
+    for(uint32_t presc = 0; presc < 16; presc++) {
+        uint32_t t_presc = (presc + 1) * t_clk;
+
+        // Data setup time: tSCLDEL = (SCLDEL + 1) * tPRESC >= tr + tSU;DAT
+        uint32_t scldel = div_ceil(t_r + t_su, t_presc);
+        scldel = (scldel > 0) ? scldel - 1 : 0;
+        if(scldel > 15)
+            continue;
+
+        // Data hold time: tf - tAF(min) - 3 * tI2CCLK <= tSDADEL <= tVD;DAT - tr - tAF(max) - 4 * tI2CCLK.
+        // When no delay is needed the upper bound is ignored, SDADEL = 0 is the hardware minimum.
+        uint32_t sdadel = 0;
+        if(t_f > I2C_AF_MIN_PS + 3 * t_clk)
+            sdadel = div_ceil(t_f - I2C_AF_MIN_PS - 3 * t_clk, t_presc);
+        if(sdadel > 15)
+            continue;
+        if(sdadel > 0) {
+            uint32_t margin = t_r + I2C_AF_MAX_PS + 4 * t_clk;
+            if(t_vd < margin || sdadel > (t_vd - margin) / t_presc)
+                continue;
+        }
+
+        // Shortest SCL low and high periods, in tPRESC units (SCLL + 1 and SCLH + 1)
+        uint32_t low_min  = (t_low > t_sync_low) ? div_ceil(t_low - t_sync_low, t_presc) : 1;
+        uint32_t high_min = (t_high > t_sync_high) ? div_ceil(t_high - t_sync_high, t_presc) : 1;
+
+        // Rounding the period up keeps the rate at or below bus_hz
+        uint32_t total = div_ceil(t_scl - t_sync, t_presc);
+        if(total < low_min + high_min)
+            total = low_min + high_min;
+
+        // Split it in the ratio of the specification minimums, within the 8-bit fields
+        uint32_t low = (uint32_t)(((uint64_t)total * t_low + (t_low + t_high) / 2) / (t_low + t_high));
+        uint32_t low_max = total - high_min;
+        if(low_max > 256)
+            low_max = 256;
+        if(total > 256 && low_min < total - 256)
+            low_min = total - 256;
+        if(low_min > low_max)
+            continue;
+        if(low < low_min)
+            low = low_min;
+        if(low > low_max)
+            low = low_max;
+        uint32_t high = total - low;
+
+        return (presc << I2C_TIMINGR_PRESC_Pos) |
+               (scldel << I2C_TIMINGR_SCLDEL_Pos) |
+               (sdadel << I2C_TIMINGR_SDADEL_Pos) |
+               ((high - 1) << I2C_TIMINGR_SCLH_Pos) |
+               ((low - 1) << I2C_TIMINGR_SCLL_Pos);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Clock tree hook: retimes every port configured through i2c_init_speed().
+ */
+static void i2c_clock_changed(const rcc_clocks_t *clocks)
+{
+    static i2c_t *const ports[3] = { I2C1, I2C2, I2C3 };
+
+    for(uint8_t i = 0; i < 3; i++) {
+        if(g_i2c_bus_hz[i] == 0)
+            continue;
+        const i2c_mode_spec_t *mode = i2c_mode_lookup(g_i2c_bus_hz[i]);
+        uint32_t timing = i2c_compute_timing(clocks->pclk1_hz, g_i2c_bus_hz[i], mode->rise_default, mode->fall_default);
+        if(timing != 0)  // Keep the previous timing if the new clock cannot support the speed
+            i2c_apply_timing(ports[i], timing);
+    }
+}
+
+int i2c_init_speed(i2c_t *I2Cx, uint32_t bus_hz)
+{
+    uint8_t number = i2c_number(I2Cx);
+    const i2c_mode_spec_t *mode = i2c_mode_lookup(bus_hz);
+    if(number == 0 || mode == NULL)
+        return -1;
+
+    uint32_t timing = i2c_compute_timing(rcc_get_clocks()->pclk1_hz, bus_hz, mode->rise_default, mode->fall_default);
+    if(timing == 0)
+        return -1;
+
+    i2c_init(I2Cx, timing);
+    syscfg_i2c_fast_mode_plus(number, bus_hz > I2C_SPEED_FAST);
+
+    g_i2c_bus_hz[number - 1] = bus_hz;
+    if(!g_i2c_hook_registered)
+        g_i2c_hook_registered = (rcc_clock_hook_register(i2c_clock_changed) == 0);
+
+    return 0;
 }
 
 /**
@@ -89,50 +259,119 @@ static int i2c_wait_for_flag(i2c_t *i2c_port, uint32_t flag, uint32_t timeout)
 }
 
 /**
- * @brief Writes a block of data to an I2C slave device.
+ * @brief Helper function to wait for the bus to be released.
+ * @return 0 on success, -1 on timeout.
  */
-int i2c_master_write(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *data, uint32_t size)
+static int i2c_wait_while_busy(i2c_t *i2c_port, uint32_t timeout)
+{
+    while (i2c_port->ISR & I2C_ISR_BUSY) {
+        if (--timeout == 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Waits for a transmit-side flag while watching for a NACK.
+ * @return 0 on success, -1 on timeout, -2 on NACK.
+ */
+static int i2c_wait_for_tx_flag(i2c_t *i2c_port, uint32_t flag, uint32_t timeout)
+{
+    while (!(i2c_port->ISR & flag)) {
+        if (i2c_port->ISR & I2C_ISR_NACKF) {
+            // A STOP is generated automatically only with AUTOEND, force it otherwise
+            if (i2c_port->CR2 & I2C_CR2_RELOAD)
+                i2c_port->CR2 |= (1U << I2C_CR2_STOP_Pos);
+            i2c_wait_for_flag(i2c_port, I2C_ISR_STOPF, timeout);
+            i2c_port->ICR = I2C_ICR_NACKCF | I2C_ICR_STOPCF;
+            return -2;
+        }
+        if (--timeout == 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the NBYTES/RELOAD/AUTOEND bits for the next chunk of a transfer.
+ */
+static uint32_t i2c_chunk_bits(uint32_t remaining)
+{
+    if (remaining > I2C_NBYTES_MAX)
+        return (I2C_NBYTES_MAX << I2C_CR2_NBYTES_Pos) | I2C_CR2_RELOAD;
+    return (remaining << I2C_CR2_NBYTES_Pos) | I2C_CR2_AUTOEND;
+}
+
+/**
+ * @brief The transfer of i2c_master_write_prefixed(), without the trace events.
+ */
+static int i2c_write_transfer(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *header, uint32_t header_len,
+                              const uint8_t *data, uint32_t size)
 {
+    uint32_t remaining = header_len + size;
+    if (remaining == 0) return -1;
+
     // 1. Wait until the bus is not busy
-    if (i2c_wait_for_flag(i2c_port, ~I2C_ISR_BUSY, 10000) != 0) return -1;
+    if (i2c_wait_while_busy(i2c_port, 10000) != 0) return -1;
+    i2c_port->ICR = I2C_ICR_NACKCF | I2C_ICR_STOPCF;
 
-    // 2. Configure the transfer
-    uint32_t cr2_val = 0;
-    cr2_val |= (slave_addr << 1) & 0xFE; // Set slave address
-    cr2_val &= ~I2C_CR2_RD_WRN_Pos;      // Set direction to Write
-    cr2_val |= (size << I2C_CR2_NBYTES_Pos); // Set number of bytes
-    cr2_val |= (1U << I2C_CR2_AUTOEND_Pos);  // Enable automatic STOP
-    
-    i2c_port->CR2 = cr2_val;
+    // 2. Configure the transfer: slave address, write direction, first chunk
+    uint32_t chunk_left = (remaining > I2C_NBYTES_MAX) ? I2C_NBYTES_MAX : remaining;
+    i2c_port->CR2 = ((slave_addr << 1) & 0xFE) | i2c_chunk_bits(remaining);
 
     // 3. Generate START condition
     i2c_port->CR2 |= (1U << I2C_CR2_START_Pos);
 
-    // 4. Loop to write data bytes
-    for (uint32_t i = 0; i < size; i++) {
-        // Wait for TXIS (Transmit Interrupt Status) flag
-        if (i2c_wait_for_flag(i2c_port, I2C_ISR_TXIS, 10000) != 0) return -1;
-        
-        // Write data to the transmit data register
-        i2c_port->TXDR = data[i];
-    }
-    
-    // 5. Wait for NACK or transfer complete
-    // The AUTOEND feature will handle the STOP condition.
-    if (i2c_port->ISR & I2C_ISR_NACKF) {
-        return -2; // Slave sent NACK
+    // 4. Loop to write the header, then the data
+    for (uint32_t i = 0; i < header_len + size; i++) {
+        int status = i2c_wait_for_tx_flag(i2c_port, I2C_ISR_TXIS, 10000);
+        if (status != 0) return status;
+
+        i2c_port->TXDR = (i < header_len) ? header[i] : data[i - header_len];
+        remaining--;
+
+        // Reload NBYTES every 255 bytes. Writing it clears TCR.
+        if (--chunk_left == 0 && remaining > 0) {
+            status = i2c_wait_for_tx_flag(i2c_port, I2C_ISR_TCR, 10000);
+            if (status != 0) return status;
+            chunk_left = (remaining > I2C_NBYTES_MAX) ? I2C_NBYTES_MAX : remaining;
+            i2c_port->CR2 = (i2c_port->CR2 & ~(I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_AUTOEND)) | i2c_chunk_bits(remaining);
+        }
     }
 
+    // 5. Wait for the STOP generated by AUTOEND, or a late NACK
+    int status = i2c_wait_for_tx_flag(i2c_port, I2C_ISR_STOPF, 10000);
+    if (status != 0) return status;
+    i2c_port->ICR = I2C_ICR_STOPCF;
+
     return 0; // Success
 }
 
+/**
+ * @brief Writes a header and a data block in one transaction.
+ */
+int i2c_master_write_prefixed(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *header, uint32_t header_len,
+                              const uint8_t *data, uint32_t size)
+{
+    TRACE_BEGIN_EVENT(TRACE_EV_I2C_WRITE, slave_addr);
+    int status = i2c_write_transfer(i2c_port, slave_addr, header, header_len, data, size);
+    TRACE_END_EVENT(TRACE_EV_I2C_WRITE, (status == 0) ? 0U : 0xFFFFU);
+    return status;
+}
+
+/**
+ * @brief Writes a block of data to an I2C slave device.
+ */
+int i2c_master_write(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *data, uint32_t size)
+{
+    return i2c_master_write_prefixed(i2c_port, slave_addr, NULL, 0, data, size);
+}
+
 /**
  * @brief Reads a block of data from an I2C slave device.
  */
 int i2c_master_read(i2c_t *i2c_port, uint8_t slave_addr, uint8_t *data, uint32_t size)
 {
     // 1. Wait until the bus is not busy
-    if (i2c_wait_for_flag(i2c_port, ~I2C_ISR_BUSY, 10000) != 0) return -1;
+    if (i2c_wait_while_busy(i2c_port, 10000) != 0) return -1;
 
     // 2. Configure the transfer
     uint32_t cr2_val = 0;
@@ -0,0 +1,116 @@
+#include "log.h"
+#include "irq.h"
+#include "systick.h"
+#include "placement.h"
+
+#define LOG_HEADER_WORDS    2U      // Header, tick
+#define LOG_ID_DROPPED      0U      // Reserved ID (.logstr starts with a pad byte): args[0] records were lost
+
+// Header word: ID (low 16 bits of the .logstr address), argument count, level
+#define LOG_HDR_ID_Msk      0xFFFFU
+#define LOG_HDR_COUNT_Pos   16U
+#define LOG_HDR_LEVEL_Pos   24U
+
+// "#L" + 8 hex digits per word + "\r\n"
+#define LOG_LINE_MAX        (2U + 8U * (LOG_HEADER_WORDS + LOG_MAX_ARGS) + 2U)
+
+static uint32_t g_log_ring[LOG_RING_WORDS] SRAM2_BSS;
+static uint32_t g_log_head = 0;     // Free running word indexes
+static uint32_t g_log_tail = 0;
+static uint32_t g_log_dropped = 0;
+
+// Line being transmitted
+static char g_log_line[LOG_LINE_MAX];
+static uint8_t g_log_line_len = 0;
+static uint8_t g_log_line_pos = 0;
+
+void log_write(log_level_t level, uint32_t id, const uint32_t *args, uint32_t count)
+{
+    uint32_t words = LOG_HEADER_WORDS + count;
+    uint32_t header = (id & LOG_HDR_ID_Msk) | (count << LOG_HDR_COUNT_Pos) | ((uint32_t)level << LOG_HDR_LEVEL_Pos);
+
+    uint32_t primask = irq_lock();
+    if(LOG_RING_WORDS - (g_log_head - g_log_tail) < words) {
+        g_log_dropped++;
+        irq_unlock(primask);
+        return;
+    }
+
+    uint32_t head = g_log_head;
+    g_log_ring[head++ & (LOG_RING_WORDS - 1U)] = header;
+    g_log_ring[head++ & (LOG_RING_WORDS - 1U)] = systick_getTick();
+    for(uint32_t i = 0; i < count; i++)
+        g_log_ring[head++ & (LOG_RING_WORDS - 1U)] = args[i];
+    g_log_head = head;
+    irq_unlock(primask);
+}
+
+static void log_append_hex(uint32_t value)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for(int8_t shift = 28; shift >= 0; shift -= 4)
+        g_log_line[g_log_line_len++] = hex[(value >> shift) & 0xFU];
+}
+
+/**
+ * @brief Encodes the next record, or the count of dropped ones, into g_log_line.
+ * @return false if there is nothing to send.
+ */
+static bool log_encode_next(void)
+{
+    uint32_t words[LOG_HEADER_WORDS + LOG_MAX_ARGS];
+    uint32_t count = 0;
+
+    uint32_t primask = irq_lock();
+    if(g_log_dropped != 0) {
+        words[0] = LOG_ID_DROPPED | (1U << LOG_HDR_COUNT_Pos) | ((uint32_t)LOG_LEVEL_WARN << LOG_HDR_LEVEL_Pos);
+        words[1] = systick_getTick();
+        words[2] = g_log_dropped;
+        count = 3;
+        g_log_dropped = 0;
+    }
+    else if(g_log_tail != g_log_head) {
+        uint32_t tail = g_log_tail;
+        words[0] = g_log_ring[tail & (LOG_RING_WORDS - 1U)];
+        count = LOG_HEADER_WORDS + ((words[0] >> LOG_HDR_COUNT_Pos) & 0xFFU);
+        for(uint32_t i = 1; i < count; i++)
+            words[i] = g_log_ring[(tail + i) & (LOG_RING_WORDS - 1U)];
+        g_log_tail = tail + count;
+    }
+    irq_unlock(primask);
+
+    if(count == 0)
+        return false;
+
+    // Formatting happens outside the critical section
+    g_log_line_len = 0;
+    g_log_line_pos = 0;
+    g_log_line[g_log_line_len++] = '#';
+    g_log_line[g_log_line_len++] = 'L';
+    for(uint32_t i = 0; i < count; i++)
+        log_append_hex(words[i]);
+    g_log_line[g_log_line_len++] = '\r';
+    g_log_line[g_log_line_len++] = '\n';
+    return true;
+}
+
+bool log_process(usart_t *usart_port)
+{
+    while(1) {
+        if(g_log_line_pos == g_log_line_len && !log_encode_next())
+            return false;
+
+        while(g_log_line_pos < g_log_line_len) {
+            if(!usart_try_send_char(usart_port, g_log_line[g_log_line_pos]))
+                return true;
+            g_log_line_pos++;
+        }
+    }
+}
+
+void log_flush(usart_t *usart_port)
+{
+    while(log_process(usart_port))
+        ;
+}
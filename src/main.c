@@ -1,7 +1,16 @@
 #include "main.h"
 
 // --- Global variables ---
-volatile bool g_button_pressed_flag = false;
+static room_control_t g_room;
+static swtimer_t g_room_timer;
+static swtimer_t g_heartbeat_timer;
+static const char *volatile g_room_label = "";
+static volatile int32_t g_fan_percent = 0;
+
+static widget_t room_widgets[] = {
+    WIDGET_LABEL(20, 4, 100, &g_room_label),
+    WIDGET_NUMBER(20, 24, 60, &g_fan_percent, " %"),
+};
 
 // --- Configurations ---
 const keypad_config_t keypad_conf = {
@@ -19,57 +28,289 @@ const usart_config_t usart2_config = {
     .parity     = ODD_PARITY
 };
 
+const rcc_clock_config_t clock_config = {
+    .sysclk_hz    = 80000000U,
+    .pclk1_max_hz = 0,
+    .pclk2_max_hz = 0
+};
+
+// The console runs from HSI16 so that it can wake the MCU from Stop 1
+const power_config_t power_config = {
+    .run_clock  = &clock_config,
+    .console    = USART2,
+    .deepest    = POWER_MODE_STOP2
+};
+
+// Fan PWM on PA6, 25 kHz. The period follows the timer clock (fan_pwm_start()).
+#define FAN_PWM_HZ  25000U
+
+pwm_config_t fan_pwm_config = {
+    .pwmTimer   = TIM3,
+    .pwmChannel = TIM_CHANNEL1,
+    .prescaler  = 1,
+    .period     = 0
+};
+
 const gpio_config_t heartbeat_config = {
     .port   = GPIOA,
     .pin    = 5,
     .mode   = GPIO_MODE_OUTPUT
 };
 
+// Deferred boot task: brings the OLED up without blocking the main loop
+static bool oled_init_task(void)
+{
+    ssd1306_state_t state = ssd1306_init_poll();
+    return state == SSD1306_STATE_READY || state == SSD1306_STATE_ERROR;
+}
+
+// (Re)starts the fan PWM for the current timer clock, at the duty of the fan level
+static void fan_pwm_start(const rcc_clocks_t *clocks)
+{
+    fan_pwm_config.period = (int)(clocks->timclk1_hz / FAN_PWM_HZ);  // 3200 at 80 MHz
+    pwm_init(&fan_pwm_config);
+    pwm_set_dutyCycle(TIM3, TIM_CHANNEL1, room_control_fan_percent(g_room.fan));
+}
+
+// Re-derives every clock dependent setting after a clock tree change
+static void clock_changed(const rcc_clocks_t *clocks)
+{
+    systick_init(clocks->hclk_hz / 1000);
+    usart_set_baudrate(USART2, rcc_usart_kernel_hz(2), usart2_config.baudrate);
+    if(fan_pwm_config.period != 0)     // Fan PWM already running
+        fan_pwm_start(clocks);
+}
+
+// OLED status screen: door icon and state, fan icon and duty cycle
+static void room_display_update(void)
+{
+    static const asset_bitmap_t *door_drawn = NULL;
+    if(!ssd1306_is_ready())
+        return;
+
+    if(door_drawn == NULL) {
+        asset_draw_bitmap(0, 16, &asset_fan, SSD1306_COLOR_WHITE);
+        ssd1306_mark_dirty(0, 16, 16, 16);
+    }
+
+    const asset_bitmap_t *door = (g_room.state == RC_STATE_EMERGENCY) ? &asset_lock
+                               : g_room.door_locked ? &asset_door_closed : &asset_door_open;
+    if(door != door_drawn) {
+        gfx_fill_rect(0, 0, 16, 16, SSD1306_COLOR_BLACK);
+        asset_draw_bitmap(0, 0, door, SSD1306_COLOR_WHITE);
+        ssd1306_mark_dirty(0, 0, 16, 16);
+        door_drawn = door;
+    }
+
+    g_room_label = room_control_state_name(g_room.state);
+    g_fan_percent = room_control_fan_percent(g_room.fan);
+    widget_render(room_widgets, sizeof(room_widgets) / sizeof(room_widgets[0]));
+    ssd1306_update_dirty();
+}
+
+// Room control outputs
+static void room_door(bool locked)
+{
+    if(locked)
+        LOG_INFO("door locked");
+    else
+        LOG_INFO("door unlocked");
+}
+
+static void room_fan(rc_fan_t level)
+{
+    // TIM3 stops in Stop mode: keep the MCU out of it while the fan runs
+    static bool running = false;
+    bool on = level != RC_FAN_OFF;
+    if(on && !running)
+        power_stop_lock();
+    else if(!on && running)
+        power_stop_unlock();
+    running = on;
+
+    pwm_set_dutyCycle(TIM3, TIM_CHANNEL1, room_control_fan_percent(level));
+    room_display_update();
+}
+
+static void room_state_changed(rc_state_t state)
+{
+    LOG_INFO("room state %u", state);
+    room_display_update();
+}
+
+// Keypad password, '#' submits. Wrong attempts back off exponentially.
+static bool room_check_password(const char *pin, uint8_t length)
+{
+    uint32_t now = systick_getTick();
+    password_result_t result = password_verify(pin, length, now);
+    if(result == PASSWORD_LOCKED)
+        LOG_INFO("password locked for %u ms", password_lockout_remaining(now));
+    else
+        LOG_INFO("password %u, verified in %u cycles", result, password_get_verify_cycles());
+    return result == PASSWORD_OK;
+}
+
+static const room_control_io_t room_io = {
+    .door           = room_door,
+    .fan            = room_fan,
+    .state_changed  = room_state_changed,
+    .check_password = room_check_password
+};
+
+// Keeps the wheel timer on the room control deadline
+static void room_timer_update(void)
+{
+    uint32_t left = room_control_time_to_deadline(&g_room, systick_getTick());
+    if(left == UINT32_MAX)
+        swtimer_stop(&g_room_timer);
+    else
+        swtimer_start(&g_room_timer, left, 0);
+}
+
+static void room_dispatch(rc_event_t event, uint32_t arg)
+{
+    room_control_dispatch(&g_room, event, arg, systick_getTick());
+    room_timer_update();
+}
+
+// Timer callbacks, run from the main loop by swtimer_process()
+static void room_timeout(swtimer_t *timer)
+{
+    (void)timer;
+    room_control_tick(&g_room, systick_getTick());
+    room_timer_update();
+}
+
+static void heartbeat(swtimer_t *timer)
+{
+    (void)timer;
+    gpio_toggle_pin(GPIOA, 5);
+}
+
+// Event subscribers, run from the main loop by event_dispatch()
+static void button_pressed(const event_t *event)
+{
+    (void)event;
+    TRACE_BEGIN_EVENT(TRACE_EV_LOOP_BUTTON, 0);
+    LOG_INFO("button pressed");
+    // The dumps below block: finish the pending log lines first
+    log_flush(USART2);
+    stack_print_usage(USART2);
+    power_print_stats(USART2);
+    TRACE_END_EVENT(TRACE_EV_LOOP_BUTTON, 0);
+    trace_dump(USART2);
+}
+
+static void key_pressed(const event_t *event)
+{
+    // Not logged: the keys are the password
+    room_dispatch(RC_EV_KEY, event->data);
+}
+
+static void button_room(const event_t *event)
+{
+    (void)event;
+    room_dispatch(RC_EV_BUTTON, 0);
+}
+
 int main(void) {
+    // 0. Start the cycle counter used to timestamp the boot stages
+    dwt_init();
+    trace_start();
+    boot_mark("reset");
+
+    // Faults are recorded for the next boot; overflowing the MSP stack faults
+    // instead of corrupting SRAM2 data
+    fault_init();
+    stack_guard_init();
+
     // 1. Initialize system clock to 80MHz using PLL
-    rcc_set_system_clock(SYSCLK_SRC_HSI);
+    rcc_clock_config(&clock_config);
+    const rcc_clocks_t *clocks = rcc_get_clocks();
+    boot_mark("clock");
     
-    // 2. Initialize SysTick for a 1ms tick at 80MHz
-    systick_init(16000);
+    // 2. Initialize SysTick for a 1ms tick
+    systick_init(clocks->hclk_hz / 1000);
 
-    // 3. Initialize peripherals
+    // 3. Critical peripherals first: user input and console
     gpio_init(&heartbeat_config);
     keypad_init(&keypad_conf);
-    usart_init(&usart2_config, 16000000); // Use 80MHz clock
-    
-    // 4. Initialize the user button interrupt on PC13
-    exti_gpio_init(GPIOC, 13, GPIO_PUPD_PULLUP, FALLING_EDGE);
+    exti_gpio_init(GPIOC, 13, GPIO_PUPD_PULLUP, FALLING_EDGE);  // User button on PC13
+    boot_mark("input");
+
+    rcc_usart_clock_source(2, RCC_USART_CLK_HSI16);
+    usart_init(&usart2_config, rcc_usart_kernel_hz(2));
+    rcc_clock_hook_register(clock_changed);
+    fault_report(USART2);
+    power_init(&power_config);
+    boot_mark("console");
+
+    // 4. Slow devices initialize in the background from the main loop
+    if(i2c_init_speed(I2C1, I2C_SPEED_FAST) == 0 && ssd1306_init_start(I2C1))
+        boot_defer("oled", oled_init_task);
+    boot_mark("main loop");
+
+    // From here on memory comes from static pools only, never from malloc
+    sysmem_heap_lock();
+
+    // Settings store, then the keypad password kept in it
+    if(!kv_init())
+        LOG_INFO("kv store mount failed");
+    password_init(systick_getTick());
+
+    // Software timers: heartbeat LED and room control timeouts
+    swtimer_init(systick_getTick());
+    swtimer_setup(&g_heartbeat_timer, heartbeat, NULL);
+    swtimer_start(&g_heartbeat_timer, 500, 500);
+    swtimer_setup(&g_room_timer, room_timeout, NULL);
 
-    uint32_t heartbeat_last_tick = 0;
+    fan_pwm_start(rcc_get_clocks());
+    room_control_init(&g_room, &room_io, systick_getTick());
+    room_timer_update();
+
+    event_subscribe(EVENT_BUTTON, button_room);
+    event_subscribe(EVENT_BUTTON, button_pressed);
+    event_subscribe(EVENT_KEY_PRESSED, key_pressed);
+
+    bool boot_reported = false;
     
     usart_send_string(USART2, "System Initialized. Ready.\r\n");
     
     while(1) {
-        char pressed_key;
+        // Task 0: Deferred initialization, then report the boot timeline once
+        if(!boot_reported) {
+            TRACE_BEGIN_EVENT(TRACE_EV_LOOP_BOOT, 0);
+            boot_process();
+            TRACE_END_EVENT(TRACE_EV_LOOP_BOOT, 0);
+            if(boot_is_complete()) {
+                log_flush(USART2);
+                boot_print_timeline(USART2);
+                stack_print_usage(USART2);
+                room_display_update();
+                boot_reported = true;
+            }
+        }
 
-        if(gpio_read_pin(GPIOC, 13) == 0)
-            gpio_toggle_pin(GPIOA, 5);
+        // Task 1: Expired software timers (heartbeat LED, room timeouts)
+        swtimer_process(systick_getTick());
 
-        // Task 1: Non-blocking Heartbeat LED
-        if(systick_getTick() - heartbeat_last_tick >= 500) {
-            heartbeat_last_tick = systick_getTick();
-            gpio_toggle_pin(GPIOA, 5);
-        }
+        // Task 2: Deliver events from the interrupt handlers (button, keypad)
+        event_dispatch();
 
-        // Task 2: Process button press flag from ISR
-        if(g_button_pressed_flag) {
-            g_button_pressed_flag = false; // Clear flag
-            usart_send_string(USART2, "Button Pressed\r\n");
-        }
-        
-        /*
-        // Task 3: Check Keypad Buffer
-        if(keypad_read_key(&pressed_key)) {
-            usart_send_string(USART2, "Key pressed: ");
-            usart_send_char(USART2, pressed_key);
-            usart_send_string(USART2, "\r\n");
+        // Task 3: Send queued log records in the background
+        bool log_pending = log_process(USART2);
+
+        // Task 4: Commit one buffered settings write
+        bool kv_pending = kv_process();
+
+        // Idle: sleep until the next software timer unless a task still has
+        // work. Interrupts are masked so that an event posted after the check
+        // still wakes us.
+        uint32_t primask = irq_lock();
+        if(boot_reported && !log_pending && !kv_pending && !event_pending()) {
+            power_idle(swtimer_time_to_next(systick_getTick()));
         }
-        */
+        irq_unlock(primask);
     }
     return 0;
 }
@@ -77,20 +318,30 @@ int main(void) {
 // NONeSAFE Interrupt Handler
 void EXTI15_10_IRQHandler(void)
 {
+    TRACE_BEGIN_EVENT(TRACE_EV_EXTI_ISR, EXTI->PR1);
     if(EXTI->PR1 & (1U << 13)) {
         EXTI->PR1 = (1U << 13); // Clear pending flag
-        g_button_pressed_flag = true;
+        event_post(EVENT_BUTTON, EVENT_PRIO_HIGH, 0);
     }
     if(EXTI->PR1 & (1U << 10))
         keypad_irq_handler();
+    TRACE_END_EVENT(TRACE_EV_EXTI_ISR, 0);
+}
+
+// Console start bit received in Stop 1
+void USART2_IRQHandler(void)
+{
+    power_usart_wakeup_irq(USART2);
 }
 
 void EXTI9_5_IRQHandler(void)
 {
+    TRACE_BEGIN_EVENT(TRACE_EV_EXTI_ISR, EXTI->PR1);
     if(EXTI->PR1 & (1U << 9))
         keypad_irq_handler();
     if(EXTI->PR1 & (1U << 8))
         keypad_irq_handler();
     if(EXTI->PR1 & (1U << 7))
         keypad_irq_handler();
+    TRACE_END_EVENT(TRACE_EV_EXTI_ISR, 0);
 }
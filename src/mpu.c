@@ -0,0 +1,45 @@
+#include "mpu.h"
+
+int mpu_region_config(uint8_t region, uint32_t base, uint32_t size, uint32_t attributes)
+{
+    // 1. Size must be a power of two and the base aligned to it
+    if(region >= MPU_REGION_COUNT || size < MPU_REGION_MIN_SIZE || (size & (size - 1U)) != 0)
+        return -1;
+    if(base & (size - 1U))
+        return -1;
+
+    // 2. SIZE field encodes 2^(SIZE + 1) bytes
+    uint32_t size_field = 31U - (uint32_t)__builtin_clz(size) - 1U;
+
+    // 3. Program the region, disabled while it changes
+    MPU->RNR = region;
+    MPU->RASR = 0;
+    MPU->RBAR = base;
+    MPU->RASR = attributes | (size_field << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE;
+
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+    return 0;
+}
+
+void mpu_region_disable(uint8_t region)
+{
+    if(region >= MPU_REGION_COUNT)
+        return;
+
+    MPU->RNR = region;
+    MPU->RASR = 0;
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+}
+
+void mpu_enable(void)
+{
+    MPU->CTRL = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+}
+
+void mpu_disable(void)
+{
+    __asm volatile ("dmb" ::: "memory");
+    MPU->CTRL = 0;
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+}
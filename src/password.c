@@ -0,0 +1,193 @@
+#include "password.h"
+#include "sha256.h"
+#include "drivers/kvStore/kvStore.h"
+#include "placement.h"
+#include "systick.h"
+#include "dwt.h"
+
+#define PASSWORD_VERSION        1U
+#define PASSWORD_UID_BASE       0x1FFF7590UL    // 96-bit unique device ID
+#define PASSWORD_THROTTLE_MAGIC 0x7A55C0DEUL
+
+typedef struct {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t iterations;
+    uint8_t salt[PASSWORD_SALT_LEN];
+    uint8_t hash[PASSWORD_HASH_LEN];
+} password_record_t;
+
+_Static_assert(sizeof(password_record_t) <= KV_MAX_VALUE_LEN, "password record does not fit a KV value");
+
+// Consecutive failures, kept across resets
+typedef struct {
+    uint32_t magic;
+    uint32_t failures;
+    uint32_t check;         // ~failures, detects a cold boot
+} password_throttle_t;
+
+static password_record_t g_record;
+static password_throttle_t g_throttle NOINIT;
+static bool g_locked = false;
+static uint32_t g_locked_until = 0;
+static uint32_t g_verify_cycles = 0;
+
+static void password_wipe(void *data, uint32_t len)
+{
+    volatile uint8_t *p = data;
+    while(len--)
+        *p++ = 0;
+}
+
+/**
+ * @brief Runs the KDF. Same amount of work for every password of a given length.
+ */
+static void password_derive(const uint8_t *salt, uint16_t iterations, const char *pin,
+                            uint8_t length, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+    sha256_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, salt, PASSWORD_SALT_LEN);
+    sha256_update(&ctx, pin, length);
+    sha256_final(&ctx, digest);
+
+    for(uint16_t i = 1; i < iterations; i++) {
+        sha256_init(&ctx);
+        sha256_update(&ctx, digest, SHA256_DIGEST_SIZE);
+        sha256_update(&ctx, pin, length);
+        sha256_final(&ctx, digest);
+    }
+}
+
+/**
+ * @brief New salt from the device ID and the current cycle and tick counts.
+ *
+ * A salt only has to differ between devices and password changes, it does
+ * not have to be secret.
+ */
+static void password_new_salt(uint8_t salt[PASSWORD_SALT_LEN])
+{
+    uint32_t seed[5];
+    const volatile uint32_t *uid = (const volatile uint32_t *)PASSWORD_UID_BASE;
+    seed[0] = uid[0];
+    seed[1] = uid[1];
+    seed[2] = uid[2];
+    seed[3] = dwt_get_cycles();
+    seed[4] = systick_getTick();
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, seed, sizeof(seed));
+    sha256_final(&ctx, digest);
+    for(uint32_t i = 0; i < PASSWORD_SALT_LEN; i++)
+        salt[i] = digest[i];
+}
+
+static void password_throttle_save(uint32_t failures)
+{
+    g_throttle.failures = failures;
+    g_throttle.check = ~failures;
+    g_throttle.magic = PASSWORD_THROTTLE_MAGIC;
+}
+
+// Starts the lockout that follows the current failure count, if any
+static void password_lockout_start(uint32_t now_ms)
+{
+    uint32_t failures = g_throttle.failures;
+    if(failures < PASSWORD_FREE_ATTEMPTS)
+        return;
+
+    uint32_t doublings = failures - PASSWORD_FREE_ATTEMPTS;
+    uint32_t lockout = PASSWORD_BACKOFF_MS;
+    while(doublings-- > 0 && lockout < PASSWORD_BACKOFF_MAX_MS)
+        lockout <<= 1;
+    if(lockout > PASSWORD_BACKOFF_MAX_MS)
+        lockout = PASSWORD_BACKOFF_MAX_MS;
+
+    g_locked_until = now_ms + lockout;
+    g_locked = true;
+}
+
+bool password_init(uint32_t now_ms)
+{
+    if(g_throttle.magic != PASSWORD_THROTTLE_MAGIC || g_throttle.check != ~g_throttle.failures)
+        password_throttle_save(0);
+    password_lockout_start(now_ms);
+
+    if(kv_get(PASSWORD_KV_KEY, &g_record, sizeof(g_record)) == (int)sizeof(g_record)
+       && g_record.version == PASSWORD_VERSION && g_record.iterations > 0)
+        return true;
+
+    const char *pin = PASSWORD_DEFAULT;
+    uint8_t length = 0;
+    while(pin[length] != '\0')
+        length++;
+    return password_set(pin, length);
+}
+
+bool password_set(const char *pin, uint8_t length)
+{
+    if(pin == NULL || length == 0 || length > PASSWORD_MAX_LEN)
+        return false;
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    g_record.version = PASSWORD_VERSION;
+    g_record.reserved = 0;
+    g_record.iterations = PASSWORD_ITERATIONS;
+    password_new_salt(g_record.salt);
+    password_derive(g_record.salt, g_record.iterations, pin, length, digest);
+    for(uint32_t i = 0; i < PASSWORD_HASH_LEN; i++)
+        g_record.hash[i] = digest[i];
+    password_wipe(digest, sizeof(digest));
+
+    return kv_set(PASSWORD_KV_KEY, &g_record, sizeof(g_record));
+}
+
+password_result_t password_verify(const char *pin, uint8_t length, uint32_t now_ms)
+{
+    if(g_locked) {
+        if(!systick_deadline_reached(g_locked_until, now_ms))
+            return PASSWORD_LOCKED;
+        g_locked = false;
+    }
+
+    // Out of range lengths still run the whole KDF, on an empty password
+    uint8_t diff = 0;
+    if(pin == NULL || length == 0 || length > PASSWORD_MAX_LEN) {
+        diff = 1;
+        pin = "";
+        length = 0;
+    }
+
+    uint32_t start = dwt_get_cycles();
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    password_derive(g_record.salt, g_record.iterations, pin, length, digest);
+
+    // Every byte is compared, whatever the first difference
+    for(uint32_t i = 0; i < PASSWORD_HASH_LEN; i++)
+        diff |= digest[i] ^ g_record.hash[i];
+    password_wipe(digest, sizeof(digest));
+    g_verify_cycles = dwt_get_cycles() - start;
+
+    if(diff == 0) {
+        password_throttle_save(0);
+        return PASSWORD_OK;
+    }
+
+    password_throttle_save(g_throttle.failures + 1);
+    password_lockout_start(now_ms);
+    return PASSWORD_WRONG;
+}
+
+uint32_t password_lockout_remaining(uint32_t now_ms)
+{
+    if(!g_locked)
+        return 0;
+    return systick_time_left(g_locked_until, now_ms);
+}
+
+uint32_t password_get_verify_cycles(void)
+{
+    return g_verify_cycles;
+}
@@ -0,0 +1,252 @@
+#include "power.h"
+#include "nvic.h"
+#include "irq.h"
+#include "pwr.h"
+#include "scb.h"
+#include "exti.h"
+#include "lptim.h"
+#include "systick.h"
+#include "trace.h"
+
+#define POWER_LPTIM_PRESC       5U          // LSI / 32 = 1 kHz, one count per millisecond
+#define POWER_EXTI_LPTIM1       (1U << 0)   // EXTI line 32, in IMR2
+
+// Wakeup line and interrupt of the USARTs able to leave Stop 1
+typedef struct {
+    usart_t *port;
+    uint8_t number;         // As used by the RCC functions
+    uint8_t exti_line;      // Direct line in EXTI IMR1
+    IRQn_t irqn;
+} power_usart_wakeup_t;
+
+static const power_usart_wakeup_t usart_wakeup[] = {
+    { USART1, 1, 26, USART1_IRQn },
+    { USART2, 2, 27, USART2_IRQn },
+    { USART3, 3, 28, USART3_IRQn },
+    { UART_4, 4, 29, UART4_IRQn },
+    { UART_5, 5, 30, UART5_IRQn },
+};
+
+static const char *const power_mode_name[POWER_MODE_COUNT] = {
+    "run", "sleep", "stop1", "stop2"
+};
+
+static struct {
+    const power_config_t *config;
+    power_mode_t deepest;
+    bool console_wakeup;
+    uint8_t stop_locks;
+    uint64_t start_us;
+    power_stats_t stats;
+} g_power;
+
+int power_init(const power_config_t *config)
+{
+    if(config == NULL || config->run_clock == NULL)
+        return -1;
+
+    g_power.config = config;
+    g_power.deepest = config->deepest;
+    g_power.console_wakeup = false;
+    g_power.stats = (power_stats_t){ 0 };
+
+    // 1. LPTIM1 on LSI counts milliseconds in Stop 2 and wakes the MCU at ARR
+    rcc_sys_power_clock_enable();
+    rcc_lptim_clock_enable(1);
+    LPTIM1->CR = 0;                                 // CFGR and IER are written while disabled
+    LPTIM1->CFGR = POWER_LPTIM_PRESC << LPTIM_CFGR_PRESC_Pos;
+    LPTIM1->IER = LPTIM_IER_ARRMIE;
+    EXTI->IMR2 |= POWER_EXTI_LPTIM1;
+    nvic_irq_enable(LPTIM1_IRQn);
+
+    // 2. Wake up from HSI16: faster than MSI and the PLL source anyway
+    RCC->CFGR |= RCC_CFGR_STOPWUCK;
+
+    // 3. The console wakes the MCU on a start bit, which needs its kernel clock in Stop
+    int result = 0;
+    if(config->console != NULL) {
+        const power_usart_wakeup_t *wakeup = NULL;
+        for(uint32_t i = 0; i < sizeof(usart_wakeup) / sizeof(usart_wakeup[0]); i++) {
+            if(usart_wakeup[i].port == config->console)
+                wakeup = &usart_wakeup[i];
+        }
+
+        usart_t *usart = config->console;
+        if(wakeup != NULL && rcc_usart_kernel_hz(wakeup->number) == RCC_HSI_HZ) {
+            // WUS can only be written while the USART is disabled
+            while(!(usart->ISR & USART_ISR_TC));
+            usart->CR1 &= ~USART_CR1_UE;
+            usart->CR3 = (usart->CR3 & ~USART_CR3_WUS_Msk) | (2U << USART_CR3_WUS_Pos) | USART_CR3_WUFIE;
+            usart->CR1 |= USART_CR1_UE;
+
+            EXTI->IMR1 |= (1U << wakeup->exti_line);
+            nvic_irq_enable(wakeup->irqn);
+            g_power.console_wakeup = true;
+
+            // USARTs are powered down in Stop 2
+            if(g_power.deepest > POWER_MODE_STOP1)
+                g_power.deepest = POWER_MODE_STOP1;
+        } else {
+            // A console that cannot wake the MCU would lose input in Stop
+            if(g_power.deepest > POWER_MODE_SLEEP)
+                g_power.deepest = POWER_MODE_SLEEP;
+            result = -1;
+        }
+    }
+
+    uint32_t primask = irq_lock();
+    g_power.start_us = systick_get_us();
+    irq_unlock(primask);
+    return result;
+}
+
+power_mode_t power_select_mode(uint32_t idle_ms, bool stop_allowed, power_mode_t deepest)
+{
+    if(idle_ms == 0 || deepest == POWER_MODE_RUN)
+        return POWER_MODE_RUN;
+    if(!stop_allowed || idle_ms < POWER_STOP_MIN_MS || deepest == POWER_MODE_SLEEP)
+        return POWER_MODE_SLEEP;
+    return deepest;
+}
+
+/**
+ * @brief Enters Stop 1 or 2 until an interrupt or the LPTIM1 deadline.
+ * @return Milliseconds spent in Stop, measured by LPTIM1.
+ */
+static uint32_t power_stop(power_mode_t mode, uint32_t idle_ms)
+{
+    uint32_t ms = (idle_ms > POWER_STOP_MAX_MS) ? POWER_STOP_MAX_MS : idle_ms;
+    usart_t *console = g_power.config->console;
+
+    // 1. Arm LPTIM1 in one-shot mode. ARR is written once the timer is enabled.
+    LPTIM1->ICR = LPTIM_ICR_ARRMCF | LPTIM_ICR_ARROKCF;
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ARR = ms;
+    while(!(LPTIM1->ISR & LPTIM_ISR_ARROK));
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LPTIM1->CR = LPTIM_CR_ENABLE | LPTIM_CR_SNGSTRT;
+
+    if(g_power.console_wakeup)
+        console->CR1 |= USART_CR1_UESM;
+
+    // 2. Deep sleep
+    PWR->CR1 = (PWR->CR1 & ~PWR_CR1_LPMS_Msk)
+             | ((mode == POWER_MODE_STOP2) ? PWR_CR1_LPMS_STOP2 : PWR_CR1_LPMS_STOP1);
+    SCB->SCR |= SCB_SCR_SLEEPDEEP;
+    irq_wait();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP;
+
+    if(g_power.console_wakeup)
+        console->CR1 &= ~USART_CR1_UESM;
+
+    // 3. Time spent. CNT runs on LSI: read it until two reads agree.
+    uint32_t elapsed;
+    if(LPTIM1->ISR & LPTIM_ISR_ARRM) {
+        elapsed = ms;
+    } else {
+        do {
+            elapsed = LPTIM1->CNT;
+        } while(elapsed != LPTIM1->CNT);
+    }
+    LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+    LPTIM1->CR = 0;
+
+    // 4. Back on HSI16: rebuild the run clock tree and catch SysTick up
+    rcc_clock_config(g_power.config->run_clock);
+    systick_advance(elapsed);
+    return elapsed;
+}
+
+power_mode_t power_idle(uint32_t idle_ms)
+{
+    if(g_power.config == NULL)
+        return POWER_MODE_RUN;
+
+    // Stop would cut the console's last character
+    usart_t *console = g_power.config->console;
+    bool stop_allowed = g_power.stop_locks == 0
+                     && (console == NULL || (console->ISR & USART_ISR_TC));
+
+    power_mode_t mode = power_select_mode(idle_ms, stop_allowed, g_power.deepest);
+    g_power.stats.entries[mode]++;
+    if(mode == POWER_MODE_RUN)
+        return mode;
+
+    TRACE_BEGIN_EVENT(TRACE_EV_IDLE, mode);
+    if(mode == POWER_MODE_SLEEP) {
+        uint64_t start = systick_get_us();
+        irq_wait();
+        g_power.stats.time_us[mode] += systick_get_us() - start;
+    } else {
+        g_power.stats.time_us[mode] += (uint64_t)power_stop(mode, idle_ms) * 1000U;
+    }
+    TRACE_END_EVENT(TRACE_EV_IDLE, 0);
+    return mode;
+}
+
+void power_stop_lock(void)
+{
+    uint32_t primask = irq_lock();
+    if(g_power.stop_locks < UINT8_MAX)
+        g_power.stop_locks++;
+    irq_unlock(primask);
+}
+
+void power_stop_unlock(void)
+{
+    uint32_t primask = irq_lock();
+    if(g_power.stop_locks > 0)
+        g_power.stop_locks--;
+    irq_unlock(primask);
+}
+
+void power_usart_wakeup_irq(usart_t *usart_port)
+{
+    if(usart_port->ISR & USART_ISR_WUF)
+        usart_port->ICR = USART_ICR_WUCF;
+}
+
+void power_get_stats(power_stats_t *stats)
+{
+    uint32_t primask = irq_lock();
+    *stats = g_power.stats;
+    uint64_t total = systick_get_us() - g_power.start_us;
+    irq_unlock(primask);
+
+    uint64_t idle = 0;
+    for(uint32_t mode = POWER_MODE_SLEEP; mode < POWER_MODE_COUNT; mode++)
+        idle += stats->time_us[mode];
+    stats->time_us[POWER_MODE_RUN] = (total > idle) ? total - idle : 0;
+}
+
+void power_print_stats(usart_t *usart_port)
+{
+    power_stats_t stats;
+    power_get_stats(&stats);
+
+    uint64_t total = 0;
+    for(uint32_t mode = 0; mode < POWER_MODE_COUNT; mode++)
+        total += stats.time_us[mode];
+    if(total == 0)
+        total = 1;
+
+    usart_send_string(usart_port, "Power:");
+    for(uint32_t mode = 0; mode < POWER_MODE_COUNT; mode++) {
+        usart_send_string(usart_port, " ");
+        usart_send_string(usart_port, power_mode_name[mode]);
+        usart_send_string(usart_port, " ");
+        usart_send_uint(usart_port, (uint32_t)(stats.time_us[mode] / 1000U));
+        usart_send_string(usart_port, " ms ");
+        usart_send_uint(usart_port, (uint32_t)(stats.time_us[mode] * 100U / total));
+        usart_send_string(usart_port, "% x");
+        usart_send_uint(usart_port, stats.entries[mode]);
+    }
+    usart_send_string(usart_port, "\r\n");
+}
+
+// Deadline reached in Stop. power_stop() already cleared the flag; the
+// interrupt was still latched by the NVIC and only the wakeup mattered.
+void LPTIM1_IRQHandler(void)
+{
+    LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+}
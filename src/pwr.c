@@ -0,0 +1,16 @@
+#include "pwr.h"
+
+void pwr_set_voltage_scaling(pwr_vos_t range)
+{
+    // PWREN must be set before touching any PWR register
+    rcc_sys_power_clock_enable();
+
+    PWR->CR1 = (PWR->CR1 & ~PWR_CR1_VOS_Msk) | ((uint32_t)range << PWR_CR1_VOS_Pos);
+    while(PWR->SR2 & PWR_SR2_VOSF);
+}
+
+pwr_vos_t pwr_get_voltage_scaling(void)
+{
+    rcc_sys_power_clock_enable();
+    return (pwr_vos_t)((PWR->CR1 & PWR_CR1_VOS_Msk) >> PWR_CR1_VOS_Pos);
+}
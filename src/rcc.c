@@ -1,4 +1,5 @@
 #include "rcc.h"
+#include "pwr.h"
 
 void rcc_sys_power_clock_enable(void)
 {
@@ -6,44 +7,250 @@ void rcc_sys_power_clock_enable(void)
     RCC->APB1ENR1 |= (1U << 28);			// Enable PWREN clock. This bit is needed for CPU speed above 26 MHz
 }
 
+// Bus clocks of the current clock tree. MSI at 4 MHz is the reset clock.
+static rcc_clocks_t g_clocks = {
+	.sysclk_hz = 4000000U, .hclk_hz = 4000000U,
+	.pclk1_hz = 4000000U, .pclk2_hz = 4000000U,
+	.timclk1_hz = 4000000U, .timclk2_hz = 4000000U
+};
+
+static rcc_clock_hook_t g_clock_hooks[RCC_CLOCK_HOOKS_MAX];
+static uint8_t g_clock_hook_count = 0;
+
+// MSI frequency for each MSIRANGE value (0-11)
+static const uint32_t msi_range_hz[12] = {
+	100000U, 200000U, 400000U, 800000U, 1000000U, 2000000U,
+	4000000U, 8000000U, 16000000U, 24000000U, 32000000U, 48000000U
+};
+
+// Everything rcc_clock_config needs to apply a configuration
+typedef struct {
+	uint8_t sw;			// SYSCLK source, RCC_CFGR SW encoding
+	uint8_t msi_range;
+	uint8_t pllm;		// Division factor, 1-8
+	uint8_t plln;		// Multiplication factor, 8-86
+	uint8_t pllr;		// Division factor, 2/4/6/8
+	uint8_t ppre1;		// RCC_CFGR PPRE1 encoding
+	uint8_t ppre2;		// RCC_CFGR PPRE2 encoding
+	uint8_t wait_states;
+	pwr_vos_t vos;
+} rcc_clock_plan_t;
+
+static uint32_t rcc_msi_hz(void)
+{
+	uint32_t range;
+	if(RCC->CR & RCC_CR_MSIRGSEL)
+		range = (RCC->CR & RCC_CR_MSIRANGE_Msk) >> RCC_CR_MSIRANGE_Pos;
+	else
+		range = (RCC->CSR & RCC_CSR_MSISRANGE_Msk) >> RCC_CSR_MSISRANGE_Pos;
+	return (range < 12) ? msi_range_hz[range] : 0;
+}
+
+/**
+ * @brief Recomputes g_clocks from the RCC registers.
+ */
+static void rcc_update_clocks(void)
+{
+	uint32_t cfgr = RCC->CFGR;
+	uint32_t sysclk;
+
+	switch((cfgr & RCC_CFGR_SWS_Msk) >> RCC_CFGR_SWS_Pos) {
+	case 0: sysclk = rcc_msi_hz(); break;
+	case 1: sysclk = RCC_HSI_HZ; break;
+	case 2: sysclk = RCC_HSE_HZ; break;
+	default: {
+		uint32_t pllcfgr = RCC->PLLCFGR;
+		uint32_t src = (pllcfgr & RCC_PLLCFGR_PLLSRC_Msk) >> RCC_PLLCFGR_PLLSRC_Pos;
+		uint32_t in = (src == 1) ? rcc_msi_hz() : (src == 3) ? RCC_HSE_HZ : RCC_HSI_HZ;
+		uint32_t m = ((pllcfgr & RCC_PLLCFGR_PLLM_Msk) >> RCC_PLLCFGR_PLLM_Pos) + 1;
+		uint32_t n = (pllcfgr & RCC_PLLCFGR_PLLN_Msk) >> RCC_PLLCFGR_PLLN_Pos;
+		uint32_t r = (((pllcfgr & RCC_PLLCFGR_PLLR_Msk) >> RCC_PLLCFGR_PLLR_Pos) + 1) * 2;
+		sysclk = (in / m) * n / r;
+		break;
+	}
+	}
+
+	// HPRE: 0xxx = /1, 1000 = /2 ... 1011 = /16, 1100 = /64 ... 1111 = /512
+	uint32_t hpre = (cfgr & RCC_CFGR_HPRE_Msk) >> RCC_CFGR_HPRE_Pos;
+	uint32_t hclk = sysclk;
+	if(hpre & 0x8U)
+		hclk >>= (hpre & 0x7U) + ((hpre & 0x4U) ? 2 : 1);
+
+	// PPREx: 0xx = /1, 100 = /2 ... 111 = /16
+	uint32_t ppre1 = (cfgr & RCC_CFGR_PPRE1_Msk) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t ppre2 = (cfgr & RCC_CFGR_PPRE2_Msk) >> RCC_CFGR_PPRE2_Pos;
+
+	g_clocks.sysclk_hz = sysclk;
+	g_clocks.hclk_hz = hclk;
+	g_clocks.pclk1_hz = (ppre1 & 0x4U) ? hclk >> ((ppre1 & 0x3U) + 1) : hclk;
+	g_clocks.pclk2_hz = (ppre2 & 0x4U) ? hclk >> ((ppre2 & 0x3U) + 1) : hclk;
+	g_clocks.timclk1_hz = (ppre1 & 0x4U) ? g_clocks.pclk1_hz * 2 : g_clocks.pclk1_hz;
+	g_clocks.timclk2_hz = (ppre2 & 0x4U) ? g_clocks.pclk2_hz * 2 : g_clocks.pclk2_hz;
+}
+
+static void rcc_run_clock_hooks(void)
+{
+	for(uint8_t i = 0; i < g_clock_hook_count; i++)
+		g_clock_hooks[i](&g_clocks);
+}
+
+/**
+ * @brief Returns the PPRE encoding that keeps hclk / divider <= max_hz.
+ */
+static uint8_t rcc_apb_prescaler(uint32_t hclk_hz, uint32_t max_hz)
+{
+	if(max_hz == 0 || hclk_hz <= max_hz)
+		return 0;
+	for(uint8_t shift = 1; shift < 4; shift++) {
+		if((hclk_hz >> shift) <= max_hz)
+			return 0x4U | (shift - 1);
+	}
+	return 0x7U;	// /16, the largest divider
+}
+
+/**
+ * @brief Flash wait states needed for a given HCLK and voltage range.
+ */
+static uint8_t rcc_flash_wait_states(uint32_t hclk_hz, pwr_vos_t vos)
+{
+	if(vos == PWR_VOS_RANGE1)
+		return (uint8_t)((hclk_hz - 1) / 16000000U);	// 16, 32, 48, 64, 80 MHz steps
+	if(hclk_hz <= 6000000U) return 0;
+	if(hclk_hz <= 12000000U) return 1;
+	if(hclk_hz <= 18000000U) return 2;
+	return 3;
+}
+
+/**
+ * @brief Finds HSI16 / M * N / R == sysclk_hz within the VCO limits.
+ * @return 0 on success, -1 if no exact setting exists.
+ */
+static int rcc_pll_search(uint32_t sysclk_hz, pwr_vos_t vos, rcc_clock_plan_t *plan)
+{
+	// VCO input 4-16 MHz; VCO output 64-344 MHz (Range 1) or 64-128 MHz (Range 2)
+	uint32_t vco_max = (vos == PWR_VOS_RANGE1) ? 344000000U : 128000000U;
+
+	for(uint8_t r = 2; r <= 8; r += 2) {
+		uint32_t vco = sysclk_hz * r;
+		if(vco < 64000000U || vco > vco_max)
+			continue;
+		for(uint8_t m = 1; m <= 4; m++) {
+			uint32_t vco_in = RCC_HSI_HZ / m;
+			if(vco % vco_in != 0)
+				continue;
+			uint32_t n = vco / vco_in;
+			if(n < 8 || n > 86)
+				continue;
+			plan->pllm = m;
+			plan->plln = (uint8_t)n;
+			plan->pllr = r;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static int rcc_clock_plan(const rcc_clock_config_t *config, rcc_clock_plan_t *plan)
+{
+	uint32_t sysclk = config->sysclk_hz;
+	if(sysclk == 0 || sysclk > RCC_SYSCLK_MAX_HZ)
+		return -1;
+
+	plan->vos = (sysclk > 26000000U) ? PWR_VOS_RANGE1 : PWR_VOS_RANGE2;
+	plan->wait_states = rcc_flash_wait_states(sysclk, plan->vos);
+	plan->ppre1 = rcc_apb_prescaler(sysclk, config->pclk1_max_hz);
+	plan->ppre2 = rcc_apb_prescaler(sysclk, config->pclk2_max_hz);
+
+	if(sysclk == RCC_HSI_HZ) {
+		plan->sw = 1;
+		return 0;
+	}
+	for(uint8_t range = 0; range < 12; range++) {
+		if(msi_range_hz[range] == sysclk && sysclk <= 24000000U) {
+			plan->sw = 0;
+			plan->msi_range = range;
+			return 0;
+		}
+	}
+	plan->sw = 3;
+	return rcc_pll_search(sysclk, plan->vos, plan);
+}
+
 /**
- * @brief Configures the system to run from the 80MHz PLL, sourced by HSI.
+ * @brief Switches SYSCLK to the given source and waits for the switch.
  */
-static void rcc_configure_pll_80mhz_from_hsi(void)
+static void rcc_switch_sysclk(uint8_t sw)
+{
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | ((uint32_t)sw << RCC_CFGR_SW_Pos);
+	while(((RCC->CFGR & RCC_CFGR_SWS_Msk) >> RCC_CFGR_SWS_Pos) != sw);
+}
+
+int rcc_clock_config(const rcc_clock_config_t *config)
 {
-	// 1. Enable HSI and wait for it to be ready
+	rcc_clock_plan_t plan;
+	if(config == NULL || rcc_clock_plan(config, &plan) != 0)
+		return -1;
+
+	// 1. Raise voltage range and wait states before speeding up
+	pwr_vos_t vos_now = pwr_get_voltage_scaling();
+	if(plan.vos == PWR_VOS_RANGE1 && vos_now != PWR_VOS_RANGE1)
+		pwr_set_voltage_scaling(PWR_VOS_RANGE1);
+	if(plan.wait_states > flash_get_latency())
+		flash_set_latency(plan.wait_states);
+
+	// 2. Keep APB at the slowest setting during the switch
+	RCC->CFGR |= RCC_CFGR_PPRE1_Msk | RCC_CFGR_PPRE2_Msk;
+
+	// 3. Bring up the new source. HSI also backs SYSCLK while the PLL is reprogrammed.
 	RCC->CR |= RCC_CR_HSION;
 	while(!(RCC->CR & RCC_CR_HSIRDY));
 
-	// 2. Configure Flash latency and power settings
-	rcc_sys_power_clock_enable();
-	// Set Voltage Scaling to Range 1 (high-performance) for clocks > 26MHz
-    // PWR->CR1 |= PWR_CR1_VOS_0; // You'd need a PWR driver for this.
-	
-	// Call the Flash driver function to set 4 wait states for 80MHz.
-    flash_configure_for_high_speed();
+	switch(plan.sw) {
+	case 0:
+		RCC->CR |= RCC_CR_MSION;
+		while(!(RCC->CR & RCC_CR_MSIRDY));
+		RCC->CR = (RCC->CR & ~RCC_CR_MSIRANGE_Msk) | ((uint32_t)plan.msi_range << RCC_CR_MSIRANGE_Pos) | RCC_CR_MSIRGSEL;
+		while(!(RCC->CR & RCC_CR_MSIRDY));
+		break;
+	case 3:
+		if(((RCC->CFGR & RCC_CFGR_SWS_Msk) >> RCC_CFGR_SWS_Pos) == 3)
+			rcc_switch_sysclk(1);
+		RCC->CR &= ~RCC_CR_PLLON;
+		while(RCC->CR & RCC_CR_PLLRDY);
 
-	// 3. Configure the PLL
-	RCC->CR &= ~RCC_CR_PLLON;
-	while(RCC->CR & RCC_CR_PLLRDY);
+		// PLLSRC = HSI (0b10), PLLR output enabled
+		RCC->PLLCFGR = (2U << RCC_PLLCFGR_PLLSRC_Pos)
+		             | ((uint32_t)(plan.pllm - 1) << RCC_PLLCFGR_PLLM_Pos)
+		             | ((uint32_t)plan.plln << RCC_PLLCFGR_PLLN_Pos)
+		             | ((uint32_t)(plan.pllr / 2 - 1) << RCC_PLLCFGR_PLLR_Pos)
+		             | RCC_PLLCFGR_PLLREN;
 
-	// Configure PLL: HSI (16MHz) -> /M=2 -> *N=20 -> /R=2 = 80MHz SYSCLK
-    // PLLSRC = HSI (0b10)
-    // PLLM   = /2   (0b001)
-    // PLLN   = *20  (0b0010100)
-    // PLLR   = /2   (0b00, this is the default and PLLREN enables it)
-    RCC->PLLCFGR = (2U << 0) | (1U << 4) | (20U << 8) | (1U << 24);
+		RCC->CR |= RCC_CR_PLLON;
+		while(!(RCC->CR & RCC_CR_PLLRDY));
+		break;
+	default:
+		break;
+	}
 
-	// Enable the PLL and wait for it to lock
-    RCC->CR |= RCC_CR_PLLON;
-    while(!(RCC->CR & RCC_CR_PLLRDY));
+	// 4. Switch, then apply the final bus prescalers (HCLK = SYSCLK)
+	rcc_switch_sysclk(plan.sw);
+	RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_HPRE_Msk | RCC_CFGR_PPRE1_Msk | RCC_CFGR_PPRE2_Msk))
+	          | ((uint32_t)plan.ppre1 << RCC_CFGR_PPRE1_Pos)
+	          | ((uint32_t)plan.ppre2 << RCC_CFGR_PPRE2_Pos);
 
-	// 4. Switch System Clock to PLL
-    // First, clear the SW bits, then set them to select PLL (0b11)
-    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | (3U << RCC_CFGR_SW_Pos);
+	// 5. Lower wait states and voltage range after slowing down
+	if(plan.wait_states < flash_get_latency())
+		flash_set_latency(plan.wait_states);
+	if(plan.vos == PWR_VOS_RANGE2 && vos_now != PWR_VOS_RANGE2)
+		pwr_set_voltage_scaling(PWR_VOS_RANGE2);
 
-    // Wait until the SWS bits confirm the PLL is the source (0b11)
-    while ((RCC->CFGR & RCC_CFGR_SWS_Msk) != (3U << RCC_CFGR_SWS_Pos));
+	// 6. The PLL burns power when unused
+	if(plan.sw != 3)
+		RCC->CR &= ~RCC_CR_PLLON;
+
+	rcc_update_clocks();
+	rcc_run_clock_hooks();
+	return 0;
 }
 
 void rcc_set_system_clock(rcc_clksrc_t clock_source)
@@ -51,25 +258,41 @@ void rcc_set_system_clock(rcc_clksrc_t clock_source)
 	switch (clock_source) {
 	case SYSCLK_SRC_MSI:
 		// MSI is default, but here's how to switch back to it.
-        RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | (0U << RCC_CFGR_SW_Pos);
-        while ((RCC->CFGR & RCC_CFGR_SWS_Msk) != (0U << RCC_CFGR_SWS_Pos));
-        break;
+		rcc_switch_sysclk(0);
+		break;
 
 	case SYSCLK_SRC_HSI:
 		RCC->CR |= RCC_CR_HSION;
 		while(!(RCC->CR & RCC_CR_HSIRDY));
-
-		RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | (1U << RCC_CFGR_SW_Pos);
-		while((RCC->CFGR & RCC_CFGR_SW_Msk) != (1U << RCC_CFGR_SW_Pos));
+		rcc_switch_sysclk(1);
 		break;
 
 	case SYSCLK_SRC_HSE:
 		break;
 
-	case SYSCLK_SRC_PLL:
-		rcc_configure_pll_80mhz_from_hsi();
-		break;
+	case SYSCLK_SRC_PLL: {
+		// 80 MHz from HSI: the settings are computed by rcc_clock_config
+		const rcc_clock_config_t config = { .sysclk_hz = RCC_SYSCLK_MAX_HZ };
+		rcc_clock_config(&config);
+		return;
+	}
 	}
+
+	rcc_update_clocks();
+	rcc_run_clock_hooks();
+}
+
+const rcc_clocks_t *rcc_get_clocks(void)
+{
+	return &g_clocks;
+}
+
+int rcc_clock_hook_register(rcc_clock_hook_t hook)
+{
+	if(hook == NULL || g_clock_hook_count >= RCC_CLOCK_HOOKS_MAX)
+		return -1;
+	g_clock_hooks[g_clock_hook_count++] = hook;
+	return 0;
 }
 
 void rcc_gpio_clock_enable(uint8_t port_index)
@@ -86,12 +309,46 @@ void rcc_usart_clock_enable(uint8_t usart_number)
 		case 3: RCC->APB1ENR1 |= (1U << 18); break;
 		case 4: RCC->APB1ENR1 |= (1U << 19); break;
 		case 5: RCC->APB1ENR1 |= (1U << 20); break;
+		case 6: RCC->APB1ENR2 |= (1U << 0); break;		// LPUART1
 
 		// USARTs in APB2 Bus.
 		case 1: RCC->APB2ENR |= (1U << 14); break;
 	}
 }
 
+// USARTxSEL position in RCC_CCIPR, indexed by usart_number - 1
+static const uint8_t usart_sel_pos[6] = { 0U, 2U, 4U, 6U, 8U, 10U };
+
+void rcc_usart_clock_source(uint8_t usart_number, rcc_usart_clk_t source)
+{
+	if(usart_number < 1 || usart_number > 6)
+		return;
+	uint8_t pos = usart_sel_pos[usart_number - 1];
+	if(source == RCC_USART_CLK_HSI16) {
+		RCC->CR |= RCC_CR_HSION;
+		while(!(RCC->CR & RCC_CR_HSIRDY));
+	}
+	RCC->CCIPR = (RCC->CCIPR & ~(0x3U << pos)) | ((uint32_t)source << pos);
+}
+
+uint32_t rcc_usart_kernel_hz(uint8_t usart_number)
+{
+	if(usart_number < 1 || usart_number > 6)
+		return 0;
+
+	uint8_t pos = usart_sel_pos[usart_number - 1];
+	switch((RCC->CCIPR >> pos) & 0x3U) {
+	case RCC_USART_CLK_PCLK:
+		return (usart_number == 1) ? g_clocks.pclk2_hz : g_clocks.pclk1_hz;
+	case RCC_USART_CLK_SYSCLK:
+		return g_clocks.sysclk_hz;
+	case RCC_USART_CLK_HSI16:
+		return (RCC->CR & RCC_CR_HSIRDY) ? RCC_HSI_HZ : 0;
+	default:
+		return 0;	// LSE is not fitted on the Nucleo board
+	}
+}
+
 void rcc_i2c_clock_enable(uint8_t i2c_number)
 {
 	switch (i2c_number) {
@@ -121,6 +378,31 @@ void rcc_tim_clock_enable(uint8_t timer_number)
 	}
 }
 
+void rcc_lptim_clock_enable(uint8_t lptim_number)
+{
+	RCC->CSR |= RCC_CSR_LSION;
+	while(!(RCC->CSR & RCC_CSR_LSIRDY));
+
+	switch (lptim_number) {
+		case 1:
+			RCC->CCIPR = (RCC->CCIPR & ~RCC_CCIPR_LPTIM1SEL_Msk) | (1U << RCC_CCIPR_LPTIM1SEL_Pos);
+			RCC->APB1ENR1 |= (1U << 31);
+			break;
+		case 2:
+			RCC->CCIPR = (RCC->CCIPR & ~RCC_CCIPR_LPTIM2SEL_Msk) | (1U << RCC_CCIPR_LPTIM2SEL_Pos);
+			RCC->APB1ENR2 |= (1U << 5);
+			break;
+	}
+}
+
+void rcc_dma_clock_enable(uint8_t dma_number)
+{
+	switch (dma_number) {
+		case 1: RCC->AHB1ENR |= (1U << 0); break;
+		case 2: RCC->AHB1ENR |= (1U << 1); break;
+	}
+}
+
 void rcc_adc_clock_enable(void)
 {
 	RCC->AHB2ENR |= (1U << 13);
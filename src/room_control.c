@@ -0,0 +1,288 @@
+#include "room_control.h"
+#include "systick.h"
+#include <stddef.h>
+
+#define RC_INTERNAL     RC_STATE_COUNT  // Transition target: handled, stay in the same state
+
+typedef void (*rc_action_t)(room_control_t *rc);
+
+// Chooses the target of a transition at run time: a state, RC_INTERNAL,
+// or RC_STATE_NONE to let the parent state handle the event
+typedef uint8_t (*rc_handler_t)(room_control_t *rc, uint32_t arg);
+
+typedef struct {
+    uint8_t parent;
+    uint32_t timeout_ms;        // 0 for none
+    rc_action_t entry;
+    rc_action_t exit;
+    const char *name;
+} rc_state_desc_t;
+
+typedef struct {
+    uint8_t target;             // RC_STATE_NONE: not handled in this state
+    rc_handler_t handler;       // When set, returns the target instead
+} rc_transition_t;
+
+static const uint8_t fan_percent[RC_FAN_LEVELS] = { 0, 25, 60, 100 };
+
+// --- Outputs ---
+
+static void rc_set_door(room_control_t *rc, bool locked)
+{
+    if(rc->door_locked == locked)
+        return;
+    rc->door_locked = locked;
+    if(rc->io->door != NULL)
+        rc->io->door(locked);
+}
+
+static void rc_set_fan(room_control_t *rc, rc_fan_t level)
+{
+    if(rc->fan == level)
+        return;
+    rc->fan = level;
+    if(rc->io->fan != NULL)
+        rc->io->fan(level);
+}
+
+static void rc_clear_pin(room_control_t *rc)
+{
+    for(uint8_t i = 0; i < RC_PIN_MAX; i++)
+        rc->pin[i] = '\0';
+    rc->pin_length = 0;
+}
+
+// --- Entry and exit actions ---
+
+static void rc_lock(room_control_t *rc)         { rc_set_door(rc, true); }
+static void rc_unlock(room_control_t *rc)       { rc_set_door(rc, false); }
+static void rc_pin_reset(room_control_t *rc)    { rc_clear_pin(rc); }
+
+static void rc_emergency_entry(room_control_t *rc)
+{
+    rc_set_door(rc, true);
+    rc_set_fan(rc, RC_FAN_HIGH);
+}
+
+static void rc_emergency_exit(room_control_t *rc)
+{
+    rc_set_fan(rc, rc->fan_user);
+}
+
+// --- Event handlers ---
+
+static uint8_t rc_key_entry(room_control_t *rc, uint32_t arg)
+{
+    char key = (char)arg;
+
+    if(key == '*') {
+        rc_clear_pin(rc);
+        return RC_INTERNAL;
+    }
+    if(key == '#') {
+        bool granted = rc->pin_length > 0 && rc->pin_length <= RC_PIN_MAX
+                    && rc->io->check_password != NULL
+                    && rc->io->check_password(rc->pin, rc->pin_length);
+        rc_clear_pin(rc);
+        return granted ? RC_STATE_UNLOCKED_TEMP : RC_STATE_DENIED;
+    }
+
+    // Keys past RC_PIN_MAX are counted but not stored: the entry then fails
+    if(rc->pin_length < RC_PIN_MAX)
+        rc->pin[rc->pin_length] = key;
+    if(rc->pin_length < UINT8_MAX)
+        rc->pin_length++;
+    return RC_INTERNAL;
+}
+
+static uint8_t rc_fan_set(room_control_t *rc, uint32_t arg)
+{
+    if(arg < RC_FAN_LEVELS) {
+        rc->fan_user = (rc_fan_t)arg;
+        rc_set_fan(rc, rc->fan_user);
+    }
+    return RC_INTERNAL;
+}
+
+// In emergency the fan stays at maximum; the request applies afterwards
+static uint8_t rc_fan_defer(room_control_t *rc, uint32_t arg)
+{
+    if(arg < RC_FAN_LEVELS)
+        rc->fan_user = (rc_fan_t)arg;
+    return RC_INTERNAL;
+}
+
+// --- Tables ---
+
+static const rc_state_desc_t rc_states[RC_STATE_COUNT] = {
+    [RC_STATE_NONE]          = { RC_STATE_NONE,     0,                 NULL,               NULL,              "" },
+    [RC_STATE_NORMAL]        = { RC_STATE_NONE,     0,                 NULL,               NULL,              "NORMAL" },
+    [RC_STATE_LOCKED]        = { RC_STATE_NORMAL,   0,                 rc_lock,            NULL,              "LOCKED" },
+    [RC_STATE_LOCKED_IDLE]   = { RC_STATE_LOCKED,   0,                 rc_pin_reset,       NULL,              "LOCKED" },
+    [RC_STATE_DENIED]        = { RC_STATE_LOCKED,   RC_DENIED_MS,      rc_pin_reset,       NULL,              "DENIED" },
+    [RC_STATE_UNLOCKED]      = { RC_STATE_NORMAL,   0,                 rc_unlock,          NULL,              "UNLOCKED" },
+    [RC_STATE_UNLOCKED_TEMP] = { RC_STATE_UNLOCKED, RC_UNLOCK_TEMP_MS, NULL,               NULL,              "OPEN" },
+    [RC_STATE_UNLOCKED_PERM] = { RC_STATE_UNLOCKED, 0,                 NULL,               NULL,              "UNLOCKED" },
+    [RC_STATE_EMERGENCY]     = { RC_STATE_NONE,     0,                 rc_emergency_entry, rc_emergency_exit, "EMERGENCY" },
+};
+
+static const rc_transition_t rc_table[RC_STATE_COUNT][RC_EV_COUNT] = {
+    [RC_STATE_NORMAL] = {
+        [RC_EV_EMERGENCY_ON]  = { RC_STATE_EMERGENCY, NULL },
+        [RC_EV_FAN_SET]       = { RC_STATE_NONE, rc_fan_set },
+    },
+    [RC_STATE_LOCKED] = {
+        [RC_EV_BUTTON]        = { RC_STATE_UNLOCKED_TEMP, NULL },
+        [RC_EV_REMOTE_OPEN]   = { RC_STATE_UNLOCKED_TEMP, NULL },
+        [RC_EV_UNLOCK]        = { RC_STATE_UNLOCKED_PERM, NULL },
+    },
+    [RC_STATE_LOCKED_IDLE] = {
+        [RC_EV_KEY]           = { RC_STATE_NONE, rc_key_entry },
+    },
+    [RC_STATE_DENIED] = {
+        [RC_EV_KEY]           = { RC_INTERNAL, NULL },
+        [RC_EV_TIMEOUT]       = { RC_STATE_LOCKED_IDLE, NULL },
+    },
+    [RC_STATE_UNLOCKED] = {
+        [RC_EV_LOCK]          = { RC_STATE_LOCKED_IDLE, NULL },
+        [RC_EV_BUTTON]        = { RC_STATE_LOCKED_IDLE, NULL },
+    },
+    [RC_STATE_UNLOCKED_TEMP] = {
+        [RC_EV_TIMEOUT]       = { RC_STATE_LOCKED_IDLE, NULL },
+        [RC_EV_REMOTE_OPEN]   = { RC_STATE_UNLOCKED_TEMP, NULL },   // Restarts the timeout
+        [RC_EV_UNLOCK]        = { RC_STATE_UNLOCKED_PERM, NULL },
+    },
+    [RC_STATE_EMERGENCY] = {
+        [RC_EV_EMERGENCY_OFF] = { RC_STATE_LOCKED_IDLE, NULL },
+        [RC_EV_FAN_SET]       = { RC_STATE_NONE, rc_fan_defer },
+    },
+};
+
+// --- Engine ---
+
+static bool rc_is_within(uint8_t state, uint8_t ancestor)
+{
+    for(uint8_t depth = 0; depth <= RC_MAX_DEPTH; depth++) {
+        if(state == ancestor)
+            return true;
+        if(state == RC_STATE_NONE)
+            return false;
+        state = rc_states[state].parent;
+    }
+    return false;
+}
+
+static void rc_exit(room_control_t *rc, uint8_t state)
+{
+    if(rc_states[state].timeout_ms != 0)
+        rc->timer_armed = false;
+    if(rc_states[state].exit != NULL)
+        rc_states[state].exit(rc);
+}
+
+static void rc_enter(room_control_t *rc, uint8_t state)
+{
+    if(rc_states[state].timeout_ms != 0) {
+        rc->deadline = rc->now + rc_states[state].timeout_ms;
+        rc->timer_armed = true;
+    }
+    if(rc_states[state].entry != NULL)
+        rc_states[state].entry(rc);
+}
+
+/**
+ * @brief Moves from the active leaf state to target, a leaf state.
+ *
+ * Exits up to the closest common ancestor and enters down to the target.
+ * A transition to the active state exits and re-enters it.
+ */
+static void rc_transition(room_control_t *rc, uint8_t target)
+{
+    uint8_t lca = rc_states[rc->state].parent;
+    while(!rc_is_within(target, lca))
+        lca = rc_states[lca].parent;
+
+    for(uint8_t state = rc->state; state != lca; state = rc_states[state].parent)
+        rc_exit(rc, state);
+
+    uint8_t path[RC_MAX_DEPTH];
+    uint8_t depth = 0;
+    for(uint8_t state = target; state != lca && depth < RC_MAX_DEPTH; state = rc_states[state].parent)
+        path[depth++] = state;
+    while(depth > 0)
+        rc_enter(rc, path[--depth]);
+
+    rc->state = (rc_state_t)target;
+    if(rc->io->state_changed != NULL)
+        rc->io->state_changed(rc->state);
+}
+
+void room_control_init(room_control_t *rc, const room_control_io_t *io, uint32_t now_ms)
+{
+    static const room_control_io_t no_io = { 0 };
+
+    rc->io = (io != NULL) ? io : &no_io;
+    rc->state = RC_STATE_NONE;
+    rc->timer_armed = false;
+    rc->now = now_ms;
+    rc->fan_user = RC_FAN_OFF;
+    rc_clear_pin(rc);
+
+    // Drive both outputs once, whatever their reset state was
+    rc->door_locked = false;
+    rc->fan = RC_FAN_OFF;
+    if(rc->io->fan != NULL)
+        rc->io->fan(RC_FAN_OFF);
+
+    rc_transition(rc, RC_STATE_LOCKED_IDLE);
+}
+
+void room_control_dispatch(room_control_t *rc, rc_event_t event, uint32_t arg, uint32_t now_ms)
+{
+    if(event >= RC_EV_COUNT)
+        return;
+    rc->now = now_ms;
+
+    uint8_t state = rc->state;
+    for(uint8_t depth = 0; depth < RC_MAX_DEPTH && state != RC_STATE_NONE; depth++) {
+        const rc_transition_t *transition = &rc_table[state][event];
+        uint8_t target = (transition->handler != NULL) ? transition->handler(rc, arg) : transition->target;
+
+        if(target != RC_STATE_NONE) {
+            if(target != RC_INTERNAL)
+                rc_transition(rc, target);
+            return;
+        }
+        state = rc_states[state].parent;
+    }
+}
+
+void room_control_tick(room_control_t *rc, uint32_t now_ms)
+{
+    if(rc->timer_armed && systick_deadline_reached(rc->deadline, now_ms)) {
+        rc->timer_armed = false;
+        room_control_dispatch(rc, RC_EV_TIMEOUT, 0, now_ms);
+    }
+}
+
+uint32_t room_control_time_to_deadline(const room_control_t *rc, uint32_t now_ms)
+{
+    if(!rc->timer_armed)
+        return UINT32_MAX;
+    return systick_time_left(rc->deadline, now_ms);
+}
+
+bool room_control_in_state(const room_control_t *rc, rc_state_t state)
+{
+    return rc_is_within(rc->state, state);
+}
+
+const char *room_control_state_name(rc_state_t state)
+{
+    return (state < RC_STATE_COUNT) ? rc_states[state].name : "";
+}
+
+uint8_t room_control_fan_percent(rc_fan_t level)
+{
+    return (level < RC_FAN_LEVELS) ? fan_percent[level] : 0;
+}
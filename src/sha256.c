@@ -0,0 +1,111 @@
+#include "sha256.h"
+
+#define ROTR(x, n)      (((x) >> (n)) | ((x) << (32U - (n))))
+#define CH(x, y, z)     (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)    (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x)          (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define EP1(x)          (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SIG0(x)         (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SIG1(x)         (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @brief Processes one 64 byte block.
+ */
+static void sha256_transform(sha256_t *ctx, const uint8_t *block)
+{
+    uint32_t w[64];
+    for(uint32_t i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16)
+             | ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+    }
+    for(uint32_t i = 16; i < 64; i++)
+        w[i] = SIG1(w[i - 2]) + w[i - 7] + SIG0(w[i - 15]) + w[i - 16];
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+
+    for(uint32_t i = 0; i < 64; i++) {
+        uint32_t t1 = h + EP1(e) + CH(e, f, g) + k[i] + w[i];
+        uint32_t t2 = EP0(a) + MAJ(a, b, c);
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+void sha256_init(sha256_t *ctx)
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    for(uint32_t i = 0; i < 8; i++)
+        ctx->state[i] = initial[i];
+    ctx->length = 0;
+    ctx->used = 0;
+}
+
+void sha256_update(sha256_t *ctx, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+    ctx->length += len;
+
+    while(len > 0) {
+        // Whole blocks straight from the source when nothing is buffered
+        if(ctx->used == 0 && len >= SHA256_BLOCK_SIZE) {
+            sha256_transform(ctx, src);
+            src += SHA256_BLOCK_SIZE;
+            len -= SHA256_BLOCK_SIZE;
+            continue;
+        }
+        ctx->block[ctx->used++] = *src++;
+        len--;
+        if(ctx->used == SHA256_BLOCK_SIZE) {
+            sha256_transform(ctx, ctx->block);
+            ctx->used = 0;
+        }
+    }
+}
+
+void sha256_final(sha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+    uint64_t bits = ctx->length * 8U;
+
+    // Padding: 0x80, zeros, then the message length in bits, big endian
+    ctx->block[ctx->used++] = 0x80;
+    if(ctx->used > SHA256_BLOCK_SIZE - 8U) {
+        while(ctx->used < SHA256_BLOCK_SIZE)
+            ctx->block[ctx->used++] = 0;
+        sha256_transform(ctx, ctx->block);
+        ctx->used = 0;
+    }
+    while(ctx->used < SHA256_BLOCK_SIZE - 8U)
+        ctx->block[ctx->used++] = 0;
+    for(uint32_t i = 0; i < 8; i++)
+        ctx->block[SHA256_BLOCK_SIZE - 1U - i] = (uint8_t)(bits >> (8U * i));
+    sha256_transform(ctx, ctx->block);
+
+    for(uint32_t i = 0; i < 8; i++) {
+        digest[4 * i]     = (uint8_t)(ctx->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+
+    // The context held password material
+    volatile uint8_t *wipe = (volatile uint8_t *)ctx;
+    for(size_t i = 0; i < sizeof(*ctx); i++)
+        wipe[i] = 0;
+}
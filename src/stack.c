@@ -0,0 +1,45 @@
+#include "stack.h"
+#include "mpu.h"
+#include "scb.h"
+
+extern uint32_t _sstack_guard;  // Symbols defined in the linker script
+extern uint32_t _sstack;
+extern uint32_t _estack;
+
+static bool g_guard_armed = false;
+
+void stack_guard_init(void)
+{
+    // 1. No access at all, not even execution, in the 32 bytes below the stack
+    if(mpu_region_config(STACK_GUARD_REGION, (uint32_t)&_sstack_guard, MPU_REGION_MIN_SIZE,
+                         MPU_AP_NO_ACCESS | MPU_RASR_XN) != 0)
+        return;
+
+    // 2. A dedicated MemManage handler, otherwise the fault escalates to HardFault
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA;
+    mpu_enable();
+    g_guard_armed = true;
+}
+
+uint32_t stack_get_size(void)
+{
+    return (uint32_t)&_estack - (uint32_t)&_sstack;
+}
+
+uint32_t stack_get_high_water(void)
+{
+    const uint32_t *word = &_sstack;
+
+    while(word < &_estack && *word == STACK_PAINT_PATTERN)
+        word++;
+    return (uint32_t)&_estack - (uint32_t)word;
+}
+
+void stack_print_usage(usart_t *usart_port)
+{
+    usart_send_string(usart_port, "Stack: ");
+    usart_send_uint(usart_port, stack_get_high_water());
+    usart_send_string(usart_port, "/");
+    usart_send_uint(usart_port, stack_get_size());
+    usart_send_string(usart_port, g_guard_armed ? " bytes, guard on\r\n" : " bytes, guard off\r\n");
+}
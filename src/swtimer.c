@@ -0,0 +1,205 @@
+#include "swtimer.h"
+#include "systick.h"
+
+#define SWTIMER_SLOT_MASK       (SWTIMER_SLOTS - 1U)
+#define SWTIMER_SHIFT(level)    ((level) * SWTIMER_SLOT_BITS)
+#define SWTIMER_RANGE_MS        (1UL << SWTIMER_SHIFT(SWTIMER_LEVELS))  // Delays the wheel holds exactly
+
+static swtimer_t *g_wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+static uint64_t g_occupied[SWTIMER_LEVELS];     // One bit per non-empty slot
+static uint32_t g_wheel_time;                   // Next tick to process
+
+/**
+ * @brief Rotates a slot bitmap right, so that bit 0 is slot n.
+ */
+static inline uint64_t swtimer_rotate(uint64_t bits, uint32_t n)
+{
+    n &= SWTIMER_SLOT_MASK;
+    return (n == 0) ? bits : (bits >> n) | (bits << (SWTIMER_SLOTS - n));
+}
+
+/**
+ * @brief Files a timer in the slot that covers its expiry.
+ */
+static void swtimer_link(swtimer_t *timer)
+{
+    int32_t delta = (int32_t)(timer->expires - g_wheel_time);
+    uint32_t when = timer->expires;
+    uint32_t level = 0;
+
+    if(delta < 0) {
+        // Late: run at the next processed tick
+        when = g_wheel_time;
+    } else {
+        while(level < SWTIMER_LEVELS - 1U && (uint32_t)delta >= (1UL << SWTIMER_SHIFT(level + 1U)))
+            level++;
+        // Beyond the wheel: park in the last top slot, re-filed when it comes round
+        if((uint32_t)delta >= SWTIMER_RANGE_MS)
+            when = g_wheel_time + SWTIMER_RANGE_MS - 1U;
+    }
+
+    uint32_t slot = (when >> SWTIMER_SHIFT(level)) & SWTIMER_SLOT_MASK;
+    swtimer_t **head = &g_wheel[level][slot];
+    timer->next = *head;
+    if(timer->next != NULL)
+        timer->next->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+    g_occupied[level] |= 1ULL << slot;
+}
+
+static void swtimer_unlink(swtimer_t *timer)
+{
+    swtimer_t **pprev = timer->pprev;
+    *pprev = timer->next;
+    if(timer->next != NULL)
+        timer->next->pprev = pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+
+    // Last timer of a wheel slot: clear its bit
+    uintptr_t first = (uintptr_t)&g_wheel[0][0];
+    uintptr_t link = (uintptr_t)pprev;
+    if(*pprev == NULL && link >= first && link < first + sizeof(g_wheel)) {
+        uint32_t index = (uint32_t)((link - first) / sizeof(g_wheel[0][0]));
+        g_occupied[index / SWTIMER_SLOTS] &= ~(1ULL << (index % SWTIMER_SLOTS));
+    }
+}
+
+/**
+ * @brief Moves the timers of a slot to a local list.
+ */
+static void swtimer_take(uint32_t level, uint32_t slot, swtimer_t **list)
+{
+    *list = g_wheel[level][slot];
+    g_wheel[level][slot] = NULL;
+    g_occupied[level] &= ~(1ULL << slot);
+    if(*list != NULL)
+        (*list)->pprev = list;
+}
+
+/**
+ * @brief Level 0 wrapped: re-files the next slot of each level that wrapped with it.
+ */
+static void swtimer_cascade(void)
+{
+    for(uint32_t level = 1; level < SWTIMER_LEVELS; level++) {
+        uint32_t slot = (g_wheel_time >> SWTIMER_SHIFT(level)) & SWTIMER_SLOT_MASK;
+        swtimer_t *list;
+        swtimer_take(level, slot, &list);
+        while(list != NULL) {
+            swtimer_t *timer = list;
+            swtimer_unlink(timer);
+            swtimer_link(timer);
+        }
+        if(slot != 0)
+            break;
+    }
+}
+
+void swtimer_init(uint32_t now_ms)
+{
+    for(uint32_t level = 0; level < SWTIMER_LEVELS; level++) {
+        for(uint32_t slot = 0; slot < SWTIMER_SLOTS; slot++)
+            g_wheel[level][slot] = NULL;
+        g_occupied[level] = 0;
+    }
+    g_wheel_time = now_ms;
+}
+
+void swtimer_setup(swtimer_t *timer, swtimer_callback_t callback, void *context)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->period_ms = 0;
+    timer->callback = callback;
+    timer->context = context;
+}
+
+void swtimer_start(swtimer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+    if(swtimer_is_active(timer))
+        swtimer_unlink(timer);
+
+    if(delay_ms > SWTIMER_MAX_DELAY_MS)
+        delay_ms = SWTIMER_MAX_DELAY_MS;
+    if(period_ms > SWTIMER_MAX_DELAY_MS)
+        period_ms = SWTIMER_MAX_DELAY_MS;
+
+    timer->expires = systick_getTick() + delay_ms;
+    timer->period_ms = period_ms;
+    swtimer_link(timer);
+}
+
+void swtimer_stop(swtimer_t *timer)
+{
+    if(swtimer_is_active(timer))
+        swtimer_unlink(timer);
+}
+
+uint32_t swtimer_process(uint32_t now_ms)
+{
+    uint32_t count = 0;
+
+    while((int32_t)(now_ms - g_wheel_time) >= 0) {
+        uint32_t index = g_wheel_time & SWTIMER_SLOT_MASK;
+        if(index == 0)
+            swtimer_cascade();
+
+        if(!(g_occupied[0] & (1ULL << index))) {
+            // Nothing due: jump to the next busy slot or the next wrap, at most past now
+            uint64_t ahead = g_occupied[0] >> index;
+            uint32_t step = (ahead != 0) ? (uint32_t)__builtin_ctzll(ahead) : SWTIMER_SLOTS - index;
+            uint32_t left = now_ms - g_wheel_time + 1U;
+            g_wheel_time += (step < left) ? step : left;
+            continue;
+        }
+
+        // The tick advances first: timers started by the callbacks for now
+        // go into the next slot instead of the one being emptied
+        swtimer_t *expired;
+        swtimer_take(0, index, &expired);
+        g_wheel_time++;
+
+        while(expired != NULL) {
+            swtimer_t *timer = expired;
+            swtimer_unlink(timer);
+            if(timer->period_ms != 0) {
+                timer->expires += timer->period_ms;
+                // Periods missed while the loop was stalled are dropped
+                if(systick_deadline_reached(timer->expires, now_ms))
+                    timer->expires = now_ms + timer->period_ms;
+                swtimer_link(timer);
+            }
+            timer->callback(timer);
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t swtimer_time_to_next(uint32_t now_ms)
+{
+    uint32_t best = SWTIMER_NONE;   // Ticks after g_wheel_time
+
+    // Level 0: the slot processed at g_wheel_time + k is (g_wheel_time + k) % 64
+    if(g_occupied[0] != 0)
+        best = (uint32_t)__builtin_ctzll(swtimer_rotate(g_occupied[0], g_wheel_time));
+
+    // Higher levels: a slot is re-filed at the first boundary of its range
+    for(uint32_t level = 1; level < SWTIMER_LEVELS; level++) {
+        if(g_occupied[level] == 0)
+            continue;
+        uint32_t shift = SWTIMER_SHIFT(level);
+        uint32_t boundary = (g_wheel_time >> shift) + ((g_wheel_time & ((1UL << shift) - 1U)) != 0);
+        uint32_t k = (uint32_t)__builtin_ctzll(swtimer_rotate(g_occupied[level], boundary));
+        uint32_t offset = ((boundary + k) << shift) - g_wheel_time;
+        if(offset < best)
+            best = offset;
+    }
+
+    if(best == SWTIMER_NONE)
+        return SWTIMER_NONE;
+    return systick_time_left(g_wheel_time + best, now_ms);
+}
@@ -18,3 +18,17 @@ void syscfg_exti_map(uint8_t GPIO_port, uint8_t pin)
     // Set the port code into the cleared bits
     SYSCFG->EXTICR[reg_index] = (GPIO_port << shift_amount);
 }
+
+void syscfg_i2c_fast_mode_plus(uint8_t i2c_number, bool enable)
+{
+    if(i2c_number < 1 || i2c_number > 3)
+        return;
+
+    rcc_sys_power_clock_enable();
+
+    uint32_t bit = 1U << (SYSCFG_CFGR1_I2C1_FMP_Pos + i2c_number - 1);
+    if(enable)
+        SYSCFG->CFGR1 |= bit;
+    else
+        SYSCFG->CFGR1 &= ~bit;
+}
@@ -1,10 +1,15 @@
 #include "systick.h"
+#include "placement.h"
+#include "trace.h"
+#include "scb.h"
 
 // This global variable holds the system tick count.
 // It is declared as 'volatile' because it is modified in an ISR and read
 // in the main application code. This prevents the compiler from making
 // unsafe optimizations.
-static volatile uint32_t tick_counter = 0;
+static volatile uint32_t tick_counter SRAM2_BSS;
+// Upper 32 bits of the tick count, incremented after tick_counter wraps
+static volatile uint32_t tick_epoch SRAM2_BSS;
 
 void systick_init(uint32_t ticks)
 {
@@ -32,21 +37,60 @@ uint32_t systick_getTick(void)
 	return tick_counter;
 }
 
+uint64_t systick_get_ms64(void)
+{
+	uint32_t epoch, ticks;
+	do {
+		epoch = tick_epoch;
+		ticks = tick_counter;
+	} while(epoch != tick_epoch);
+	return ((uint64_t)epoch << 32) | ticks;
+}
+
+uint64_t systick_get_us(void)
+{
+	uint32_t load = SYSTICK->LOAD + 1;
+	uint64_t ms;
+	uint32_t val;
+	bool pending;
+	do {
+		ms = systick_get_ms64();
+		val = SYSTICK->VAL;
+		// Wrapped, but the handler has not run yet: re-read VAL after the reload
+		pending = (SCB->ICSR & SCB_ICSR_PENDSTSET) != 0;
+		if(pending)
+			val = SYSTICK->VAL;
+	} while(ms != systick_get_ms64());
+
+	if(pending)
+		ms++;
+	return ms * 1000U + (uint64_t)(load - 1 - val) * 1000U / load;
+}
+
 void systick_delay_ms(uint32_t time)
 {
 	// Record the start time of the delay
     uint32_t start_tick = systick_getTick();
-    while(systick_getTick() - start_tick < time)
+    while(!systick_elapsed(start_tick, time))
         ;
     return ;
 }
 
-void systick_reset(void)
+void systick_advance(uint32_t ms)
 {
-	tick_counter = 0;
+	uint32_t ticks = tick_counter;
+	tick_counter = ticks + ms;
+	if(ticks + ms < ticks)
+		tick_epoch++;
 }
 
-void SysTick_Handler(void)
+// Runs from SRAM2: every millisecond, without flash wait states
+RAMFUNC void SysTick_Handler(void)
 {
-	tick_counter++;
+	// Low word first: see systick_get_ms64()
+	if(++tick_counter == 0)
+		tick_epoch++;
+#if TRACE_SYSTICK
+	TRACE_INSTANT_EVENT(TRACE_EV_SYSTICK_ISR, tick_counter);
+#endif
 }
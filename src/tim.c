@@ -1,6 +1,6 @@
 #include "tim.h"
 
-gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
+gpio_config_t timer_base_pin_config(uint8_t number, timer_channel_t channel)
 {
     gpio_config_t config = {
         .port   = NULL,
@@ -11,7 +11,17 @@ gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
         .alt_func = 0
     };
 
-    if(Timer == TIM2)
+    switch (number) {
+    case 1:
+        config.alt_func = 1;    // All TIM1 channels use AF1
+        switch (channel) {
+        case TIM_CHANNEL1: config.port = GPIOA; config.pin = 8;  break;   // Options: PA8, PE9.
+        case TIM_CHANNEL2: config.port = GPIOA; config.pin = 9;  break;   // Options: PA9, PE11.
+        case TIM_CHANNEL3: config.port = GPIOA; config.pin = 10; break;   // Options: PA10, PE13.
+        case TIM_CHANNEL4: config.port = GPIOA; config.pin = 11; break;   // Options: PA11, PE14.
+        }
+        break;
+    case 2:
         config.alt_func = 1;    // All TIM2 channels use AF1
         switch (channel) {
         case TIM_CHANNEL1:      // Options: PA0, PA5, PA15. Using PA5 (Nucleo Green LED).
@@ -27,7 +37,8 @@ gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
             config.port = GPIOB; config.pin = 11;
             break;
         }
-    if(Timer == TIM3)
+        break;
+    case 3:
         config.alt_func = 2;    // All TIM3 channels use AF2
         switch (channel) {
         case TIM_CHANNEL1:      // Options: PA6, PB4, PC6. Using PA6.
@@ -43,11 +54,12 @@ gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
             config.port = GPIOB; config.pin = 1;
             break;
         }
-    if(Timer == TIM4)
+        break;
+    case 4:
         config.alt_func = 2;    // All TIM4 channels use AF2
         switch (channel) {
         case TIM_CHANNEL1:      // Options: PB6, PD12. Using PB6.
-            config.port = GPIOA; config.pin = 6;
+            config.port = GPIOB; config.pin = 6;
             break;
         case TIM_CHANNEL2:      // Options: PB7, PD13. Using PB7.
             config.port = GPIOB; config.pin = 7;
@@ -59,7 +71,8 @@ gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
             config.port = GPIOB; config.pin = 9;
             break;
         }
-    if(Timer == TIM5)
+        break;
+    case 5:
         config.alt_func = 2;    // All TIM5 channels use AF2
         switch (channel) {
         case TIM_CHANNEL1:      // Options: PA0, PH10. Using PA0.
@@ -75,47 +88,157 @@ gpio_config_t timer_get_pin_config(void *Timer, timer_channel_t channel)
             config.port = GPIOA; config.pin = 3;
             break;
         }
+        break;
+    case 8:
+        config.alt_func = 3;    // All TIM8 channels use AF3
+        switch (channel) {
+        case TIM_CHANNEL1: config.port = GPIOC; config.pin = 6; break;    // Only PC6.
+        case TIM_CHANNEL2: config.port = GPIOC; config.pin = 7; break;    // Only PC7.
+        case TIM_CHANNEL3: config.port = GPIOC; config.pin = 8; break;    // Only PC8.
+        case TIM_CHANNEL4: config.port = GPIOC; config.pin = 9; break;    // Only PC9.
+        }
+        break;
+    case 15:
+        config.alt_func = 14;   // TIM15-17 channels use AF14
+        switch (channel) {
+        case TIM_CHANNEL1:      // Options: PA2, PB14. Using PB14 (PA2 is USART2_TX).
+            config.port = GPIOB; config.pin = 14;
+            break;
+        case TIM_CHANNEL2:      // Options: PA3, PB15. Using PB15 (PA3 is USART2_RX).
+            config.port = GPIOB; config.pin = 15;
+            break;
+        default:
+            break;
+        }
+        break;
+    case 16:
+        config.alt_func = 14;
+        if(channel == TIM_CHANNEL1) {   // Options: PA6, PB8. Using PB8.
+            config.port = GPIOB; config.pin = 8;
+        }
+        break;
+    case 17:
+        config.alt_func = 14;
+        if(channel == TIM_CHANNEL1) {   // Options: PA7, PB9. Using PB9.
+            config.port = GPIOB; config.pin = 9;
+        }
+        break;
+    }
 
     return config;
 }
 
-void timer_clock_enable(void *Timer)
+gpio_config_t timer_base_complementary_pin_config(uint8_t number, timer_channel_t channel)
 {
-    if(Timer == TIM1) rcc_tim_clock_enable(1);
-    else if(Timer == TIM2) rcc_tim_clock_enable(2);
-    else if(Timer == TIM3) rcc_tim_clock_enable(3);
-    else if(Timer == TIM4) rcc_tim_clock_enable(4);
-    else if(Timer == TIM5) rcc_tim_clock_enable(5);
-    else if(Timer == TIM6) rcc_tim_clock_enable(6);
-    else if(Timer == TIM7) rcc_tim_clock_enable(7);
-    else if(Timer == TIM8) rcc_tim_clock_enable(8);
-    else if(Timer == TIM15) rcc_tim_clock_enable(15);
-    else if(Timer == TIM16) rcc_tim_clock_enable(16);
-    else if(Timer == TIM17) rcc_tim_clock_enable(17);
-    else return;
+    gpio_config_t config = timer_base_pin_config(number, channel);
+    config.port = NULL;
+
+    switch (number) {
+    case 1:
+        switch (channel) {
+        case TIM_CHANNEL1: config.port = GPIOB; config.pin = 13; break;   // Options: PA7, PB13.
+        case TIM_CHANNEL2: config.port = GPIOB; config.pin = 14; break;   // Options: PB0, PB14.
+        case TIM_CHANNEL3: config.port = GPIOB; config.pin = 15; break;   // Options: PB1, PB15.
+        default: break;
+        }
+        break;
+    case 8:
+        switch (channel) {
+        case TIM_CHANNEL1: config.port = GPIOA; config.pin = 7; break;    // Options: PA5, PA7.
+        case TIM_CHANNEL2: config.port = GPIOB; config.pin = 0; break;    // Options: PB0, PB14.
+        case TIM_CHANNEL3: config.port = GPIOB; config.pin = 1; break;    // Options: PB1, PB15.
+        default: break;
+        }
+        break;
+    }
+    return config;
 }
 
-void pwm_init(pwm_config_t *config)
+gpio_config_t timer_base_break_pin_config(uint8_t number)
 {
-    GeneralPurpose_Timer_t *TIMx = config->pwmTimer;
+    gpio_config_t config = timer_base_pin_config(number, TIM_CHANNEL1);
+    config.port = NULL;
 
-    // 1. Enable Timer Clock
-    timer_clock_enable(TIMx);
+    switch (number) {
+    case 1:     // Options: PA6, PB12. Using PB12.
+        config.port = GPIOB; config.pin = 12;
+        break;
+    case 8:     // Options: PA6, PB7. Using PA6.
+        config.port = GPIOA; config.pin = 6;
+        break;
+    }
+    return config;
+}
+
+/**
+ * @brief Returns the NVIC line serving the update (and, for general purpose
+ *        timers, capture) interrupt of a timer.
+ */
+static IRQn_t timer_irqn(uint8_t number)
+{
+    switch (number) {
+        case 1:  return TIM1_UP_IRQn;
+        case 2:  return TIM2_IRQn;
+        case 3:  return TIM3_IRQn;
+        case 4:  return TIM4_IRQn;
+        case 5:  return TIM5_IRQn;
+        case 6:  return TIM6_DACUNDER;
+        case 7:  return TIM7_IRQn;
+        case 8:  return TIM8_UP_IRQn;
+        case 15: return TIM1_BRK_IRQn;  // Shared with TIM1 break
+        case 16: return TIM1_UP_IRQn;   // Shared with TIM1 update
+        case 17: return TIM1_TRG_COM_IRQn;
+        default: return (IRQn_t)-100;   // Rejected by the nvic driver
+    }
+}
+
+void timer_base_periodic_init(Basic_Timer_t *TIMx, uint8_t number, uint32_t prescaler, uint32_t period)
+{
+    if(number == 0 || prescaler == 0 || period == 0)
+        return;
+
+    rcc_tim_clock_enable(number);
+
+    TIMx->CR1 &= ~TIM_CR1_CEN;
+    TIMx->PSC = prescaler - 1;
+    TIMx->ARR = period - 1;
+    TIMx->CR1 |= TIM_CR1_ARPE;
+
+    // Load PSC/ARR now, then drop the update flag raised by UG
+    TIMx->EGR = TIM_EGR_UG;
+    TIMx->SR = ~TIM_SR_UIF;
+
+    TIMx->DIER |= TIM_DIER_UIE;
+    nvic_irq_enable(timer_irqn(number));
+}
+
+bool timer_base_update_pending(Basic_Timer_t *TIMx)
+{
+    if(!(TIMx->SR & TIM_SR_UIF))
+        return false;
+    TIMx->SR = ~TIM_SR_UIF;     // rc_w0: writing 1 to the other flags leaves them untouched
+    return true;
+}
 
-    // 2. Get the complete GPIO configuration for the required timer and channel
-    gpio_config_t pin_config = timer_get_pin_config(TIMx, config->pwmChannel);
+/**
+ * @brief Configures the GPIO, compare mode and output enable of one PWM channel.
+ *
+ * CCMR1/CCMR2/CCER share the same layout and offsets in the advanced and
+ * general purpose timers, so the caller passes their addresses.
+ *
+ * @return 0 on success, -1 if the timer/channel has no pin mapping.
+ */
+static int pwm_channel_setup(uint8_t number, volatile uint32_t *ccmr1, volatile uint32_t *ccer, timer_channel_t channel)
+{
+    // Get the complete GPIO configuration for the required timer and channel
+    gpio_config_t pin_config = timer_base_pin_config(number, channel);
     if(pin_config.port == NULL)
-        return; // Exit if no valid pin mapping found
+        return -1; // Exit if no valid pin mapping found
     // Initialize the GPIO pin using the retrieved configuration
-    gpio_init(&pin_config); // This is your new, powerful GPIO init function
+    gpio_init(&pin_config);
 
-    // 3. Configure Timer Base: Prescaler and Period
-    TIMx->PSC = config->prescaler - 1;
-    TIMx->ARR = config->period - 1;
-
-    // 4. Configure PWM Channel
-    volatile uint32_t *ccmr_reg = (config->pwmChannel < TIM_CHANNEL3) ? &TIMx->CCMR1 : &TIMx->CCMR2;
-    uint8_t shift = (config->pwmChannel % 2) * 8;   // 0 for ch1/3, 8 for ch2/4
+    volatile uint32_t *ccmr_reg = &ccmr1[channel / 2];  // CCMR1 for ch1/2, CCMR2 for ch3/4
+    uint8_t shift = (channel % 2) * 8;   // 0 for ch1/3, 8 for ch2/4
 
     // Set PWM Mode 1 (OCxM bits = 110) and enable Preload (OCxPE bit = 1)
     // Preload enable is crucial for glitch-free duty cycle updates.
@@ -123,23 +246,143 @@ void pwm_init(pwm_config_t *config)
     *ccmr_reg |= (0x6U << (4 + shift));   // OCxM = 110 for PWM Mode 1
     *ccmr_reg |= (0x1U << (3 + shift));   // OCxPE = 1 (Output Compare Preload Enable)
 
-    // 5. Enable the specific PWM Channel Output
-    TIMx->CCER |= (0x1U << (4 * config->pwmChannel));
+    // Enable the specific PWM Channel Output
+    *ccer |= (0x1U << (4 * channel));
+    return 0;
+}
+
+void pwm_init(pwm_config_t *config)
+{
+    GeneralPurpose_Timer_t *TIMx = config->pwmTimer;
 
-    // 6. Main Output Enable and Counter Start
+    // 1. Enable Timer Clock
+    timer_clock_enable(TIMx);
+
+    // 2. Configure Timer Base: Prescaler and Period
+    TIMx->PSC = config->prescaler - 1;
+    TIMx->ARR = config->period - 1;
+
+    // 3. Configure PWM Channel: pin, PWM mode 1 with preload and output enable
+    if(pwm_channel_setup(timer_number(TIMx), &TIMx->CCMR1, &TIMx->CCER, config->pwmChannel) != 0)
+        return;
+
+    // 4. Main Output Enable and Counter Start
     TIMx->CR1 |= (0x1U << 7);   // ARPE: Auto-reload preload enable
     TIMx->EGR |= (0x1U << 0);   // UG: Generate and update event to load PSC and ARR
     TIMx->CR1 |= (0x1U << 0);   // CEN: Counter enable. Starts the timer.
 }
 
+/**
+ * @brief Finds the DMA channel and request that serve the update event of a timer.
+ * @return 1 on success, 0 if the timer has no update DMA request.
+ */
+static int timer_get_update_dma(uint8_t number, dma_t **dma, uint8_t *channel, uint8_t *request)
+{
+    switch (number) {
+        case 2: *dma = DMA1; *channel = 2; *request = 4; return 1;
+        case 3: *dma = DMA1; *channel = 3; *request = 5; return 1;
+        case 4: *dma = DMA1; *channel = 7; *request = 6; return 1;
+        case 5: *dma = DMA2; *channel = 2; *request = 5; return 1;
+        default: return 0;
+    }
+}
+
+int pwm_waveform_start(const pwm_waveform_config_t *config)
+{
+    if(config == NULL || config->table == NULL)
+        return -1;
+    if(config->channels < 1 || config->channels > 4 || config->frames == 0)
+        return -1;
+
+    uint32_t items = (uint32_t)config->frames * config->channels;
+    if(items > 0xFFFF)
+        return -1;
+
+    GeneralPurpose_Timer_t *TIMx = config->pwmTimer;
+    dma_t *dma;
+    uint8_t dma_channel, dma_request;
+    if(!timer_get_update_dma(timer_number(TIMx), &dma, &dma_channel, &dma_request))
+        return -1;
+
+    // 1. Timer base, exactly as in pwm_init
+    timer_clock_enable(TIMx);
+    TIMx->CR1 &= ~(0x1U << 0);  // Stop the counter while reconfiguring
+    TIMx->PSC = config->prescaler - 1;
+    TIMx->ARR = config->period - 1;
+
+    // 2. CH1..CHn in PWM mode 1, preloaded with the first frame of the table
+    volatile uint32_t *ccr = &TIMx->CCR1;
+    for(uint8_t ch = 0; ch < config->channels; ch++) {
+        if(pwm_channel_setup(timer_number(TIMx), &TIMx->CCMR1, &TIMx->CCER, (timer_channel_t)ch) != 0)
+            return -1;
+        ccr[ch] = config->table[ch];
+    }
+
+    // 3. DMA: table -> DMAR, one item per request, restarting at the end of the table.
+    // DMAR is a 32-bit register, the 16-bit table items are zero-extended by the DMA.
+    dma_config_t dma_config = {
+        .dma          = dma,
+        .channel      = dma_channel,
+        .request      = dma_request,
+        .periph_addr  = &TIMx->DMAR,
+        .mem_addr     = config->table,
+        .count        = (uint16_t)items,
+        .direction    = DMA_DIR_MEM_TO_PERIPH,
+        .periph_width = DMA_WIDTH_32BIT,
+        .mem_width    = DMA_WIDTH_16BIT,
+        .priority     = DMA_PRIORITY_HIGH,
+        .circular     = true
+    };
+    if(dma_init(&dma_config) != 0)
+        return -1;
+    dma_enable(dma, dma_channel);
+
+    // 4. Burst: every update event issues DBL+1 requests, written to CCR1..CCRn through DMAR
+    TIMx->DCR = ((uint32_t)(config->channels - 1) << TIM_DCR_DBL_Pos) | (TIM_DCR_DBA_CCR1 << TIM_DCR_DBA_Pos);
+    TIMx->DIER |= TIM_DIER_UDE;
+
+    // 5. Every update event makes the preloaded frame active, then its burst
+    //    preloads the next one. The first UG loads PSC/ARR, makes frame 0
+    //    active and bursts frame 0 again; once that burst is done the second
+    //    UG bursts frame 1, so frame k plays in period k from the start.
+    TIMx->CR1 |= (0x1U << 7);   // ARPE: Auto-reload preload enable
+    TIMx->EGR = TIM_EGR_UG;
+    if(config->frames > 1) {
+        while(dma_get_remaining(dma, dma_channel) > items - config->channels)
+            ;
+        TIMx->EGR = TIM_EGR_UG;
+    }
+    TIMx->CR1 |= (0x1U << 0);   // CEN: Counter enable. Starts the timer.
+    return 0;
+}
+
+void pwm_waveform_stop(GeneralPurpose_Timer_t *TIMx)
+{
+    dma_t *dma;
+    uint8_t dma_channel, dma_request;
+    if(!timer_get_update_dma(timer_number(TIMx), &dma, &dma_channel, &dma_request))
+        return;
+
+    // The outputs keep the last compare values written by the DMA
+    TIMx->DIER &= ~TIM_DIER_UDE;
+    dma_disable(dma, dma_channel);
+}
+
+/**
+ * @brief Converts a duty cycle in percent into a compare value for the given ARR.
+ */
+static uint32_t pwm_compare_value(uint32_t arr, int dutyCycle)
+{
+    // The period is the value in ARR + 1
+    return ((arr + 1) * dutyCycle) / 100;
+}
+
 void pwm_set_dutyCycle(GeneralPurpose_Timer_t *TIMx, timer_channel_t channel, int dutyCycle)
 {
     if(dutyCycle < 0 || dutyCycle > 100)
         return;
 
-    // The period is the value in ARR + 1
-    uint32_t period = TIMx->ARR;
-    uint32_t crrValue = ((period + 1) * dutyCycle) / 100;
+    uint32_t crrValue = pwm_compare_value(TIMx->ARR, dutyCycle);
 
     switch (channel) {
         case TIM_CHANNEL1: TIMx->CCR1 = crrValue; break;
@@ -149,3 +392,169 @@ void pwm_set_dutyCycle(GeneralPurpose_Timer_t *TIMx, timer_channel_t channel, in
         default: return;
     }
 }
+
+/**
+ * @brief Encodes a dead time, in timer clock ticks, into the BDTR DTG field.
+ *
+ * DTG[7:5] = 0xx: DT = DTG[6:0] ticks (0-127)
+ * DTG[7:5] = 10x: DT = (64 + DTG[5:0]) * 2 ticks (128-254)
+ * DTG[7:5] = 110: DT = (32 + DTG[4:0]) * 8 ticks (256-504)
+ * DTG[7:5] = 111: DT = (32 + DTG[4:0]) * 16 ticks (512-1008)
+ * Values between steps are rounded up; larger values saturate.
+ */
+static uint8_t timer_dead_time_encode(uint32_t ticks)
+{
+    if(ticks <= 127)
+        return (uint8_t)ticks;
+    if(ticks <= 254)
+        return 0x80 | (((ticks + 1) / 2) - 64);
+    if(ticks <= 504)
+        return 0xC0 | (((ticks + 7) / 8) - 32);
+    if(ticks <= 1008)
+        return 0xE0 | (((ticks + 15) / 16) - 32);
+    return 0xFF;
+}
+
+int adv_pwm_init(const adv_pwm_config_t *config)
+{
+    if(config == NULL)
+        return -1;
+
+    Advanced_Timer_t *TIMx = config->pwmTimer;
+    uint8_t number = timer_number(TIMx);
+    if(number != 1 && number != 8)
+        return -1;
+    if(config->complementary && config->pwmChannel == TIM_CHANNEL4)
+        return -1;  // CH4 has no complementary output
+
+    // 1. Enable Timer Clock and configure the time base
+    rcc_tim_clock_enable(number);
+    TIMx->CR1 &= ~TIM_CR1_CEN;
+    TIMx->PSC = config->prescaler - 1;
+    TIMx->ARR = config->period - 1;
+
+    // 2. CHx in PWM mode 1 with preload
+    if(pwm_channel_setup(timer_number(TIMx), &TIMx->CCMR1, &TIMx->CCER, config->pwmChannel) != 0)
+        return -1;
+
+    // 3. Complementary output CHxN
+    if(config->complementary) {
+        gpio_config_t pin_config = timer_get_complementary_pin_config(TIMx, config->pwmChannel);
+        if(pin_config.port == NULL)
+            return -1;
+        gpio_init(&pin_config);
+        TIMx->CCER |= (0x1U << (4 * config->pwmChannel + 2));   // CCxNE
+    }
+
+    // 4. Break input
+    if(config->break_enable) {
+        gpio_config_t pin_config = timer_get_break_pin_config(TIMx);
+        if(pin_config.port == NULL)
+            return -1;
+        pin_config.pupd = config->break_active_high ? GPIO_PUPD_PULLDOWN : GPIO_PUPD_PULLUP;
+        gpio_init(&pin_config);
+    }
+
+    // 5. Break and dead-time. OSSR/OSSI keep the outputs driven to their idle
+    //    level when disabled instead of floating.
+    uint32_t ticks = (uint32_t)(((uint64_t)config->dead_time_ns * config->timer_clock_hz) / 1000000000ULL);
+    uint32_t bdtr = timer_dead_time_encode(ticks) | TIM_BDTR_OSSR | TIM_BDTR_OSSI;
+    if(config->break_enable) {
+        bdtr |= TIM_BDTR_BKE;
+        if(config->break_active_high)
+            bdtr |= TIM_BDTR_BKP;
+    }
+    TIMx->BDTR = bdtr;
+
+    // 6. Load PSC/ARR, enable the main output and start the counter
+    TIMx->CR1 |= TIM_CR1_ARPE;
+    TIMx->EGR = TIM_EGR_UG;
+    TIMx->SR = ~TIM_SR_BIF;
+    TIMx->BDTR |= TIM_BDTR_MOE;
+    TIMx->CR1 |= TIM_CR1_CEN;
+    return 0;
+}
+
+void adv_pwm_set_dutyCycle(Advanced_Timer_t *TIMx, timer_channel_t channel, int dutyCycle)
+{
+    if(dutyCycle < 0 || dutyCycle > 100 || channel > TIM_CHANNEL4)
+        return;
+
+    (&TIMx->CCR1)[channel] = pwm_compare_value(TIMx->ARR, dutyCycle);
+}
+
+void adv_pwm_break_clear(Advanced_Timer_t *TIMx)
+{
+    // MOE is cleared by hardware on a break; it can only be set again once
+    // the break input is inactive.
+    TIMx->SR = ~TIM_SR_BIF;
+    TIMx->BDTR |= TIM_BDTR_MOE;
+}
+
+/**
+ * @brief Common input capture setup for timers sharing the CCMRx/CCER layout.
+ * @param max_channel Highest channel available on this timer.
+ */
+static int timer_ic_setup(Basic_Timer_t *TIMx, uint8_t number, volatile uint32_t *ccmr1, volatile uint32_t *ccer,
+                          timer_channel_t max_channel, const timer_ic_config_t *config)
+{
+    timer_channel_t channel = config->channel;
+    if(number == 0 || channel > max_channel || config->prescaler == 0 || config->prescaler > TIM_PRESCALER_MAX)
+        return -1;
+
+    gpio_config_t pin_config = timer_base_pin_config(number, channel);
+    if(pin_config.port == NULL)
+        return -1;
+
+    // 1. Clock and pin
+    rcc_tim_clock_enable(number);
+    gpio_init(&pin_config);
+
+    // 2. Time base. A zero period selects the full counter range.
+    TIMx->CR1 &= ~TIM_CR1_CEN;
+    TIMx->PSC = config->prescaler - 1;
+    TIMx->ARR = (config->period != 0) ? config->period - 1 : 0xFFFFFFFFU;
+
+    // 3. CCxS = 01 (ICx mapped on TIx), no input prescaler, digital filter
+    volatile uint32_t *ccmr_reg = &ccmr1[channel / 2];
+    uint8_t shift = (channel % 2) * 8;
+    *ccmr_reg &= ~(0xFFU << shift);
+    *ccmr_reg |= (0x1U << shift) | ((config->filter & 0xFU) << (4 + shift));
+
+    // 4. Edge polarity (CCxP/CCxNP) and capture enable (CCxE)
+    uint8_t ccer_shift = 4 * channel;
+    *ccer &= ~(0xBU << ccer_shift);
+    switch (config->edge) {
+        case TIM_IC_RISING:     break;
+        case TIM_IC_FALLING:    *ccer |= (0x2U << ccer_shift); break;
+        case TIM_IC_BOTH_EDGES: *ccer |= (0xAU << ccer_shift); break;
+    }
+    *ccer |= (0x1U << ccer_shift);
+
+    // 5. Capture interrupt (CCxIE)
+    if(config->interrupt) {
+        TIMx->SR = ~(0x1U << (channel + 1));
+        TIMx->DIER |= (0x1U << (channel + 1));
+        nvic_irq_enable(timer_irqn(number));
+    }
+
+    // 6. Load PSC/ARR and start counting
+    TIMx->EGR = TIM_EGR_UG;
+    TIMx->SR = ~TIM_SR_UIF;
+    TIMx->CR1 |= TIM_CR1_CEN;
+    return 0;
+}
+
+int gp_timer_input_capture_init(GeneralPurpose_Timer_t *TIMx, const timer_ic_config_t *config)
+{
+    if(config == NULL)
+        return -1;
+    return timer_ic_setup(TIMER_BASE(TIMx), timer_number(TIMx), &TIMx->CCMR1, &TIMx->CCER, TIM_CHANNEL4, config);
+}
+
+int tim15_input_capture_init(GeneralPurpose_Timer_15_t *TIMx, const timer_ic_config_t *config)
+{
+    if(config == NULL)
+        return -1;
+    return timer_ic_setup(TIMER_BASE(TIMx), timer_number(TIMx), &TIMx->CCMR1, &TIMx->CCER, TIM_CHANNEL2, config);
+}
@@ -0,0 +1,61 @@
+#include "trace.h"
+#include "placement.h"
+#include "rcc.h"
+
+trace_entry_t g_trace_buffer[TRACE_SIZE] SRAM2_BSS;
+uint32_t g_trace_head SRAM2_BSS;
+volatile bool g_trace_enabled = false;
+
+void trace_start(void)
+{
+    g_trace_enabled = false;
+    g_trace_head = 0;
+    g_trace_enabled = true;
+}
+
+void trace_stop(void)
+{
+    g_trace_enabled = false;
+}
+
+static void trace_send_hex(usart_t *usart_port, uint32_t value, uint8_t digits)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for(int8_t shift = (int8_t)((digits - 1) * 4); shift >= 0; shift -= 4)
+        usart_send_char(usart_port, hex[(value >> shift) & 0xFU]);
+}
+
+void trace_dump(usart_t *usart_port)
+{
+    bool was_enabled = g_trace_enabled;
+    g_trace_enabled = false;
+
+    // 1. Only the newest TRACE_SIZE events are still in the ring
+    uint32_t head = g_trace_head;
+    uint32_t count = (head < TRACE_SIZE) ? head : TRACE_SIZE;
+
+    usart_send_string(usart_port, "TRACE ");
+    usart_send_uint(usart_port, rcc_get_clocks()->hclk_hz);
+    usart_send_char(usart_port, ' ');
+    usart_send_uint(usart_port, count);
+    usart_send_string(usart_port, "\r\n");
+
+    // 2. Oldest first
+    for(uint32_t i = head - count; i != head; i++) {
+        const trace_entry_t *entry = &g_trace_buffer[i & (TRACE_SIZE - 1U)];
+        trace_send_hex(usart_port, entry->cycles, 8);
+        usart_send_char(usart_port, ' ');
+        trace_send_hex(usart_port, entry->id, 4);
+        usart_send_char(usart_port, ' ');
+        trace_send_hex(usart_port, entry->arg, 4);
+        usart_send_string(usart_port, "\r\n");
+    }
+    usart_send_string(usart_port, "TRACE END\r\n");
+
+    // 3. Events recorded from now on follow the dump
+    if(was_enabled) {
+        g_trace_head = 0;
+        g_trace_enabled = true;
+    }
+}
@@ -1,4 +1,5 @@
 #include "uart.h"
+#include "trace.h"
 
 int usart_number(usart_t *USARTx)
 {
@@ -7,6 +8,7 @@ int usart_number(usart_t *USARTx)
     else if(USARTx == USART3) return 3;
     else if(USARTx == UART_4) return 4;
     else if(USARTx == UART_5) return 5;
+    else if(USARTx == LPUART1) return 6;
     else return 0xF;
 }
 
@@ -61,6 +63,13 @@ static int get_usart_pin_configs(usart_t *usart_port, gpio_config_t *tx_conf, gp
         tx_conf->alt_func = rx_conf->alt_func = 8;
         return 1;
     }
+    if (usart_port == LPUART1) {        // Options: TX = PB11, PC1, PG7; RX = PB10, PC0, PG8
+        tx_conf->port = GPIOC; tx_conf->pin = 1;
+        rx_conf->port = GPIOC; rx_conf->pin = 0;
+
+        tx_conf->alt_func = rx_conf->alt_func = 8;
+        return 1;
+    }
     
     // If no mapping is found
     return 0;
@@ -148,15 +157,11 @@ void usart_init(const usart_config_t *config, uint32_t pclk_freq)
     // 3. Configure the USART peripheral
     USARTx->CR1 &= ~USART_CR1_UE;                        // Disable USART first to allow configuration
 
-    // Ensure oversampling is by 16 for our baud rate calculation
-    //USARTx->CR1 &= ~(1U << 15); // Clear OVER8 bit
-
     // --- Disable hardware flow control ---
     //USARTx->CR3 &= ~((1U << 9) | (1U << 8)); // Clear CTSE and RTSE
 
-    // Set baud rate. BRR = PCLK / Baudrate.
-    // For an 80MHz clock with no APB prescaler, PCLK is 80MHz.
-    USARTx->BRR = pclk_freq / config->baudrate;
+    // Set baud rate. The oversampling mode is chosen from PCLK / Baudrate.
+    usart_set_baudrate(USARTx, pclk_freq, config->baudrate);
 
     usart_set_word_lenght(USARTx, config->word_lengt);
     usart_set_stop_bits(USARTx, config->stop_bits);
@@ -167,6 +172,72 @@ void usart_init(const usart_config_t *config, uint32_t pclk_freq)
     USARTx->CR1 |= USART_CR1_UE;
 }
 
+int usart_compute_brr(usart_t *USARTx, uint32_t pclk_freq, uint32_t baudrate, usart_brr_t *result)
+{
+    if(baudrate == 0 || result == NULL)
+        return -1;
+
+    // All the dividers are rounded to nearest instead of truncated
+    uint64_t scaled;
+    result->over8 = false;
+
+    if(USARTx == LPUART1) {
+        // LPUART: BRR = 256 * fck / baud, 0x300 <= BRR <= 0xFFFFF
+        scaled = 256ULL * pclk_freq;
+        result->brr = (uint32_t)((scaled + baudrate / 2) / baudrate);
+        if(result->brr < 0x300U || result->brr > 0xFFFFFU)
+            return -1;
+        result->actual_baud = (uint32_t)((scaled + result->brr / 2) / result->brr);
+    }
+    else if(pclk_freq / baudrate >= 16) {
+        // Oversampling by 16: BRR = fck / baud
+        scaled = pclk_freq;
+        uint32_t div = (uint32_t)((scaled + baudrate / 2) / baudrate);
+        if(div > 0xFFFFU)
+            return -1;
+        result->brr = div;
+        result->actual_baud = (uint32_t)((scaled + div / 2) / div);
+    }
+    else {
+        // Oversampling by 8: USARTDIV = 2 * fck / baud, BRR[2:0] = USARTDIV[3:0] >> 1.
+        // BRR[3] must stay clear, so the LSB of USARTDIV is lost: round fck / baud instead.
+        scaled = 2ULL * pclk_freq;
+        uint32_t div = 2U * ((pclk_freq + baudrate / 2) / baudrate);
+        if(div < 16U)
+            return -1;
+        result->over8 = true;
+        result->brr = (div & 0xFFF0U) | ((div & 0xFU) >> 1);
+        result->actual_baud = (uint32_t)((scaled + div / 2) / div);
+    }
+
+    int64_t diff = (int64_t)result->actual_baud - (int64_t)baudrate;
+    result->error_ppm = (int32_t)((diff * 1000000LL) / (int64_t)baudrate);
+    return 0;
+}
+
+int32_t usart_set_baudrate(usart_t *USARTx, uint32_t pclk_freq, uint32_t baudrate)
+{
+    usart_brr_t brr;
+    if(usart_compute_brr(USARTx, pclk_freq, baudrate, &brr) != 0)
+        return USART_BAUD_INVALID;
+
+    // BRR and OVER8 can only be written while the USART is disabled
+    uint32_t enabled = USARTx->CR1 & USART_CR1_UE;
+    if(enabled) {
+        while(!(USARTx->ISR & USART_ISR_TC));
+        USARTx->CR1 &= ~USART_CR1_UE;
+    }
+
+    if(brr.over8)
+        USARTx->CR1 |= USART_CR1_OVER8;
+    else
+        USARTx->CR1 &= ~USART_CR1_OVER8;
+    USARTx->BRR = brr.brr;
+
+    USARTx->CR1 |= enabled;
+    return brr.error_ppm;
+}
+
 void usart_rx_interrupt_enable(usart_t *USARTx)
 {
     // 1. Enable the RXNE interrupt within the USART peripheral
@@ -179,6 +250,7 @@ void usart_rx_interrupt_enable(usart_t *USARTx)
         case 3: nvic_irq_enable(USART3_IRQn); break;
         case 4: nvic_irq_enable(UART4_IRQn); break;
         case 5: nvic_irq_enable(UART5_IRQn); break;
+        case 6: nvic_irq_enable(LPUART1_IRQn); break;
     }
 }
 
@@ -191,10 +263,49 @@ void usart_send_char(usart_t *USARTx, char c)
     USARTx->TDR = (uint8_t)c;
 }
 
+bool usart_try_send_char(usart_t *USARTx, char c)
+{
+    if (!(USARTx->ISR & USART_ISR_TXE))
+        return false;
+
+    USARTx->TDR = (uint8_t)c;
+    return true;
+}
+
 void usart_send_string(usart_t *USARTx, const char *str)
 {
-    while(*str)
+    uint16_t count = 0;
+
+    TRACE_BEGIN_EVENT(TRACE_EV_USART_TX, 0);
+    while(*str) {
         usart_send_char(USARTx, *str++);
+        count++;
+    }
+    TRACE_END_EVENT(TRACE_EV_USART_TX, count);
+}
+
+void usart_send_uint(usart_t *USARTx, uint32_t value)
+{
+    char digits[10];
+    uint8_t count = 0;
+
+    // Digits come out least significant first
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+
+    while(count > 0)
+        usart_send_char(USARTx, digits[--count]);
+}
+
+void usart_send_hex(usart_t *USARTx, uint32_t value)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    usart_send_string(USARTx, "0x");
+    for(int8_t shift = 28; shift >= 0; shift -= 4)
+        usart_send_char(USARTx, hex[(value >> shift) & 0xFU]);
 }
 
 char usart_receive_char(usart_t *usart_port)
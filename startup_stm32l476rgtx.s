@@ -41,6 +41,15 @@ defined in linker script */
 .word  _sbss
 /* end address for the .bss section. defined in linker script */
 .word  _ebss
+/* start address for the initialization values of the .sram2 section.
+defined in linker script */
+.word  _sisram2
+/* start/end address for the .sram2 section. defined in linker script */
+.word  _ssram2
+.word  _esram2
+/* start/end address for the .sram2_bss section. defined in linker script */
+.word  _ssram2_bss
+.word  _esram2_bss
 
 /**
  * @brief  This is the code that gets called when the processor first
@@ -91,6 +100,52 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Copy the SRAM2 code and data (RAMFUNC, SRAM2_DATA) from flash */
+  ldr r0, =_ssram2
+  ldr r1, =_esram2
+  ldr r2, =_sisram2
+  movs r3, #0
+  b LoopCopySram2Init
+
+CopySram2Init:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopySram2Init:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopySram2Init
+
+/* Zero fill the SRAM2 bss segment. */
+  ldr r2, =_ssram2_bss
+  ldr r4, =_esram2_bss
+  movs r3, #0
+  b LoopFillZeroSram2
+
+FillZeroSram2:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopFillZeroSram2:
+  cmp r2, r4
+  bcc FillZeroSram2
+
+/* Paint the unused stack with STACK_PAINT_PATTERN (stack.h) for the
+   high-water mark. Nothing has been pushed yet, sp is still _estack */
+  ldr r2, =_sstack
+  mov r4, sp
+  ldr r3, =0xDEADBEEF
+  b LoopPaintStack
+
+PaintStack:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopPaintStack:
+  cmp r2, r4
+  bcc PaintStack
+
 /* Call static constructors */
   bl __libc_init_array
 /* Call the application's entry point.*/
@@ -103,16 +158,16 @@ LoopForever:
 
 /**
  * @brief  This is the code that gets called when the processor receives an
- *         unexpected interrupt.  This simply enters an infinite loop, preserving
- *         the system state for examination by a debugger.
+ *         unexpected interrupt.  It hands over to the fault handler
+ *         (src/fault.c), which records the exception number and state
+ *         for the next boot and resets the MCU.
  *
  * @param  None
  * @retval : None
 */
   .section .text.Default_Handler,"ax",%progbits
 Default_Handler:
-Infinite_Loop:
-  b Infinite_Loop
+  b fault_entry
   .size Default_Handler, .-Default_Handler
 
 /******************************************************************************
@@ -0,0 +1,83 @@
+#include "golden.h"
+#include "SSD1306/ssd1306.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PBM_HEADER_SIZE (SSD1306_PBM_SIZE - SSD1306_BUFFER_SIZE)
+#define PBM_ROW_BYTES   (SSD1306_WIDTH / 8)
+
+static bool pbm_pixel(const uint8_t *pbm, uint32_t x, uint32_t y)
+{
+    return (pbm[PBM_HEADER_SIZE + y * PBM_ROW_BYTES + x / 8] >> (7 - x % 8)) & 1U;
+}
+
+/**
+ * @brief Prints both images side by side: '#' lit, '.' dark, 'X' where they differ.
+ */
+static void golden_print_diff(const uint8_t *expected, const uint8_t *actual)
+{
+    fprintf(stderr, "%-*s   %s\n", SSD1306_WIDTH, "expected", "actual");
+    for(uint32_t y = 0; y < SSD1306_HEIGHT; y++) {
+        char line[2 * SSD1306_WIDTH + 4];
+        uint32_t n = 0;
+        for(uint32_t x = 0; x < SSD1306_WIDTH; x++)
+            line[n++] = pbm_pixel(expected, x, y) ? '#' : '.';
+        line[n++] = ' ';
+        line[n++] = ' ';
+        line[n++] = ' ';
+        for(uint32_t x = 0; x < SSD1306_WIDTH; x++) {
+            bool a = pbm_pixel(actual, x, y);
+            line[n++] = (a != pbm_pixel(expected, x, y)) ? 'X' : (a ? '#' : '.');
+        }
+        line[n] = '\0';
+        fprintf(stderr, "%s\n", line);
+    }
+}
+
+bool golden_check(const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.pbm", GOLDEN_DIR, name);
+
+    uint8_t actual[SSD1306_PBM_SIZE];
+    if(ssd1306_export_pbm(actual, sizeof(actual)) != SSD1306_PBM_SIZE) {
+        fprintf(stderr, "%s: export failed\n", name);
+        return false;
+    }
+
+    const char *update = getenv("GOLDEN_UPDATE");
+    if(update != NULL && strcmp(update, "1") == 0) {
+        FILE *f = fopen(path, "wb");
+        bool ok = f != NULL && fwrite(actual, 1, sizeof(actual), f) == sizeof(actual);
+        if(f != NULL)
+            ok &= fclose(f) == 0;
+        if(!ok)
+            fprintf(stderr, "%s: cannot write\n", path);
+        return ok;
+    }
+
+    uint8_t expected[SSD1306_PBM_SIZE];
+    FILE *f = fopen(path, "rb");
+    size_t size = (f != NULL) ? fread(expected, 1, sizeof(expected), f) : 0;
+    bool at_end = (f != NULL) && fgetc(f) == EOF;
+    if(f != NULL)
+        fclose(f);
+    if(size != sizeof(expected) || !at_end || memcmp(expected, actual, PBM_HEADER_SIZE) != 0) {
+        fprintf(stderr, "%s: missing or not a %ux%u PBM (run with GOLDEN_UPDATE=1 to create it)\n",
+                path, SSD1306_WIDTH, SSD1306_HEIGHT);
+        return false;
+    }
+
+    uint32_t differences = 0;
+    for(uint32_t y = 0; y < SSD1306_HEIGHT; y++) {
+        for(uint32_t x = 0; x < SSD1306_WIDTH; x++)
+            differences += pbm_pixel(expected, x, y) != pbm_pixel(actual, x, y);
+    }
+    if(differences == 0)
+        return true;
+
+    fprintf(stderr, "%s: %u pixel(s) differ from %s\n", name, differences, path);
+    golden_print_diff(expected, actual);
+    return false;
+}
@@ -0,0 +1,21 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <stdbool.h>
+
+/*
+ * Golden images of the SSD1306 screen buffer. Each reference is a binary PBM
+ * (ssd1306_export_pbm() output) in tests/golden/<name>.pbm, compared pixel
+ * for pixel. Run a test with GOLDEN_UPDATE=1 in the environment to write
+ * the references instead, and review them before committing: any PBM
+ * viewer shows them, lit pixels black on white.
+ */
+
+/**
+ * @brief Compares the screen buffer with a reference image.
+ * @param[in] name Image name, without directory or extension.
+ * @return true if every pixel matches. Differences are printed.
+ */
+bool golden_check(const char *name);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+/*
+ * Host stand-in for inc/irq.h. PRIMASK is a counter, so tests can check
+ * that every lock taken is released, and irq_wait() calls the test's
+ * host_irq_wait(), which plays the interrupt that ends the wait.
+ */
+
+extern uint32_t g_irq_locked;
+
+void host_irq_wait(void);
+
+static inline uint32_t irq_lock(void)
+{
+    return g_irq_locked++;
+}
+
+static inline void irq_unlock(uint32_t primask)
+{
+    g_irq_locked = primask;
+}
+
+static inline void irq_wait(void)
+{
+    host_irq_wait();
+}
+
+#endif
@@ -0,0 +1,20 @@
+#define _GNU_SOURCE
+#include "periph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+void periph_map(uint32_t base, uint32_t size)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = base & ~(page - 1);
+    size_t length = ((base + size - start) + page - 1) & ~(page - 1);
+
+    void *mem = mmap((void *)start, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(mem != (void *)start) {
+        fprintf(stderr, "cannot map peripheral memory at 0x%08lx\n", (unsigned long)start);
+        exit(1);
+    }
+}
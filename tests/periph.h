@@ -0,0 +1,16 @@
+#ifndef PERIPH_H
+#define PERIPH_H
+
+#include <stdint.h>
+
+/**
+ * @brief Backs a peripheral register block with zeroed host memory at its
+ *        STM32 address, so drivers that compare peripheral addresses
+ *        (timer_number(), dma_number()...) run unmodified.
+ * @param[in] base First address, rounded down to the page.
+ * @param[in] size Bytes to map.
+ * @note Exits the test if the address range cannot be mapped.
+ */
+void periph_map(uint32_t base, uint32_t size);
+
+#endif
@@ -0,0 +1,138 @@
+#include "ssd1306_panel.h"
+#include <string.h>
+
+#define CTRL_CONTINUATION   0x80U   // Co: another control byte follows the next byte
+#define CTRL_DATA           0x40U   // D/C#: display data
+
+static uint8_t g_ram[SSD1306_BUFFER_SIZE];
+static panel_stats_t g_stats;
+static uint32_t g_ticks;
+
+// Addressing window and pointer (horizontal addressing mode)
+static uint8_t g_col_start, g_col_end, g_page_start, g_page_end;
+static uint8_t g_col, g_page;
+
+// Command being decoded: opcode and the arguments still expected
+static uint8_t g_command;
+static uint8_t g_args[2];
+static uint8_t g_arg_count, g_args_needed;
+
+static uint8_t command_arguments(uint8_t command)
+{
+    switch(command) {
+        case 0x21: case 0x22:
+            return 2;
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void command_byte(uint8_t byte)
+{
+    if(g_args_needed == 0) {
+        g_command = byte;
+        g_arg_count = 0;
+        g_args_needed = command_arguments(byte);
+        return;
+    }
+    g_args[g_arg_count++] = byte;
+    if(g_arg_count < g_args_needed)
+        return;
+    g_args_needed = 0;
+
+    if(g_command == 0x21) {
+        g_col_start = g_col = g_args[0] & 0x7FU;
+        g_col_end = g_args[1] & 0x7FU;
+    } else if(g_command == 0x22) {
+        g_page_start = g_page = g_args[0] % SSD1306_PAGES;
+        g_page_end = g_args[1] % SSD1306_PAGES;
+    }
+}
+
+static void data_byte(uint8_t byte)
+{
+    g_ram[g_page * SSD1306_WIDTH + g_col] = byte;
+    g_stats.data_bytes++;
+    if(g_col++ == g_col_end) {
+        g_col = g_col_start;
+        g_page = (g_page == g_page_end) ? g_page_start : g_page + 1;
+    }
+}
+
+// Decoder state of the current transaction: control byte, then one byte (Co = 1) or the rest (Co = 0)
+static bool g_expect_control, g_is_data, g_single;
+static bool g_addressed;
+
+void panel_bus_start(uint8_t slave_addr)
+{
+    g_addressed = (slave_addr == SSD1306_I2C_ADDR);
+    if(!g_addressed)
+        return;
+    g_stats.transactions++;
+    g_stats.bus_bytes++;                    // Address byte
+    g_expect_control = true;
+    g_is_data = g_single = false;
+}
+
+void panel_bus_byte(uint8_t byte)
+{
+    if(!g_addressed)
+        return;
+    g_stats.bus_bytes++;
+    if(g_expect_control) {
+        g_single = (byte & CTRL_CONTINUATION) != 0;
+        g_is_data = (byte & CTRL_DATA) != 0;
+        g_expect_control = false;
+        return;
+    }
+    if(g_is_data)
+        data_byte(byte);
+    else
+        command_byte(byte);
+    g_expect_control = g_single;
+}
+
+#ifndef PANEL_REAL_I2C
+int i2c_master_write_prefixed(i2c_t *i2c_port, uint8_t slave_addr, const uint8_t *header, uint32_t header_len,
+                              const uint8_t *data, uint32_t size)
+{
+    if(i2c_port == NULL || slave_addr != SSD1306_I2C_ADDR)
+        return -1;
+    panel_bus_start(slave_addr);
+    for(uint32_t i = 0; i < header_len + size; i++)
+        panel_bus_byte((i < header_len) ? header[i] : data[i - header_len]);
+    return 0;
+}
+#endif
+
+uint32_t systick_getTick(void)
+{
+    // Every read moves time on, so the power-up wait of the driver ends
+    return g_ticks += 5U;
+}
+
+void panel_init(void)
+{
+    memset(g_ram, 0xA5, sizeof(g_ram));    // Power-up garbage, cleared by the driver
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_args_needed = 0;
+    ssd1306_init(I2C1);
+}
+
+const uint8_t *panel_ram(void)
+{
+    return g_ram;
+}
+
+panel_stats_t panel_stats(void)
+{
+    return g_stats;
+}
+
+bool panel_in_sync(void)
+{
+    return memcmp(g_ram, ssd1306_get_buffer(), SSD1306_BUFFER_SIZE) == 0;
+}
@@ -0,0 +1,54 @@
+#ifndef SSD1306_PANEL_H
+#define SSD1306_PANEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "SSD1306/ssd1306.h"
+
+/*
+ * Model of an SSD1306 controller behind the I2C bus, for the host builds of
+ * ssd1306.c. It provides i2c_master_write_prefixed() and systick_getTick(),
+ * decodes the control bytes and the addressing commands, and keeps the
+ * display RAM the driver has written, with the bus traffic it took.
+ *
+ * Built with PANEL_REAL_I2C, the test links src/i2c.c instead and feeds
+ * the bytes its simulated I2C peripheral puts on the bus to panel_bus_*().
+ */
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t data_bytes;        // Display RAM bytes written
+    uint32_t bus_bytes;         // Address, control and payload bytes on the wire
+} panel_stats_t;
+
+/**
+ * @brief Initializes the driver against the model, with a blank display RAM.
+ */
+void panel_init(void);
+
+/**
+ * @brief START condition and address byte of a write transaction.
+ */
+void panel_bus_start(uint8_t slave_addr);
+
+/**
+ * @brief One byte written after the address, acknowledged by the panel.
+ */
+void panel_bus_byte(uint8_t byte);
+
+/**
+ * @brief Display RAM, in the screen buffer layout (SSD1306_BUFFER_SIZE bytes).
+ */
+const uint8_t *panel_ram(void);
+
+/**
+ * @brief Bus traffic since panel_init().
+ */
+panel_stats_t panel_stats(void);
+
+/**
+ * @brief Checks that the display RAM matches the screen buffer.
+ */
+bool panel_in_sync(void);
+
+#endif
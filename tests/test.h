@@ -0,0 +1,39 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+/*
+ * Minimal checks for the host tests: a failed check prints its location and
+ * the test keeps going, test_result() gives the process exit code.
+ */
+
+static int test_failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while(0)
+
+#define CHECK_EQ(actual, expected) do { \
+    unsigned long long a_ = (unsigned long long)(actual); \
+    unsigned long long e_ = (unsigned long long)(expected); \
+    if(a_ != e_) { \
+        fprintf(stderr, "%s:%d: %s is %llu (0x%llx), expected %llu (0x%llx)\n", \
+                __FILE__, __LINE__, #actual, a_, a_, e_, e_); \
+        test_failures++; \
+    } \
+} while(0)
+
+static inline int test_result(void)
+{
+    if(test_failures != 0) {
+        fprintf(stderr, "%d check(s) failed\n", test_failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,326 @@
+#include "test.h"
+#include "ssd1306_panel.h"
+#include "SSD1306/asset.h"
+#include "SSD1306/gfx.h"
+#include "assets.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Decoder of the tables generated by tools/assetgen.py --rle (assets.c is
+ * generated by this build from the files in assets/).
+ *
+ * Every icon is drawn at all row alignments and clipped at each edge, and
+ * compared with its source PBM read here. Every glyph of the BDF font is
+ * compared with the same character of the built-in g_font_5x7. A hand
+ * encoded bitmap covers runs that span page strips, and tests/assets/frame.pbm
+ * a full screen that RLE shrinks to a tenth.
+ *
+ * Then the glyphs the generator stored RLE are timed against the same
+ * glyphs raw, and the frame against its raw pages. Timings are printed, not
+ * checked.
+ */
+
+#define ICON_SIZE       16
+#define BENCH_ROUNDS    20000U
+
+typedef struct {
+    const char *file;
+    const asset_bitmap_t *bitmap;
+} icon_t;
+
+static const icon_t icons[] = {
+    { "fan.pbm", &asset_fan },
+    { "door_closed.pbm", &asset_door_closed },
+    { "door_open.pbm", &asset_door_open },
+    { "lock.pbm", &asset_lock },
+};
+
+static uint8_t g_expected[SSD1306_BUFFER_SIZE];
+
+/**
+ * @brief Reads a plain PBM (P1) of the given size, bits whitespace separated or not.
+ */
+static bool read_pbm(const char *dir, const char *file, int width, int height, uint8_t *pixels)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return false;
+
+    int size[2];
+    int count = 0, bits = 0, c;
+    char magic[3] = { 0 };
+    bool ok = fread(magic, 1, 2, f) == 2 && strcmp(magic, "P1") == 0;
+    while(ok && (c = fgetc(f)) != EOF) {
+        if(c == '#') {
+            while((c = fgetc(f)) != EOF && c != '\n') { }
+        } else if(count < 2 && c >= '0' && c <= '9') {
+            ungetc(c, f);
+            ok = fscanf(f, "%d", &size[count++]) == 1;
+        } else if(c == '0' || c == '1') {
+            ok = bits < width * height;
+            if(ok)
+                pixels[bits++] = (uint8_t)(c - '0');
+        }
+    }
+    fclose(f);
+    return ok && count == 2 && size[0] == width && size[1] == height && bits == width * height;
+}
+
+static void expect_pixel(int16_t x, int16_t y)
+{
+    if(x >= 0 && x < SSD1306_WIDTH && y >= 0 && y < SSD1306_HEIGHT)
+        g_expected[(y >> 3) * SSD1306_WIDTH + x] |= (uint8_t)(1U << (y & 7));
+}
+
+static bool screen_matches(void)
+{
+    return memcmp(ssd1306_get_buffer(), g_expected, SSD1306_BUFFER_SIZE) == 0;
+}
+
+static void check_icons(void)
+{
+    static const int16_t xs[] = { 0, 5, -7, 120, 127, -16, 128 };
+    uint8_t pixels[ICON_SIZE][ICON_SIZE];
+
+    for(uint32_t i = 0; i < sizeof(icons) / sizeof(icons[0]); i++) {
+        if(!read_pbm(ASSET_ICON_DIR, icons[i].file, ICON_SIZE, ICON_SIZE, &pixels[0][0])) {
+            fprintf(stderr, "%s: cannot read the source\n", icons[i].file);
+            test_failures++;
+            continue;
+        }
+        CHECK_EQ(icons[i].bitmap->width, ICON_SIZE);
+        CHECK_EQ(icons[i].bitmap->height, ICON_SIZE);
+
+        for(uint32_t xi = 0; xi < sizeof(xs) / sizeof(xs[0]); xi++) {
+            for(int16_t y = -17; y <= SSD1306_HEIGHT; y++) {
+                ssd1306_fill(SSD1306_COLOR_BLACK);
+                memset(g_expected, 0, sizeof(g_expected));
+                asset_draw_bitmap(xs[xi], y, icons[i].bitmap, SSD1306_COLOR_WHITE);
+                for(int16_t row = 0; row < ICON_SIZE; row++) {
+                    for(int16_t col = 0; col < ICON_SIZE; col++) {
+                        if(pixels[row][col])
+                            expect_pixel((int16_t)(xs[xi] + col), (int16_t)(y + row));
+                    }
+                }
+                if(!screen_matches()) {
+                    fprintf(stderr, "%s at %d,%d differs from the source\n", icons[i].file, xs[xi], y);
+                    test_failures++;
+                }
+            }
+        }
+    }
+}
+
+static void check_font(void)
+{
+    const asset_font_t *font = &asset_font5x7;
+    CHECK_EQ(font->first, ' ');
+    CHECK_EQ(font->count, '~' - ' ' + 1);
+
+    for(char ch = ' '; ch <= '~'; ch++) {
+        for(int16_t y = 0; y < 8; y++) {
+            ssd1306_fill(SSD1306_COLOR_BLACK);
+            ssd1306_draw_char(10, (uint8_t)y, ch, SSD1306_COLOR_WHITE);
+            memcpy(g_expected, ssd1306_get_buffer(), sizeof(g_expected));
+
+            ssd1306_fill(SSD1306_COLOR_BLACK);
+            CHECK_EQ(asset_draw_char(10, y, font, ch, SSD1306_COLOR_WHITE), 6);
+            if(!screen_matches()) {
+                fprintf(stderr, "glyph '%c' at row %d differs from g_font_5x7\n", ch, y);
+                test_failures++;
+                break;
+            }
+        }
+    }
+
+    // Text helpers: characters outside the font only advance by half the height
+    CHECK_EQ(asset_text_width(font, "AB"), 12);
+    CHECK_EQ(asset_text_width(font, "A\x7F"), 6 + font->height / 2);
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    CHECK_EQ(asset_draw_text(-6, 0, font, "xAB", SSD1306_COLOR_WHITE), 12);
+    memcpy(g_expected, ssd1306_get_buffer(), sizeof(g_expected));
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    ssd1306_draw_string(0, 0, "AB", SSD1306_COLOR_WHITE);
+    CHECK(screen_matches());
+}
+
+/**
+ * @brief 40x20 bitmap (3 pages) whose runs cross the page strips.
+ */
+static void check_rle_runs(void)
+{
+    static const uint8_t packed[] = {
+        0x80 | (50 - 3), 0xFF,                  // Page 0 and 10 bytes of page 1
+        0x04, 0x01, 0x02, 0x04, 0x08, 0x10,     // 5 literals
+        0x80 | (35 - 3), 0x81,                  // Rest of page 1 and 10 bytes of page 2
+        0x1D, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,
+              0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x01, 0x02, 0x03, 0x04, 0x05,
+              0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    };
+    uint8_t raw[3 * 40];
+    memset(raw, 0xFF, 50);
+    memcpy(&raw[50], (const uint8_t[]){ 0x01, 0x02, 0x04, 0x08, 0x10 }, 5);
+    memset(&raw[55], 0x81, 35);
+    for(int i = 0; i < 30; i++)
+        raw[90 + i] = (uint8_t)(1 + i % 15);
+
+    const asset_bitmap_t bitmap = { .width = 40, .height = 20, .rle = 1, .data = packed };
+    for(int16_t y = -3; y < 16; y++) {
+        ssd1306_fill(SSD1306_COLOR_BLACK);
+        gfx_draw_bitmap(30, y, raw, 40, 20, SSD1306_COLOR_WHITE);
+        memcpy(g_expected, ssd1306_get_buffer(), sizeof(g_expected));
+
+        ssd1306_fill(SSD1306_COLOR_BLACK);
+        asset_draw_bitmap(30, y, &bitmap, SSD1306_COLOR_WHITE);
+        if(!screen_matches()) {
+            fprintf(stderr, "RLE bitmap at row %d differs from the raw one\n", y);
+            test_failures++;
+        }
+    }
+}
+
+/**
+ * @brief The frame drawn at offsets against its source, and RLE where it pays.
+ */
+static void check_frame(void)
+{
+    static uint8_t pixels[SSD1306_HEIGHT][SSD1306_WIDTH];
+    static const int16_t offsets[][2] = { { 0, 0 }, { 3, 5 }, { -9, -2 }, { 60, 20 } };
+    if(!read_pbm(ASSET_TEST_DIR, "frame.pbm", SSD1306_WIDTH, SSD1306_HEIGHT, &pixels[0][0])) {
+        fprintf(stderr, "frame.pbm: cannot read the source\n");
+        test_failures++;
+        return;
+    }
+    CHECK_EQ(asset_frame.rle, 1);
+
+    for(uint32_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        ssd1306_fill(SSD1306_COLOR_BLACK);
+        memset(g_expected, 0, sizeof(g_expected));
+        asset_draw_bitmap(offsets[i][0], offsets[i][1], &asset_frame, SSD1306_COLOR_WHITE);
+        for(int16_t row = 0; row < SSD1306_HEIGHT; row++) {
+            for(int16_t col = 0; col < SSD1306_WIDTH; col++) {
+                if(pixels[row][col])
+                    expect_pixel((int16_t)(offsets[i][0] + col), (int16_t)(offsets[i][1] + row));
+            }
+        }
+        if(!screen_matches()) {
+            fprintf(stderr, "frame at %d,%d differs from the source\n", offsets[i][0], offsets[i][1]);
+            test_failures++;
+        }
+    }
+}
+
+// --- Benchmark ---
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Length of an RLE stream that unpacks to raw_size bytes.
+ */
+static uint32_t rle_length(const uint8_t *data, uint32_t raw_size)
+{
+    uint32_t length = 0;
+    while(raw_size > 0) {
+        uint8_t ctrl = data[length];
+        uint32_t n = (ctrl & 0x80U) ? (ctrl & 0x7FU) + 3U : ctrl + 1U;
+        length += (ctrl & 0x80U) ? 2U : 1U + n;
+        raw_size -= n;
+    }
+    return length;
+}
+
+/**
+ * @brief Draws every listed character BENCH_ROUNDS times, off the page grid.
+ * @return Nanoseconds per glyph.
+ */
+static double bench_glyphs(const asset_font_t *font, const char *chars, uint32_t count)
+{
+    double start = now_ns();
+    for(uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for(uint32_t i = 0; i < count; i++)
+            asset_draw_char((int16_t)(6 * i % 120U), (int16_t)(3 + round % 16U), font, chars[i], SSD1306_COLOR_INVERT);
+    }
+    return (now_ns() - start) / (BENCH_ROUNDS * count);
+}
+
+static void bench(void)
+{
+    const asset_font_t *font = &asset_font5x7;
+    uint8_t pages = (uint8_t)((font->height + 7) / 8);
+    static uint8_t raw_data[256 * 8 * 4];
+    static asset_glyph_t raw_glyphs[256];
+    char rle_chars[256];
+    uint32_t rle_count = 0, rle_bytes = 0, raw_bytes = 0, offset = 0;
+
+    // The same font with every glyph raw: each glyph drawn on the page grid is its page data
+    for(uint32_t i = 0; i < font->count; i++) {
+        const asset_glyph_t *glyph = &font->glyphs[i];
+        char ch = (char)(font->first + i);
+        ssd1306_fill(SSD1306_COLOR_BLACK);
+        asset_draw_char(0, 0, font, ch, SSD1306_COLOR_WHITE);
+        raw_glyphs[i] = (asset_glyph_t){ .offset = (uint16_t)offset, .width = glyph->width, .advance = glyph->advance };
+        for(uint8_t page = 0; page < pages; page++) {
+            memcpy(&raw_data[offset], &ssd1306_get_buffer()[page * SSD1306_WIDTH], glyph->width);
+            offset += glyph->width;
+        }
+        if(glyph->offset & ASSET_GLYPH_RLE) {
+            rle_chars[rle_count++] = ch;
+            raw_bytes += (uint32_t)glyph->width * pages;
+            rle_bytes += rle_length(&font->data[glyph->offset & ~ASSET_GLYPH_RLE], (uint32_t)glyph->width * pages);
+        }
+    }
+    const asset_font_t raw_font = { .first = font->first, .count = font->count, .height = font->height,
+                                    .glyphs = raw_glyphs, .data = raw_data };
+    CHECK(rle_count > 0);
+
+    // Both fonts draw the same text
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    asset_draw_text(-2, 3, font, "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ", SSD1306_COLOR_WHITE);
+    memcpy(g_expected, ssd1306_get_buffer(), sizeof(g_expected));
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    asset_draw_text(-2, 3, &raw_font, "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ", SSD1306_COLOR_WHITE);
+    CHECK(screen_matches());
+
+    double rle_ns = bench_glyphs(font, rle_chars, rle_count);
+    double raw_ns = bench_glyphs(&raw_font, rle_chars, rle_count);
+    printf("asset_draw_char, the %u of %u glyphs stored RLE (%u B, raw %u B): RLE %.1f ns, raw %.1f ns\n",
+           rle_count, font->count, rle_bytes, raw_bytes, rle_ns, raw_ns);
+
+    // The frame: on the page grid at 0,0 the screen buffer is its raw data
+    static uint8_t frame_raw[SSD1306_BUFFER_SIZE];
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    asset_draw_bitmap(0, 0, &asset_frame, SSD1306_COLOR_WHITE);
+    memcpy(frame_raw, ssd1306_get_buffer(), sizeof(frame_raw));
+    double start = now_ns();
+    for(uint32_t round = 0; round < BENCH_ROUNDS / 10U; round++)
+        asset_draw_bitmap(0, (int16_t)(round % 8U), &asset_frame, SSD1306_COLOR_INVERT);
+    double frame_rle_ns = (now_ns() - start) / (BENCH_ROUNDS / 10U);
+    start = now_ns();
+    for(uint32_t round = 0; round < BENCH_ROUNDS / 10U; round++)
+        gfx_draw_bitmap(0, (int16_t)(round % 8U), frame_raw, SSD1306_WIDTH, SSD1306_HEIGHT, SSD1306_COLOR_INVERT);
+    double frame_raw_ns = (now_ns() - start) / (BENCH_ROUNDS / 10U);
+    printf("asset_draw_bitmap, 128x32 frame (RLE %u B, raw %u B): RLE %.1f ns, raw %.1f ns\n",
+           rle_length(asset_frame.data, sizeof(frame_raw)), (uint32_t)sizeof(frame_raw), frame_rle_ns, frame_raw_ns);
+}
+
+int main(void)
+{
+    panel_init();
+
+    check_icons();
+    check_font();
+    check_rle_runs();
+    check_frame();
+    bench();
+
+    return test_result();
+}
@@ -0,0 +1,417 @@
+#include "test.h"
+#include "golden.h"
+#include "ssd1306_panel.h"
+#include "SSD1306/gfx.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Golden images of every drawing primitive of ssd1306.c and gfx.c, on and
+ * off the byte and word boundaries of the screen buffer, clipped at each
+ * edge and in the three colors. Each scene is also sent to the panel model,
+ * and the gfx spans, lines and bitmaps are checked against the same shapes
+ * drawn pixel by pixel with ssd1306_draw_pixel(). Then both are timed on
+ * the same random shapes; timings are printed, not checked.
+ */
+
+#define BENCH_SHAPES    1024U
+#define BENCH_ROUNDS    20U
+
+// 12x12 arrow, two pages of 12 columns
+static const uint8_t arrow[] = {
+    0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0xF8, 0xF8, 0xF0, 0xE0, 0xC0, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+};
+
+static void clear(void)
+{
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+}
+
+/**
+ * @brief Compares the scene with its golden image and sends it to the panel.
+ */
+static void scene(const char *name)
+{
+    CHECK(golden_check(name));
+    ssd1306_update_screen();
+    CHECK(panel_in_sync());
+}
+
+static void scene_pixels(void)
+{
+    clear();
+    for(uint8_t i = 0; i < 32; i++) {
+        ssd1306_draw_pixel(i, i, SSD1306_COLOR_WHITE);                  // Diagonal, every bit of every page
+        ssd1306_draw_pixel((uint8_t)(127 - i), i, SSD1306_COLOR_WHITE);
+    }
+    ssd1306_draw_pixel(0, 0, SSD1306_COLOR_BLACK);                      // Cleared
+    ssd1306_draw_pixel(96, 31, SSD1306_COLOR_INVERT);                   // Toggled off
+    ssd1306_draw_pixel(64, 16, SSD1306_COLOR_INVERT);                   // Toggled on
+    ssd1306_draw_pixel(64, 16, SSD1306_COLOR_WHITE);                    // Stays on
+    ssd1306_draw_pixel(128, 0, SSD1306_COLOR_WHITE);                    // Off screen
+    ssd1306_draw_pixel(0, 32, SSD1306_COLOR_WHITE);
+    ssd1306_draw_pixel(255, 255, SSD1306_COLOR_WHITE);
+    CHECK(ssd1306_get_pixel(5, 5));
+    CHECK(!ssd1306_get_pixel(0, 0));
+    CHECK(!ssd1306_get_pixel(96, 31));
+    CHECK(!ssd1306_get_pixel(128, 0));
+    scene("gfx_pixels");
+}
+
+static void scene_fill(void)
+{
+    ssd1306_fill(SSD1306_COLOR_WHITE);
+    for(uint8_t i = 0; i < 8; i++)
+        ssd1306_draw_pixel((uint8_t)(60 + i), (uint8_t)(12 + i), SSD1306_COLOR_BLACK);
+    scene("gfx_fill_white");
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    scene("gfx_fill_black");
+}
+
+static void scene_text(void)
+{
+    clear();
+    uint8_t x = ssd1306_draw_char(0, 0, 'A', SSD1306_COLOR_WHITE);
+    CHECK_EQ(x, 6);
+    CHECK_EQ(ssd1306_draw_char(x, 0, '\n', SSD1306_COLOR_WHITE), x);   // Not printable: nothing drawn
+    x = ssd1306_draw_char(x, 3, 'g', SSD1306_COLOR_WHITE);            // Across two pages
+    ssd1306_draw_char(x, 0, '~', SSD1306_COLOR_WHITE);
+    ssd1306_draw_string(24, 0, "0123456789:;<=>?@", SSD1306_COLOR_WHITE);
+    gfx_fill_rect(0, 10, 40, 9, SSD1306_COLOR_WHITE);
+    ssd1306_draw_string(2, 11, "INVERT", SSD1306_COLOR_INVERT);
+    ssd1306_draw_string(0, 20, "!\"#$%&'()*+,-./", SSD1306_COLOR_WHITE);
+    ssd1306_draw_string(0, 28, "[\\]^_`{|}", SSD1306_COLOR_WHITE);        // Clipped at the bottom
+    ssd1306_draw_string(100, 10, "WRAP TEXT", SSD1306_COLOR_WHITE);      // Wraps back to x = 100 twice
+    ssd1306_draw_string(125, 20, "x", SSD1306_COLOR_WHITE);             // Clipped at the right edge
+    scene("gfx_text");
+}
+
+static void scene_lines(void)
+{
+    clear();
+    gfx_draw_hline(0, 0, 128, SSD1306_COLOR_WHITE);                     // Full width
+    gfx_draw_hline(-10, 2, 20, SSD1306_COLOR_WHITE);                    // Clipped left
+    gfx_draw_hline(120, 2, 20, SSD1306_COLOR_WHITE);                    // Clipped right
+    gfx_draw_hline(3, 4, 1, SSD1306_COLOR_WHITE);                       // One pixel
+    gfx_draw_hline(5, 4, 0, SSD1306_COLOR_WHITE);                       // Empty
+    gfx_draw_hline(5, 4, -3, SSD1306_COLOR_WHITE);
+    gfx_draw_hline(0, -1, 50, SSD1306_COLOR_WHITE);                     // Off screen
+    gfx_draw_hline(0, 32, 50, SSD1306_COLOR_WHITE);
+    gfx_draw_hline(20, 0, 30, SSD1306_COLOR_BLACK);                     // Cut the first line
+    gfx_draw_hline(30, 6, 40, SSD1306_COLOR_WHITE);
+    gfx_draw_hline(40, 6, 40, SSD1306_COLOR_INVERT);                    // Overlap cancels out
+
+    gfx_draw_vline(0, 8, 24, SSD1306_COLOR_WHITE);                      // Spans three pages
+    gfx_draw_vline(2, 9, 3, SSD1306_COLOR_WHITE);                       // Inside one page
+    gfx_draw_vline(4, 5, 6, SSD1306_COLOR_WHITE);                       // Across a page boundary
+    gfx_draw_vline(6, -5, 10, SSD1306_COLOR_WHITE);                     // Clipped top
+    gfx_draw_vline(8, 28, 10, SSD1306_COLOR_WHITE);                     // Clipped bottom
+    gfx_draw_vline(10, 8, 16, SSD1306_COLOR_WHITE);                     // Page aligned
+    gfx_draw_vline(10, 12, 8, SSD1306_COLOR_INVERT);
+    gfx_draw_vline(127, 0, 32, SSD1306_COLOR_WHITE);
+    gfx_draw_vline(127, 10, 4, SSD1306_COLOR_BLACK);
+    gfx_draw_vline(128, 0, 32, SSD1306_COLOR_WHITE);                    // Off screen
+    gfx_draw_vline(-1, 0, 32, SSD1306_COLOR_WHITE);
+    gfx_draw_vline(12, 8, 0, SSD1306_COLOR_WHITE);
+    scene("gfx_hline_vline");
+}
+
+static void scene_rects(void)
+{
+    clear();
+    gfx_draw_rect(0, 0, 128, 32, SSD1306_COLOR_WHITE);                  // Screen border
+    gfx_draw_rect(3, 3, 10, 10, SSD1306_COLOR_WHITE);
+    gfx_draw_rect(15, 3, 1, 1, SSD1306_COLOR_WHITE);                    // Degenerate
+    gfx_draw_rect(17, 3, 5, 1, SSD1306_COLOR_WHITE);
+    gfx_draw_rect(17, 6, 1, 5, SSD1306_COLOR_WHITE);
+    gfx_draw_rect(120, 20, 20, 20, SSD1306_COLOR_WHITE);                // Clipped: only two sides show
+    gfx_draw_rect(-5, 20, 12, 6, SSD1306_COLOR_WHITE);
+
+    gfx_fill_rect(25, 3, 13, 26, SSD1306_COLOR_WHITE);                  // Three pages, odd width
+    gfx_fill_rect(28, 6, 7, 7, SSD1306_COLOR_BLACK);
+    gfx_fill_rect(41, 1, 17, 30, SSD1306_COLOR_WHITE);
+    gfx_fill_rect(45, 5, 40, 22, SSD1306_COLOR_INVERT);                 // Overlaps the previous one
+    gfx_fill_rect(90, 8, 8, 8, SSD1306_COLOR_WHITE);                    // Exactly one page
+    gfx_fill_rect(100, -4, 6, 10, SSD1306_COLOR_WHITE);                 // Clipped top
+    gfx_fill_rect(108, 28, 6, 10, SSD1306_COLOR_WHITE);                 // Clipped bottom
+    gfx_fill_rect(124, 12, 10, 4, SSD1306_COLOR_INVERT);                // Clipped right
+    gfx_fill_rect(60, 30, 0, 2, SSD1306_COLOR_WHITE);                   // Empty
+    gfx_fill_rect(60, 30, 2, -2, SSD1306_COLOR_WHITE);
+    scene("gfx_rects");
+}
+
+static void scene_line_octants(void)
+{
+    clear();
+    // Star from the center to 16 points: all octants, both directions
+    static const int8_t ends[][2] = {
+        { 30, 0 }, { 30, 8 }, { 30, 15 }, { 15, 15 }, { 8, 15 }, { 0, 15 }, { -8, 15 }, { -15, 15 },
+        { -30, 15 }, { -30, 8 }, { -30, 0 }, { -30, -8 }, { -30, -15 }, { -8, -15 }, { 0, -15 }, { 15, -15 },
+    };
+    for(uint32_t i = 0; i < sizeof(ends) / sizeof(ends[0]); i++) {
+        if(i & 1U)
+            gfx_draw_line((int16_t)(32 + ends[i][0]), (int16_t)(16 + ends[i][1]), 32, 16, SSD1306_COLOR_WHITE);
+        else
+            gfx_draw_line(32, 16, (int16_t)(32 + ends[i][0]), (int16_t)(16 + ends[i][1]), SSD1306_COLOR_WHITE);
+    }
+
+    // Clipped against every edge, including lines from far off screen
+    gfx_draw_line(70, -20, 90, 50, SSD1306_COLOR_WHITE);
+    gfx_draw_line(60, 40, 140, -10, SSD1306_COLOR_WHITE);
+    gfx_draw_line(-1000, 10, 1000, 12, SSD1306_COLOR_WHITE);
+    gfx_draw_line(127, -300, 100, 300, SSD1306_COLOR_WHITE);
+    gfx_draw_line(-5, -5, -1, 40, SSD1306_COLOR_WHITE);                 // Entirely off screen
+    gfx_draw_line(130, 0, 200, 31, SSD1306_COLOR_WHITE);
+    gfx_draw_line(110, 20, 110, 20, SSD1306_COLOR_WHITE);               // One point
+    gfx_draw_line(100, 25, 125, 25, SSD1306_COLOR_INVERT);              // Horizontal and vertical
+    gfx_draw_line(115, 31, 115, 18, SSD1306_COLOR_INVERT);
+    scene("gfx_lines");
+}
+
+static void scene_bitmaps(void)
+{
+    clear();
+    gfx_draw_bitmap(0, 0, arrow, 12, 12, SSD1306_COLOR_WHITE);         // Page aligned
+    gfx_draw_bitmap(14, 3, arrow, 12, 12, SSD1306_COLOR_WHITE);        // Unaligned: spans three pages
+    gfx_draw_bitmap(28, 13, arrow, 12, 12, SSD1306_COLOR_WHITE);
+    gfx_draw_bitmap(42, 5, arrow, 12, 7, SSD1306_COLOR_WHITE);         // Height cut inside the first page
+    gfx_draw_bitmap(56, -6, arrow, 12, 12, SSD1306_COLOR_WHITE);       // Clipped top
+    gfx_draw_bitmap(70, 25, arrow, 12, 12, SSD1306_COLOR_WHITE);       // Clipped bottom
+    gfx_draw_bitmap(-5, 18, arrow, 12, 12, SSD1306_COLOR_WHITE);       // Clipped left
+    gfx_draw_bitmap(122, 7, arrow, 12, 12, SSD1306_COLOR_WHITE);       // Clipped right
+    gfx_fill_rect(86, 0, 30, 16, SSD1306_COLOR_WHITE);
+    gfx_draw_bitmap(88, 2, arrow, 12, 12, SSD1306_COLOR_BLACK);        // Punched out
+    gfx_draw_bitmap(96, 6, arrow, 12, 12, SSD1306_COLOR_INVERT);       // Half on the filled area
+    gfx_draw_bitmap(200, 0, arrow, 12, 12, SSD1306_COLOR_WHITE);       // Off screen
+    gfx_draw_bitmap(0, 40, arrow, 12, 12, SSD1306_COLOR_WHITE);
+    scene("gfx_bitmaps");
+}
+
+// --- Per-pixel references ---
+
+static void ref_pixel(int32_t x, int32_t y, ssd1306_color_t color)
+{
+    if(x >= 0 && x < SSD1306_WIDTH && y >= 0 && y < SSD1306_HEIGHT)
+        ssd1306_draw_pixel((uint8_t)x, (uint8_t)y, color);
+}
+
+static void ref_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, ssd1306_color_t color)
+{
+    for(int32_t py = y; py < y + h; py++) {
+        for(int32_t px = x; px < x + w; px++)
+            ref_pixel(px, py, color);
+    }
+}
+
+// Bresenham over the whole line: the same pixels as gfx_draw_line() while both ends are on screen
+static void ref_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, ssd1306_color_t color)
+{
+    int32_t dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+    int32_t dy = (y1 > y0) ? y0 - y1 : y1 - y0;
+    int32_t sx = (x0 < x1) ? 1 : -1;
+    int32_t sy = (y0 < y1) ? 1 : -1;
+    int32_t err = dx + dy;
+    int32_t x = x0, y = y0;
+
+    while(1) {
+        ref_pixel(x, y, color);
+        if(x == x1 && y == y1)
+            break;
+        int32_t e2 = 2 * err;
+        if(e2 >= dy) { err += dy; x += sx; }
+        if(e2 <= dx) { err += dx; y += sy; }
+    }
+}
+
+static void ref_draw_bitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, ssd1306_color_t color)
+{
+    for(int32_t row = 0; row < h; row++) {
+        for(int32_t col = 0; col < w; col++) {
+            if(bitmap[(row / 8) * w + col] & (1U << (row % 8)))
+                ref_pixel(x + col, y + row, color);
+        }
+    }
+}
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+typedef enum { SHAPE_HLINE, SHAPE_VLINE, SHAPE_RECT, SHAPE_LINE, SHAPE_BITMAP } shape_kind_t;
+
+typedef struct {
+    shape_kind_t kind;
+    int16_t x, y, w, h;                 // SHAPE_LINE: from x, y to w, h
+    ssd1306_color_t color;
+} shape_t;
+
+static uint8_t g_bitmap[3 * 40];       // Up to 40 x 24
+
+static void draw_shape(const shape_t *s, bool per_pixel)
+{
+    switch(s->kind) {
+        case SHAPE_HLINE:
+            if(per_pixel) ref_fill_rect(s->x, s->y, s->w, 1, s->color);
+            else gfx_draw_hline(s->x, s->y, s->w, s->color);
+            break;
+        case SHAPE_VLINE:
+            if(per_pixel) ref_fill_rect(s->x, s->y, 1, s->h, s->color);
+            else gfx_draw_vline(s->x, s->y, s->h, s->color);
+            break;
+        case SHAPE_RECT:
+            if(per_pixel) ref_fill_rect(s->x, s->y, s->w, s->h, s->color);
+            else gfx_fill_rect(s->x, s->y, s->w, s->h, s->color);
+            break;
+        case SHAPE_LINE:
+            if(per_pixel) ref_draw_line(s->x, s->y, s->w, s->h, s->color);
+            else gfx_draw_line(s->x, s->y, s->w, s->h, s->color);
+            break;
+        case SHAPE_BITMAP:
+            if(per_pixel) ref_draw_bitmap(s->x, s->y, g_bitmap, (uint8_t)s->w, (uint8_t)s->h, s->color);
+            else gfx_draw_bitmap(s->x, s->y, g_bitmap, (uint8_t)s->w, (uint8_t)s->h, s->color);
+            break;
+    }
+}
+
+/**
+ * @brief A random shape, clipped at any edge except for lines, whose ends stay on screen.
+ */
+static shape_t random_shape(shape_kind_t kind, uint32_t *rng)
+{
+    uint32_t r = rng_next(rng);
+    shape_t s = { .kind = kind, .color = (ssd1306_color_t)(rng_next(rng) % 3U) };
+    if(kind == SHAPE_LINE) {
+        s.x = (int16_t)(r % SSD1306_WIDTH);
+        s.y = (int16_t)((r >> 8) % SSD1306_HEIGHT);
+        s.w = (int16_t)((r >> 13) % SSD1306_WIDTH);
+        s.h = (int16_t)((r >> 21) % SSD1306_HEIGHT);
+    } else if(kind == SHAPE_BITMAP) {
+        s.x = (int16_t)((int32_t)(r % 180U) - 40);
+        s.y = (int16_t)((int32_t)((r >> 8) % 64U) - 24);
+        s.w = (int16_t)(1 + (r >> 14) % 40U);
+        s.h = (int16_t)(1 + (r >> 20) % 24U);
+    } else {
+        s.x = (int16_t)((int32_t)(r % 160U) - 16);
+        s.y = (int16_t)((int32_t)((r >> 8) % 48U) - 8);
+        s.w = (int16_t)((r >> 14) % 70U);
+        s.h = (int16_t)((r >> 21) % 40U);
+    }
+    return s;
+}
+
+static void random_background(uint32_t *rng)
+{
+    // BLACK and INVERT need something to act on
+    uint8_t *buffer = ssd1306_get_buffer();
+    uint32_t r = rng_next(rng);
+    for(uint32_t b = 0; b < SSD1306_BUFFER_SIZE; b++)
+        buffer[b] = (uint8_t)(r * (b + 1U) >> 24);
+}
+
+/**
+ * @brief Compares gfx spans, lines and bitmaps with the same shapes drawn pixel by pixel.
+ */
+static void check_shapes_against_pixels(void)
+{
+    static uint8_t background[SSD1306_BUFFER_SIZE], drawn[SSD1306_BUFFER_SIZE];
+    uint32_t rng = 0x2545F491U;
+    uint32_t mismatches = 0;
+    uint8_t *screen = ssd1306_get_buffer();
+
+    for(uint32_t i = 0; i < 10000 && mismatches < 5; i++) {
+        shape_t s = random_shape((shape_kind_t)(i % 5U), &rng);
+        if(s.kind == SHAPE_BITMAP) {
+            for(uint32_t b = 0; b < sizeof(g_bitmap); b++)
+                g_bitmap[b] = (uint8_t)rng_next(&rng);
+        }
+        random_background(&rng);
+        memcpy(background, screen, sizeof(background));
+
+        draw_shape(&s, false);
+        memcpy(drawn, screen, sizeof(drawn));
+        memcpy(screen, background, sizeof(background));
+        draw_shape(&s, true);
+
+        if(memcmp(drawn, screen, sizeof(drawn)) != 0) {
+            fprintf(stderr, "shape %u at %d,%d %d,%d color %d differs from the pixels\n",
+                    s.kind, s.x, s.y, s.w, s.h, s.color);
+            mismatches++;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+// --- Benchmark ---
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Draws the shapes BENCH_ROUNDS times from the same background.
+ * @return Nanoseconds per shape.
+ */
+static double bench_shapes(const shape_t *shapes, bool per_pixel)
+{
+    uint32_t rng = 0x600DF00DU;
+    random_background(&rng);
+    double start = now_ns();
+    for(uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for(uint32_t i = 0; i < BENCH_SHAPES; i++)
+            draw_shape(&shapes[i], per_pixel);
+    }
+    return (now_ns() - start) / (BENCH_ROUNDS * BENCH_SHAPES);
+}
+
+static void bench(void)
+{
+    static const struct { shape_kind_t kind; const char *name; } benches[] = {
+        { SHAPE_RECT, "gfx_fill_rect" }, { SHAPE_LINE, "gfx_draw_line" }, { SHAPE_BITMAP, "gfx_draw_bitmap" },
+    };
+    static shape_t shapes[BENCH_SHAPES];
+    static uint8_t drawn[SSD1306_BUFFER_SIZE];
+    uint32_t rng = 0xBE4C4A11U;
+    for(uint32_t b = 0; b < sizeof(g_bitmap); b++)
+        g_bitmap[b] = (uint8_t)rng_next(&rng);
+
+    for(uint32_t k = 0; k < sizeof(benches) / sizeof(benches[0]); k++) {
+        for(uint32_t i = 0; i < BENCH_SHAPES; i++)
+            shapes[i] = random_shape(benches[k].kind, &rng);
+
+        double fast = bench_shapes(shapes, false);
+        memcpy(drawn, ssd1306_get_buffer(), sizeof(drawn));
+        double slow = bench_shapes(shapes, true);
+        CHECK(memcmp(drawn, ssd1306_get_buffer(), sizeof(drawn)) == 0);
+
+        printf("%-16s %u random shapes: %7.1f ns, per pixel %7.1f ns (%.1fx)\n",
+               benches[k].name, BENCH_SHAPES, fast, slow, slow / fast);
+    }
+}
+
+int main(void)
+{
+    panel_init();
+    CHECK(ssd1306_is_ready());
+
+    scene_pixels();
+    scene_fill();
+    scene_text();
+    scene_lines();
+    scene_rects();
+    scene_line_octants();
+    scene_bitmaps();
+    check_shapes_against_pixels();
+    bench();
+
+    return test_result();
+}
@@ -0,0 +1,185 @@
+#include "test.h"
+#include "i2c.h"
+#include "trace.h"
+
+/*
+ * i2c_compute_timing() against the TIMINGR examples of RM0351 (tables
+ * "Examples of timing settings for fI2CCLK = 8/16/48 MHz") and a sweep of
+ * kernel clocks and bus rates. Every result is decoded and checked with the
+ * timing model of RM0351, independently of the driver code:
+ *   tLOW  = tf + tAF + 2 * tI2CCLK + (SCLL + 1) * tPRESC
+ *   tHIGH = tr + tAF + 2 * tI2CCLK + (SCLH + 1) * tPRESC
+ *   tSCL  = tLOW + tHIGH
+ * with the analog filter delay tAF between 50 and 260 ns.
+ */
+
+#define AF_MIN_NS   50.0
+#define AF_MAX_NS   260.0
+
+// --- Stubs for the drivers i2c.c calls ---
+void gpio_init(const gpio_config_t *config) { (void)config; }
+void rcc_i2c_clock_enable(uint8_t i2c_number) { (void)i2c_number; }
+void syscfg_i2c_fast_mode_plus(uint8_t i2c_number, bool enable) { (void)i2c_number; (void)enable; }
+int rcc_clock_hook_register(rcc_clock_hook_t hook) { (void)hook; return 0; }
+const rcc_clocks_t *rcc_get_clocks(void) { return NULL; }
+
+// Tracing stays disabled
+trace_entry_t g_trace_buffer[TRACE_SIZE];
+uint32_t g_trace_head;
+volatile bool g_trace_enabled;
+
+typedef struct {
+    double low, high, su_dat, vd_dat, rise, fall;
+} spec_t;
+
+static const spec_t spec_sm  = { 4700, 4000, 250, 3450, 1000, 300 };
+static const spec_t spec_fm  = { 1300,  600, 100,  900,  300, 300 };
+static const spec_t spec_fmp = {  500,  260,  50,  450,  100,  50 };
+
+static const spec_t *spec_for(uint32_t bus_hz)
+{
+    if(bus_hz <= I2C_SPEED_STANDARD)
+        return &spec_sm;
+    return (bus_hz <= I2C_SPEED_FAST) ? &spec_fm : &spec_fmp;
+}
+
+/**
+ * @brief Shortest SCL period a TIMINGR value gives, in nanoseconds.
+ */
+static double scl_period_ns(uint32_t clk_hz, uint32_t timing, const spec_t *spec)
+{
+    double t_clk = 1e9 / clk_hz;
+    double t_presc = (((timing >> I2C_TIMINGR_PRESC_Pos) & 0xFU) + 1) * t_clk;
+    uint32_t scll = (timing >> I2C_TIMINGR_SCLL_Pos) & 0xFFU;
+    uint32_t sclh = (timing >> I2C_TIMINGR_SCLH_Pos) & 0xFFU;
+    return spec->fall + spec->rise + 2 * (AF_MIN_NS + 2 * t_clk) + (scll + 1 + sclh + 1) * t_presc;
+}
+
+/**
+ * @brief Checks a TIMINGR value against the I2C-bus specification limits.
+ * @return true if the SCL and data timings are all met and the rate is at most bus_hz.
+ */
+static bool timing_valid(uint32_t clk_hz, uint32_t bus_hz, uint32_t timing)
+{
+    const spec_t *spec = spec_for(bus_hz);
+    double t_clk = 1e9 / clk_hz;
+    double t_presc = (((timing >> I2C_TIMINGR_PRESC_Pos) & 0xFU) + 1) * t_clk;
+    uint32_t scll   = (timing >> I2C_TIMINGR_SCLL_Pos) & 0xFFU;
+    uint32_t sclh   = (timing >> I2C_TIMINGR_SCLH_Pos) & 0xFFU;
+    uint32_t sdadel = (timing >> I2C_TIMINGR_SDADEL_Pos) & 0xFU;
+    uint32_t scldel = (timing >> I2C_TIMINGR_SCLDEL_Pos) & 0xFU;
+    double eps = 1e-6;
+
+    double t_low  = spec->fall + AF_MIN_NS + 2 * t_clk + (scll + 1) * t_presc;
+    double t_high = spec->rise + AF_MIN_NS + 2 * t_clk + (sclh + 1) * t_presc;
+    double t_sdadel = sdadel * t_presc;
+
+    bool ok = true;
+    ok &= t_low + eps >= spec->low;
+    ok &= t_high + eps >= spec->high;
+    ok &= (scldel + 1) * t_presc + eps >= spec->rise + spec->su_dat;
+    ok &= t_sdadel + eps >= spec->fall - AF_MIN_NS - 3 * t_clk;
+    ok &= sdadel == 0 || t_sdadel <= spec->vd_dat - spec->rise - AF_MAX_NS - 4 * t_clk + eps;
+    ok &= 1e9 / scl_period_ns(clk_hz, timing, spec) <= bus_hz * (1 + 1e-9);
+    return ok;
+}
+
+static uint32_t compute(uint32_t clk_hz, uint32_t bus_hz)
+{
+    const spec_t *spec = spec_for(bus_hz);
+    return i2c_compute_timing(clk_hz, bus_hz, (uint32_t)spec->rise, (uint32_t)spec->fall);
+}
+
+static const struct {
+    uint32_t clk_hz;
+    uint32_t bus_hz;
+    uint32_t timing;    // RM0351 example
+} rm0351[] = {
+    {  8000000U,   10000U, 0x1042C3C7U },
+    {  8000000U,  100000U, 0x10420F13U },
+    {  8000000U,  400000U, 0x00310309U },
+    { 16000000U,   10000U, 0x3042C3C7U },
+    { 16000000U,  100000U, 0x30420F13U },
+    { 16000000U,  400000U, 0x10320309U },
+    { 16000000U, 1000000U, 0x00200204U },
+    { 48000000U,   10000U, 0xB042C3C7U },
+    { 48000000U,  100000U, 0xB0420F13U },
+    { 48000000U,  400000U, 0x50330309U },
+    { 48000000U, 1000000U, 0x50100103U },
+};
+
+static void check_rm0351_examples(void)
+{
+    for(uint32_t i = 0; i < sizeof(rm0351) / sizeof(rm0351[0]); i++) {
+        uint32_t clk = rm0351[i].clk_hz, bus = rm0351[i].bus_hz;
+        const spec_t *spec = spec_for(bus);
+        uint32_t timing = compute(clk, bus);
+
+        double rate = 1e9 / scl_period_ns(clk, timing, spec);
+        double rm_rate = 1e9 / scl_period_ns(clk, rm0351[i].timing, spec);
+        printf("%2u MHz %4u kHz: 0x%08X %7.1f kHz (RM0351 0x%08X %7.1f kHz)\n",
+               clk / 1000000U, bus / 1000U, timing, rate / 1000, rm0351[i].timing, rm_rate / 1000);
+
+        if(timing == 0 || !timing_valid(clk, bus, timing)) {
+            fprintf(stderr, "%u Hz / %u Hz: invalid timing 0x%08X\n", clk, bus, timing);
+            test_failures++;
+            continue;
+        }
+        // Within spec, and no slower than the reference settings
+        if(rate < rm_rate * 0.999) {
+            fprintf(stderr, "%u Hz / %u Hz: %.0f Hz, slower than RM0351\n", clk, bus, rate);
+            test_failures++;
+        }
+    }
+
+    // The Fast-mode Plus example with the 16 MHz HSI
+    CHECK_EQ(compute(16000000U, 1000000U), 0x00200204U);
+}
+
+static void check_sweep(void)
+{
+    static const uint32_t rates[] = { 1000, 10000, 50000, 100000, 250000, 400000, 500000, 800000, 1000000 };
+    uint32_t checked = 0;
+
+    for(uint32_t clk = 1000000U; clk <= 80000000U; clk += 250000U) {
+        for(uint32_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+            uint32_t bus = rates[i];
+            uint32_t timing = compute(clk, bus);
+
+            // Some clocks cannot meet the Fast-mode data hold window (e.g. 12 MHz),
+            // multiples of 8 MHz (the RM0351 examples, HSI16, PLL) always can
+            bool required = clk % 8000000U == 0 && (bus <= I2C_SPEED_FAST || clk >= 16000000U) && bus >= 10000U;
+            if(required && timing == 0) {
+                fprintf(stderr, "%u Hz / %u Hz: no timing\n", clk, bus);
+                test_failures++;
+            }
+            if(timing == 0)
+                continue;
+            if(!timing_valid(clk, bus, timing)) {
+                fprintf(stderr, "%u Hz / %u Hz: invalid timing 0x%08X\n", clk, bus, timing);
+                test_failures++;
+            }
+            // The prescaler step is the only loss: at most a few percent off the rate
+            double rate = 1e9 / scl_period_ns(clk, timing, spec_for(bus));
+            if(clk >= 16000000U && rate < bus * 0.95) {
+                fprintf(stderr, "%u Hz / %u Hz: %.0f Hz\n", clk, bus, rate);
+                test_failures++;
+            }
+            checked++;
+        }
+    }
+    printf("%u timings checked\n", checked);
+
+    // Out of range
+    CHECK_EQ(compute(16000000U, 999U), 0);
+    CHECK_EQ(compute(16000000U, 1000001U), 0);
+    CHECK_EQ(compute(4000000U, 1000000U), 0);
+    CHECK_EQ(compute(0, 100000U), 0);
+}
+
+int main(void)
+{
+    check_rm0351_examples();
+    check_sweep();
+    return test_result();
+}
@@ -0,0 +1,406 @@
+#define _GNU_SOURCE     // REG_EFL, REG_ERR
+#include "test.h"
+#include "periph.h"
+#include "i2c.h"
+#include "trace.h"
+#include "ssd1306_panel.h"
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+/*
+ * i2c_master_write_prefixed() of src/i2c.c against a simulated I2C1, and
+ * the SSD1306 traffic it carries.
+ *
+ * The register page is mapped without access while the driver runs. Every
+ * access faults, the SIGSEGV handler opens the page and single-steps the
+ * instruction with the x86 trap flag, and the SIGTRAP handler plays the
+ * peripheral on what was written: START, TXIS per byte, TCR and the NBYTES
+ * reload every 255 bytes, STOP with AUTOEND, and a NACK where a test asks
+ * for one. The bytes go on to the panel model, so the transaction and byte
+ * counts of ssd1306_init() and ssd1306_update_screen() are the ones of the
+ * bus, and are printed against the former one-command-per-transaction scheme.
+ */
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#define I2C_PAGE        0x40005000U
+#define I2C_PAGE_SIZE   0x1000U
+#define TRAP_FLAG       0x100U
+#define PF_WRITE        0x2U            // Page fault error code: the access was a write
+#define NEVER           UINT32_MAX
+#define MAX_BYTES       2048U
+#define MAX_CHUNKS      16U
+#define MAX_TXNS        64U
+
+// --- Stubs for the drivers i2c.c calls ---
+void gpio_init(const gpio_config_t *config) { (void)config; }
+void rcc_i2c_clock_enable(uint8_t i2c_number) { (void)i2c_number; }
+void syscfg_i2c_fast_mode_plus(uint8_t i2c_number, bool enable) { (void)i2c_number; (void)enable; }
+int rcc_clock_hook_register(rcc_clock_hook_t hook) { (void)hook; return 0; }
+const rcc_clocks_t *rcc_get_clocks(void) { return NULL; }
+
+// Tracing stays disabled
+trace_entry_t g_trace_buffer[TRACE_SIZE];
+uint32_t g_trace_head;
+volatile bool g_trace_enabled;
+
+// --- Simulated peripheral ---
+
+static struct {
+    bool active;
+    uint32_t nbytes;                    // Bytes left in the current chunk
+    uint32_t nack_at;                   // Byte of the transaction the slave does not acknowledge
+    uint32_t sent;                      // Bytes acknowledged in the current transaction
+    uint8_t bytes[MAX_BYTES];
+    uint32_t chunks[MAX_CHUNKS];        // NBYTES, RELOAD and AUTOEND of every chunk
+    uint32_t chunk_count;
+    uint32_t transactions;
+    uint32_t txn_bytes[MAX_TXNS];       // Bytes after the address, per transaction
+    uint8_t txn_control[MAX_TXNS];      // First byte, the SSD1306 control byte
+    uint32_t violations;                // Accesses the peripheral does not expect
+} g_bus;
+
+static volatile uint32_t *g_access;     // Register of the instruction being stepped
+static uint32_t g_access_before;
+static bool g_access_write;
+
+static void bus_reset(void)
+{
+    memset(&g_bus, 0, sizeof(g_bus));
+    g_bus.nack_at = NEVER;
+    I2C1->CR2 = 0;
+    I2C1->ISR = 0;
+}
+
+static void bus_stop(void)
+{
+    if(g_bus.transactions < MAX_TXNS)
+        g_bus.txn_bytes[g_bus.transactions] = g_bus.sent;
+    g_bus.transactions++;
+    g_bus.active = false;
+    I2C1->ISR = (I2C1->ISR & ~I2C_ISR_BUSY) | I2C_ISR_STOPF;
+}
+
+/**
+ * @brief Sets the flag the driver waits for after a byte or a chunk.
+ */
+static void bus_transmit_ready(void)
+{
+    if(g_bus.nbytes > 0)
+        I2C1->ISR |= I2C_ISR_TXIS;
+    else if(I2C1->CR2 & I2C_CR2_RELOAD)
+        I2C1->ISR |= I2C_ISR_TCR;
+    else if(I2C1->CR2 & I2C_CR2_AUTOEND)
+        bus_stop();
+    else
+        I2C1->ISR |= I2C_ISR_TC;
+}
+
+static void bus_load_chunk(uint32_t cr2)
+{
+    if(g_bus.chunk_count < MAX_CHUNKS)
+        g_bus.chunks[g_bus.chunk_count] = cr2 & (I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_AUTOEND);
+    g_bus.chunk_count++;
+    g_bus.nbytes = (cr2 & I2C_CR2_NBYTES) >> I2C_CR2_NBYTES_Pos;
+    if(g_bus.nbytes == 0)
+        g_bus.violations++;
+    bus_transmit_ready();
+}
+
+static void cr2_written(void)
+{
+    uint32_t cr2 = I2C1->CR2;
+    if(cr2 & (1U << I2C_CR2_START_Pos)) {
+        if(g_bus.active)
+            g_bus.violations++;
+        I2C1->CR2 = cr2 & ~(1U << I2C_CR2_START_Pos);     // Cleared once the address is sent
+        g_bus.active = true;
+        g_bus.sent = 0;
+        g_bus.chunk_count = 0;
+        I2C1->ISR |= I2C_ISR_BUSY;
+        panel_bus_start((uint8_t)((cr2 >> 1) & 0x7FU));
+        bus_load_chunk(cr2);
+    } else if(cr2 & (1U << I2C_CR2_STOP_Pos)) {
+        I2C1->CR2 = cr2 & ~(1U << I2C_CR2_STOP_Pos);
+        if(g_bus.active)
+            bus_stop();
+    } else if(I2C1->ISR & I2C_ISR_TCR) {
+        I2C1->ISR &= ~I2C_ISR_TCR;
+        bus_load_chunk(cr2);
+    } else if(g_bus.active) {
+        g_bus.violations++;                             // NBYTES changed in the middle of a chunk
+    }
+}
+
+static void txdr_written(void)
+{
+    if(!g_bus.active || !(I2C1->ISR & I2C_ISR_TXIS)) {
+        g_bus.violations++;
+        return;
+    }
+    I2C1->ISR &= ~I2C_ISR_TXIS;
+    uint8_t byte = (uint8_t)I2C1->TXDR;
+
+    if(g_bus.sent == g_bus.nack_at) {
+        // Only AUTOEND ends the transfer by itself, in reload mode the driver must send the STOP
+        I2C1->ISR |= I2C_ISR_NACKF;
+        if(I2C1->CR2 & I2C_CR2_AUTOEND)
+            bus_stop();
+        return;
+    }
+    if(g_bus.sent < MAX_BYTES)
+        g_bus.bytes[g_bus.sent] = byte;
+    if(g_bus.sent == 0 && g_bus.transactions < MAX_TXNS)
+        g_bus.txn_control[g_bus.transactions] = byte;
+    g_bus.sent++;
+    panel_bus_byte(byte);
+    g_bus.nbytes--;
+    bus_transmit_ready();
+}
+
+static void register_written(volatile uint32_t *reg)
+{
+    if(reg == &I2C1->CR2) {
+        cr2_written();
+    } else if(reg == &I2C1->TXDR) {
+        txdr_written();
+    } else if(reg == &I2C1->ICR) {
+        // NACKCF and STOPCF sit at the bit positions of NACKF and STOPF
+        I2C1->ISR &= ~(I2C1->ICR & (I2C_ICR_NACKCF | I2C_ICR_STOPCF));
+        I2C1->ICR = 0;
+    }
+}
+
+static void on_segv(int sig, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = context;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    if(addr < I2C_PAGE || addr >= I2C_PAGE + I2C_PAGE_SIZE || g_access != NULL) {
+        signal(sig, SIG_DFL);           // A real crash: fault again, without the handler
+        return;
+    }
+    mprotect((void *)(uintptr_t)I2C_PAGE, I2C_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    g_access = (volatile uint32_t *)(addr & ~(uintptr_t)3U);
+    g_access_before = *g_access;
+    g_access_write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+    uc->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+}
+
+static void on_trap(int sig, siginfo_t *info, void *context)
+{
+    (void)sig;
+    (void)info;
+    ucontext_t *uc = context;
+    uc->uc_mcontext.gregs[REG_EFL] &= ~(greg_t)TRAP_FLAG;
+    if(g_access == NULL)
+        return;
+    // A read-modify-write may fault as a read: a changed value is a write as well
+    if(g_access_write || *g_access != g_access_before)
+        register_written(g_access);
+    g_access = NULL;
+    mprotect((void *)(uintptr_t)I2C_PAGE, I2C_PAGE_SIZE, PROT_NONE);
+}
+
+static void regs_trapped(bool trapped)
+{
+    mprotect((void *)(uintptr_t)I2C_PAGE, I2C_PAGE_SIZE, trapped ? PROT_NONE : (PROT_READ | PROT_WRITE));
+}
+
+static int write_prefixed(uint8_t slave_addr, const uint8_t *header, uint32_t header_len,
+                          const uint8_t *data, uint32_t size)
+{
+    regs_trapped(true);
+    int status = i2c_master_write_prefixed(I2C1, slave_addr, header, header_len, data, size);
+    regs_trapped(false);
+    return status;
+}
+
+// --- Checks ---
+
+static uint32_t rng_next(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/**
+ * @brief Checks the chunks of a transfer: 255 bytes with RELOAD, then the rest with AUTOEND.
+ */
+static bool chunks_match(uint32_t total)
+{
+    uint32_t count = 0;
+    for(uint32_t left = total; left > 0; count++) {
+        uint32_t n = (left > I2C_NBYTES_MAX) ? I2C_NBYTES_MAX : left;
+        left -= n;
+        uint32_t expected = (n << I2C_CR2_NBYTES_Pos) | ((left > 0) ? I2C_CR2_RELOAD : I2C_CR2_AUTOEND);
+        if(count >= MAX_CHUNKS || g_bus.chunks[count] != expected)
+            return false;
+    }
+    return g_bus.chunk_count == count;
+}
+
+static void check_transfers(void)
+{
+    static const uint32_t sizes[] = { 1, 2, 254, 255, 256, 509, 510, 511, 525, 1024, 1500 };
+    static uint8_t data[MAX_BYTES];
+    uint8_t header[13];
+    uint32_t seed = 0x12C0FFEEU;
+    for(uint32_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)rng_next(&seed);
+    for(uint32_t i = 0; i < sizeof(header); i++)
+        header[i] = (uint8_t)(0x80U + i);
+
+    for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for(uint32_t header_len = 0; header_len <= sizeof(header); header_len += sizeof(header)) {
+            uint32_t total = header_len + sizes[s];
+            bus_reset();
+            CHECK_EQ(write_prefixed(0x50, header, header_len, data, sizes[s]), 0);
+            CHECK_EQ(g_bus.transactions, 1);
+            CHECK_EQ(g_bus.sent, total);
+            CHECK_EQ(g_bus.violations, 0);
+            CHECK(memcmp(g_bus.bytes, header, header_len) == 0);
+            CHECK(memcmp(g_bus.bytes + header_len, data, sizes[s]) == 0);
+            if(!chunks_match(total)) {
+                fprintf(stderr, "%u bytes: %u chunks, NBYTES reload wrong\n", total, g_bus.chunk_count);
+                test_failures++;
+            }
+            CHECK_EQ(I2C1->ISR & (I2C_ISR_BUSY | I2C_ISR_STOPF | I2C_ISR_TCR), 0);
+        }
+    }
+
+    // Nothing to send: no START
+    bus_reset();
+    CHECK_EQ(write_prefixed(0x50, NULL, 0, NULL, 0), -1);
+    CHECK_EQ(g_bus.chunk_count, 0);
+
+    // A NACK in the AUTOEND chunk stops the bus by itself, one in a RELOAD chunk needs the driver's STOP
+    static const uint32_t nacks[] = { 0, 100, 300, 520 };
+    for(uint32_t n = 0; n < sizeof(nacks) / sizeof(nacks[0]); n++) {
+        bus_reset();
+        g_bus.nack_at = nacks[n];
+        CHECK_EQ(write_prefixed(0x50, header, sizeof(header), data, 512), -2);
+        CHECK_EQ(g_bus.transactions, 1);
+        CHECK_EQ(g_bus.sent, nacks[n]);
+        CHECK_EQ(g_bus.violations, 0);
+        CHECK_EQ(I2C1->ISR & (I2C_ISR_BUSY | I2C_ISR_STOPF | I2C_ISR_NACKF), 0);
+    }
+}
+
+// The former driver: one command per transaction, the frame in 16-byte chunks
+static const uint8_t old_init_commands[] = {
+    0xAE, 0x20, 0x10, 0xB0, 0xC8, 0x00, 0x10, 0x40, 0x81, 0xFF, 0xA1, 0xA6, 0xA8, 0x3F,
+    0xA4, 0xD3, 0x00, 0xD5, 0xF0, 0xD9, 0x22, 0xDA, 0x12, 0xDB, 0x20, 0x8D, 0x14, 0xAF,
+};
+#define OLD_CHUNK_SIZE  16U
+
+static void old_command(uint8_t cmd)
+{
+    uint8_t buffer[2] = { 0x00, cmd };
+    CHECK_EQ(write_prefixed(SSD1306_I2C_ADDR, NULL, 0, buffer, sizeof(buffer)), 0);
+}
+
+static void old_update_screen(void)
+{
+    static const uint8_t window[] = { 0x21, 0, 127, 0x22, 0, 3 };
+    for(uint32_t i = 0; i < sizeof(window); i++)
+        old_command(window[i]);
+    for(uint32_t chunk = 0; chunk < SSD1306_BUFFER_SIZE / OLD_CHUNK_SIZE; chunk++) {
+        uint8_t buffer[OLD_CHUNK_SIZE + 1] = { 0x40 };
+        memcpy(buffer + 1, ssd1306_get_buffer() + chunk * OLD_CHUNK_SIZE, OLD_CHUNK_SIZE);
+        CHECK_EQ(write_prefixed(SSD1306_I2C_ADDR, NULL, 0, buffer, sizeof(buffer)), 0);
+    }
+}
+
+static void print_traffic(const char *what, panel_stats_t old_before, panel_stats_t old_after,
+                          panel_stats_t before, panel_stats_t after)
+{
+    printf("%-14s per command: %3u transactions / %4u bytes, batched: %u transaction%s / %4u bytes\n", what,
+           old_after.transactions - old_before.transactions, old_after.bus_bytes - old_before.bus_bytes,
+           after.transactions - before.transactions, (after.transactions - before.transactions == 1) ? " " : "s",
+           after.bus_bytes - before.bus_bytes);
+}
+
+static void check_display(void)
+{
+    // Init: the command table in one stream, then the blank frame one page per poll
+    bus_reset();
+    regs_trapped(true);
+    panel_init();
+    regs_trapped(false);
+    CHECK(ssd1306_is_ready());
+    CHECK_EQ(g_bus.violations, 0);
+    CHECK_EQ(g_bus.transactions, 1 + SSD1306_PAGES);
+    CHECK_EQ(g_bus.txn_control[0], 0x00);                   // Co = 0, D/C# = 0: command stream
+    for(uint32_t i = 1; i < g_bus.transactions; i++)
+        CHECK_EQ(g_bus.txn_control[i], 0x80);               // Window pairs, then the data
+    CHECK(panel_in_sync());
+    uint32_t init_command_bytes = 1 + g_bus.txn_bytes[0];   // With the address byte
+    uint32_t clear_bytes = panel_stats().bus_bytes - init_command_bytes;
+
+    // A full frame is one transaction of 512 data bytes behind the window header, reloaded twice
+    uint32_t seed = 0x55D1306U;
+    uint8_t *buffer = ssd1306_get_buffer();
+    for(uint32_t i = 0; i < SSD1306_BUFFER_SIZE; i++)
+        buffer[i] = (uint8_t)rng_next(&seed);
+    bus_reset();
+    panel_stats_t before = panel_stats();
+    regs_trapped(true);
+    ssd1306_update_screen();
+    regs_trapped(false);
+    panel_stats_t frame = panel_stats();
+    CHECK_EQ(g_bus.transactions, 1);
+    CHECK_EQ(g_bus.violations, 0);
+    CHECK_EQ(frame.transactions - before.transactions, 1);
+    CHECK_EQ(frame.data_bytes - before.data_bytes, SSD1306_BUFFER_SIZE);
+    CHECK_EQ(g_bus.chunk_count, (g_bus.sent + I2C_NBYTES_MAX - 1) / I2C_NBYTES_MAX);
+    CHECK(chunks_match(g_bus.sent));
+    CHECK(panel_in_sync());
+
+    // The same traffic, the former way
+    bus_reset();
+    panel_stats_t old_before = panel_stats();
+    for(uint32_t i = 0; i < sizeof(old_init_commands); i++)
+        old_command(old_init_commands[i]);
+    panel_stats_t old_init = panel_stats();
+    old_update_screen();
+    panel_stats_t old_frame = panel_stats();
+    CHECK_EQ(g_bus.violations, 0);
+
+    panel_stats_t none = { 0 };
+    panel_stats_t init_commands = { .transactions = 1, .bus_bytes = init_command_bytes };
+    print_traffic("init commands", old_before, old_init, none, init_commands);
+    print_traffic("frame", old_init, old_frame, before, frame);
+    printf("%-14s batched: %u page transactions / %u bytes\n", "init clear", SSD1306_PAGES, clear_bytes);
+}
+
+int main(void)
+{
+    periph_map(I2C_PAGE, I2C_PAGE_SIZE);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = on_segv;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = on_trap;
+    sigaction(SIGTRAP, &action, NULL);
+
+    check_transfers();
+    check_display();
+    return test_result();
+}
+
+#else
+
+int main(void)
+{
+    printf("register trapping needs x86-64 Linux: skipped\n");
+    return 0;
+}
+
+#endif
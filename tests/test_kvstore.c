@@ -0,0 +1,332 @@
+#include "test.h"
+#include "periph.h"
+#include "kvStore/kvStore.h"
+#include <string.h>
+
+/*
+ * kvStore on simulated flash, with a power loss injected at every flash
+ * operation of a write sequence in turn.
+ *
+ * The reserved pages live in host memory at their address in the linker
+ * script (the test links with _skvstore/_ekvstore at the same place). The
+ * flash model only clears bits when programming, refuses to program a
+ * double-word that is not erased, and at the power loss tears the
+ * operation in progress: an erase leaves the page partly erased, a program
+ * leaves some of the bits to clear still set. Every later operation fails
+ * until the "reboot", where kv_init() must find each key with its last
+ * committed value, or for the key being written, the new one.
+ *
+ * The index limit is checked with new keys still queued: kv_set() refuses a
+ * key over KV_MAX_KEYS rather than accepting it and losing it.
+ */
+
+#define KV_BASE         0x080FE000UL
+#define KV_SIZE         0x2000UL
+#define KEYS            8U
+#define SEQUENCE_LEN    240U
+
+static struct {
+    int32_t ops_left;       // Operations before the power loss, -1 for none
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t rng;
+} g_flash;
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// --- Flash model ---
+void flash_unlock(void) { }
+void flash_lock(void) { }
+
+/**
+ * @brief Counts an operation against the power budget.
+ * @return 1 to run it, 0 to tear it, -1 if the power is already gone.
+ */
+static int flash_power(void)
+{
+    if(g_flash.ops_left < 0)
+        return 1;
+    if(g_flash.ops_left == 0)
+        return -1;
+    return (--g_flash.ops_left == 0) ? 0 : 1;
+}
+
+int flash_erase_page(uint32_t address)
+{
+    int power = flash_power();
+    if(power < 0)
+        return -1;
+    g_flash.erases++;
+
+    uint32_t *page = (uint32_t *)(address & ~(FLASH_PAGE_SIZE - 1U));
+    for(uint32_t i = 0; i < FLASH_PAGE_SIZE / 4; i++) {
+        if(power > 0 || (rng_next(&g_flash.rng) & 1U))
+            page[i] = 0xFFFFFFFFU;
+    }
+    return (power > 0) ? 0 : -1;
+}
+
+int flash_program_double_word(uint32_t address, uint64_t data)
+{
+    int power = flash_power();
+    if(power < 0 || (address & 7U))
+        return -1;
+    g_flash.programs++;
+
+    volatile uint64_t *dword = (volatile uint64_t *)(uintptr_t)address;
+    if(*dword != UINT64_MAX)
+        return -1;      // PROGERR
+    if(power == 0) {
+        uint64_t pending = ((uint64_t)rng_next(&g_flash.rng) << 32) | rng_next(&g_flash.rng);
+        *dword = data | pending;
+        return -1;
+    }
+    *dword = data;
+    return 0;
+}
+
+static void flash_format(void)
+{
+    memset((void *)KV_BASE, 0xFF, KV_SIZE);
+}
+
+// --- Reference model of the store ---
+typedef struct {
+    bool present;
+    uint8_t len;
+    uint8_t data[KV_MAX_VALUE_LEN];
+} value_t;
+
+typedef struct {
+    uint16_t key;
+    bool remove;
+    value_t value;
+} op_t;
+
+static op_t g_ops[SEQUENCE_LEN];
+
+static void make_sequence(uint32_t seed)
+{
+    uint32_t rng = seed;
+    for(uint32_t i = 0; i < SEQUENCE_LEN; i++) {
+        op_t *op = &g_ops[i];
+        op->key = (uint16_t)(1U + rng_next(&rng) % KEYS);
+        op->remove = (rng_next(&rng) % 8U) == 0;
+        op->value.present = !op->remove;
+        op->value.len = op->remove ? 0 : (uint8_t)(rng_next(&rng) % (KV_MAX_VALUE_LEN + 1U));
+        for(uint32_t b = 0; b < op->value.len; b++)
+            op->value.data[b] = (uint8_t)rng_next(&rng);
+    }
+}
+
+static bool value_matches(uint16_t key, const value_t *expected)
+{
+    uint8_t buffer[KV_MAX_VALUE_LEN];
+    int len = kv_get(key, buffer, sizeof(buffer));
+    if(!expected->present)
+        return len == -1;
+    return len == expected->len && memcmp(buffer, expected->data, expected->len) == 0;
+}
+
+/**
+ * @brief Plays the sequence until the power fails, then reboots and checks the store.
+ * @param power_ops Flash operations before the power loss, -1 for none.
+ * @return true if the power loss happened.
+ */
+static bool run_with_power_loss(int32_t power_ops)
+{
+    value_t committed[KEYS + 1];
+    memset(committed, 0, sizeof(committed));
+    const op_t *in_flight = NULL;
+
+    flash_format();
+    g_flash.ops_left = power_ops;
+    g_flash.rng = 0x9E3779B9U ^ (uint32_t)power_ops;
+
+    bool lost = !kv_init();
+    for(uint32_t i = 0; i < SEQUENCE_LEN && !lost; i++) {
+        const op_t *op = &g_ops[i];
+        bool ok = op->remove ? kv_delete(op->key) : kv_set(op->key, op->value.data, op->value.len);
+        CHECK(ok);
+        if(kv_flush())
+            committed[op->key] = op->value;
+        else {
+            in_flight = op;
+            lost = true;
+        }
+    }
+    if(!lost)
+        return false;
+
+    // Reboot
+    g_flash.ops_left = -1;
+    if(!kv_init()) {
+        fprintf(stderr, "power loss after %d operations: kv_init() failed\n", power_ops);
+        test_failures++;
+        return true;
+    }
+    for(uint16_t key = 1; key <= KEYS; key++) {
+        bool ok = value_matches(key, &committed[key]);
+        if(!ok && in_flight != NULL && in_flight->key == key)
+            ok = value_matches(key, &in_flight->value);
+        if(!ok) {
+            fprintf(stderr, "power loss after %d operations: key %u lost its value\n", power_ops, key);
+            test_failures++;
+        }
+    }
+
+    // The store keeps working: a torn page is compacted on the next writes
+    for(uint16_t key = 1; key <= KEYS; key++) {
+        uint8_t value[4] = { (uint8_t)key, 0xC0, 0xFF, 0xEE };
+        CHECK(kv_set(key, value, sizeof(value)));
+    }
+    CHECK(kv_flush());
+    CHECK(kv_init());
+    for(uint16_t key = 1; key <= KEYS; key++) {
+        value_t expected = { .present = true, .len = 4, .data = { (uint8_t)key, 0xC0, 0xFF, 0xEE } };
+        CHECK(value_matches(key, &expected));
+    }
+    return true;
+}
+
+/**
+ * @brief kv_process() spreads a compaction over several calls, one erase at most per call.
+ */
+static void check_incremental_compaction(void)
+{
+    flash_format();
+    g_flash.ops_left = -1;
+    CHECK(kv_init());
+
+    uint8_t value[KV_MAX_VALUE_LEN];
+    memset(value, 0x42, sizeof(value));
+    uint32_t compactions = 0;
+
+    for(uint32_t i = 0; i < 200; i++) {
+        value[0] = (uint8_t)i;
+        CHECK(kv_set((uint16_t)(1U + i % KEYS), value, sizeof(value)));
+
+        uint32_t calls = 0;
+        bool pending = true;
+        while(pending) {
+            uint32_t erases = g_flash.erases, programs = g_flash.programs;
+            pending = kv_process();
+            calls++;
+
+            // An erase is a step of its own
+            if(g_flash.erases != erases) {
+                CHECK_EQ(g_flash.erases - erases, 1);
+                CHECK_EQ(g_flash.programs - programs, 0);
+                compactions++;
+            }
+            CHECK(calls < KEYS + 4U);
+        }
+        // Compaction: erase, one call per live record, header, then the write
+        if(calls > 1)
+            CHECK(calls >= 3U);
+    }
+    CHECK(compactions > 3);
+
+    for(uint16_t key = 1; key <= KEYS; key++) {
+        uint8_t buffer[KV_MAX_VALUE_LEN];
+        CHECK_EQ(kv_get(key, buffer, sizeof(buffer)), KV_MAX_VALUE_LEN);
+        CHECK_EQ(buffer[0], (uint8_t)(200U - KEYS + key - 1U));
+    }
+}
+
+static bool set_u32(uint16_t key, uint32_t value)
+{
+    return kv_set(key, &value, sizeof(value));
+}
+
+static bool has_u32(uint16_t key, uint32_t value)
+{
+    uint32_t stored = 0;
+    return kv_get(key, &stored, sizeof(stored)) == (int)sizeof(stored) && stored == value;
+}
+
+/**
+ * @brief New keys still queued count against KV_MAX_KEYS: a key over the
+ *        limit is refused by kv_set(), never accepted and then lost.
+ */
+static void check_index_limit(void)
+{
+    // KV_MAX_KEYS - 1 keys in flash: one more fits, the next does not
+    flash_format();
+    g_flash.ops_left = -1;
+    CHECK(kv_init());
+    for(uint16_t key = 1; key < KV_MAX_KEYS; key++)
+        CHECK(set_u32(key, key));
+    CHECK(kv_flush());
+    CHECK(set_u32(100, 100));
+    CHECK(!set_u32(101, 101));
+    CHECK(kv_flush());
+    CHECK(kv_init());
+    CHECK(has_u32(100, 100));
+    CHECK_EQ(kv_get(101, &(uint32_t){ 0 }, 4), -1);
+
+    // Filled up to the limit with KV_PENDING_MAX new keys still queued
+    flash_format();
+    CHECK(kv_init());
+    uint16_t in_flash = KV_MAX_KEYS - KV_PENDING_MAX;
+    for(uint16_t key = 1; key <= in_flash; key++)
+        CHECK(set_u32(key, key));
+    CHECK(kv_flush());
+    for(uint16_t key = in_flash + 1; key <= KV_MAX_KEYS; key++)
+        CHECK(set_u32(key, key));
+    CHECK_EQ(kv_pending_count(), KV_PENDING_MAX);
+    CHECK(!set_u32(KV_MAX_KEYS + 1, 0));
+    CHECK(!set_u32(200, 0));
+
+    // Keys already counted can still change, queued or in flash
+    CHECK(set_u32(KV_MAX_KEYS, 0xAB));
+    CHECK(set_u32(1, 0xCD));                // Commits the oldest queued write to make room
+    CHECK(!set_u32(200, 0));
+
+    CHECK(kv_flush());
+    CHECK(kv_init());
+    for(uint16_t key = 1; key <= KV_MAX_KEYS; key++)
+        CHECK(has_u32(key, (key == 1) ? 0xCDU : (key == KV_MAX_KEYS) ? 0xABU : key));
+    CHECK_EQ(kv_get(KV_MAX_KEYS + 1, &(uint32_t){ 0 }, 4), -1);
+
+    // A queued delete frees its slot once committed
+    CHECK(kv_delete(2));
+    CHECK(!set_u32(200, 200));
+    CHECK(kv_flush());
+    CHECK(set_u32(200, 200));
+    CHECK(kv_flush());
+    CHECK(kv_init());
+    CHECK(has_u32(200, 200));
+    CHECK_EQ(kv_get(2, &(uint32_t){ 0 }, 4), -1);
+}
+
+int main(void)
+{
+    periph_map(KV_BASE, KV_SIZE);
+
+    check_incremental_compaction();
+    check_index_limit();
+
+    make_sequence(12345);
+    g_flash.erases = g_flash.programs = 0;
+    CHECK(!run_with_power_loss(-1));
+    uint32_t total = g_flash.erases + g_flash.programs;
+    CHECK(g_flash.erases > 3);      // The sequence goes through several compactions
+
+    uint32_t losses = 0;
+    for(int32_t n = 1; n <= (int32_t)total; n++)
+        losses += run_with_power_loss(n);
+    CHECK_EQ(losses, total);
+
+    printf("%u power losses checked over %u flash operations\n", losses, total);
+    return test_result();
+}
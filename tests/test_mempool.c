@@ -0,0 +1,288 @@
+#include "test.h"
+#include "memPool/memPool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/*
+ * memPool against a model of the blocks in use, with a random alloc/free
+ * churn: blocks are distinct, aligned, inside the storage and keep their
+ * contents, the statistics follow, and a pool never fragments (while blocks
+ * are free, an allocation succeeds). Then the same churn is timed against
+ * malloc/free, with three pools as size classes, and the glibc heap is
+ * reported after it: its size and the free bytes caught in holes below the
+ * top, which only blocks of the right size can reuse.
+ */
+
+#define BLOCK_SIZE      20U     // Rounded up to 24
+#define BLOCK_COUNT     64U
+#define CHURN_OPS       200000U
+#define BENCH_SLOTS     256U
+#define BENCH_OPS       4000000U
+
+uint32_t g_irq_locked;
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void check_stats(const mem_pool_t *pool, uint32_t used, uint32_t peak, uint32_t failures)
+{
+    mem_stats_t stats;
+    mem_pool_get_stats(pool, &stats);
+    CHECK_EQ(stats.capacity, pool->count);
+    CHECK_EQ(stats.used, used);
+    CHECK_EQ(stats.peak, peak);
+    CHECK_EQ(stats.failures, failures);
+}
+
+static void check_pool_churn(void)
+{
+    MEM_POOL_DEFINE(pool, BLOCK_SIZE, BLOCK_COUNT);
+    CHECK_EQ(pool.block_size, 24);
+
+    uint8_t *live[BLOCK_COUNT];
+    uint32_t live_count = 0, peak = 0, failures = 0;
+    uint32_t rng = 0xC0FFEE01U;
+
+    for(uint32_t op = 0; op < CHURN_OPS; op++) {
+        uint32_t r = rng_next(&rng);
+        // Drift between nearly empty and full so both ends are exercised
+        bool grow = ((op / 5000U) & 1U) ? (r % 4U) != 0 : (r % 4U) == 0;
+
+        if(grow || live_count == 0) {
+            uint8_t *block = mem_pool_alloc(&pool);
+            if(live_count == BLOCK_COUNT) {
+                CHECK(block == NULL);
+                failures++;
+                continue;
+            }
+            // A free block always exists here: the pool does not fragment
+            if(block == NULL) {
+                fprintf(stderr, "allocation %u failed with %u of %u blocks in use\n",
+                        op, live_count, BLOCK_COUNT);
+                test_failures++;
+                return;
+            }
+            uintptr_t offset = (uintptr_t)(block - pool.storage);
+            CHECK(block >= pool.storage && offset < (uintptr_t)BLOCK_COUNT * pool.block_size);
+            CHECK_EQ(offset % pool.block_size, 0);
+            CHECK_EQ((uintptr_t)block % MEM_ALIGN, 0);
+            for(uint32_t i = 0; i < live_count; i++)
+                CHECK(live[i] != block);
+
+            memset(block, (int)(offset / pool.block_size), BLOCK_SIZE);
+            live[live_count++] = block;
+            if(live_count > peak)
+                peak = live_count;
+        } else {
+            uint32_t index = r % live_count;
+            uint8_t *block = live[index];
+            uint8_t tag = (uint8_t)((uintptr_t)(block - pool.storage) / pool.block_size);
+            for(uint32_t i = 0; i < BLOCK_SIZE; i++) {
+                if(block[i] != tag) {
+                    fprintf(stderr, "block %u was overwritten while in use\n", tag);
+                    test_failures++;
+                    return;
+                }
+            }
+            CHECK(mem_pool_free(&pool, block));
+            live[index] = live[--live_count];
+        }
+        CHECK_EQ(g_irq_locked, 0);
+    }
+    check_stats(&pool, live_count, peak, failures);
+    CHECK_EQ(peak, BLOCK_COUNT);
+    CHECK(failures > 0);
+
+    // Pointers that are not blocks of this pool are refused and change nothing
+    MEM_POOL_DEFINE(other, BLOCK_SIZE, 4);
+    void *foreign = mem_pool_alloc(&other);
+    CHECK(!mem_pool_free(&pool, foreign));
+    CHECK(!mem_pool_free(&pool, pool.storage + 8));
+    CHECK(!mem_pool_free(&pool, pool.storage - pool.block_size));
+    CHECK(!mem_pool_free(&pool, pool.storage + (uint32_t)BLOCK_COUNT * pool.block_size));
+    CHECK(!mem_pool_free(NULL, foreign));
+    CHECK(mem_pool_free(&pool, NULL));
+    check_stats(&pool, live_count, peak, failures);
+
+    // Blocks never handed out are not accepted back either
+    mem_pool_t fresh;
+    static uint64_t fresh_storage[8];
+    mem_pool_init(&fresh, "fresh", fresh_storage, 16, 4);
+    void *first = mem_pool_alloc(&fresh);
+    CHECK(first == (void *)fresh_storage);
+    CHECK(!mem_pool_free(&fresh, (uint8_t *)fresh_storage + 16));
+    CHECK(mem_pool_free(&fresh, first));
+    check_stats(&fresh, 0, 1, 0);
+    CHECK(mem_pool_alloc(&fresh) == first);     // Reused before untouched blocks
+}
+
+static void check_arena(void)
+{
+    MEM_ARENA_DEFINE(arena, 100);
+    CHECK_EQ(arena.size, 104);
+
+    uint8_t *a = mem_arena_alloc(&arena, 1);
+    uint8_t *b = mem_arena_alloc(&arena, 9);
+    CHECK(a == arena.base);
+    CHECK(b == arena.base + 8);
+    uint32_t mark = mem_arena_mark(&arena);
+    CHECK_EQ(mark, 24);
+
+    CHECK(mem_arena_alloc(&arena, 0) == NULL);
+    CHECK(mem_arena_alloc(&arena, 81) == NULL);             // 88 > 80 left
+    CHECK(mem_arena_alloc(&arena, UINT32_MAX - 3U) == NULL); // Wraps when aligned
+    uint8_t *c = mem_arena_alloc(&arena, 80);
+    CHECK(c == arena.base + 24);
+    CHECK(mem_arena_alloc(&arena, 1) == NULL);
+
+    mem_stats_t stats;
+    mem_arena_get_stats(&arena, &stats);
+    CHECK_EQ(stats.used, 104);
+    CHECK_EQ(stats.peak, 104);
+    CHECK_EQ(stats.failures, 3);
+
+    mem_arena_release(&arena, mark);
+    CHECK(mem_arena_alloc(&arena, 8) == c);
+    mem_arena_release(&arena, 200);                         // Ahead of the fill level: ignored
+    CHECK_EQ(mem_arena_mark(&arena), 32);
+    mem_arena_reset(&arena);
+    mem_arena_get_stats(&arena, &stats);
+    CHECK_EQ(stats.used, 0);
+    CHECK_EQ(stats.peak, 104);
+    CHECK(mem_arena_alloc(&arena, 104) == arena.base);
+    CHECK_EQ(g_irq_locked, 0);
+}
+
+// --- Throughput against malloc ---
+static const uint16_t bench_sizes[] = { 16, 24, 40, 64, 100, 128, 200, 256 };
+
+MEM_POOL_DEFINE(bench_small, 32, BENCH_SLOTS);
+MEM_POOL_DEFINE(bench_medium, 128, BENCH_SLOTS);
+MEM_POOL_DEFINE(bench_large, 256, BENCH_SLOTS);
+
+static mem_pool_t *bench_pool(uint16_t size)
+{
+    return (size <= 32U) ? &bench_small : (size <= 128U) ? &bench_medium : &bench_large;
+}
+
+// glibc heap around the malloc churn
+static struct {
+    size_t live;            // Bytes requested by the blocks in use
+    size_t arena_before;    // Heap obtained from the system, before and after
+    size_t arena_after;
+    size_t free_after;      // Free bytes inside the heap
+    size_t holes_after;     // Of those, free bytes below the top chunk
+} g_heap;
+
+static void heap_sample(size_t *arena, size_t *free_bytes, size_t *holes)
+{
+#if defined(__GLIBC__)
+    struct mallinfo2 info = mallinfo2();
+    *arena = info.arena;
+    *free_bytes = info.fordblks;
+    *holes = info.fordblks - info.keepcost;
+#else
+    *arena = *free_bytes = *holes = 0;
+#endif
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Frees and reallocates random slots with random sizes.
+ * @param use_pool true for the pools, false for malloc.
+ * @return Nanoseconds per alloc/free pair.
+ */
+static double bench_churn(bool use_pool)
+{
+    static void *slots[BENCH_SLOTS];
+    static uint16_t sizes[BENCH_SLOTS];
+    uint32_t rng = 0x1234567U;
+    uint32_t failed = 0;
+
+    for(uint32_t i = 0; i < BENCH_SLOTS; i++) {
+        sizes[i] = bench_sizes[rng_next(&rng) % 8U];
+        slots[i] = use_pool ? mem_pool_alloc(bench_pool(sizes[i])) : malloc(sizes[i]);
+    }
+
+    size_t unused_free, unused_holes;
+    if(!use_pool)
+        heap_sample(&g_heap.arena_before, &unused_free, &unused_holes);
+
+    double start = now_ns();
+    for(uint32_t op = 0; op < BENCH_OPS; op++) {
+        uint32_t r = rng_next(&rng);
+        uint32_t i = r % BENCH_SLOTS;
+        uint16_t size = bench_sizes[(r >> 16) % 8U];
+        if(use_pool) {
+            mem_pool_free(bench_pool(sizes[i]), slots[i]);
+            slots[i] = mem_pool_alloc(bench_pool(size));
+        } else {
+            free(slots[i]);
+            slots[i] = malloc(size);
+        }
+        sizes[i] = size;
+        failed += (slots[i] == NULL);
+        *(volatile uint8_t *)slots[i] = (uint8_t)op;
+    }
+    double elapsed = now_ns() - start;
+
+    if(!use_pool) {
+        heap_sample(&g_heap.arena_after, &g_heap.free_after, &g_heap.holes_after);
+        g_heap.live = 0;
+        for(uint32_t i = 0; i < BENCH_SLOTS; i++)
+            g_heap.live += sizes[i];
+    }
+
+    for(uint32_t i = 0; i < BENCH_SLOTS; i++) {
+        if(use_pool)
+            mem_pool_free(bench_pool(sizes[i]), slots[i]);
+        else
+            free(slots[i]);
+    }
+    CHECK_EQ(failed, 0);
+    return elapsed / BENCH_OPS;
+}
+
+int main(void)
+{
+    check_pool_churn();
+    check_arena();
+
+    double pool_ns = bench_churn(true);
+    double malloc_ns = bench_churn(false);
+    printf("alloc+free of %u random slots, 16-256 B: pools %.1f ns, malloc %.1f ns\n",
+           BENCH_SLOTS, pool_ns, malloc_ns);
+#if defined(__GLIBC__)
+    printf("after the churn, %zu B live: malloc heap %zu B (%zu B before), %zu B free, %zu B of it in holes; "
+           "pools %u B fixed, no holes\n", g_heap.live, g_heap.arena_after, g_heap.arena_before,
+           g_heap.free_after, g_heap.holes_after, BENCH_SLOTS * (32U + 128U + 256U));
+#endif
+
+    // Each size class only ever holds BENCH_SLOTS blocks: all of them are back
+    mem_stats_t stats;
+    mem_pool_t *pools[] = { &bench_small, &bench_medium, &bench_large };
+    for(uint32_t i = 0; i < 3; i++) {
+        mem_pool_get_stats(pools[i], &stats);
+        CHECK_EQ(stats.used, 0);
+        CHECK_EQ(stats.failures, 0);
+    }
+    return test_result();
+}
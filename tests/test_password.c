@@ -0,0 +1,203 @@
+#include "test.h"
+#include "periph.h"
+#include "password.h"
+#include "sha256.h"
+#include "dwt.h"
+#include "drivers/kvStore/kvStore.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * password.c with the key-value store, the tick and the cycle counter
+ * stubbed, and the DWT and the device ID backed by host memory.
+ *
+ * Checks the results and the backoff, then times password_verify(): a
+ * correct password, wrong ones differing in the first or the last key, and
+ * out of range lengths must all cost the same KDF. Timings are printed,
+ * not checked, so a loaded machine does not fail the test.
+ */
+
+#define UID_BASE        0x1FFF7590U
+#define BENCH_VERIFIES  2000U
+
+// --- Stubs ---
+
+static struct {
+    bool stored;
+    uint8_t value[KV_MAX_VALUE_LEN];
+    uint8_t len;
+    uint32_t sets;
+} g_kv;
+
+static uint32_t g_tick;
+
+bool kv_set(uint16_t key, const void *value, uint8_t len)
+{
+    CHECK_EQ(key, PASSWORD_KV_KEY);
+    if(len > KV_MAX_VALUE_LEN)
+        return false;
+    memcpy(g_kv.value, value, len);
+    g_kv.len = len;
+    g_kv.stored = true;
+    g_kv.sets++;
+    return true;
+}
+
+int kv_get(uint16_t key, void *value, uint8_t max_len)
+{
+    if(key != PASSWORD_KV_KEY || !g_kv.stored)
+        return -1;
+    memcpy(value, g_kv.value, (g_kv.len < max_len) ? g_kv.len : max_len);
+    return g_kv.len;
+}
+
+uint32_t systick_getTick(void)
+{
+    return g_tick;
+}
+
+// --- Checks ---
+
+static void check_sha256(void)
+{
+    static const uint8_t abc[SHA256_DIGEST_SIZE] = {
+        0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+        0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD,
+    };
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, "a", 1);
+    sha256_update(&ctx, "bc", 2);
+    sha256_final(&ctx, digest);
+    CHECK(memcmp(digest, abc, sizeof(abc)) == 0);
+}
+
+static void check_verify(void)
+{
+    // First boot: the default password is stored, salted from the device ID
+    CHECK(password_init(0));
+    CHECK_EQ(g_kv.sets, 1);
+    uint8_t first[KV_MAX_VALUE_LEN];
+    memcpy(first, g_kv.value, sizeof(first));
+
+    CHECK_EQ(password_verify("1234", 4, 0), PASSWORD_OK);
+    CHECK_EQ(password_verify("1235", 4, 0), PASSWORD_WRONG);
+    CHECK_EQ(password_verify("123", 3, 0), PASSWORD_WRONG);
+    CHECK_EQ(password_verify("12345", 5, 0), PASSWORD_WRONG);
+    CHECK_EQ(password_lockout_remaining(0), PASSWORD_BACKOFF_MS);  // Third failure
+    CHECK_EQ(password_verify("1234", 4, 10), PASSWORD_LOCKED);
+    CHECK_EQ(password_lockout_remaining(10), PASSWORD_BACKOFF_MS - 10);
+
+    // Out of range lengths are wrong, even when the stored bytes match
+    CHECK_EQ(password_verify("1234", 0, 1000), PASSWORD_WRONG);
+    CHECK_EQ(password_lockout_remaining(1000), 2 * PASSWORD_BACKOFF_MS);
+
+    // A reset keeps the failure count: the lockout starts again from the boot
+    CHECK(password_init(5000));
+    CHECK_EQ(g_kv.sets, 1);                                 // The stored record is kept
+    CHECK_EQ(password_lockout_remaining(5000), 2 * PASSWORD_BACKOFF_MS);
+    CHECK_EQ(password_verify("1234", 4, 7000), PASSWORD_OK);
+    CHECK_EQ(password_lockout_remaining(7000), 0);
+
+    // The lockout doubles up to its maximum, across the tick wrap
+    uint32_t now = UINT32_MAX - 100U;
+    uint32_t expected = PASSWORD_BACKOFF_MS;
+    for(uint32_t failure = 1; failure <= 16; failure++) {
+        CHECK_EQ(password_verify("0000", 4, now), PASSWORD_WRONG);
+        if(failure < PASSWORD_FREE_ATTEMPTS) {
+            CHECK_EQ(password_lockout_remaining(now), 0);
+            continue;
+        }
+        CHECK_EQ(password_lockout_remaining(now), expected);
+        CHECK_EQ(password_verify("1234", 4, now + expected - 1), PASSWORD_LOCKED);
+        now += expected;
+        expected = (expected * 2 > PASSWORD_BACKOFF_MAX_MS) ? PASSWORD_BACKOFF_MAX_MS : expected * 2;
+    }
+    CHECK_EQ(password_verify("1234", 4, now), PASSWORD_OK);
+
+    // A new password takes a new salt, also when the same password is set again
+    CHECK(!password_set("x", 0));
+    CHECK(!password_set("01234567890123456", PASSWORD_MAX_LEN + 1));
+    g_tick = 12345;
+    CHECK(password_set("1234", 4));
+    CHECK(memcmp(g_kv.value, first, sizeof(first)) != 0);
+    CHECK_EQ(password_verify("1234", 4, now), PASSWORD_OK);
+    CHECK(password_set("0123456789ABCDEF", PASSWORD_MAX_LEN));
+    CHECK_EQ(password_verify("1234", 4, now), PASSWORD_WRONG);
+    CHECK_EQ(password_verify("0123456789ABCDEF", PASSWORD_MAX_LEN, now), PASSWORD_OK);
+}
+
+// --- Benchmark ---
+
+static uint32_t g_bench_ms;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Times password_verify() on one input, past any lockout.
+ * @return Microseconds per call.
+ */
+static double bench_verify(const char *pin, uint8_t length, password_result_t expected)
+{
+    double total = 0;
+    for(uint32_t i = 0; i < BENCH_VERIFIES; i++) {
+        g_bench_ms += PASSWORD_BACKOFF_MAX_MS;
+        double start = now_ns();
+        password_result_t result = password_verify(pin, length, g_bench_ms);
+        total += now_ns() - start;
+        if(result != expected) {
+            fprintf(stderr, "'%.*s': result %d, expected %d\n", length, pin, result, expected);
+            test_failures++;
+            break;
+        }
+    }
+    return total / BENCH_VERIFIES / 1000.0;
+}
+
+static void bench(void)
+{
+    static const char pin[] = "0123456789ABCDEF";
+    CHECK(password_set(pin, PASSWORD_MAX_LEN));
+
+    double ok = bench_verify(pin, PASSWORD_MAX_LEN, PASSWORD_OK);
+    double first = bench_verify("X123456789ABCDEF", PASSWORD_MAX_LEN, PASSWORD_WRONG);
+    double last = bench_verify("0123456789ABCDEX", PASSWORD_MAX_LEN, PASSWORD_WRONG);
+    double empty = bench_verify(pin, 0, PASSWORD_WRONG);
+    double too_long = bench_verify(pin, PASSWORD_MAX_LEN + 1, PASSWORD_WRONG);
+
+    printf("password_verify, %u rounds: correct %.1f us, wrong first key %.1f us, "
+           "wrong last key %.1f us, length 0 %.1f us, length %u %.1f us\n",
+           PASSWORD_ITERATIONS, ok, first, last, empty, PASSWORD_MAX_LEN + 1, too_long);
+
+    // While locked out, a verification does not hash at all
+    g_bench_ms += PASSWORD_BACKOFF_MAX_MS;
+    CHECK_EQ(password_verify(pin, PASSWORD_MAX_LEN, g_bench_ms), PASSWORD_OK);
+    for(uint32_t i = 0; i < PASSWORD_FREE_ATTEMPTS; i++)
+        CHECK_EQ(password_verify("X", 1, g_bench_ms), PASSWORD_WRONG);
+    double start = now_ns();
+    for(uint32_t i = 0; i < BENCH_VERIFIES; i++)
+        CHECK_EQ(password_verify(pin, PASSWORD_MAX_LEN, g_bench_ms), PASSWORD_LOCKED);
+    printf("password_verify while locked out: %.3f us\n", (now_ns() - start) / BENCH_VERIFIES / 1000.0);
+}
+
+int main(void)
+{
+    periph_map(0xE0001000U, 0x1000);       // DWT
+    periph_map(UID_BASE, 0x10);            // Device ID
+    volatile uint32_t *uid = (volatile uint32_t *)UID_BASE;
+    uid[0] = 0x00350047U;
+    uid[1] = 0x4E4B5010U;
+    uid[2] = 0x20333738U;
+    DWT->CYCCNT = 0x1000U;
+
+    check_sha256();
+    check_verify();
+    bench();
+    return test_result();
+}
@@ -0,0 +1,277 @@
+#include "test.h"
+#include "periph.h"
+#include "power.h"
+#include "pwr.h"
+#include "scb.h"
+#include "exti.h"
+#include "lptim.h"
+#include "irq.h"
+#include "trace.h"
+#include <string.h>
+
+/*
+ * power.c on simulated registers: the mode chosen for each idle period and
+ * the time and entries accounted to each mode.
+ *
+ * Time is a microsecond counter. irq_wait() (tests/host/irq.h) plays the
+ * wakeup: in Sleep SysTick keeps running and the counter moves on; in Stop
+ * it is frozen and LPTIM1 either reaches ARR or is read at the wakeup.
+ * After Stop, power.c must add the LPTIM1 time with systick_advance().
+ */
+
+uint32_t g_irq_locked;
+trace_entry_t g_trace_buffer[TRACE_SIZE];
+uint32_t g_trace_head;
+volatile bool g_trace_enabled;
+
+static const rcc_clock_config_t run_clock;
+
+static struct {
+    uint64_t now_us;
+    uint32_t sleep_us;          // Length of the next Sleep
+    uint32_t stop_wakeup_ms;    // LPTIM1 count at the next Stop wakeup, UINT32_MAX for ARR
+    uint32_t kernel_hz;         // Console kernel clock
+    uint32_t waits;
+    uint32_t wait_scr;          // SCB->SCR, PWR->CR1 and console CR1 during the last wait
+    uint32_t wait_pwr_cr1;
+    uint32_t wait_usart_cr1;
+    uint32_t wait_arr;
+    uint32_t advanced_ms;
+    uint32_t clock_configs;
+    char out[256];
+} g_sim;
+
+// --- Stubs ---
+uint64_t systick_get_us(void) { return g_sim.now_us; }
+void rcc_sys_power_clock_enable(void) { }
+void rcc_lptim_clock_enable(uint8_t lptim_number) { (void)lptim_number; }
+uint32_t rcc_usart_kernel_hz(uint8_t usart_number) { (void)usart_number; return g_sim.kernel_hz; }
+void nvic_irq_enable(IRQn_t IRQn) { (void)IRQn; }
+
+void systick_advance(uint32_t ms)
+{
+    g_sim.advanced_ms += ms;
+    g_sim.now_us += (uint64_t)ms * 1000U;
+}
+
+int rcc_clock_config(const rcc_clock_config_t *config)
+{
+    CHECK(config == &run_clock);
+    g_sim.clock_configs++;
+    return 0;
+}
+
+void usart_send_string(usart_t *usart_port, const char *str)
+{
+    (void)usart_port;
+    strncat(g_sim.out, str, sizeof(g_sim.out) - strlen(g_sim.out) - 1);
+}
+
+void usart_send_uint(usart_t *usart_port, uint32_t value)
+{
+    char digits[12];
+    snprintf(digits, sizeof(digits), "%u", value);
+    usart_send_string(usart_port, digits);
+}
+
+void host_irq_wait(void)
+{
+    g_sim.waits++;
+    g_sim.wait_scr = SCB->SCR;
+    g_sim.wait_pwr_cr1 = PWR->CR1;
+    g_sim.wait_usart_cr1 = USART2->CR1;
+    g_sim.wait_arr = LPTIM1->ARR;
+
+    if(!(SCB->SCR & SCB_SCR_SLEEPDEEP)) {
+        g_sim.now_us += g_sim.sleep_us;
+        return;
+    }
+    CHECK(LPTIM1->CR & LPTIM_CR_ENABLE);
+    if(g_sim.stop_wakeup_ms >= LPTIM1->ARR) {
+        LPTIM1->ISR |= LPTIM_ISR_ARRM;
+        LPTIM1->CNT = 0;
+    } else {
+        LPTIM1->ISR &= ~LPTIM_ISR_ARRM;
+        LPTIM1->CNT = g_sim.stop_wakeup_ms;
+    }
+}
+
+static power_mode_t idle(uint32_t idle_ms)
+{
+    uint32_t primask = irq_lock();
+    power_mode_t mode = power_idle(idle_ms);
+    irq_unlock(primask);
+    return mode;
+}
+
+static void check_select_mode(void)
+{
+    static const struct {
+        uint32_t idle_ms;
+        bool stop_allowed;
+        power_mode_t deepest;
+        power_mode_t expected;
+    } cases[] = {
+        { 0, true, POWER_MODE_STOP2, POWER_MODE_RUN },                  // Work pending
+        { 100, true, POWER_MODE_RUN, POWER_MODE_RUN },                  // Sleeping not allowed
+        { 1, true, POWER_MODE_STOP2, POWER_MODE_SLEEP },
+        { POWER_STOP_MIN_MS - 1, true, POWER_MODE_STOP2, POWER_MODE_SLEEP },  // Not worth a PLL relock
+        { POWER_STOP_MIN_MS, true, POWER_MODE_STOP2, POWER_MODE_STOP2 },
+        { POWER_STOP_MIN_MS, true, POWER_MODE_STOP1, POWER_MODE_STOP1 },
+        { 100, true, POWER_MODE_SLEEP, POWER_MODE_SLEEP },
+        { 100, false, POWER_MODE_STOP2, POWER_MODE_SLEEP },             // Peripheral needs its clock
+        { 100, false, POWER_MODE_STOP1, POWER_MODE_SLEEP },
+        { POWER_STOP_MAX_MS + 1, true, POWER_MODE_STOP1, POWER_MODE_STOP1 },
+        { POWER_IDLE_FOREVER, true, POWER_MODE_STOP2, POWER_MODE_STOP2 },
+        { POWER_IDLE_FOREVER, false, POWER_MODE_STOP2, POWER_MODE_SLEEP },
+    };
+    for(uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        power_mode_t mode = power_select_mode(cases[i].idle_ms, cases[i].stop_allowed, cases[i].deepest);
+        if(mode != cases[i].expected) {
+            fprintf(stderr, "idle %u ms, stop %s, deepest %d: mode %d, expected %d\n", cases[i].idle_ms,
+                    cases[i].stop_allowed ? "allowed" : "locked", cases[i].deepest, mode, cases[i].expected);
+            test_failures++;
+        }
+    }
+
+    // Never deeper than allowed, never Stop while locked
+    for(uint32_t idle_ms = 0; idle_ms < 2 * POWER_STOP_MIN_MS; idle_ms++) {
+        for(power_mode_t deepest = POWER_MODE_RUN; deepest < POWER_MODE_COUNT; deepest++) {
+            CHECK(power_select_mode(idle_ms, true, deepest) <= deepest);
+            CHECK(power_select_mode(idle_ms, false, deepest) <= POWER_MODE_SLEEP);
+        }
+    }
+}
+
+/**
+ * @brief No console, Stop 2 allowed: Sleep, Stop to the deadline, Stop cut short.
+ */
+static void check_accounting(void)
+{
+    static const power_config_t config = { .run_clock = &run_clock, .console = NULL, .deepest = POWER_MODE_STOP2 };
+    power_stats_t stats;
+
+    CHECK_EQ(idle(100), POWER_MODE_RUN);        // Before power_init()
+
+    g_sim.now_us = 1000000U;
+    CHECK_EQ(power_init(&config), 0);
+    CHECK(LPTIM1->IER & LPTIM_IER_ARRMIE);
+    CHECK(EXTI->IMR2 & 1U);
+    CHECK(RCC->CFGR & RCC_CFGR_STOPWUCK);
+
+    CHECK_EQ(idle(0), POWER_MODE_RUN);
+    CHECK_EQ(g_sim.waits, 0);
+
+    g_sim.sleep_us = 700;
+    CHECK_EQ(idle(3), POWER_MODE_SLEEP);
+    CHECK(!(g_sim.wait_scr & SCB_SCR_SLEEPDEEP));
+
+    // Stop 2 until LPTIM1 reaches the deadline
+    g_sim.stop_wakeup_ms = UINT32_MAX;
+    CHECK_EQ(idle(100), POWER_MODE_STOP2);
+    CHECK(g_sim.wait_scr & SCB_SCR_SLEEPDEEP);
+    CHECK_EQ(g_sim.wait_pwr_cr1 & PWR_CR1_LPMS_Msk, PWR_CR1_LPMS_STOP2);
+    CHECK_EQ(g_sim.wait_arr, 100);
+    CHECK(!(SCB->SCR & SCB_SCR_SLEEPDEEP));
+    CHECK_EQ(LPTIM1->CR, 0);
+    CHECK_EQ(g_sim.advanced_ms, 100);
+    CHECK_EQ(g_sim.clock_configs, 1);
+
+    // A stop lock keeps the core in Sleep
+    power_stop_lock();
+    power_stop_lock();
+    g_sim.sleep_us = 1000;
+    CHECK_EQ(idle(100), POWER_MODE_SLEEP);
+    power_stop_unlock();
+    CHECK_EQ(idle(100), POWER_MODE_SLEEP);
+    power_stop_unlock();
+    power_stop_unlock();                        // Extra unlocks are ignored
+
+    // No deadline: the longest Stop, woken early by an interrupt
+    g_sim.stop_wakeup_ms = 37;
+    CHECK_EQ(idle(POWER_IDLE_FOREVER), POWER_MODE_STOP2);
+    CHECK_EQ(g_sim.wait_arr, POWER_STOP_MAX_MS);
+    CHECK_EQ(g_sim.advanced_ms, 137);
+    CHECK_EQ(g_sim.clock_configs, 2);
+
+    // Work between the idle periods is run time
+    g_sim.now_us += 5000U;
+
+    power_get_stats(&stats);
+    CHECK_EQ(stats.entries[POWER_MODE_RUN], 1);
+    CHECK_EQ(stats.entries[POWER_MODE_SLEEP], 3);
+    CHECK_EQ(stats.entries[POWER_MODE_STOP1], 0);
+    CHECK_EQ(stats.entries[POWER_MODE_STOP2], 2);
+    CHECK_EQ(stats.time_us[POWER_MODE_SLEEP], 2700);
+    CHECK_EQ(stats.time_us[POWER_MODE_STOP1], 0);
+    CHECK_EQ(stats.time_us[POWER_MODE_STOP2], 137000);
+    CHECK_EQ(stats.time_us[POWER_MODE_RUN], 5000);
+
+    static const char report[] = "Power: run 5 ms 3% x1 sleep 2 ms 1% x3 stop1 0 ms 0% x0 stop2 137 ms 94% x2\r\n";
+    g_sim.out[0] = '\0';
+    power_print_stats(USART2);
+    if(strcmp(g_sim.out, report) != 0) {
+        fprintf(stderr, "report: %s", g_sim.out);
+        test_failures++;
+    }
+    CHECK_EQ(g_irq_locked, 0);
+}
+
+/**
+ * @brief Console on USART2: Stop 1 at most, and only once its last character is out.
+ */
+static void check_console(void)
+{
+    static const power_config_t config = { .run_clock = &run_clock, .console = USART2, .deepest = POWER_MODE_STOP2 };
+    power_stats_t stats;
+
+    // Kernel clock not HSI16: the console cannot wake the MCU, Sleep only
+    g_sim.kernel_hz = 80000000U;
+    USART2->ISR = USART_ISR_TC;
+    CHECK_EQ(power_init(&config), -1);
+    CHECK_EQ(idle(100), POWER_MODE_SLEEP);
+
+    g_sim.kernel_hz = RCC_HSI_HZ;
+    USART2->CR1 = USART_CR1_UE;
+    CHECK_EQ(power_init(&config), 0);
+    CHECK_EQ(USART2->CR3 & (USART_CR3_WUS_Msk | USART_CR3_WUFIE), (2U << USART_CR3_WUS_Pos) | USART_CR3_WUFIE);
+    CHECK(USART2->CR1 & USART_CR1_UE);
+    CHECK(EXTI->IMR1 & (1U << 27));
+
+    // Restarting the statistics with power_init()
+    power_get_stats(&stats);
+    for(uint32_t mode = 0; mode < POWER_MODE_COUNT; mode++)
+        CHECK_EQ(stats.entries[mode], 0);
+
+    USART2->ISR = 0;                            // Still transmitting
+    CHECK_EQ(idle(100), POWER_MODE_SLEEP);
+
+    USART2->ISR = USART_ISR_TC;
+    g_sim.stop_wakeup_ms = 12;
+    CHECK_EQ(idle(100), POWER_MODE_STOP1);
+    CHECK_EQ(g_sim.wait_pwr_cr1 & PWR_CR1_LPMS_Msk, PWR_CR1_LPMS_STOP1);
+    CHECK(g_sim.wait_usart_cr1 & USART_CR1_UESM);
+    CHECK(!(USART2->CR1 & USART_CR1_UESM));
+
+    power_get_stats(&stats);
+    CHECK_EQ(stats.entries[POWER_MODE_SLEEP], 1);
+    CHECK_EQ(stats.entries[POWER_MODE_STOP1], 1);
+    CHECK_EQ(stats.entries[POWER_MODE_STOP2], 0);
+    CHECK_EQ(stats.time_us[POWER_MODE_STOP1], 12000);
+}
+
+int main(void)
+{
+    periph_map(0x40007000U, 0x1000);       // PWR, LPTIM1
+    periph_map(0x40004000U, 0x1000);       // USART2
+    periph_map(0x40010000U, 0x1000);       // EXTI
+    periph_map(0x40021000U, 0x1000);       // RCC
+    periph_map(0xE000E000U, 0x1000);       // SCB
+    LPTIM1->ISR = LPTIM_ISR_ARROK;          // ARR writes complete at once
+
+    check_select_mode();
+    check_accounting();
+    check_console();
+
+    return test_result();
+}
@@ -0,0 +1,180 @@
+#include "test.h"
+#include "periph.h"
+#include "tim.h"
+#include <string.h>
+
+/*
+ * pwm_waveform_start() against a model of a general purpose timer and its
+ * update DMA channel. The timer registers live in host memory at their real
+ * address; CCRx there are the preload registers, the model keeps the active
+ * compare values. On every update event the model, like the hardware:
+ *   1. copies the preload registers to the active ones,
+ *   2. if UDE is set, runs one DMA burst of DBL + 1 items into DBA..DBA+DBL.
+ */
+
+#define TIMER_CLOCK_HZ      80000000U
+#define MAX_FRAMES          64U
+
+// Cycles the same waveform costs without DMA: an update interrupt that
+// writes the next frame (Cortex-M4: 12 cycles entry, 12 exit, flag clear and
+// table index, then a load and a store per channel)
+#define ISR_OVERHEAD_CYCLES 34U
+#define ISR_CHANNEL_CYCLES  4U
+
+static GeneralPurpose_Timer_t *const tim = TIM3;
+
+static struct {
+    dma_config_t config;
+    bool enabled;
+    uint16_t remaining;
+    uint32_t next;
+    uint32_t bursts;
+} g_dma;
+
+static uint32_t g_active[4];
+static uint32_t g_updates;
+
+// --- Stubs for the drivers tim.c calls ---
+void gpio_init(const gpio_config_t *config) { (void)config; }
+void rcc_tim_clock_enable(uint8_t timer_number) { (void)timer_number; }
+void nvic_irq_enable(IRQn_t IRQn) { (void)IRQn; }
+
+int dma_init(const dma_config_t *config)
+{
+    g_dma.config = *config;
+    g_dma.enabled = false;
+    g_dma.remaining = config->count;
+    g_dma.next = 0;
+    g_dma.bursts = 0;
+    return 0;
+}
+
+void dma_enable(dma_t *DMAx, uint8_t channel) { (void)DMAx; (void)channel; g_dma.enabled = true; }
+void dma_disable(dma_t *DMAx, uint8_t channel) { (void)DMAx; (void)channel; g_dma.enabled = false; }
+
+static void model_update_event(void)
+{
+    volatile uint32_t *regs = &tim->CR1;
+    volatile uint32_t *ccr = &tim->CCR1;
+
+    for(uint32_t ch = 0; ch < 4; ch++)
+        g_active[ch] = ccr[ch];
+    g_updates++;
+
+    if(!(tim->DIER & TIM_DIER_UDE) || !g_dma.enabled)
+        return;
+
+    const uint16_t *table = g_dma.config.mem_addr;
+    uint32_t base = (tim->DCR >> TIM_DCR_DBA_Pos) & 0x1FU;
+    uint32_t length = ((tim->DCR >> TIM_DCR_DBL_Pos) & 0x1FU) + 1U;
+    for(uint32_t i = 0; i < length; i++) {
+        regs[base + i] = table[g_dma.next];
+        g_dma.next = (g_dma.next + 1U) % g_dma.config.count;
+        if(--g_dma.remaining == 0 && g_dma.config.circular)
+            g_dma.remaining = g_dma.config.count;
+    }
+    g_dma.bursts++;
+}
+
+// A UG written to EGR is served by the model, then EGR reads back 0
+static void model_run(void)
+{
+    if(tim->EGR & TIM_EGR_UG) {
+        tim->EGR = 0;
+        model_update_event();
+    }
+}
+
+uint16_t dma_get_remaining(dma_t *DMAx, uint8_t channel)
+{
+    (void)DMAx;
+    (void)channel;
+    model_run();
+    return g_dma.remaining;
+}
+
+static void model_reset(void)
+{
+    memset((void *)tim, 0, sizeof(*tim));
+    memset(g_active, 0, sizeof(g_active));
+    g_updates = 0;
+}
+
+/**
+ * @brief Starts a waveform and checks that period k outputs frame k, for a few table wraps.
+ */
+static void check_waveform(uint8_t channels, uint16_t frames)
+{
+    static uint16_t table[MAX_FRAMES * 4];
+    for(uint32_t i = 0; i < (uint32_t)frames * channels; i++)
+        table[i] = (uint16_t)(100U + i);    // Every item distinct
+
+    pwm_waveform_config_t config = {
+        .pwmTimer   = tim,
+        .channels   = channels,
+        .table      = table,
+        .frames     = frames,
+        .prescaler  = 1,
+        .period     = 3200
+    };
+
+    model_reset();
+    CHECK_EQ(pwm_waveform_start(&config), 0);
+    model_run();
+
+    // Register setup
+    CHECK_EQ(tim->PSC, 0);
+    CHECK_EQ(tim->ARR, 3199);
+    CHECK(tim->CR1 & TIM_CR1_CEN);
+    CHECK(tim->CR1 & TIM_CR1_ARPE);
+    CHECK(tim->DIER & TIM_DIER_UDE);
+    CHECK_EQ(tim->DCR, ((uint32_t)(channels - 1U) << TIM_DCR_DBL_Pos) | TIM_DCR_DBA_CCR1);
+    CHECK(g_dma.enabled);
+    CHECK(g_dma.config.circular);
+    CHECK_EQ(g_dma.config.count, (uint32_t)frames * channels);
+    CHECK(g_dma.config.periph_addr == &tim->DMAR);
+
+    // Period 0 runs with the active values left by the start-up update events
+    for(uint32_t period = 0; period < 3U * frames + 1U; period++) {
+        uint32_t frame = period % frames;
+        for(uint32_t ch = 0; ch < channels; ch++)
+            CHECK_EQ(g_active[ch], table[frame * channels + ch]);
+        model_update_event();
+    }
+}
+
+int main(void)
+{
+    periph_map(TIM2_BASE, TIM5_BASE + 0x400U - TIM2_BASE);
+
+    for(uint8_t channels = 1; channels <= 4; channels++) {
+        check_waveform(channels, 1);
+        check_waveform(channels, 2);
+        check_waveform(channels, 17);
+        check_waveform(channels, MAX_FRAMES);
+    }
+
+    // Invalid configurations
+    uint16_t table[4] = { 0 };
+    pwm_waveform_config_t config = { .pwmTimer = tim, .channels = 0, .table = table, .frames = 1,
+                                     .prescaler = 1, .period = 100 };
+    CHECK_EQ(pwm_waveform_start(&config), -1);
+    config.channels = 5;
+    CHECK_EQ(pwm_waveform_start(&config), -1);
+    config.channels = 1;
+    config.frames = 0;
+    CHECK_EQ(pwm_waveform_start(&config), -1);
+    config.frames = 1;
+    config.pwmTimer = (GeneralPurpose_Timer_t *)TIM6;   // No update DMA burst support
+    CHECK_EQ(pwm_waveform_start(&config), -1);
+
+    // CPU time the DMA takes over, for the fan PWM rate (80 MHz / 3200 = 25 kHz)
+    uint32_t update_hz = TIMER_CLOCK_HZ / 3200U;
+    for(uint32_t channels = 1; channels <= 4; channels++) {
+        uint32_t cycles = update_hz * (ISR_OVERHEAD_CYCLES + channels * ISR_CHANNEL_CYCLES);
+        printf("%u channel(s) at %u Hz: %u CPU cycles/s saved (%.2f %% of %u MHz)\n",
+               channels, update_hz, cycles, 100.0 * cycles / TIMER_CLOCK_HZ, TIMER_CLOCK_HZ / 1000000U);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,416 @@
+#include "test.h"
+#include "room_control.h"
+#include <string.h>
+
+/*
+ * Room control against a flat reference model written from the description
+ * in room_control.h, over millions of random sequences of events and time
+ * steps. After every event and every tick the state, the outputs, the timer,
+ * the callbacks made and the passwords checked must match the model.
+ *
+ * The model keeps time in 64 bits since the start of the sequence, while the
+ * state machine gets the wrapping 32-bit time from a random start, often
+ * just before the wrap: timeouts must fire on the first tick at or past
+ * their delay, never before.
+ */
+
+#define SEQUENCES       2000000U
+#define STEPS           24U
+#define LOG_SIZE        (STEPS * 12U)
+
+static const char g_password[RC_PIN_MAX] = { '3', '1', '4', '1', '5', '9', '2', '6' };
+
+typedef struct {
+    rc_state_t state;
+    bool locked;
+    rc_fan_t fan;
+    rc_fan_t fan_user;
+    bool armed;
+    uint64_t armed_at;
+    uint32_t timeout;
+    char pin[RC_PIN_MAX];
+    uint32_t pin_length;
+    // Callbacks expected so far
+    uint32_t door_calls;
+    uint32_t fan_calls;
+    uint32_t state_calls;
+    uint32_t password_calls;
+    uint8_t checked_length;         // Last password checked
+    char checked[RC_PIN_MAX];
+} model_t;
+
+// What the callbacks saw
+static struct {
+    bool locked;
+    rc_fan_t fan;
+    rc_state_t state;
+    uint32_t door_calls;
+    uint32_t fan_calls;
+    uint32_t state_calls;
+    uint32_t password_calls;
+    char pin[RC_PIN_MAX];
+    uint8_t pin_length;
+} g_io;
+
+static model_t g_model;
+static uint64_t g_time;             // Model time since the start of the sequence
+
+// Replay of the current sequence when it fails
+static struct {
+    char what;                      // 'e' event, 't' tick
+    uint32_t a, b;
+} g_log[LOG_SIZE];
+static uint32_t g_log_count;
+
+static void io_door(bool locked)        { g_io.locked = locked; g_io.door_calls++; }
+static void io_fan(rc_fan_t level)      { g_io.fan = level; g_io.fan_calls++; }
+static void io_state(rc_state_t state)  { g_io.state = state; g_io.state_calls++; }
+
+static bool io_check_password(const char *pin, uint8_t length)
+{
+    g_io.password_calls++;
+    g_io.pin_length = length;
+    memcpy(g_io.pin, pin, (length <= RC_PIN_MAX) ? length : RC_PIN_MAX);
+    return length == RC_PIN_MAX && memcmp(pin, g_password, RC_PIN_MAX) == 0;
+}
+
+static const room_control_io_t g_room_io = {
+    .door = io_door, .fan = io_fan, .state_changed = io_state, .check_password = io_check_password,
+};
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// --- Reference model ---
+
+static void model_door(bool locked)
+{
+    if(g_model.locked != locked) {
+        g_model.locked = locked;
+        g_model.door_calls++;
+    }
+}
+
+static void model_fan(rc_fan_t level)
+{
+    if(g_model.fan != level) {
+        g_model.fan = level;
+        g_model.fan_calls++;
+    }
+}
+
+static void model_arm(uint32_t timeout)
+{
+    g_model.armed = true;
+    g_model.armed_at = g_time;
+    g_model.timeout = timeout;
+}
+
+static void model_go(rc_state_t target)
+{
+    if(g_model.state == RC_STATE_EMERGENCY)
+        model_fan(g_model.fan_user);
+    g_model.armed = false;
+
+    switch(target) {
+    case RC_STATE_LOCKED_IDLE:
+        model_door(true);
+        g_model.pin_length = 0;
+        break;
+    case RC_STATE_DENIED:
+        model_door(true);
+        g_model.pin_length = 0;
+        model_arm(RC_DENIED_MS);
+        break;
+    case RC_STATE_UNLOCKED_TEMP:
+        model_door(false);
+        model_arm(RC_UNLOCK_TEMP_MS);
+        break;
+    case RC_STATE_UNLOCKED_PERM:
+        model_door(false);
+        break;
+    case RC_STATE_EMERGENCY:
+        model_door(true);
+        model_fan(RC_FAN_HIGH);
+        break;
+    default:
+        break;
+    }
+    g_model.state = target;
+    g_model.state_calls++;
+}
+
+static void model_key(char key)
+{
+    if(key == '*') {
+        g_model.pin_length = 0;
+    } else if(key == '#') {
+        bool granted = false;
+        if(g_model.pin_length >= 1 && g_model.pin_length <= RC_PIN_MAX) {
+            g_model.password_calls++;
+            g_model.checked_length = (uint8_t)g_model.pin_length;
+            memcpy(g_model.checked, g_model.pin, RC_PIN_MAX);
+            granted = g_model.pin_length == RC_PIN_MAX && memcmp(g_model.pin, g_password, RC_PIN_MAX) == 0;
+        }
+        model_go(granted ? RC_STATE_UNLOCKED_TEMP : RC_STATE_DENIED);
+    } else {
+        if(g_model.pin_length < RC_PIN_MAX)
+            g_model.pin[g_model.pin_length] = key;
+        if(g_model.pin_length < UINT8_MAX)
+            g_model.pin_length++;
+    }
+}
+
+static void model_event(rc_event_t event, uint32_t arg)
+{
+    rc_state_t state = g_model.state;
+    bool locked = state == RC_STATE_LOCKED_IDLE || state == RC_STATE_DENIED;
+
+    if(state == RC_STATE_EMERGENCY) {
+        if(event == RC_EV_EMERGENCY_OFF)
+            model_go(RC_STATE_LOCKED_IDLE);
+        else if(event == RC_EV_FAN_SET && arg < RC_FAN_LEVELS)
+            g_model.fan_user = (rc_fan_t)arg;
+        return;
+    }
+
+    switch(event) {
+    case RC_EV_EMERGENCY_ON:
+        model_go(RC_STATE_EMERGENCY);
+        break;
+    case RC_EV_FAN_SET:
+        if(arg < RC_FAN_LEVELS) {
+            g_model.fan_user = (rc_fan_t)arg;
+            model_fan(g_model.fan_user);
+        }
+        break;
+    case RC_EV_KEY:
+        if(state == RC_STATE_LOCKED_IDLE)
+            model_key((char)arg);
+        break;
+    case RC_EV_BUTTON:
+        model_go(locked ? RC_STATE_UNLOCKED_TEMP : RC_STATE_LOCKED_IDLE);
+        break;
+    case RC_EV_REMOTE_OPEN:
+        if(locked || state == RC_STATE_UNLOCKED_TEMP)
+            model_go(RC_STATE_UNLOCKED_TEMP);
+        break;
+    case RC_EV_UNLOCK:
+        if(state != RC_STATE_UNLOCKED_PERM)
+            model_go(RC_STATE_UNLOCKED_PERM);
+        break;
+    case RC_EV_LOCK:
+        if(!locked)
+            model_go(RC_STATE_LOCKED_IDLE);
+        break;
+    case RC_EV_TIMEOUT:
+        if(state == RC_STATE_DENIED || state == RC_STATE_UNLOCKED_TEMP)
+            model_go(RC_STATE_LOCKED_IDLE);
+        break;
+    default:
+        break;
+    }
+}
+
+// --- Comparison ---
+
+static bool matches(const room_control_t *rc, uint32_t now)
+{
+    const model_t *m = &g_model;
+    uint32_t left = UINT32_MAX;
+    if(m->armed)
+        left = (g_time - m->armed_at >= m->timeout) ? 0 : (uint32_t)(m->timeout - (g_time - m->armed_at));
+
+    bool in_locked = m->state == RC_STATE_LOCKED_IDLE || m->state == RC_STATE_DENIED;
+    bool in_unlocked = m->state == RC_STATE_UNLOCKED_TEMP || m->state == RC_STATE_UNLOCKED_PERM;
+    const char *what = NULL;
+
+    if(rc->state != m->state)
+        what = "state";
+    else if(rc->door_locked != m->locked || g_io.locked != m->locked)
+        what = "door";
+    else if(rc->fan != m->fan || g_io.fan != m->fan || rc->fan_user != m->fan_user)
+        what = "fan";
+    else if(rc->timer_armed != m->armed || room_control_time_to_deadline(rc, now) != left)
+        what = "timeout";
+    else if(g_io.door_calls != m->door_calls || g_io.fan_calls != m->fan_calls)
+        what = "output callbacks";
+    else if(g_io.state_calls != m->state_calls || g_io.state != m->state)
+        what = "state_changed callbacks";
+    else if(g_io.password_calls != m->password_calls || g_io.pin_length != m->checked_length
+            || memcmp(g_io.pin, m->checked, m->checked_length) != 0)
+        what = "password checks";
+    else if(m->state == RC_STATE_LOCKED_IDLE && (rc->pin_length != m->pin_length
+            || memcmp(rc->pin, m->pin, (m->pin_length <= RC_PIN_MAX) ? m->pin_length : RC_PIN_MAX) != 0))
+        what = "pin";
+    else if(room_control_in_state(rc, RC_STATE_LOCKED) != in_locked
+            || room_control_in_state(rc, RC_STATE_UNLOCKED) != in_unlocked
+            || room_control_in_state(rc, RC_STATE_NORMAL) != (m->state != RC_STATE_EMERGENCY))
+        what = "in_state";
+
+    if(what == NULL)
+        return true;
+    fprintf(stderr, "%s differs: state %s (model %s), locked %d (%d), fan %d (%d), "
+            "time left %u (%u), at %llu ms\n", what,
+            room_control_state_name(rc->state), room_control_state_name(m->state),
+            rc->door_locked, m->locked, rc->fan, m->fan,
+            room_control_time_to_deadline(rc, now), left, (unsigned long long)g_time);
+    return false;
+}
+
+static void log_step(char what, uint32_t a, uint32_t b)
+{
+    if(g_log_count < LOG_SIZE)
+        g_log[g_log_count++] = (typeof(g_log[0])){ what, a, b };
+}
+
+// The password typed with a given number of its keys (more than RC_PIN_MAX: extra digits)
+static bool type_pin(room_control_t *rc, uint32_t keys, uint32_t start)
+{
+    for(uint32_t i = 0; i <= keys; i++) {
+        char key = (i == keys) ? '#' : (i < RC_PIN_MAX) ? g_password[i] : '7';
+        log_step('e', RC_EV_KEY, (uint32_t)key);
+        room_control_dispatch(rc, RC_EV_KEY, (uint32_t)key, start + (uint32_t)g_time);
+        model_event(RC_EV_KEY, (uint32_t)key);
+        if(!matches(rc, start + (uint32_t)g_time))
+            return false;
+    }
+    return true;
+}
+
+static const uint32_t time_steps[] = {
+    0, 1, RC_DENIED_MS - 1, RC_DENIED_MS, RC_DENIED_MS + 1,
+    RC_UNLOCK_TEMP_MS - 1, RC_UNLOCK_TEMP_MS, RC_UNLOCK_TEMP_MS + 1,
+};
+
+/**
+ * @brief Runs one random sequence from its seed.
+ * @return false at the first difference with the model.
+ */
+static bool run_sequence(uint32_t seed)
+{
+    uint32_t rng = seed;
+    room_control_t rc;
+
+    // Start before the wrap half of the time
+    uint32_t start = rng_next(&rng);
+    if(start & 1U)
+        start = UINT32_MAX - (start >> 16);
+
+    memset(&g_io, 0, sizeof(g_io));
+    g_io.fan = RC_FAN_LEVELS;                       // init must drive the fan
+    g_model = (model_t){ .state = RC_STATE_LOCKED_IDLE, .locked = true, .door_calls = 1,
+                         .fan_calls = 1, .state_calls = 1 };
+    g_time = 0;
+    g_log_count = 0;
+
+    room_control_init(&rc, &g_room_io, start);
+    if(!matches(&rc, start))
+        return false;
+
+    for(uint32_t step = 0; step < STEPS; step++) {
+        uint32_t r = rng_next(&rng);
+        uint32_t choice = r % 16U;
+        uint32_t now = start + (uint32_t)g_time;
+
+        if(choice < 3) {
+            if(!type_pin(&rc, (r >> 8) % (RC_PIN_MAX + 3U), start))
+                return false;
+        } else {
+            rc_event_t event;
+            uint32_t arg = 0;
+            if(choice < 6) {
+                static const char keys[] = "0123456789*#";
+                event = RC_EV_KEY;
+                arg = (uint32_t)keys[(r >> 8) % 12U];
+            } else if(choice < 8) {
+                event = RC_EV_FAN_SET;
+                arg = (r >> 8) % (RC_FAN_LEVELS + 1U);      // One level out of range
+            } else {
+                // Every other event, TIMEOUT dispatched directly, and one out of range
+                static const rc_event_t others[] = {
+                    RC_EV_BUTTON, RC_EV_REMOTE_OPEN, RC_EV_LOCK, RC_EV_UNLOCK, RC_EV_EMERGENCY_ON,
+                    RC_EV_EMERGENCY_OFF, RC_EV_EMERGENCY_OFF, RC_EV_TIMEOUT, RC_EV_COUNT,
+                };
+                event = others[(r >> 8) % (sizeof(others) / sizeof(others[0]))];
+            }
+            log_step('e', event, arg);
+            room_control_dispatch(&rc, event, arg, now);
+            model_event(event, arg);
+            if(!matches(&rc, now))
+                return false;
+        }
+
+        // Time passes, near the timeouts or anywhere below the longest one
+        uint32_t t = rng_next(&rng);
+        uint32_t elapsed = (t & 1U) ? time_steps[(t >> 1) % (sizeof(time_steps) / sizeof(time_steps[0]))]
+                                    : (t >> 1) % (RC_UNLOCK_TEMP_MS + 2U);
+        g_time += elapsed;
+        now = start + (uint32_t)g_time;
+        log_step('t', elapsed, 0);
+
+        if(!matches(&rc, now))
+            return false;
+        room_control_tick(&rc, now);
+        if(g_model.armed && g_time - g_model.armed_at >= g_model.timeout)
+            model_event(RC_EV_TIMEOUT, 0);
+        if(!matches(&rc, now))
+            return false;
+    }
+    return true;
+}
+
+static void check_random_sequences(void)
+{
+    uint32_t seed = 0x2545F491U;
+    for(uint32_t sequence = 0; sequence < SEQUENCES; sequence++) {
+        uint32_t sequence_seed = rng_next(&seed);
+        if(!run_sequence(sequence_seed)) {
+            fprintf(stderr, "sequence %u (seed 0x%08X) after:\n", sequence, sequence_seed);
+            for(uint32_t i = 0; i < g_log_count; i++) {
+                if(g_log[i].what == 't')
+                    fprintf(stderr, "  +%u ms, tick\n", g_log[i].a);
+                else
+                    fprintf(stderr, "  event %u arg %u\n", g_log[i].a, g_log[i].b);
+            }
+            test_failures++;
+            return;
+        }
+    }
+}
+
+static void check_fixed(void)
+{
+    // Without callbacks every password is refused
+    room_control_t rc;
+    room_control_init(&rc, NULL, 0);
+    for(uint32_t i = 0; i < RC_PIN_MAX; i++)
+        room_control_dispatch(&rc, RC_EV_KEY, (uint32_t)g_password[i], 0);
+    room_control_dispatch(&rc, RC_EV_KEY, '#', 0);
+    CHECK_EQ(rc.state, RC_STATE_DENIED);
+    CHECK(rc.door_locked);
+
+    CHECK_EQ(room_control_fan_percent(RC_FAN_OFF), 0);
+    CHECK_EQ(room_control_fan_percent(RC_FAN_LOW), 25);
+    CHECK_EQ(room_control_fan_percent(RC_FAN_MED), 60);
+    CHECK_EQ(room_control_fan_percent(RC_FAN_HIGH), 100);
+    CHECK_EQ(room_control_fan_percent(RC_FAN_LEVELS), 0);
+    for(rc_state_t state = RC_STATE_NORMAL; state < RC_STATE_COUNT; state++)
+        CHECK(room_control_state_name(state)[0] != '\0');
+    CHECK(room_control_state_name(RC_STATE_COUNT)[0] == '\0');
+}
+
+int main(void)
+{
+    check_fixed();
+    check_random_sequences();
+    return test_result();
+}
@@ -0,0 +1,345 @@
+#include "test.h"
+#include "swtimer.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Timer wheel against a brute-force model: a list of timers and their
+ * expiry times, kept in 64 bits from the start while the wheel runs on the
+ * wrapping 32-bit tick.
+ *
+ * - Every delay class alone: each timer fires exactly at its expiry, after
+ *   at most one swtimer_time_to_next() hop per level it cascades through.
+ * - Random starts, stops, restarts from callbacks and time steps from 1 ms
+ *   to days: a timer fires in the first swtimer_process() that covers its
+ *   expiry, in expiry order, and swtimer_time_to_next() is never past the
+ *   first expiry.
+ * - 10k periodic timers, processed every millisecond: every expiry
+ *   happens, and the cost per tick is printed.
+ */
+
+#define MODEL_TIMERS    64U
+#define RANDOM_OPS      300000U
+#define BENCH_TIMERS    10000U
+#define BENCH_TICKS     1000000U
+#define PARK_MS         (1UL << (SWTIMER_LEVELS * SWTIMER_SLOT_BITS))   // Range of the wheel
+#define PARK_ROUND_MS   (PARK_MS - PARK_MS / SWTIMER_SLOTS)             // Least progress of a parked timer per re-filing
+
+static uint32_t g_now;
+
+uint32_t systick_getTick(void)
+{
+    return g_now;
+}
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// --- Every delay class alone ---
+
+static uint32_t g_fired_at;
+static uint32_t g_fire_count;
+
+static void on_single(swtimer_t *timer)
+{
+    (void)timer;
+    g_fired_at = g_now;
+    g_fire_count++;
+}
+
+static void check_single(uint32_t start, uint32_t delay)
+{
+    swtimer_t timer;
+    swtimer_init(start);
+    g_now = start;
+    swtimer_process(g_now);
+    CHECK_EQ(swtimer_time_to_next(g_now), SWTIMER_NONE);
+
+    swtimer_setup(&timer, on_single, NULL);
+    swtimer_start(&timer, delay, 0);
+    if(delay > SWTIMER_MAX_DELAY_MS)
+        delay = SWTIMER_MAX_DELAY_MS;
+    if(delay < SWTIMER_SLOTS)
+        CHECK_EQ(swtimer_time_to_next(g_now), delay);
+
+    uint32_t hops = 0;
+    uint32_t max_hops = SWTIMER_LEVELS + delay / PARK_ROUND_MS + 1U;
+    g_fire_count = 0;
+    while(g_fire_count == 0 && hops <= max_hops) {
+        uint32_t next = swtimer_time_to_next(g_now);
+        if(next == 0 || next == SWTIMER_NONE || next > start + delay - g_now) {
+            fprintf(stderr, "delay %u from 0x%08X: time to next %u at +%u\n",
+                    delay, start, next, g_now - start);
+            test_failures++;
+            return;
+        }
+        g_now += next;
+        swtimer_process(g_now);
+        hops++;
+    }
+    if(g_fire_count != 1 || g_fired_at != start + delay || hops > max_hops || swtimer_is_active(&timer)) {
+        fprintf(stderr, "delay %u from 0x%08X: fired %u times, at +%u, after %u hops\n",
+                delay, start, g_fire_count, g_fired_at - start, hops);
+        test_failures++;
+    }
+    CHECK_EQ(swtimer_time_to_next(g_now), SWTIMER_NONE);
+}
+
+static void check_delay_classes(void)
+{
+    static const uint32_t starts[] = { 0, 1, 63, 64, 4095, 0x0003FFFFU, 0xFFFFFFC0U, 0xFFFFFFFFU, 0x89ABCDEFU };
+    static const uint32_t delays[] = {
+        1, 2, 62, 63, 64, 65, 127, 128, 4095, 4096, 4097, 100000,
+        (1UL << 18) - 1U, 1UL << 18, (1UL << 18) + 1U, 5000000,
+        PARK_MS - 1U, PARK_MS, PARK_MS + 1U, 3U * PARK_MS + 12345U,
+        SWTIMER_MAX_DELAY_MS, UINT32_MAX,
+    };
+    for(uint32_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+        for(uint32_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++)
+            check_single(starts[s], delays[d]);
+    }
+}
+
+// --- Random operations against the model ---
+
+typedef struct {
+    swtimer_t timer;
+    bool active;
+    uint64_t expires;
+    uint64_t runs_at;       // Expiry, or the next tick processed for a timer started late
+    uint32_t period;
+} model_timer_t;
+
+static model_timer_t g_timers[MODEL_TIMERS];
+static uint64_t g_time;             // Model time since the start
+static uint32_t g_start;
+static uint32_t g_rng;
+static uint64_t g_wheel_time;       // Next tick the wheel processes
+static uint64_t g_last_fired;       // runs_at of the last callback of this swtimer_process()
+static bool g_failed;
+
+static uint32_t random_delay(void)
+{
+    uint32_t r = rng_next(&g_rng);
+    switch(r % 8U) {
+    case 0:  return (r >> 8) % 4U;
+    case 1:  return (r >> 8) % SWTIMER_SLOTS;
+    case 2:  return (r >> 8) % 4096U;
+    case 3:  return (r >> 8) % (1UL << 18);
+    case 4:  return (r >> 8) % PARK_MS;
+    case 5:  return (r % 64U == 5U) ? rng_next(&g_rng) % (SWTIMER_MAX_DELAY_MS / 4U) : 1U + (r >> 8) % 100U;
+    default: return 1U + (r >> 8) % 300U;
+    }
+}
+
+static void model_start(model_timer_t *t, uint32_t delay, uint32_t period)
+{
+    swtimer_start(&t->timer, delay, period);
+    t->active = true;
+    t->expires = g_time + delay;
+    t->runs_at = (t->expires < g_wheel_time) ? g_wheel_time : t->expires;
+    t->period = period;
+}
+
+static void model_stop(model_timer_t *t)
+{
+    swtimer_stop(&t->timer);
+    t->active = false;
+}
+
+static void on_model(swtimer_t *timer)
+{
+    model_timer_t *t = timer->context;
+    if(!t->active || t->expires > g_time || t->runs_at < g_last_fired) {
+        if(!g_failed)
+            fprintf(stderr, "timer %u fired at +%llu: active %d, due at +%llu, after one run at +%llu\n",
+                    (uint32_t)(t - g_timers), (unsigned long long)g_time, t->active,
+                    (unsigned long long)t->expires, (unsigned long long)g_last_fired);
+        g_failed = true;
+        return;
+    }
+    g_last_fired = t->runs_at;
+
+    if(t->period != 0) {
+        t->expires += t->period;
+        if(t->expires <= g_time)            // Missed periods are dropped
+            t->expires = g_time + t->period;
+        t->runs_at = t->expires;
+    } else {
+        t->active = false;
+    }
+
+    // Callbacks may restart themselves and start or stop other timers
+    uint32_t r = rng_next(&g_rng);
+    model_timer_t *other = &g_timers[(r >> 8) % MODEL_TIMERS];
+    switch(r % 8U) {
+    case 0:  model_start(t, 1U + random_delay(), (r & 0x100U) ? 1U + random_delay() : 0); break;
+    case 1:  model_stop(t); break;
+    case 2:  model_stop(other); break;
+    case 3:  if(other != t) model_start(other, 1U + random_delay(), 0); break;
+    default: break;
+    }
+}
+
+/**
+ * @brief Compares the wheel with the model after a swtimer_process() up to now.
+ */
+static bool model_matches(void)
+{
+    uint64_t first = UINT64_MAX;
+    for(uint32_t i = 0; i < MODEL_TIMERS; i++) {
+        model_timer_t *t = &g_timers[i];
+        if(swtimer_is_active(&t->timer) != t->active) {
+            fprintf(stderr, "timer %u: active %d, model %d\n", i, swtimer_is_active(&t->timer), t->active);
+            return false;
+        }
+        if(!t->active)
+            continue;
+        if(t->expires <= g_time) {
+            fprintf(stderr, "timer %u due at +%llu did not fire by +%llu\n",
+                    i, (unsigned long long)t->expires, (unsigned long long)g_time);
+            return false;
+        }
+        if(t->expires < first)
+            first = t->expires;
+    }
+
+    uint32_t next = swtimer_time_to_next(g_start + (uint32_t)g_time);
+    if(first == UINT64_MAX ? next != SWTIMER_NONE : (next == 0 || next > first - g_time)) {
+        fprintf(stderr, "time to next %u at +%llu, first expiry at +%llu\n",
+                next, (unsigned long long)g_time, (unsigned long long)first);
+        return false;
+    }
+    return true;
+}
+
+static void check_random(void)
+{
+    g_rng = 0x9E3779B9U;
+    g_start = 0xFFFFFFFFU - 500000U;        // Wraps early in the run
+    g_time = 0;
+    g_wheel_time = 0;
+    g_now = g_start;
+    swtimer_init(g_start);
+    for(uint32_t i = 0; i < MODEL_TIMERS; i++) {
+        swtimer_setup(&g_timers[i].timer, on_model, &g_timers[i]);
+        g_timers[i].active = false;
+    }
+
+    uint32_t fired = 0;
+    for(uint32_t op = 0; op < RANDOM_OPS; op++) {
+        uint32_t r = rng_next(&g_rng);
+        model_timer_t *t = &g_timers[(r >> 8) % MODEL_TIMERS];
+
+        switch(r % 16U) {
+        case 0: case 1: case 2: case 3:
+            model_start(t, random_delay(), 0);
+            break;
+        case 4: case 5:
+            model_start(t, random_delay(), 1U + random_delay());
+            break;
+        case 6:
+            model_stop(t);
+            break;
+        default: {
+            // Time passes: a tick, a few, as far as the wheel asks, or a long stall
+            uint32_t next = swtimer_time_to_next(g_now);
+            uint32_t kind = (r >> 16) % 8U;
+            uint32_t step = (kind < 3) ? 1U
+                          : (kind < 5) ? 1U + (r >> 20) % 200U
+                          : (kind < 7) ? ((next == SWTIMER_NONE) ? 1000U : next)
+                          : ((r >> 20) % 256U == 0) ? rng_next(&g_rng) % (1UL << 27) : rng_next(&g_rng) % 100000U;
+            g_time += step;
+            g_now = g_start + (uint32_t)g_time;
+            g_last_fired = 0;
+            fired += swtimer_process(g_now);
+            g_wheel_time = g_time + 1U;
+            if(g_failed || !model_matches()) {
+                fprintf(stderr, "operation %u, +%u ms\n", op, step);
+                test_failures++;
+                return;
+            }
+            break;
+        }
+        }
+    }
+    // The run crossed the wrap and went far past the range of the wheel
+    CHECK(g_time > 4U * PARK_MS);
+    CHECK(fired > RANDOM_OPS / 10U);
+}
+
+// --- 10k periodic timers ---
+
+static swtimer_t g_bench[BENCH_TIMERS];
+static uint32_t g_bench_fired[BENCH_TIMERS];
+
+static void on_bench(swtimer_t *timer)
+{
+    g_bench_fired[timer - g_bench]++;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    uint32_t rng = 0x1234567U;
+    uint32_t delays[BENCH_TIMERS], periods[BENCH_TIMERS];
+    g_now = 0xFFF00000U;
+    swtimer_init(g_now);
+
+    // Periods from 10 ms to 10 s: about 7 expiries per tick
+    double start = now_ns();
+    for(uint32_t i = 0; i < BENCH_TIMERS; i++) {
+        periods[i] = 10U + rng_next(&rng) % 10000U;
+        delays[i] = 1U + rng_next(&rng) % periods[i];
+        swtimer_setup(&g_bench[i], on_bench, NULL);
+        swtimer_start(&g_bench[i], delays[i], periods[i]);
+    }
+    double start_ns = (now_ns() - start) / BENCH_TIMERS;
+
+    uint32_t fired = 0;
+    start = now_ns();
+    for(uint32_t tick = 1; tick <= BENCH_TICKS; tick++) {
+        g_now++;
+        fired += swtimer_process(g_now);
+    }
+    double tick_ns = (now_ns() - start) / BENCH_TICKS;
+
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < BENCH_TIMERS; i++) {
+        uint32_t expected = (BENCH_TICKS >= delays[i]) ? (BENCH_TICKS - delays[i]) / periods[i] + 1U : 0;
+        wrong += g_bench_fired[i] != expected;
+    }
+    CHECK_EQ(wrong, 0);
+
+    start = now_ns();
+    for(uint32_t i = 0; i < BENCH_TIMERS; i++)
+        swtimer_stop(&g_bench[i]);
+    double stop_ns = (now_ns() - start) / BENCH_TIMERS;
+    CHECK_EQ(swtimer_time_to_next(g_now), SWTIMER_NONE);
+
+    printf("%u periodic timers, %u ticks: %.1f ns per tick (%.2f expiries per tick), "
+           "start %.1f ns, stop %.1f ns\n", BENCH_TIMERS, BENCH_TICKS, tick_ns,
+           (double)fired / BENCH_TICKS, start_ns, stop_ns);
+}
+
+int main(void)
+{
+    check_delay_classes();
+    check_random();
+    bench();
+    return test_result();
+}
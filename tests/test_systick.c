@@ -0,0 +1,226 @@
+#define _GNU_SOURCE     // REG_EFL
+#include "test.h"
+#include "periph.h"
+#include "systick.h"
+#include "scb.h"
+#include <signal.h>
+#include <string.h>
+#include <ucontext.h>
+
+/*
+ * systick_get_ms64() and systick_get_us() against a simulated SysTick that
+ * runs between the instructions of the reader.
+ *
+ * The reader is single-stepped with the x86 trap flag. After every
+ * instruction the SIGTRAP handler plays the hardware: VAL counts down,
+ * reloads and pends the interrupt, and SysTick_Handler() runs at a chosen
+ * instruction, like an interrupt preempting the reader there, or not at
+ * all, like a reader with interrupts masked. Every injection point is
+ * swept, with the tick count crossing the 32-bit wrap, and every result
+ * must be a time the counter really held during the read.
+ */
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#define LOAD_80MHZ      79999U          // 1 ms at 80 MHz
+#define TRAP_FLAG       0x100U
+#define ISR_NEVER       UINT32_MAX
+#define MAX_STEPS       400U            // The reader must finish within this many instructions
+#define SWEEP_STEPS     56U             // Longer than one systick_get_us() with the harness around it
+
+void SysTick_Handler(void);
+
+static struct {
+    volatile bool tracing;
+    uint32_t steps;             // Instructions executed since tracing started
+    uint32_t cycles;            // Counter decrement per instruction, 0 to freeze the counter
+    uint32_t isr_at[2];         // Instructions after which SysTick_Handler() may run
+    uint32_t isr_runs;
+    bool forced;                // isr_at[] runs the handler whether or not the counter pended it
+    uint32_t reloads;
+} g_sim;
+
+static void sim_step(void)
+{
+    g_sim.steps++;
+
+    if(g_sim.cycles != 0) {
+        uint32_t val = SYSTICK->VAL;
+        if(val < g_sim.cycles) {
+            SYSTICK->VAL = SYSTICK->LOAD + 1U + val - g_sim.cycles;
+            SCB->ICSR |= SCB_ICSR_PENDSTSET;
+            g_sim.reloads++;
+        } else {
+            SYSTICK->VAL = val - g_sim.cycles;
+        }
+    }
+
+    uint32_t next = g_sim.isr_at[g_sim.isr_runs < 2 ? g_sim.isr_runs : 1];
+    bool due = g_sim.isr_runs < 2 && g_sim.steps >= next;
+    if(due && (g_sim.forced || (SCB->ICSR & SCB_ICSR_PENDSTSET))) {
+        SCB->ICSR &= ~SCB_ICSR_PENDSTSET;
+        g_sim.isr_runs++;
+        SysTick_Handler();
+    }
+}
+
+static void on_trap(int sig, siginfo_t *info, void *context)
+{
+    (void)sig;
+    (void)info;
+    ucontext_t *uc = context;
+    if(!g_sim.tracing || g_sim.steps >= MAX_STEPS) {
+        uc->uc_mcontext.gregs[REG_EFL] &= ~(greg_t)TRAP_FLAG;
+        return;
+    }
+    sim_step();
+}
+
+static void trace_start(void)
+{
+    g_sim.steps = 0;
+    g_sim.isr_runs = 0;
+    g_sim.tracing = true;
+    __asm__ volatile("pushfq\n\torq %0, (%%rsp)\n\tpopfq" :: "i"(TRAP_FLAG) : "memory", "cc");
+}
+
+// The next instruction traps once more and the handler clears the flag
+static void trace_stop(void)
+{
+    g_sim.tracing = false;
+    __asm__ volatile("nop" ::: "memory");
+}
+
+/**
+ * @brief Moves the tick count to the given low word, upper word unchanged or incremented.
+ * @return The 64-bit count.
+ */
+static uint64_t set_ticks(uint32_t low)
+{
+    systick_advance(low - systick_getTick());
+    return systick_get_ms64();
+}
+
+static void check_ms64(void)
+{
+    static const uint32_t starts[] = { 0xFFFFFFFFU, 0xFFFFFFFEU, 0x7FFFFFFFU, 12345U };
+    bool retried = false;
+    g_sim.cycles = 0;
+    g_sim.forced = true;
+
+    for(uint32_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+        // Without interrupts: the number of instructions of one read
+        uint64_t base = set_ticks(starts[s]);
+        g_sim.isr_at[0] = g_sim.isr_at[1] = ISR_NEVER;
+        trace_start();
+        uint64_t value = systick_get_ms64();
+        trace_stop();
+        uint32_t length = g_sim.steps;
+        CHECK_EQ(value, base);
+        CHECK(length > 0 && length < MAX_STEPS);
+
+        // One or two ticks after every instruction
+        for(uint32_t first = 0; first <= length; first++) {
+            for(uint32_t second = first; second <= length + 1; second++) {
+                base = set_ticks(starts[s]);
+                g_sim.isr_at[0] = first;
+                g_sim.isr_at[1] = (second <= length) ? second : ISR_NEVER;
+                trace_start();
+                value = systick_get_ms64();
+                trace_stop();
+
+                if(g_sim.steps >= MAX_STEPS) {
+                    fprintf(stderr, "systick_get_ms64() did not return\n");
+                    test_failures++;
+                    return;
+                }
+                if(g_sim.steps > length)
+                    retried = true;
+                if(value < base || value > base + g_sim.isr_runs) {
+                    fprintf(stderr, "systick_get_ms64() from 0x%llx with ticks after instructions "
+                            "%u and %u: 0x%llx\n", (unsigned long long)base, first, second,
+                            (unsigned long long)value);
+                    test_failures++;
+                    return;
+                }
+            }
+        }
+    }
+    // The sweep did land between the reads of the two words
+    CHECK(retried);
+}
+
+/**
+ * @brief Simulated time at the current counter value.
+ */
+static uint64_t true_us(uint64_t base_ms)
+{
+    uint32_t load = SYSTICK->LOAD + 1U;
+    return (base_ms + g_sim.reloads) * 1000U + (uint64_t)(load - 1U - SYSTICK->VAL) * 1000U / load;
+}
+
+static void check_us(void)
+{
+    static const uint32_t starts[] = { 0xFFFFFFFFU, 1000U };
+    static const uint32_t cycles[] = { 1U, 400U };
+    g_sim.forced = false;
+    SYSTICK->LOAD = LOAD_80MHZ;
+
+    for(uint32_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+        for(uint32_t c = 0; c < sizeof(cycles) / sizeof(cycles[0]); c++) {
+            g_sim.cycles = cycles[c];
+            // The reload happens after instruction 'wrap', the interrupt 'delay' later or never
+            for(uint32_t wrap = 0; wrap < SWEEP_STEPS; wrap++) {
+                for(uint32_t delay = 0; delay <= SWEEP_STEPS; delay++) {
+                    uint64_t base = set_ticks(starts[s]);
+                    SYSTICK->VAL = wrap * g_sim.cycles;
+                    SCB->ICSR = 0;
+                    g_sim.reloads = 0;
+                    g_sim.isr_at[0] = g_sim.isr_at[1] = (delay == SWEEP_STEPS) ? ISR_NEVER : wrap + delay;
+
+                    uint64_t before = true_us(base);
+                    trace_start();
+                    uint64_t value = systick_get_us();
+                    trace_stop();
+                    uint64_t after = true_us(base);
+
+                    if(value < before || value > after || g_sim.steps >= MAX_STEPS) {
+                        fprintf(stderr, "systick_get_us() from %llu ms, %u cycles per instruction, reload "
+                                "after %u, interrupt %u later: %llu us, time was %llu..%llu us\n",
+                                (unsigned long long)base, g_sim.cycles, wrap, delay,
+                                (unsigned long long)value, (unsigned long long)before,
+                                (unsigned long long)after);
+                        test_failures++;
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    g_sim.cycles = 0;
+}
+
+int main(void)
+{
+    periph_map(0xE000E000U, 0x1000);       // SysTick, SCB
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = on_trap;
+    action.sa_flags = SA_SIGINFO;
+    sigaction(SIGTRAP, &action, NULL);
+
+    check_ms64();
+    check_us();
+    return test_result();
+}
+
+#else
+
+int main(void)
+{
+    printf("single-stepping needs x86-64 Linux: skipped\n");
+    return 0;
+}
+
+#endif
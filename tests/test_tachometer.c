@@ -0,0 +1,191 @@
+#include "test.h"
+#include "periph.h"
+#include "tachometer/tachometer.h"
+#include <string.h>
+
+/*
+ * Tachometer driver against synthetic edges: the test plays the capture
+ * unit of TIM5, latching the edge time in CCR1 and raising CC1IF, then
+ * calls the capture ISR the way TIM5_IRQHandler would.
+ */
+
+#define TIMER_CLOCK_HZ  80000000U
+#define TICK_HZ         1000000U
+#define PULSES_PER_REV  2U
+#define STALL_MS        500U
+
+static GeneralPurpose_Timer_t *const tim = TIM5;
+
+static uint64_t g_now_us;   // Time of the simulation, in capture ticks
+
+// --- Stubs for the drivers tim.c and the tachometer call ---
+void gpio_init(const gpio_config_t *config) { (void)config; }
+void rcc_tim_clock_enable(uint8_t timer_number) { (void)timer_number; }
+void nvic_irq_enable(IRQn_t IRQn) { (void)IRQn; }
+int dma_init(const dma_config_t *config) { (void)config; return 0; }
+void dma_enable(dma_t *DMAx, uint8_t channel) { (void)DMAx; (void)channel; }
+void dma_disable(dma_t *DMAx, uint8_t channel) { (void)DMAx; (void)channel; }
+uint16_t dma_get_remaining(dma_t *DMAx, uint8_t channel) { (void)DMAx; (void)channel; return 0; }
+
+uint32_t systick_getTick(void)
+{
+    return (uint32_t)(g_now_us / 1000U);
+}
+
+/**
+ * @brief Latches an edge at the current time and runs the capture ISR.
+ * @param lost Also flag an over-capture, as if an edge before this one was missed.
+ */
+static void edge(bool lost)
+{
+    tim->CCR1 = (uint32_t)g_now_us;     // 32-bit counter at TICK_HZ, wraps like the hardware
+    tim->SR |= (1U << 1) | (lost ? (1U << 9) : 0U);
+    tach_irq_handler();
+    tim->SR = 0;
+}
+
+static tach_config_t default_config(void)
+{
+    tach_config_t config = {
+        .timer            = tim,
+        .channel          = TIM_CHANNEL1,
+        .timer_clock_hz   = TIMER_CLOCK_HZ,
+        .tick_hz          = TICK_HZ,
+        .pulses_per_rev   = PULSES_PER_REV,
+        .stall_timeout_ms = STALL_MS
+    };
+    return config;
+}
+
+static void check_config(void)
+{
+    tach_config_t config = default_config();
+
+    // PSC is 16 bits: 80 MHz can be divided down to 1221 Hz, not 1 kHz
+    config.tick_hz = 1221;
+    CHECK(tach_init(&config));
+    CHECK_EQ(tim->PSC, TIMER_CLOCK_HZ / 1221U - 1U);
+    config.tick_hz = 1220;
+    CHECK(!tach_init(&config));
+    config.tick_hz = 1000;
+    CHECK(!tach_init(&config));
+    config.tick_hz = TIMER_CLOCK_HZ + 1U;
+    CHECK(!tach_init(&config));
+    config.tick_hz = 0;
+    CHECK(!tach_init(&config));
+    config = default_config();
+    config.pulses_per_rev = 0;
+    CHECK(!tach_init(&config));
+
+    timer_ic_config_t ic_config = { .channel = TIM_CHANNEL1, .edge = TIM_IC_RISING,
+                                    .prescaler = TIM_PRESCALER_MAX + 1U };
+    CHECK_EQ(timer_input_capture_init(tim, &ic_config), -1);
+
+    config = default_config();
+    CHECK(tach_init(&config));
+    CHECK_EQ(tim->PSC, TIMER_CLOCK_HZ / TICK_HZ - 1U);
+    CHECK_EQ(tim->ARR, 0xFFFFFFFFU);
+}
+
+/**
+ * @brief Runs edges at a fixed rate, with the fractional period spread over
+ *        the edges, and checks the averaged frequency and speed.
+ */
+static void check_rate(uint32_t hz)
+{
+    tach_config_t config = default_config();
+    memset((void *)tim, 0, sizeof(*tim));
+    CHECK(tach_init(&config));
+
+    // Before two edges there is no period
+    CHECK_EQ(tach_get_period_ticks(), 0);
+    edge(false);
+    CHECK_EQ(tach_get_period_ticks(), 0);
+
+    uint64_t start = g_now_us;
+    for(uint32_t n = 1; n <= 4U * TACH_AVG_WINDOW; n++) {
+        g_now_us = start + ((uint64_t)n * TICK_HZ) / hz;
+        edge(false);
+    }
+
+    // One tick of quantization per period at most, over the full window
+    uint32_t expected = TICK_HZ / hz;
+    uint32_t period = tach_get_period_ticks();
+    CHECK(period == expected || period == expected + 1U);
+
+    // So the relative error is within one tick of the period
+    uint64_t mhz = tach_get_frequency_mhz();
+    uint64_t error = (mhz > hz * 1000ULL) ? mhz - hz * 1000ULL : hz * 1000ULL - mhz;
+    if(error * expected > hz * 1000ULL) {
+        fprintf(stderr, "%u Hz: measured %llu mHz\n", hz, (unsigned long long)mhz);
+        test_failures++;
+    }
+    uint64_t rpm = tach_get_rpm();
+    uint64_t expected_rpm = hz * 60U / PULSES_PER_REV;
+    CHECK((rpm > expected_rpm ? rpm - expected_rpm : expected_rpm - rpm) * expected <= expected_rpm + expected);
+
+    tach_event_t event;
+    CHECK(!tach_poll_event(&event));
+    CHECK_EQ(event, TACH_EVENT_NONE);
+}
+
+static void check_stall(void)
+{
+    tach_config_t config = default_config();
+    CHECK(tach_init(&config));
+
+    uint32_t period_us = 1000;     // 1 kHz
+    for(uint32_t n = 0; n < TACH_AVG_WINDOW; n++) {
+        g_now_us += period_us;
+        edge(false);
+    }
+    CHECK_EQ(tach_get_period_ticks(), period_us);
+
+    // No edge for longer than the timeout
+    tach_event_t event;
+    g_now_us += STALL_MS * 1000ULL;
+    CHECK(!tach_poll_event(&event));
+    g_now_us += 1000U;
+    CHECK(tach_poll_event(&event));
+    CHECK_EQ(event, TACH_EVENT_STALL);
+    CHECK_EQ(tach_get_period_ticks(), 0);
+    CHECK_EQ(tach_get_rpm(), 0);
+    CHECK(!tach_poll_event(&event));
+
+    // The first edge after the stall only restarts the measurement
+    g_now_us += 12345U;
+    edge(false);
+    CHECK(!tach_poll_event(&event));
+    CHECK_EQ(tach_get_period_ticks(), 0);
+    g_now_us += 2 * period_us;
+    edge(false);
+    CHECK(tach_poll_event(&event));
+    CHECK_EQ(event, TACH_EVENT_RUNNING);
+    CHECK_EQ(tach_get_period_ticks(), 2 * period_us);
+
+    // An over-capture drops the window: the spanned period is not used
+    g_now_us += 3 * period_us;
+    edge(true);
+    CHECK_EQ(tach_get_period_ticks(), 0);
+    g_now_us += period_us;
+    edge(false);
+    CHECK_EQ(tach_get_period_ticks(), period_us);
+}
+
+int main(void)
+{
+    periph_map(TIM2_BASE, TIM5_BASE + 0x400U - TIM2_BASE);
+
+    check_config();
+
+    // Fan tach rates from a slow spin-up to several kHz, first across the
+    // 32-bit counter wrap
+    static const uint32_t rates[] = { 7, 50, 433, 1000, 2500, 4000, 6000, 9999 };
+    g_now_us = 0x100000000ULL - 5000U;
+    for(uint32_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+        check_rate(rates[i]);
+
+    check_stall();
+
+    return test_result();
+}
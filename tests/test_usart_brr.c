@@ -0,0 +1,145 @@
+#include "test.h"
+#include "uart.h"
+#include "trace.h"
+#include <math.h>
+
+/*
+ * usart_compute_brr() over the kernel clocks the clock tree can produce and
+ * the usual baud rates. Each BRR is decoded back to the divider the
+ * hardware uses (RM0351, USART and LPUART baud rate generation) and the
+ * baud rate it generates is checked against the request and the reported
+ * error.
+ */
+
+#define MAX_ERROR_PPM   20000       // 2 %, what a UART link tolerates on one side
+
+// --- Stubs for the drivers uart.c calls ---
+void gpio_init(const gpio_config_t *config) { (void)config; }
+void nvic_irq_enable(IRQn_t IRQn) { (void)IRQn; }
+void rcc_usart_clock_enable(uint8_t usart_number) { (void)usart_number; }
+
+// Tracing stays disabled
+trace_entry_t g_trace_buffer[TRACE_SIZE];
+uint32_t g_trace_head;
+volatile bool g_trace_enabled;
+
+/**
+ * @brief Baud rate the hardware generates for a BRR value.
+ */
+static double decode_baud(usart_t *usart, uint32_t pclk, const usart_brr_t *brr)
+{
+    if(usart == LPUART1)
+        return 256.0 * pclk / brr->brr;
+    if(!brr->over8)
+        return (double)pclk / brr->brr;
+    // OVER8: USARTDIV[15:4] = BRR[15:4], USARTDIV[3:1] = BRR[2:0], USARTDIV[0] = 0
+    uint32_t usartdiv = (brr->brr & 0xFFF0U) | ((brr->brr & 0x7U) << 1);
+    return 2.0 * pclk / usartdiv;
+}
+
+/**
+ * @brief Checks one clock and baud rate.
+ * @return The error in ppm of the generated baud rate, or -1 if the rate is out of range.
+ */
+static double check_one(usart_t *usart, uint32_t pclk, uint32_t baud)
+{
+    usart_brr_t brr;
+    if(usart_compute_brr(usart, pclk, baud, &brr) != 0)
+        return -1;
+
+    double actual = decode_baud(usart, pclk, &brr);
+    double error = (actual - baud) / baud * 1e6;
+    double ratio = (double)pclk / baud;
+
+    // Register constraints
+    if(usart == LPUART1) {
+        CHECK(brr.brr >= 0x300U && brr.brr <= 0xFFFFFU);
+        CHECK(!brr.over8);
+    } else {
+        CHECK(brr.brr >= 16U && brr.brr <= 0xFFFFU);
+        CHECK(!(brr.over8 && (brr.brr & 0x8U)));
+        CHECK_EQ(brr.over8, ratio < 16);
+    }
+
+    // Reported values match the decoded ones
+    if(fabs(brr.actual_baud - actual) > 1.0 || fabs(brr.error_ppm - error) > 1.0 + 1e6 / baud) {
+        fprintf(stderr, "%s %u Hz %u baud: reports %u baud %d ppm, generates %.1f baud %.0f ppm\n",
+                usart == LPUART1 ? "LPUART1" : "USART", pclk, baud, brr.actual_baud, brr.error_ppm, actual, error);
+        test_failures++;
+    }
+
+    // Nearest divider: at most half a divider step off
+    double divider = (usart == LPUART1) ? 256.0 * ratio : ratio;
+    if(fabs(error) > 0.5 / (divider - 0.5) * 1e6 + 1.0) {
+        fprintf(stderr, "%u Hz %u baud: %.0f ppm, not the nearest divider (BRR 0x%X)\n", pclk, baud, error, brr.brr);
+        test_failures++;
+    }
+    return fabs(error);
+}
+
+int main(void)
+{
+    static const uint32_t clocks[] = {
+        100000, 200000, 400000, 800000, 1000000, 2000000, 4000000, 8000000,     // MSI ranges
+        16000000, 24000000, 32000000, 48000000,                                 // HSI16, MSI
+        20000000, 26000000, 40000000, 64000000, 72000000, 80000000,             // PLL
+        32768                                                                   // LSE, LPUART1
+    };
+    static const uint32_t bauds[] = {
+        300, 1200, 2400, 4800, 9600, 14400, 19200, 38400, 57600, 115200, 230400,
+        250000, 460800, 500000, 921600, 1000000, 2000000, 3000000, 4000000, 5000000
+    };
+
+    uint32_t checked = 0;
+    double worst = 0;
+    for(uint32_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+        for(uint32_t b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+            uint32_t pclk = clocks[c], baud = bauds[b];
+
+            double error = check_one(USART2, pclk, baud);
+            if(error >= 0) {
+                checked++;
+                // 2 % is reachable once the divider is 25 or more
+                if(pclk / baud >= 25U && error >= MAX_ERROR_PPM) {
+                    fprintf(stderr, "USART %u Hz %u baud: %.0f ppm\n", pclk, baud, error);
+                    test_failures++;
+                }
+                if(pclk / baud >= 25U && error > worst)
+                    worst = error;
+            } else {
+                // Only out of range below 8x oversampling or beyond the 16-bit divider
+                uint32_t div = (pclk + baud / 2) / baud;
+                CHECK(div < 8U || div > 0xFFFFU);
+            }
+
+            error = check_one(LPUART1, pclk, baud);
+            if(error >= 0) {
+                checked++;
+                CHECK(error < MAX_ERROR_PPM);
+            } else {
+                uint64_t div = (256ULL * pclk + baud / 2) / baud;
+                CHECK(div < 0x300U || div > 0xFFFFFU);
+            }
+        }
+    }
+
+    // Fine sweep over the whole OVER8/OVER16 range of the fastest clock
+    for(uint32_t baud = 80000000U / 0xFFFFU + 1; baud <= 10000000U; baud += 997U) {
+        if(check_one(USART1, 80000000U, baud) < 0) {
+            fprintf(stderr, "80 MHz %u baud: out of range\n", baud);
+            test_failures++;
+        }
+        checked++;
+    }
+
+    // Out of range
+    usart_brr_t brr;
+    CHECK_EQ(usart_compute_brr(USART2, 80000000U, 0, &brr), -1);
+    CHECK_EQ(usart_compute_brr(USART2, 80000000U, 11000000U, &brr), -1);
+    CHECK_EQ(usart_compute_brr(USART2, 80000000U, 1000, &brr), -1);
+    CHECK_EQ(usart_compute_brr(LPUART1, 32768U, 11000U, &brr), -1);
+    CHECK_EQ(usart_compute_brr(LPUART1, 32768U, 9600U, &brr), 0);
+
+    printf("%u combinations checked, worst error %.0f ppm where the divider is 25 or more\n", checked, worst);
+    return test_result();
+}
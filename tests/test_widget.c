@@ -0,0 +1,144 @@
+#include "test.h"
+#include "golden.h"
+#include "ssd1306_panel.h"
+#include "SSD1306/widget.h"
+#include <string.h>
+
+/*
+ * Headless widget rendering: the screen buffer is compared with golden
+ * images after every change, and the panel model checks what reaches the
+ * display. A refresh with unchanged bound values must redraw nothing, mark
+ * nothing dirty and send nothing.
+ */
+
+static const uint8_t icon_off[] = { 0x3C, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3C };   // Circle
+static const uint8_t icon_on[]  = { 0x3C, 0x7E, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E, 0x3C };   // Disc
+static const uint8_t *const icons[] = { icon_off, icon_on };
+
+static const char *volatile g_status = "IDLE";
+static volatile int32_t g_rpm = 1200;
+static volatile uint8_t g_icon = 0;
+static volatile int32_t g_duty = 25;
+
+static widget_t g_widgets[] = {
+    WIDGET_LABEL(0, 0, 60, &g_status),
+    WIDGET_NUMBER(0, 12, 60, &g_rpm, " RPM"),
+    WIDGET_ICON(100, 0, 8, 8, &g_icon, icons, 2),
+    WIDGET_BAR(64, 20, 52, 8, &g_duty, 100),
+};
+#define WIDGET_COUNT ((uint8_t)(sizeof(g_widgets) / sizeof(g_widgets[0])))
+
+static uint8_t g_before[SSD1306_BUFFER_SIZE];
+
+/**
+ * @brief Renders and sends the changes, and checks which screen area changed.
+ * @param x, y, w, h Box that may change, w = 0 when nothing may.
+ * @return Data bytes sent to the display.
+ */
+static uint32_t refresh(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    ssd1306_snapshot(g_before);
+    panel_stats_t before = panel_stats();
+
+    bool redrawn = widget_render(g_widgets, WIDGET_COUNT);
+    CHECK_EQ(redrawn, w != 0);
+
+    // Nothing outside the box was touched
+    const uint8_t *buffer = ssd1306_get_buffer();
+    for(int16_t py = 0; py < SSD1306_HEIGHT; py++) {
+        for(int16_t px = 0; px < SSD1306_WIDTH; px++) {
+            bool inside = w != 0 && px >= x && px < x + w && py >= y && py < y + h;
+            uint8_t bit = (uint8_t)(1U << (py & 7));
+            uint32_t index = (uint32_t)(py >> 3) * SSD1306_WIDTH + px;
+            if(!inside && ((buffer[index] ^ g_before[index]) & bit)) {
+                fprintf(stderr, "pixel %d,%d changed outside %d,%d %dx%d\n", px, py, x, y, w, h);
+                test_failures++;
+                return 0;
+            }
+        }
+    }
+
+    // Only the dirty pages of the box are sent, and the display shows the buffer
+    bool sent = ssd1306_update_dirty();
+    CHECK_EQ(sent, w != 0);
+    panel_stats_t after = panel_stats();
+    uint32_t bytes = after.data_bytes - before.data_bytes;
+    if(w == 0) {
+        CHECK_EQ(after.transactions, before.transactions);
+    } else {
+        uint32_t pages = (uint32_t)(((y + h - 1) >> 3) - (y >> 3) + 1);
+        CHECK_EQ(after.transactions - before.transactions, pages);
+        CHECK_EQ(bytes, pages * (uint32_t)w);
+    }
+    CHECK(panel_in_sync());
+    CHECK(!ssd1306_update_dirty());
+    return bytes;
+}
+
+int main(void)
+{
+    panel_init();
+    CHECK(ssd1306_is_ready());
+    CHECK(panel_in_sync());
+
+    // First render draws everything
+    CHECK(widget_render(g_widgets, WIDGET_COUNT));
+    CHECK(ssd1306_update_dirty());
+    CHECK(panel_in_sync());
+    CHECK(golden_check("widget_initial"));
+
+    // Unchanged values: no redraw, no dirty region, no I2C traffic
+    for(int i = 0; i < 3; i++)
+        CHECK_EQ(refresh(0, 0, 0, 0), 0);
+
+    // Writing the same values again changes nothing either
+    g_rpm = 1200;
+    g_icon = 0;
+    g_status = "IDLE";
+    CHECK_EQ(refresh(0, 0, 0, 0), 0);
+
+    // A duty change that does not move the bar by a pixel (50 inner pixels, 2 % per pixel)
+    g_duty = 24;
+    CHECK_EQ(refresh(0, 0, 0, 0), 0);
+
+    // Each change redraws its own widget only
+    g_rpm = 980;
+    refresh(0, 12, 60, 8);
+    CHECK(golden_check("widget_number"));
+
+    g_duty = 75;
+    refresh(64, 20, 52, 8);
+
+    g_icon = 1;
+    refresh(100, 0, 8, 8);
+
+    g_status = "COOLING";
+    refresh(0, 0, 60, 8);
+    CHECK(golden_check("widget_changed"));
+    CHECK_EQ(refresh(0, 0, 0, 0), 0);
+
+    // Out of range icon index: the box is cleared
+    g_icon = 7;
+    refresh(100, 0, 8, 8);
+    g_icon = 1;
+    refresh(100, 0, 8, 8);
+
+    // Back to the first values gives the first image
+    g_status = "IDLE";
+    g_rpm = 1200;
+    g_icon = 0;
+    g_duty = 25;
+    CHECK(widget_render(g_widgets, WIDGET_COUNT));
+    CHECK(ssd1306_update_dirty());
+    CHECK(golden_check("widget_initial"));
+
+    // After a clear, invalidate redraws every widget
+    ssd1306_fill(SSD1306_COLOR_BLACK);
+    widget_invalidate(g_widgets, WIDGET_COUNT);
+    CHECK(widget_render(g_widgets, WIDGET_COUNT));
+    CHECK(ssd1306_update_dirty());
+    CHECK(golden_check("widget_initial"));
+    CHECK_EQ(refresh(0, 0, 0, 0), 0);
+
+    return test_result();
+}
@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+"""Generate page-aligned SSD1306 font and bitmap tables from BDF/PBM/PNG sources.
+
+Every asset is converted to the screen buffer layout used by
+drivers/SSD1306: ceil(height / 8) pages of `width` bytes, each byte a column
+of 8 rows with bit 0 on top. With --rle each glyph/bitmap is stored RLE
+compressed when that is smaller (see drivers/SSD1306/asset.h for the format).
+
+    assetgen.py --rle --out-c assets.c --out-h assets.h font5x7.bdf fan.pbm
+
+The C symbol of an asset is `asset_<file stem>`. A size report is printed
+so the flash cost of every asset shows up in the build log.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+RLE_LITERAL_MAX = 128   # ctrl 0x00-0x7F: ctrl + 1 literal bytes follow
+RLE_REPEAT_MIN = 3      # ctrl 0x80-0xFF: next byte repeated (ctrl & 0x7F) + 3 times
+RLE_REPEAT_MAX = 127 + RLE_REPEAT_MIN
+ASSET_GLYPH_RLE = 0x8000  # Flag in asset_glyph_t.offset
+
+
+# --- Sources -----------------------------------------------------------------
+
+def read_bdf(path):
+    """Returns (height, {code: (advance, rows)}) with rows as lists of 0/1, top aligned."""
+    ascent = descent = None
+    glyphs = {}
+    with open(path) as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        key, _, value = line.partition(" ")
+        if key == "FONT_ASCENT":
+            ascent = int(value)
+        elif key == "FONT_DESCENT":
+            descent = int(value)
+        elif key == "STARTCHAR":
+            code = advance = None
+            bbx = (0, 0, 0, 0)
+            bitmap = []
+            for line in lines:
+                key, _, value = line.partition(" ")
+                if key == "ENCODING":
+                    code = int(value.split()[0])
+                elif key == "DWIDTH":
+                    advance = int(value.split()[0])
+                elif key == "BBX":
+                    bbx = tuple(int(v) for v in value.split())
+                elif key == "BITMAP":
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        bitmap.append(int(line, 16) if line.strip() else 0)
+                    break
+            if code is None or code < 0:
+                continue
+            glyphs[code] = (advance, bbx, bitmap)
+
+    if ascent is None or descent is None:
+        sys.exit(f"{path}: FONT_ASCENT/FONT_DESCENT missing")
+    height = ascent + descent
+
+    out = {}
+    for code, (advance, (w, h, xoff, yoff), bitmap) in glyphs.items():
+        # Trailing spacing is left to the advance, only inked columns are stored
+        width = max(xoff + w, 0)
+        rows = [[0] * width for _ in range(height)]
+        row_bits = ((w + 7) // 8) * 8
+        top = ascent - (yoff + h)
+        for r, value in enumerate(bitmap[:h]):
+            y = top + r
+            if not 0 <= y < height:
+                continue
+            for c in range(w):
+                if value >> (row_bits - 1 - c) & 1 and 0 <= xoff + c < width:
+                    rows[y][xoff + c] = 1
+        out[code] = (advance if advance is not None else width, rows)
+    return height, out
+
+
+def read_pbm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    # Header tokens, skipping comments
+    tokens = []
+    pos = 0
+    while len(tokens) < 3:
+        match = re.compile(rb"\s*(#[^\n]*\n\s*)*(\S+)").match(data, pos)
+        if not match:
+            sys.exit(f"{path}: bad PBM header")
+        tokens.append(match.group(2))
+        pos = match.end()
+    magic, width, height = tokens[0], int(tokens[1]), int(tokens[2])
+    if magic == b"P1":
+        bits = [int(c) for c in re.sub(rb"#[^\n]*", b"", data[pos:]).decode() if c in "01"]
+        return [bits[y * width:(y + 1) * width] for y in range(height)]
+    if magic == b"P4":
+        raw = data[pos + 1:]
+        stride = (width + 7) // 8
+        return [[raw[y * stride + x // 8] >> (7 - x % 8) & 1 for x in range(width)] for y in range(height)]
+    sys.exit(f"{path}: only P1/P4 PBM files are supported")
+
+
+def read_png(path):
+    """Minimal decoder: 8-bit, non-interlaced gray/RGB/gray+alpha/RGBA. Lit = bright and opaque."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        sys.exit(f"{path}: not a PNG file")
+    pos, idat = 8, b""
+    while pos < len(data):
+        length, tag = struct.unpack(">I4s", data[pos:pos + 8])
+        payload = data[pos + 8:pos + 8 + length]
+        if tag == b"IHDR":
+            width, height, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", payload)
+        elif tag == b"IDAT":
+            idat += payload
+        pos += 12 + length
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}.get(ctype)
+    if depth != 8 or channels is None or interlace:
+        sys.exit(f"{path}: only 8-bit non-interlaced gray/RGB(A) PNGs are supported")
+
+    raw = zlib.decompress(idat)
+    stride = width * channels
+    prev = bytearray(stride)
+    rows = []
+    for y in range(height):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        prev = line
+        row = []
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            gray = px[0] if channels < 3 else (px[0] * 299 + px[1] * 587 + px[2] * 114) // 1000
+            alpha = px[-1] if channels in (2, 4) else 255
+            row.append(1 if gray >= 128 and alpha >= 128 else 0)
+        rows.append(row)
+    return rows
+
+
+# --- Encoding ----------------------------------------------------------------
+
+def to_pages(rows, width):
+    """Row-major 0/1 pixels to page-aligned column bytes."""
+    height = len(rows)
+    out = bytearray()
+    for page in range((height + 7) // 8):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < height and rows[y][x]:
+                    byte |= 1 << bit
+            out.append(byte)
+    return bytes(out)
+
+
+def rle_encode(data):
+    out = bytearray()
+    literal = bytearray()
+
+    def flush():
+        while literal:
+            chunk = literal[:RLE_LITERAL_MAX]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+            del literal[:RLE_LITERAL_MAX]
+
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < RLE_REPEAT_MAX:
+            run += 1
+        if run >= RLE_REPEAT_MIN:
+            flush()
+            out.append(0x80 | (run - RLE_REPEAT_MIN))
+            out.append(data[i])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush()
+    return bytes(out)
+
+
+def rle_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        ctrl = data[i]
+        if ctrl & 0x80:
+            out.extend(bytes([data[i + 1]]) * ((ctrl & 0x7F) + RLE_REPEAT_MIN))
+            i += 2
+        else:
+            out.extend(data[i + 1:i + 2 + ctrl])
+            i += 2 + ctrl
+    return bytes(out)
+
+
+def pack(raw, use_rle):
+    """Returns (stored bytes, rle flag). RLE is only kept when it is smaller."""
+    if use_rle:
+        encoded = rle_encode(raw)
+        assert rle_decode(encoded) == raw
+        if len(encoded) < len(raw):
+            return encoded, 1
+    return raw, 0
+
+
+# --- Output ------------------------------------------------------------------
+
+def c_bytes(data, indent="    "):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append(indent + ", ".join(f"0x{b:02X}" for b in data[i:i + 16]) + ",")
+    return "\n".join(lines) if lines else indent + "0x00,"
+
+
+def symbol(path):
+    return "asset_" + re.sub(r"\W", "_", os.path.splitext(os.path.basename(path))[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="+", help=".bdf fonts, .pbm or .png bitmaps")
+    parser.add_argument("--out-c", required=True)
+    parser.add_argument("--out-h", required=True)
+    parser.add_argument("--rle", action="store_true", help="store RLE when it saves space")
+    parser.add_argument("--first", type=int, default=32, help="first font character")
+    parser.add_argument("--last", type=int, default=126, help="last font character")
+    args = parser.parse_args()
+
+    header_name = os.path.basename(args.out_h)
+    guard = re.sub(r"\W", "_", header_name).upper()
+    h_out = [f"/* Generated by tools/assetgen.py, do not edit. */",
+             f"#ifndef {guard}", f"#define {guard}", "", '#include "SSD1306/asset.h"', ""]
+    c_out = [f"/* Generated by tools/assetgen.py, do not edit. */", f'#include "{header_name}"', ""]
+    report = []
+    total_raw = total_stored = 0
+
+    for path in args.inputs:
+        name = symbol(path)
+        ext = os.path.splitext(path)[1].lower()
+
+        if ext == ".bdf":
+            height, glyphs = read_bdf(path)
+            data = bytearray()
+            entries = []
+            raw_size = 0
+            for code in range(args.first, args.last + 1):
+                advance, rows = glyphs.get(code, (0, [[] for _ in range(height)]))
+                width = len(rows[0]) if rows and rows[0] else 0
+                raw = to_pages(rows, width) if width else b""
+                stored, rle = pack(raw, args.rle)
+                if len(data) >= ASSET_GLYPH_RLE:
+                    sys.exit(f"{path}: font data exceeds {ASSET_GLYPH_RLE} bytes")
+                entries.append((len(data) | (ASSET_GLYPH_RLE if rle else 0), width, advance, chr(code)))
+                data.extend(stored)
+                raw_size += len(raw)
+            stored_size = len(data)
+            c_out.append(f"static const uint8_t {name}_data[] = {{\n{c_bytes(data)}\n}};\n")
+            c_out.append(f"static const asset_glyph_t {name}_glyphs[] = {{")
+            for offset, width, advance, char in entries:
+                comment = char.replace("\\", "backslash") if char.isprintable() else "?"
+                c_out.append(f"    {{ 0x{offset:04X}, {width}, {advance} }}, // {comment}")
+            c_out.append("};\n")
+            c_out.append(f"const asset_font_t {name} = {{\n"
+                         f"    .first = {args.first},\n    .count = {len(entries)},\n"
+                         f"    .height = {height},\n    .glyphs = {name}_glyphs,\n"
+                         f"    .data = {name}_data\n}};\n")
+            h_out.append(f"extern const asset_font_t {name};")
+            # The glyph index (4 bytes per glyph) is needed with or without RLE
+            report.append((name, f"font {len(entries)} glyphs +{4 * len(entries)} B index", raw_size, stored_size))
+        elif ext in (".pbm", ".png"):
+            rows = read_pbm(path) if ext == ".pbm" else read_png(path)
+            width, height = len(rows[0]), len(rows)
+            if width > 255 or height > 255:
+                sys.exit(f"{path}: bitmaps are limited to 255x255")
+            raw = to_pages(rows, width)
+            stored, rle = pack(raw, args.rle)
+            c_out.append(f"static const uint8_t {name}_data[] = {{\n{c_bytes(stored)}\n}};\n")
+            c_out.append(f"const asset_bitmap_t {name} = {{\n"
+                         f"    .width = {width},\n    .height = {height},\n    .rle = {rle},\n"
+                         f"    .data = {name}_data\n}};\n")
+            h_out.append(f"extern const asset_bitmap_t {name};")
+            raw_size, stored_size = len(raw), len(stored)
+            report.append((name, f"bitmap {width}x{height}", raw_size, stored_size))
+        else:
+            sys.exit(f"{path}: unsupported asset type")
+
+        total_raw += raw_size
+        total_stored += stored_size
+
+    h_out += ["", "#endif", ""]
+    with open(args.out_h, "w") as f:
+        f.write("\n".join(h_out))
+    with open(args.out_c, "w") as f:
+        f.write("\n".join(c_out))
+
+    for name, kind, raw_size, stored_size in report:
+        print(f"assetgen: {name:<24} {kind:<28} {raw_size:6d} B raw -> {stored_size:6d} B")
+    print(f"assetgen: total {total_raw} B raw -> {total_stored} B stored")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Symbolize a crash report printed by fault_report() (src/fault.c).
+
+Give it the UART log containing the "*** FAULT" block and the .map file the
+linker wrote for the same build (-Wl,-Map=Final_Project.map):
+
+    fault_decode.py build/Final_Project.map uart.log
+    fault_decode.py build/Final_Project.map - < uart.log
+
+Addresses are resolved to function+offset (and object file) from the .map
+sections and symbols, fault status registers are decoded bit by bit.
+"""
+
+import argparse
+import bisect
+import re
+import sys
+
+EXCEPTIONS = {2: "NMI", 3: "HardFault", 4: "MemManage", 5: "BusFault", 6: "UsageFault",
+              0x100: "Panic (fault_panic)", 0x101: "Unhandled IRQ (default handler)"}
+
+CFSR_BITS = [
+    (0, "IACCVIOL", "instruction fetch from a no-execute/no-access region"),
+    (1, "DACCVIOL", "data access violation (MPU), see MMFAR"),
+    (3, "MUNSTKERR", "MemManage fault on exception return unstacking"),
+    (4, "MSTKERR", "MemManage fault on exception entry stacking (stack overflow into the guard?)"),
+    (5, "MLSPERR", "MemManage fault during lazy FPU state preservation"),
+    (7, "MMARVALID", "MMFAR is valid"),
+    (8, "IBUSERR", "bus error on instruction fetch"),
+    (9, "PRECISERR", "precise data bus error, see BFAR"),
+    (10, "IMPRECISERR", "imprecise data bus error (pc is after the faulting store)"),
+    (11, "UNSTKERR", "bus fault on exception return unstacking"),
+    (12, "STKERR", "bus fault on exception entry stacking"),
+    (13, "LSPERR", "bus fault during lazy FPU state preservation"),
+    (15, "BFARVALID", "BFAR is valid"),
+    (16, "UNDEFINSTR", "undefined instruction"),
+    (17, "INVSTATE", "invalid EPSR state (branch to an even address / ARM state)"),
+    (18, "INVPC", "invalid EXC_RETURN on exception return"),
+    (19, "NOCP", "coprocessor (FPU) access while disabled"),
+    (24, "UNALIGNED", "unaligned access with UNALIGN_TRP set"),
+    (25, "DIVBYZERO", "division by zero"),
+]
+
+HFSR_BITS = [
+    (1, "VECTTBL", "bus fault on vector table read"),
+    (30, "FORCED", "escalated from a configurable fault, see CFSR"),
+    (31, "DEBUGEVT", "debug event"),
+]
+
+
+class MapFile:
+    """Function ranges and symbols from a GNU ld .map file."""
+
+    SECTION = re.compile(r"^ (\.\S+)\s*$|^ (\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)")
+    CONT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)")
+    SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+
+    def __init__(self, path):
+        self.ranges = []    # (start, end, name, file)
+        self.symbols = []   # (addr, name)
+        pending = None
+        in_map = False
+        with open(path, errors="replace") as f:
+            for line in f:
+                if line.startswith("Linker script and memory map"):
+                    in_map = True
+                    continue
+                if not in_map:
+                    continue
+
+                if pending:
+                    m = self.CONT.match(line)
+                    if m:
+                        self._add_range(pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+                        pending = None
+                        continue
+                    pending = None
+
+                m = self.SECTION.match(line)
+                if m:
+                    if m.group(1):
+                        pending = m.group(1)   # Long name, address on the next line
+                    else:
+                        self._add_range(m.group(2), int(m.group(3), 16), int(m.group(4), 16), m.group(5))
+                    continue
+
+                m = self.SYMBOL.match(line)
+                if m:
+                    addr = int(m.group(1), 16)
+                    if addr:
+                        self.symbols.append((addr, m.group(2)))
+
+        self.ranges.sort()
+        self.symbols.sort()
+        self._range_starts = [r[0] for r in self.ranges]
+        self._symbol_addrs = [s[0] for s in self.symbols]
+
+    def _add_range(self, section, start, size, obj):
+        if size == 0 or not re.match(r"\.(text|ramfunc|RamFunc)", section):
+            return
+        name = re.sub(r"^\.(text|ramfunc|RamFunc)\.?", "", section) or None
+        self.ranges.append((start, start + size, name, obj))
+
+    def lookup(self, addr):
+        addr &= ~1
+        i = bisect.bisect_right(self._range_starts, addr) - 1
+        if i < 0 or addr >= self.ranges[i][1]:
+            return None
+        start, end, name, obj = self.ranges[i]
+
+        # A global symbol inside the section wins over the section name
+        j = bisect.bisect_right(self._symbol_addrs, addr) - 1
+        if j >= 0 and start <= self.symbols[j][0] <= addr:
+            sym_addr, sym = self.symbols[j]
+            return f"{sym}+0x{addr - sym_addr:x}", obj
+        if name:
+            return f"{name}+0x{addr - start:x}", obj
+        return f"?+0x{addr - start:x}", obj
+
+
+def parse_report(text):
+    start = text.rfind("*** FAULT")
+    if start < 0:
+        sys.exit("no '*** FAULT' report found in the log")
+    block = text[start:]
+    header = block.splitlines()[0]
+    fields = {k: int(v, 16) for k, v in re.findall(r"\b(\w+)=0x([0-9a-fA-F]{8})", block)}
+    bt_line = re.search(r"^bt=(.*)$", block, re.M)
+    backtrace = [int(v, 16) for v in re.findall(r"0x([0-9a-fA-F]{8})", bt_line.group(1))] if bt_line else []
+    return header, fields, backtrace
+
+
+def decode_bits(value, table):
+    return [f"{name}: {text}" for bit, name, text in table if value >> bit & 1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", help="linker .map file of the build that crashed")
+    parser.add_argument("log", help="UART log with the report, - for stdin")
+    args = parser.parse_args()
+
+    text = sys.stdin.read() if args.log == "-" else open(args.log, errors="replace").read()
+    header, fields, backtrace = parse_report(text)
+    symbols = MapFile(args.map)
+
+    def where(addr):
+        found = symbols.lookup(addr)
+        return f"{found[0]}  ({found[1]})" if found else "not in code"
+
+    reason = fields.get("reason", 0)
+    name = EXCEPTIONS.get(reason, f"IRQ{reason - 16}" if 16 <= reason < 0x100 else f"exception {reason}")
+    print(header.strip())
+    print(f"Cause:  {name}")
+    if reason == 0x101 and fields.get("xpsr", 0) & 0x1FF >= 16:
+        print(f"        IRQ{(fields['xpsr'] & 0x1FF) - 16} had no handler")
+    print(f"PC:     0x{fields.get('pc', 0):08x}  {where(fields.get('pc', 0))}")
+    print(f"LR:     0x{fields.get('lr', 0):08x}  {where(fields.get('lr', 0))}")
+    print(f"SP:     0x{fields.get('sp', 0):08x}")
+    for reg, label in (("r0", "R0"), ("r1", "R1"), ("r2", "R2"), ("r3", "R3"), ("r12", "R12"),
+                       ("xpsr", "xPSR"), ("exc_return", "EXC_RET")):
+        if reg in fields:
+            print(f"{label + ':':<8}0x{fields[reg]:08x}")
+
+    cfsr, hfsr = fields.get("cfsr", 0), fields.get("hfsr", 0)
+    print(f"CFSR:   0x{cfsr:08x}")
+    for line in decode_bits(cfsr, CFSR_BITS):
+        print(f"        {line}")
+    print(f"HFSR:   0x{hfsr:08x}")
+    for line in decode_bits(hfsr, HFSR_BITS):
+        print(f"        {line}")
+    if cfsr & (1 << 7):
+        print(f"MMFAR:  0x{fields.get('mmfar', 0):08x}")
+    if cfsr & (1 << 15):
+        print(f"BFAR:   0x{fields.get('bfar', 0):08x}")
+
+    if backtrace:
+        print("Backtrace (return addresses found on the stack, may include stale ones):")
+        for i, addr in enumerate(backtrace):
+            print(f"  #{i} 0x{addr:08x}  {where(addr)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Convert an SSD1306 screen buffer dump into a PBM or PNG image.
+
+The input is the page-organised buffer of drivers/SSD1306/ssd1306.c: byte
+x + page * width holds column x of rows page*8..page*8+7, bit 0 on top. It
+may be a raw binary file (e.g. `dump binary memory fb.bin ...` from gdb) or
+text with hex bytes (e.g. copied from a UART log).
+
+    fb2pbm.py fb.bin frame.pbm
+    fb2pbm.py --width 128 --height 32 fb.txt frame.png
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+
+def load_buffer(path, size):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) != size:
+        # Not a raw dump, try hex text ("0x1F, 0x00" or "1f 00 ...")
+        tokens = re.findall(rb"(?:0x)?([0-9a-fA-F]{2})\b", data)
+        data = bytes(int(t, 16) for t in tokens)
+    if len(data) != size:
+        sys.exit(f"{path}: expected {size} bytes, got {len(data)}")
+    return data
+
+
+def to_rows(buf, width, height):
+    """Returns one list of 0/1 pixels per row, 1 meaning lit."""
+    return [[(buf[(y // 8) * width + x] >> (y % 8)) & 1 for x in range(width)]
+            for y in range(height)]
+
+
+def write_pbm(path, rows, width, height):
+    # P4: row-major, MSB first, 1 is black; lit pixels are drawn black
+    out = bytearray(f"P4\n{width} {height}\n".encode())
+    for row in rows:
+        for x in range(0, width, 8):
+            byte = 0
+            for bit in row[x:x + 8]:
+                byte = (byte << 1) | bit
+            out.append(byte << (8 - len(row[x:x + 8])))
+    with open(path, "wb") as f:
+        f.write(out)
+
+
+def write_png(path, rows, width, height, scale):
+    # 8-bit grayscale, lit pixels white on black like the panel
+    raw = bytearray()
+    for row in rows:
+        line = bytearray()
+        for pixel in row:
+            line += bytes([255 if pixel else 0]) * scale
+        for _ in range(scale):
+            raw.append(0)  # No filter
+            raw += line
+
+    def chunk(tag, payload):
+        body = tag + payload
+        return struct.pack(">I", len(payload)) + body + struct.pack(">I", zlib.crc32(body))
+
+    header = struct.pack(">IIBBBBB", width * scale, height * scale, 8, 0, 0, 0, 0)
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", header) +
+                chunk(b"IDAT", zlib.compress(bytes(raw), 9)) + chunk(b"IEND", b""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="raw or hex buffer dump")
+    parser.add_argument("output", help="output image, .pbm or .png")
+    parser.add_argument("--width", type=int, default=128)
+    parser.add_argument("--height", type=int, default=32)
+    parser.add_argument("--scale", type=int, default=4, help="PNG pixel scale")
+    args = parser.parse_args()
+
+    buf = load_buffer(args.input, args.width * args.height // 8)
+    rows = to_rows(buf, args.width, args.height)
+    if args.output.lower().endswith(".png"):
+        write_png(args.output, rows, args.width, args.height, args.scale)
+    else:
+        write_pbm(args.output, rows, args.width, args.height)
+
+
+if __name__ == "__main__":
+    main()
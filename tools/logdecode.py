@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Rebuild deferred log messages (log.h) from a UART capture and the ELF file.
+
+The target sends "#L" lines of hex words: a header {ID, argument count,
+level}, the tick in ms and the raw arguments. The ID is the address of the
+format string in the ELF's .logstr section, which never reaches flash.
+
+    logdecode.py build/Final_Project.elf uart.log
+    picocom -b 115200 /dev/ttyACM0 | logdecode.py build/Final_Project.elf -
+
+Other lines of the capture (plain text output) are passed through unchanged.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = {0: "DEBUG", 1: "INFO", 2: "WARN", 3: "ERROR"}
+ID_DROPPED = 0          # The linker script pads .logstr so no string has this ID
+LINE = re.compile(r"#L((?:[0-9A-F]{8})+)\s*$")
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diuxXcpsf%])")
+
+
+def read_logstr(path):
+    """Returns (contents, address) of the .logstr section of an ELF32/ELF64 file."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        sys.exit(f"{path}: not an ELF file")
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        fmt = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        fmt = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(fmt, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for sh_name, _, _, sh_addr, sh_offset, sh_size, *_ in sections:
+        start = names[4] + sh_name
+        name = elf[start:elf.index(b"\0", start)].decode()
+        if name == ".logstr":
+            return elf[sh_offset:sh_offset + sh_size], sh_addr
+    sys.exit(f"{path}: no .logstr section (no LOG_* call linked in?)")
+
+
+def format_message(fmt, args):
+    args = list(args)
+
+    def convert(match):
+        flags, width, precision, _, conv = match.groups()
+        if conv == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        spec = "%" + flags + width + (("." + precision) if precision else "")
+        if conv in "di":
+            return (spec + "d") % (value - (1 << 32) if value & 0x80000000 else value)
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conv == "p":
+            return "0x%08x" % value
+        if conv in "sf":
+            return f"<{conv}:0x{value:08x}>"   # Not supported by the deferred logger
+        return (spec + conv) % value
+
+    return SPEC.sub(convert, fmt)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="ELF file of the running firmware")
+    parser.add_argument("log", help="UART capture, - for stdin")
+    args = parser.parse_args()
+
+    strings, base = read_logstr(args.elf)
+    stream = sys.stdin if args.log == "-" else open(args.log, errors="replace")
+    for raw in stream:
+        line = raw.rstrip("\r\n")
+        m = LINE.search(line)
+        if not m:
+            print(line)
+            continue
+
+        hexdigits = m.group(1)
+        words = [int(hexdigits[i:i + 8], 16) for i in range(0, len(hexdigits), 8)]
+        header = words[0]
+        ident, count, level = header & 0xFFFF, (header >> 16) & 0xFF, header >> 24
+        if len(words) != 2 + count:
+            # Broken by other output written in the middle of the line
+            print(f"[log] corrupt record: {line[m.start():]}")
+            continue
+
+        tick, values = words[1], words[2:]
+        if ident == ID_DROPPED:
+            text = f"{values[0] if values else '?'} log record(s) dropped, ring full"
+        else:
+            offset = (ident - base) & 0xFFFF
+            if offset >= len(strings):
+                text = f"<unknown log id 0x{ident:04x}> {values}"
+            else:
+                text = format_message(strings[offset:strings.index(b"\0", offset)].decode(errors="replace"), values)
+        print(f"[{tick / 1000:10.3f}] {LEVELS.get(level, level):5} {text}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Convert a trace_dump() UART capture into Chrome trace / Perfetto JSON.
+
+    trace2json.py uart.log trace.json
+    trace2json.py --header inc/trace.h - trace.json < uart.log
+
+Open the result in https://ui.perfetto.dev or chrome://tracing. Event names
+come from the TRACE_EV_* enum in inc/trace.h. Events whose name ends in
+_ISR go on the "interrupts" track, the others on "main loop". The 32-bit
+cycle counter is unwrapped, so dumps longer than 2^32 cycles stay in order.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+TRACE_BEGIN = 0x4000
+TRACE_END = 0x8000
+TRACE_KIND_MASK = 0xC000
+
+TID_MAIN, TID_ISR = 1, 2
+
+
+def load_names(header):
+    names = {}
+    with open(header) as f:
+        for name, value in re.findall(r"TRACE_EV_(\w+)\s*=\s*(\d+)", f.read()):
+            names[int(value)] = name
+    return names
+
+
+def parse_dump(text):
+    """Returns (cpu_hz, [(cycles, id, arg)]) of the last complete dump in text."""
+    dumps = list(re.finditer(r"TRACE (\d+) (\d+)\r?\n(.*?)TRACE END", text, re.S))
+    if not dumps:
+        sys.exit("no complete 'TRACE ... TRACE END' block found")
+    last = dumps[-1]
+    hz = int(last.group(1))
+    events = [tuple(int(v, 16) for v in m) for m in
+              re.findall(r"^([0-9A-Fa-f]{8}) ([0-9A-Fa-f]{4}) ([0-9A-Fa-f]{4})\s*$", last.group(3), re.M)]
+    if len(events) != int(last.group(2)):
+        print(f"warning: header announces {last.group(2)} events, found {len(events)}", file=sys.stderr)
+    return hz, events
+
+
+def main():
+    default_header = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "inc", "trace.h")
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", help="UART log containing a trace dump, - for stdin")
+    parser.add_argument("output", help="JSON file to write")
+    parser.add_argument("--header", default=default_header, help="trace.h with the event enum")
+    args = parser.parse_args()
+
+    text = sys.stdin.read() if args.log == "-" else open(args.log, errors="replace").read()
+    hz, events = parse_dump(text)
+    names = load_names(args.header)
+    if hz == 0:
+        sys.exit("CPU frequency is 0 in the dump header")
+
+    out = [
+        {"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "STM32L476"}},
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": TID_MAIN, "args": {"name": "main loop"}},
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": TID_ISR, "args": {"name": "interrupts"}},
+    ]
+
+    # Slots are claimed before the timestamp is read, so neighbours can be
+    # a few cycles out of order; only a big backwards step is a wrap
+    base = 0
+    previous = None
+    open_spans = {}
+    for cycles, ident, arg in events:
+        if previous is not None and cycles < previous and previous - cycles > 0x80000000:
+            base += 1 << 32
+        previous = cycles
+        ts = (base + cycles) * 1e6 / hz
+
+        event = ident & ~TRACE_KIND_MASK
+        kind = ident & TRACE_KIND_MASK
+        name = names.get(event, f"event_{event}")
+        tid = TID_ISR if name.endswith("_ISR") else TID_MAIN
+        record = {"name": name, "pid": 1, "tid": tid, "ts": round(ts, 3), "args": {"arg": arg}}
+
+        if kind == TRACE_BEGIN:
+            record["ph"] = "B"
+            open_spans[event] = open_spans.get(event, 0) + 1
+        elif kind == TRACE_END:
+            # The ring may start in the middle of a span: drop its lone end
+            if not open_spans.get(event):
+                continue
+            open_spans[event] -= 1
+            record["ph"] = "E"
+        else:
+            record["ph"] = "i"
+            record["s"] = "t"
+        out.append(record)
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": out, "displayTimeUnit": "ns"}, f, indent=1)
+    span = (out[-1]["ts"] - out[3]["ts"]) if len(out) > 4 else 0
+    print(f"trace2json: {len(events)} events over {span:.1f} us at {hz / 1e6:g} MHz -> {args.output}")
+
+
+if __name__ == "__main__":
+    main()